@@ -0,0 +1,129 @@
+#include "ParticleBench.h"
+#include "BlockBench.h"
+#include "MixBench.h"
+#include "MathBench.h"
+#include "Capture.h"
+#include <stdio.h>
+#include <string.h>
+
+// Portable bench driver.
+// Runs the checks the game and the Matrices demo keep behind their command
+// line modes (-particlebench, -bcbench, -mixbench, -mathbench, -replay)
+// without a window, a device or Windows, so they can be built with
+// CMakeLists.txt next to this file and run anywhere:
+//   bench particle | bc | mix | math
+//   bench capture <folder>    records a scripted session of the game's sprites
+//   bench replay <folder>     draws that session again, against its goldens
+// The textures are read from img/ under the working folder, so capture and
+// replay run from Shooting_game. Every command returns its number of failed
+// checks or frames, -1 when it could not run at all.
+
+#define BENCH_FRAMES   5
+#define BENCH_SPRITES  300
+#define BENCH_WIDTH    800
+#define BENCH_HEIGHT   600
+#define BENCH_COLORKEY 0xffff00ff
+#define BENCH_PATH_LEN 260
+
+// the game's sprite sheets, in its texture id order
+static const char* g_pBenchTextures[] = { "img/sasuke(w).png", "img/attack(w).png", "img/enemy_1.png",
+	"img/weapon.png", "img/explosion.png", "img/skill.png" };
+static const int g_nBenchTextures = sizeof(g_pBenchTextures) / sizeof(g_pBenchTextures[0]);
+
+static void Bench_Report(const char* pLine)
+{
+	fputs(pLine, stdout);
+}
+
+//Bench_Capture() : records BENCH_FRAMES frames of sprites spread over every
+//sheet, half of them tinted; the goldens are written the first time
+static int Bench_Capture(const char* pDir)
+{
+	char szOut[BENCH_PATH_LEN], szGolden[BENCH_PATH_LEN];
+	snprintf(szOut, sizeof(szOut), "%s/out", pDir);
+	snprintf(szGolden, sizeof(szGolden), "%s/golden", pDir);
+
+	IMAGE textures[sizeof(g_pBenchTextures) / sizeof(g_pBenchTextures[0])];
+	for (int i = 0; i < g_nBenchTextures; i++)
+	{
+		if (!Capture_LoadTexture(g_pBenchTextures[i], BENCH_COLORKEY, &textures[i]))
+		{
+			printf("bench: %s could not be read\n", g_pBenchTextures[i]);
+			for (int j = 0; j < i; j++)
+				Image_Free(&textures[j]);
+			return -1;
+		}
+	}
+
+	if (!Capture_Begin(szOut, szGolden, 0, 0.0f, 4))
+	{
+		for (int i = 0; i < g_nBenchTextures; i++)
+			Image_Free(&textures[i]);
+		return -1;
+	}
+
+	static FRAMEPACKET packet;
+	for (int frame = 1; frame <= BENCH_FRAMES; frame++)
+	{
+		packet.nSprites = 0;
+		packet.nTexts = 0;
+		packet.cameraX = frame * 3.5f;
+		packet.bgColor = 0xffffffff;
+		for (int i = 0; i < BENCH_SPRITES; i++)
+		{
+			SPRITEINSTANCE& sprite = packet.sprites[packet.nSprites++];
+			sprite.texture = i % g_nBenchTextures;
+			sprite.src.left = (i % 4) * 64;
+			sprite.src.top = 0;
+			sprite.src.right = sprite.src.left + 64;
+			sprite.src.bottom = 64;
+			sprite.centerX = 32.0f;
+			sprite.centerY = 32.0f;
+			sprite.x = (i * 37 + frame * 11) % BENCH_WIDTH + 0.3f;
+			sprite.y = (i * 53) % BENCH_HEIGHT - 0.6f;
+			sprite.color = (i & 1) ? 0xffffffff : 0x80ff8040;
+		}
+		Capture_SubmitPacket(frame, &packet, textures, g_nBenchTextures, BENCH_WIDTH, BENCH_HEIGHT);
+	}
+
+	CAPTURESTATS stats = Capture_End();
+	for (int i = 0; i < g_nBenchTextures; i++)
+		Image_Free(&textures[i]);
+
+	printf("bench: captured %d frames, %d recorded as goldens, %d failed\n", stats.nFrames, stats.nRecorded, stats.nFailed);
+	return stats.nFailed;
+}
+
+//Bench_Replay() : the replay has to match the goldens of the capture exactly
+static int Bench_Replay(const char* pDir)
+{
+	char szPackets[BENCH_PATH_LEN], szOut[BENCH_PATH_LEN], szGolden[BENCH_PATH_LEN];
+	snprintf(szPackets, sizeof(szPackets), "%s/out/packets.bin", pDir);
+	snprintf(szOut, sizeof(szOut), "%s/replay", pDir);
+	snprintf(szGolden, sizeof(szGolden), "%s/golden", pDir);
+
+	int nFailed = Capture_Replay(szPackets, g_pBenchTextures, g_nBenchTextures, BENCH_COLORKEY, szOut, szGolden, 0, 0.0f, 4);
+	printf("bench: replay of %s, %d frames failed\n", szPackets, nFailed);
+	return nFailed;
+}
+
+int main(int argc, char* argv[])
+{
+	const char* pCommand = (argc > 1) ? argv[1] : "";
+
+	if (strcmp(pCommand, "particle") == 0)
+		return ParticleBench_Run(Bench_Report);
+	if (strcmp(pCommand, "bc") == 0)
+		return BlockBench_Run(Bench_Report);
+	if (strcmp(pCommand, "mix") == 0)
+		return MixBench_Run(Bench_Report);
+	if (strcmp(pCommand, "math") == 0)
+		return MathBench_Run(Bench_Report);
+	if (strcmp(pCommand, "capture") == 0 && argc > 2)
+		return Bench_Capture(argv[2]);
+	if (strcmp(pCommand, "replay") == 0 && argc > 2)
+		return Bench_Replay(argv[2]);
+
+	fputs("usage: bench particle | bc | mix | math | capture <folder> | replay <folder>\n", stderr);
+	return -1;
+}
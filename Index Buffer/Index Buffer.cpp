@@ -8,7 +8,7 @@
 *------------------------------------------------------------------------------
 */
 #include <d3d9.h>
-#include <d3dx9.h>
+#include "VecMath.h"
 
 
 
@@ -169,23 +169,23 @@ HRESULT InitIB()
 VOID SetupMatrices()
 {
 	/// 
-	D3DXMATRIXA16 matWorld;
-	D3DXMatrixIdentity(&matWorld);							///   
-	D3DXMatrixRotationY(&matWorld, GetTickCount() / 500.0f);	/// Y ߽ ȸ 
-	g_pd3dDevice->SetTransform(D3DTS_WORLD, &matWorld);		/// ̽  
+	MAT4 matWorld;
+	Mat4_Identity(&matWorld);							///   
+	Mat4_RotationY(&matWorld, GetTickCount() / 500.0f);	/// Y ߽ ȸ 
+	g_pd3dDevice->SetTransform(D3DTS_WORLD, (D3DMATRIX*)&matWorld);		/// ̽  
 
 															///  
-	D3DXVECTOR3 vEyePt(0.0f, 3.0f, -5.0f);
-	D3DXVECTOR3 vLookatPt(0.0f, 0.0f, 0.0f);
-	D3DXVECTOR3 vUpVec(0.0f, 1.0f, 0.0f);
-	D3DXMATRIXA16 matView;
-	D3DXMatrixLookAtLH(&matView, &vEyePt, &vLookatPt, &vUpVec);
-	g_pd3dDevice->SetTransform(D3DTS_VIEW, &matView);
+	VEC3 vEyePt = Vec3(0.0f, 3.0f, -5.0f);
+	VEC3 vLookatPt = Vec3(0.0f, 0.0f, 0.0f);
+	VEC3 vUpVec = Vec3(0.0f, 1.0f, 0.0f);
+	MAT4 matView;
+	Mat4_LookAtLH(&matView, vEyePt, vLookatPt, vUpVec);
+	g_pd3dDevice->SetTransform(D3DTS_VIEW, (D3DMATRIX*)&matView);
 
 	///   
-	D3DXMATRIXA16 matProj;
-	D3DXMatrixPerspectiveFovLH(&matProj, D3DX_PI / 4, 1.0f, 1.0f, 100.0f);
-	g_pd3dDevice->SetTransform(D3DTS_PROJECTION, &matProj);
+	MAT4 matProj;
+	Mat4_PerspectiveFovLH(&matProj, VECMATH_PI / 4, 1.0f, 1.0f, 100.0f);
+	g_pd3dDevice->SetTransform(D3DTS_PROJECTION, (D3DMATRIX*)&matProj);
 }
 
 
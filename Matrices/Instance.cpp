@@ -0,0 +1,104 @@
+#include "Instance.h"
+
+void Instance_Set(INSTANCE* pInstance, const MAT4& world, unsigned int color)
+{
+	for (int c = 0; c < 3; c++)
+		for (int r = 0; r < 4; r++)
+			pInstance->world[c][r] = world.m[r][c];
+	pInstance->color = color;
+}
+
+//Instance_GetWorld() : the fourth column is always (0, 0, 0, 1)
+void Instance_GetWorld(const INSTANCE* pInstance, MAT4* pWorld)
+{
+	for (int r = 0; r < 4; r++)
+	{
+		for (int c = 0; c < 3; c++)
+			pWorld->m[r][c] = pInstance->world[c][r];
+		pWorld->m[r][3] = r == 3 ? 1.0f : 0.0f;
+	}
+}
+
+unsigned int Instance_AddColor(unsigned int a, unsigned int b)
+{
+	unsigned int result = 0;
+
+	for (int shift = 0; shift < 32; shift += 8)
+	{
+		unsigned int sum = ((a >> shift) & 0xff) + ((b >> shift) & 0xff);
+		result |= (sum > 0xff ? 0xff : sum) << shift;
+	}
+
+	return result;
+}
+
+//Instance_Expand() : instance by instance, so each mesh goes through Vec3_TransformCoordArray() in one batch
+void Instance_Expand(INSTANCEVERTEX* pOut, const INSTANCEVERTEX* pMesh, int nVertices, const INSTANCE* pInstances, int nInstances)
+{
+	for (int i = 0; i < nInstances; i++)
+	{
+		MAT4 world;
+		Instance_GetWorld(&pInstances[i], &world);
+
+		INSTANCEVERTEX* pVertices = pOut + i * nVertices;
+		Vec3_TransformCoordArray((VEC3*)pVertices, sizeof(INSTANCEVERTEX), (const VEC3*)pMesh, sizeof(INSTANCEVERTEX), world, nVertices);
+		for (int v = 0; v < nVertices; v++)
+			pVertices[v].color = Instance_AddColor(pMesh[v].color, pInstances[i].color);
+	}
+}
+
+// Tokens of:
+//   vs_3_0
+//   dcl_position v0
+//   dcl_color v1
+//   dcl_texcoord0 v2
+//   dcl_texcoord1 v3
+//   dcl_texcoord2 v4
+//   dcl_color1 v5
+//   dcl_position o0
+//   dcl_color o1
+//   dp4 r0.x, v0, v2
+//   dp4 r0.y, v0, v3
+//   dp4 r0.z, v0, v4
+//   mov r0.w, v0.w
+//   dp4 o0.x, r0, c0
+//   dp4 o0.y, r0, c1
+//   dp4 o0.z, r0, c2
+//   dp4 o0.w, r0, c3
+//   add o1, v1, v5
+// written out by hand so the demo needs no shader compiler
+const unsigned int g_InstanceShader[] =
+{
+	0xfffe0300,
+	0x0200001f, 0x80000000, 0x900f0000,
+	0x0200001f, 0x8000000a, 0x900f0001,
+	0x0200001f, 0x80000005, 0x900f0002,
+	0x0200001f, 0x80010005, 0x900f0003,
+	0x0200001f, 0x80020005, 0x900f0004,
+	0x0200001f, 0x8001000a, 0x900f0005,
+	0x0200001f, 0x80000000, 0xe00f0000,
+	0x0200001f, 0x8000000a, 0xe00f0001,
+	0x03000009, 0x80010000, 0x90e40000, 0x90e40002,
+	0x03000009, 0x80020000, 0x90e40000, 0x90e40003,
+	0x03000009, 0x80040000, 0x90e40000, 0x90e40004,
+	0x02000001, 0x80080000, 0x90ff0000,
+	0x03000009, 0xe0010000, 0x80e40000, 0xa0e40000,
+	0x03000009, 0xe0020000, 0x80e40000, 0xa0e40001,
+	0x03000009, 0xe0040000, 0x80e40000, 0xa0e40002,
+	0x03000009, 0xe0080000, 0x80e40000, 0xa0e40003,
+	0x03000002, 0xe00f0001, 0x90e40001, 0x90e40005,
+	0x0000ffff,
+};
+
+// Tokens of:
+//   ps_3_0
+//   dcl_color v0
+//   mov_sat oC0, v0
+// vs_3_0 cannot be paired with the fixed function pixel stage
+const unsigned int g_InstancePixelShader[] =
+{
+	0xffff0300,
+	0x0200001f, 0x8000000a, 0x900f0000,
+	0x02000001, 0x801f0800, 0x90e40000,
+	0x0000ffff,
+};
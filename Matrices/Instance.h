@@ -0,0 +1,37 @@
+#pragma once
+#include "VecMath.h"
+
+// Instanced stars.
+// One mesh is drawn once per instance, with the instance's transform and
+// color fed from a second vertex stream. An instance holds the first three
+// columns of its world matrix, the rows the vertex shader dots the position
+// with, and a color that is added to the mesh's vertex colors with
+// saturation, so white parts of the mesh stay white and black parts take
+// the instance's color. Instance_Expand() is the CPU reference of that
+// shader: it writes every instance's vertices in world space, which is what
+// the demo draws when the device cannot instance, and what the benchmark
+// times and checks the layout against.
+
+// same layout as the demo's CUSTOMVERTEX (D3DFVF_XYZ|D3DFVF_DIFFUSE)
+struct INSTANCEVERTEX
+{
+	float x, y, z;
+	unsigned int color;
+};
+
+struct INSTANCE
+{
+	float world[3][4];    // columns 0 to 2 of the world matrix
+	unsigned int color;   // A8R8G8B8
+};
+
+void Instance_Set(INSTANCE* pInstance, const MAT4& world, unsigned int color);
+void Instance_GetWorld(const INSTANCE* pInstance, MAT4* pWorld);
+unsigned int Instance_AddColor(unsigned int a, unsigned int b);    // per channel, saturated
+void Instance_Expand(INSTANCEVERTEX* pOut, const INSTANCEVERTEX* pMesh, int nVertices, const INSTANCE* pInstances, int nInstances);    // pOut holds nVertices * nInstances
+
+// the vs_3_0 shader: v0 position, v1 color, v2-v4 INSTANCE::world (TEXCOORD0-2),
+// v5 INSTANCE::color (COLOR1), c0-c3 the transposed view-projection;
+// the ps_3_0 one passes the color through
+extern const unsigned int g_InstanceShader[];
+extern const unsigned int g_InstancePixelShader[];
@@ -0,0 +1,526 @@
+#include "MathBench.h"
+#include "VecMath.h"
+#include "Mesh.h"
+#include "Instance.h"
+#include "VertexPipe.h"
+#include <chrono>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#define MATHBENCH_MATRICES  4096
+#define MATHBENCH_POINTS    65536
+
+static MATHBENCHREPORT g_pReport;
+static int g_nFailed;
+
+static void MathBench_Report(const char* pLine)
+{
+	if (g_pReport != NULL)
+		g_pReport(pLine);
+}
+
+//MathBench_Expect() : pExpected is the matrix row by row, compared within fTolerance
+static void MathBench_Expect(const char* pName, const MAT4& m, const float* pExpected, float fTolerance)
+{
+	for (int i = 0; i < 16; i++)
+	{
+		float d = m.m[i / 4][i % 4] - pExpected[i];
+		if (d > fTolerance || d < -fTolerance)
+		{
+			char line[256];
+			sprintf(line, "mathbench: %s [%d][%d] is %f, expected %f\n", pName, i / 4, i % 4, m.m[i / 4][i % 4], pExpected[i]);
+			MathBench_Report(line);
+			g_nFailed++;
+			return;
+		}
+	}
+}
+
+static void MathBench_ExpectVec3(const char* pName, const VEC3& v, float x, float y, float z)
+{
+	float d = fabsf(v.x - x) + fabsf(v.y - y) + fabsf(v.z - z);
+	if (d > 1e-5f)
+	{
+		char line[256];
+		sprintf(line, "mathbench: %s is (%f, %f, %f), expected (%f, %f, %f)\n", pName, v.x, v.y, v.z, x, y, z);
+		MathBench_Report(line);
+		g_nFailed++;
+	}
+}
+
+// the D3DX results for the transforms the demos build
+static void MathBench_References(void)
+{
+	MAT4 m, a, b;
+
+	Mat4_LookAtLH(&m, Vec3(0.0f, 3.0f, -5.0f), Vec3(0.0f, 0.0f, 0.0f), Vec3(0.0f, 1.0f, 0.0f));
+	float view[16] = {
+		1.0f, 0.0f, 0.0f, 0.0f,
+		0.0f, 0.857493f, -0.514496f, 0.0f,
+		0.0f, 0.514496f, 0.857493f, 0.0f,
+		0.0f, 0.0f, 5.830952f, 1.0f };
+	MathBench_Expect("LookAtLH", m, view, 1e-5f);
+
+	Mat4_PerspectiveFovLH(&m, VECMATH_PI / 2, 1.0f, 1.0f, 100.0f);
+	float proj[16] = {
+		1.0f, 0.0f, 0.0f, 0.0f,
+		0.0f, 1.0f, 0.0f, 0.0f,
+		0.0f, 0.0f, 1.010101f, 1.0f,
+		0.0f, 0.0f, -1.010101f, 0.0f };
+	MathBench_Expect("PerspectiveFovLH", m, proj, 1e-5f);
+
+	Mat4_PerspectiveFovLH(&m, VECMATH_PI / 4, 1.0f, 1.0f, 100.0f);
+	float proj45[16] = {
+		2.414214f, 0.0f, 0.0f, 0.0f,
+		0.0f, 2.414214f, 0.0f, 0.0f,
+		0.0f, 0.0f, 1.010101f, 1.0f,
+		0.0f, 0.0f, -1.010101f, 0.0f };
+	MathBench_Expect("PerspectiveFovLH 45", m, proj45, 1e-5f);
+
+	// a quarter turn takes x to -z about y, y to z about x and x to y about z
+	Mat4_RotationY(&m, VECMATH_PI / 2);
+	MathBench_ExpectVec3("RotationY", Vec3_TransformCoord(Vec3(1.0f, 0.0f, 0.0f), m), 0.0f, 0.0f, -1.0f);
+	Mat4_RotationX(&m, VECMATH_PI / 2);
+	MathBench_ExpectVec3("RotationX", Vec3_TransformCoord(Vec3(0.0f, 1.0f, 0.0f), m), 0.0f, 0.0f, 1.0f);
+	Mat4_RotationZ(&m, VECMATH_PI / 2);
+	MathBench_ExpectVec3("RotationZ", Vec3_TransformCoord(Vec3(1.0f, 0.0f, 0.0f), m), 0.0f, 1.0f, 0.0f);
+
+	// translate, then turn
+	Mat4_Translation(&a, 1.0f, 0.0f, 0.0f);
+	Mat4_RotationZ(&b, VECMATH_PI / 2);
+	Mat4_Multiply(&m, a, b);
+	MathBench_ExpectVec3("Multiply", Vec3_TransformCoord(Vec3(0.0f, 0.0f, 0.0f), m), 0.0f, 1.0f, 0.0f);
+	Mat4_Scaling(&a, 2.0f, 3.0f, 4.0f);
+	MathBench_ExpectVec3("Scaling", Vec3_TransformCoord(Vec3(1.0f, 1.0f, 1.0f), a), 2.0f, 3.0f, 4.0f);
+
+	// the origin through the Matrices demo's view and projection
+	MAT4 viewProj;
+	Mat4_LookAtLH(&a, Vec3(0.0f, 3.0f, -5.0f), Vec3(0.0f, 0.0f, 0.0f), Vec3(0.0f, 1.0f, 0.0f));
+	Mat4_PerspectiveFovLH(&b, VECMATH_PI / 2, 1.0f, 1.0f, 100.0f);
+	Mat4_Multiply(&viewProj, a, b);
+	MathBench_ExpectVec3("TransformCoord", Vec3_TransformCoord(Vec3(0.0f, 0.0f, 0.0f), viewProj), 0.0f, 0.0f, 0.836870f);
+
+	// quaternions turn like the matrices and compose in the same order
+	QUAT qx = Quat_RotationAxis(Vec3(1.0f, 0.0f, 0.0f), 0.7f);
+	QUAT qz = Quat_RotationAxis(Vec3(0.0f, 0.0f, 1.0f), 1.3f);
+	Mat4_RotationX(&a, 0.7f);
+	Mat4_RotationZ(&b, 1.3f);
+	Mat4_Multiply(&m, a, b);
+	MAT4 q;
+	Mat4_RotationQuat(&q, Quat_Multiply(qx, qz));
+	MathBench_Expect("Quat_Multiply", q, m.m[0], 1e-5f);
+
+	Mat4_RotationZ(&m, 0.65f);
+	Mat4_RotationQuat(&q, Quat_Slerp(Quat_Identity(), qz, 0.5f));
+	MathBench_Expect("Quat_Slerp", q, m.m[0], 1e-5f);
+}
+
+static float MathBench_Random(unsigned int* pSeed)
+{
+	*pSeed = *pSeed * 1664525u + 1013904223u;
+	return (int)(*pSeed >> 9) / 4194304.0f - 1.0f;
+}
+
+static double MathBench_Seconds(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// what Vec3_TransformCoord() does without SSE
+static VEC3 MathBench_TransformScalar(const VEC3& v, const MAT4& m)
+{
+	float x = v.x * m.m[0][0] + v.y * m.m[1][0] + v.z * m.m[2][0] + m.m[3][0];
+	float y = v.x * m.m[0][1] + v.y * m.m[1][1] + v.z * m.m[2][1] + m.m[3][1];
+	float z = v.x * m.m[0][2] + v.y * m.m[1][2] + v.z * m.m[2][2] + m.m[3][2];
+	float w = v.x * m.m[0][3] + v.y * m.m[1][3] + v.z * m.m[2][3] + m.m[3][3];
+	return Vec3(x / w, y / w, z / w);
+}
+
+// the generated star against the triangle list the Matrices demo had
+// written out by hand, welded and as it was, and the index sizes
+static void MathBench_Mesh(void)
+{
+	char line[256];
+	const float a = 0.224513988f, b = 0.309016994f, c = 0.363271264f, d = 0.118033989f, e = 0.381966011f;
+	const float f = 0.951056516f, g = 0.587785252f, h = 0.809016994f;
+	const unsigned int W = 0xffffffff, K = 0xff000000;
+	MESHVERTEX list[30] = {
+		{ -a, b, 0, K }, { 0, 0, 0, W }, { a, b, 0, K },    { 0, 1, 0, W }, { -a, b, 0, K }, { a, b, 0, K },
+		{ a, b, 0, K }, { 0, 0, 0, W }, { c, -d, 0, K },    { f, b, 0, W }, { a, b, 0, K }, { c, -d, 0, K },
+		{ c, -d, 0, K }, { 0, 0, 0, W }, { 0, -e, 0, K },   { g, -h, 0, W }, { c, -d, 0, K }, { 0, -e, 0, K },
+		{ 0, -e, 0, K }, { 0, 0, 0, W }, { -c, -d, 0, K },  { -g, -h, 0, W }, { 0, -e, 0, K }, { -c, -d, 0, K },
+		{ -c, -d, 0, K }, { 0, 0, 0, W }, { -a, b, 0, K },  { -f, b, 0, W }, { -c, -d, 0, K }, { -a, b, 0, K } };
+
+	MESHVERTEX vertices[Mesh_StarVertices(5)], welded[30];
+	unsigned short indices[Mesh_StarIndices(5)], weldedIndices[30];
+	MESH star, weld;
+	Mesh_Init(&star, vertices, Mesh_StarVertices(5), indices, 2, Mesh_StarIndices(5));
+	Mesh_Init(&weld, welded, 30, weldedIndices, 2, 30);
+	if (Mesh_Star(&star, 5, 1.0f, e, W, K) == false || Mesh_AddTriangleList(&weld, list, 30) == false ||
+		weld.nVertices != star.nVertices || weld.nIndices != star.nIndices)
+	{
+		sprintf(line, "mathbench: the star has %d vertices and %d indices, welded %d and %d\n",
+			star.nVertices, star.nIndices, weld.nVertices, weld.nIndices);
+		MathBench_Report(line);
+		g_nFailed++;
+		return;
+	}
+
+	// every hand written triangle is a generated one, starting anywhere and wound either way
+	int nMissing = 0;
+	for (int t = 0; t < 30; t += 3)
+	{
+		bool bFound = false;
+		for (int u = 0; u < star.nIndices && bFound == false; u += 3)
+			for (int start = 0; start < 6 && bFound == false; start++)
+			{
+				bFound = true;
+				for (int k = 0; k < 3; k++)
+				{
+					int corner = start < 3 ? (start + k) % 3 : (start - k + 3) % 3;
+					const MESHVERTEX& p = list[t + k];
+					const MESHVERTEX& q = vertices[Mesh_GetIndex(&star, u + corner)];
+					if (fabsf(p.x - q.x) > 1e-6f || fabsf(p.y - q.y) > 1e-6f || p.color != q.color)
+						bFound = false;
+				}
+			}
+		if (bFound == false)
+			nMissing++;
+	}
+	if (nMissing != 0)
+	{
+		sprintf(line, "mathbench: %d of the star's triangles are not generated\n", nMissing);
+		MathBench_Report(line);
+		g_nFailed++;
+	}
+
+	// 100000 corners only fit 32 bit indices, and a mesh that fails stays as it was
+	const int nSides = 100000;
+	std::vector<MESHVERTEX> polygon(Mesh_PolygonVertices(nSides));
+	std::vector<unsigned int> polygonIndices(Mesh_PolygonIndices(nSides));
+	MESH big;
+	Mesh_Init(&big, &polygon[0], Mesh_PolygonVertices(nSides), &polygonIndices[0], 2, Mesh_PolygonIndices(nSides));
+	bool b16 = Mesh_Polygon(&big, nSides, 1.0f, W, K);
+	int nLeft = big.nVertices;
+	Mesh_Init(&big, &polygon[0], Mesh_PolygonVertices(nSides), &polygonIndices[0], 4, Mesh_PolygonIndices(nSides));
+	bool b32 = Mesh_Polygon(&big, nSides, 1.0f, W, K);
+	if (b16 || nLeft != 0 || b32 == false || Mesh_GetIndex(&big, big.nIndices - 1) != 1)
+		g_nFailed++;
+
+	sprintf(line, "mathbench: star mesh %d vertices and %d indices, %u bytes; as a triangle list %u bytes\n",
+		star.nVertices, star.nIndices, (unsigned int)(sizeof(vertices) + sizeof(indices)), (unsigned int)sizeof(list));
+	MathBench_Report(line);
+}
+
+// the instanced stars: the stream layout against the shader's arithmetic,
+// then expanding 9 to 100000 stars on the CPU like the demo's fallback
+static void MathBench_Instancing(void)
+{
+	char line[256];
+	unsigned int seed = 7;
+	const int nMesh = Mesh_StarVertices(5);
+	MESHVERTEX star[nMesh];
+	unsigned short starIndices[Mesh_StarIndices(5)];
+	MESH generated;
+	Mesh_Init(&generated, star, nMesh, starIndices, 2, Mesh_StarIndices(5));
+	Mesh_Star(&generated, 5, 1.0f, 0.381966011f, 0xffffffff, 0xff000000);
+	const INSTANCEVERTEX* mesh = (const INSTANCEVERTEX*)star;
+
+	const int nMax = 100000;
+	std::vector<INSTANCE> instances(nMax);
+	for (int i = 0; i < nMax; i++)
+	{
+		MAT4 world, turn;
+		Mat4_Scaling(&world, 0.15f, 0.15f, 0.15f);
+		Mat4_RotationZ(&turn, MathBench_Random(&seed) * VECMATH_PI);
+		Mat4_Multiply(&world, world, turn);
+		world.m[3][0] = MathBench_Random(&seed) * 12.0f;
+		world.m[3][1] = MathBench_Random(&seed) * 8.0f;
+		world.m[3][2] = MathBench_Random(&seed) * 20.0f + 22.0f;
+		Instance_Set(&instances[i], world, i & 1 ? 0xffff0000 : 0xff0000ff);
+	}
+
+	// what the vertex shader does with the second stream: dp4 against each column
+	std::vector<INSTANCEVERTEX> expanded((size_t)nMax * nMesh);
+	Instance_Expand(&expanded[0], mesh, nMesh, &instances[0], 2);
+	int nWrong = 0;
+	for (int i = 0; i < 2; i++)
+	{
+		MAT4 world;
+		Instance_GetWorld(&instances[i], &world);
+		for (int v = 0; v < nMesh; v++)
+		{
+			const float* pColumn = instances[i].world[0];
+			const INSTANCEVERTEX& out = expanded[i * nMesh + v];
+			float x = mesh[v].x * pColumn[0] + mesh[v].y * pColumn[1] + mesh[v].z * pColumn[2] + pColumn[3];
+			VEC3 reference = Vec3_TransformCoord(Vec3(mesh[v].x, mesh[v].y, mesh[v].z), world);
+			if (out.x != reference.x || out.y != reference.y || out.z != reference.z || fabsf(out.x - x) > 1e-6f ||
+				out.color != (mesh[v].color == 0xffffffff ? 0xffffffff : instances[i].color))
+				nWrong++;
+		}
+	}
+	if (nWrong != 0)
+	{
+		sprintf(line, "mathbench: %d instanced vertices differ from the transformed mesh\n", nWrong);
+		MathBench_Report(line);
+		g_nFailed++;
+	}
+	if (Instance_AddColor(0x80ff4000, 0x80402010) != 0xffff6010)
+		g_nFailed++;
+
+	static const int counts[] = { 9, 1000, nMax };
+	for (int c = 0; c < 3; c++)
+	{
+		int nStars = counts[c];
+		int nRepeats = 3000000 / (nStars * nMesh) + 1;
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		for (int r = 0; r < nRepeats; r++)
+			Instance_Expand(&expanded[0], mesh, nMesh, &instances[0], nStars);
+		double fTime = MathBench_Seconds(start);
+
+		sprintf(line, "mathbench: %6d stars expanded at %.1f M vertices/s, %u KB a frame; instanced %u KB once and %u bytes per moved star\n",
+			nStars, (double)nRepeats * nStars * nMesh / fTime * 1e-6, (unsigned int)(nStars * nMesh * sizeof(INSTANCEVERTEX) / 1024),
+			(unsigned int)((nStars * sizeof(INSTANCE) + sizeof(star) + sizeof(starIndices)) / 1024),
+			(unsigned int)sizeof(INSTANCE));
+		MathBench_Report(line);
+	}
+}
+
+// the software vertex pipeline: a known point onto a 640x480 viewport, the
+// clip codes and a triangle clipped against the near plane, the AVX2 and
+// SSE2 blocks against the scalar version, and both formats timed through
+// the transform and the triangle culling and clipping
+static void MathBench_VertexPipe(void)
+{
+	char line[256];
+	MAT4 view, proj, viewProj;
+	Mat4_LookAtLH(&view, Vec3(0.0f, 3.0f, -5.0f), Vec3(0.0f, 0.0f, 0.0f), Vec3(0.0f, 1.0f, 0.0f));
+	Mat4_PerspectiveFovLH(&proj, VECMATH_PI / 4, 4.0f / 3.0f, 1.0f, 100.0f);
+	Mat4_Multiply(&viewProj, view, proj);
+
+	VERTEXPIPE pipe;
+	VertexPipe_Init(&pipe, viewProj, 0.0f, 0.0f, 640.0f, 480.0f, 0.0f, 1.0f);
+
+	// the origin is at the middle of the view, (0, 0, -6) behind the eye
+	// and (-10, 0, 0) off its left side
+	float probe[3][4] = { { 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, -6.0f }, { -10.0f, 0.0f, 0.0f } };
+	float screen[5][5];
+	unsigned char codes[3];
+	VertexPipe_TransformScalar(&pipe, screen, probe, 16, 3, codes);
+	MathBench_ExpectVec3("VertexPipe origin", Vec3(screen[0][0], screen[0][1], screen[0][3]), 320.0f, 240.0f, 1.0f / 5.830952f);
+	if (codes[0] != 0 || (codes[1] & VERTEXPIPE_CLIP_NEAR) == 0 || codes[2] != VERTEXPIPE_CLIP_LEFT)
+	{
+		sprintf(line, "mathbench: VertexPipe clip codes are %02x %02x %02x\n", codes[0], codes[1], codes[2]);
+		MathBench_Report(line);
+		g_nFailed++;
+	}
+
+	// the three as a triangle lose the corner behind the eye to two on the
+	// near plane, the first of them straight in front of the origin
+	unsigned short clipped[6];
+	int nScreen = 3;
+	if (VertexPipe_Cull(&pipe, probe, 16, screen, &nScreen, 5, clipped, codes, NULL, 1, NULL) != 2 || nScreen != 5 ||
+		clipped[0] != 0 || clipped[1] != 3 || clipped[2] != 4 || clipped[3] != 0 || clipped[4] != 4 || clipped[5] != 2)
+	{
+		MathBench_Report("mathbench: VertexPipe did not clip the triangle across the near plane into two\n");
+		g_nFailed++;
+	}
+	MathBench_ExpectVec3("VertexPipe near plane", Vec3(screen[3][0], screen[3][2], screen[3][3]), 320.0f, 0.0f, 1.0f);
+
+	// a cloud a bit wider than the view, XYZ|DIFFUSE|TEX1 vertices with the
+	// XYZ|DIFFUSE ones being the same at the shorter stride
+	const int nVertices = MATHBENCH_POINTS * 3;
+	unsigned int seed = 3;
+	std::vector<float> input(nVertices * 6);
+	for (int i = 0; i < nVertices; i++)
+	{
+		float* v = &input[i * 6];
+		v[0] = MathBench_Random(&seed) * 6.0f;
+		v[1] = MathBench_Random(&seed) * 6.0f;
+		v[2] = MathBench_Random(&seed) * 6.0f;
+		unsigned int color = seed;
+		memcpy(&v[3], &color, 4);
+		v[4] = MathBench_Random(&seed);
+		v[5] = MathBench_Random(&seed);
+	}
+	std::vector<float> input16(nVertices * 4);
+	for (int i = 0; i < nVertices; i++)
+		memcpy(&input16[i * 4], &input[i * 6], 16);
+
+	std::vector<float> output(nVertices * 7), sse(nVertices * 7), scalar(nVertices * 7);
+	std::vector<unsigned char> clip(nVertices), sseClip(nVertices), scalarClip(nVertices);
+
+	for (int nStride = 16; nStride <= 24; nStride += 8)
+	{
+		const float* pIn = nStride == 16 ? &input16[0] : &input[0];
+		size_t nBytes = (size_t)nVertices * (nStride + 4);
+		VertexPipe_Transform(&pipe, &output[0], pIn, nStride, nVertices, &clip[0]);
+		VertexPipe_TransformSSE2(&pipe, &sse[0], pIn, nStride, nVertices, &sseClip[0]);
+		VertexPipe_TransformScalar(&pipe, &scalar[0], pIn, nStride, nVertices, &scalarClip[0]);
+		if (memcmp(&output[0], &scalar[0], nBytes) != 0 || memcmp(&clip[0], &scalarClip[0], nVertices) != 0 ||
+			memcmp(&sse[0], &scalar[0], nBytes) != 0 || memcmp(&sseClip[0], &scalarClip[0], nVertices) != 0)
+		{
+			sprintf(line, "mathbench: VertexPipe at %d bytes differs from its scalar version\n", nStride);
+			MathBench_Report(line);
+			g_nFailed++;
+		}
+
+		const int nRepeats = 20;
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		for (int r = 0; r < nRepeats; r++)
+			VertexPipe_Transform(&pipe, &output[0], pIn, nStride, nVertices, &clip[0]);
+		double fBatched = MathBench_Seconds(start);
+
+		start = std::chrono::steady_clock::now();
+		for (int r = 0; r < nRepeats; r++)
+			VertexPipe_TransformSSE2(&pipe, &sse[0], pIn, nStride, nVertices, &sseClip[0]);
+		double fSSE = MathBench_Seconds(start);
+
+		start = std::chrono::steady_clock::now();
+		for (int r = 0; r < nRepeats; r++)
+			VertexPipe_TransformScalar(&pipe, &scalar[0], pIn, nStride, nVertices, &scalarClip[0]);
+		double fScalar = MathBench_Seconds(start);
+
+		// the demo's batches stay below 65536 vertices for the 16 bit indices,
+		// clipped ones included; every index has to be one of the batch's
+		// vertices, and every new one on the near plane
+		const int nBatch = 30720;
+		int nMaxVertices = nBatch + VertexPipe_ClipVertices(nBatch / 3);
+		std::vector<float> batch(nMaxVertices * 7);
+		std::vector<unsigned short> indices(VertexPipe_ClipIndices(nBatch / 3));
+		VERTEXPIPESTATS stats = { 0, 0, 0, 0, 0 };
+		int nKept = 0, nWrong = 0;
+		double fCull = 0.0;
+		for (int first = 0; first < nVertices; first += nBatch)
+		{
+			int nCount = nVertices - first < nBatch ? nVertices - first : nBatch;
+			memcpy(&batch[0], (const unsigned char*)&output[0] + first * (nStride + 4), nCount * (nStride + 4));
+			int nBatchVertices = nCount;
+			start = std::chrono::steady_clock::now();
+			int nTriangles = VertexPipe_Cull(&pipe, (const unsigned char*)pIn + first * nStride, nStride, &batch[0], &nBatchVertices, nMaxVertices,
+				&indices[0], &clip[first], NULL, nCount / 3, &stats);
+			fCull += MathBench_Seconds(start);
+			nKept += nTriangles;
+
+			for (int i = 0; i < nTriangles * 3; i++)
+			{
+				if (indices[i] >= nBatchVertices || (indices[i] < nCount && (clip[first + indices[i]] & VERTEXPIPE_CLIP_NEAR) != 0))
+					nWrong++;
+			}
+			for (int i = nCount; i < nBatchVertices; i++)
+			{
+				const float* o = (const float*)((const unsigned char*)&batch[0] + i * (nStride + 4));
+				if (o[2] != 0.0f || !(o[3] > 0.0f))
+					nWrong++;
+			}
+		}
+
+		double nProcessed = (double)nRepeats * nVertices;
+		sprintf(line, "mathbench: vertex pipe %d bytes %.1f M vertices/s (%s), four at a time %.1f M vertices/s, one by one %.1f M vertices/s (%.1fx), culling %.0f M triangles/s\n",
+			nStride, nProcessed / fBatched * 1e-6, VertexPipe_HasAVX2() ? "AVX2" : "no AVX2", nProcessed / fSSE * 1e-6,
+			nProcessed / fScalar * 1e-6, fScalar / fBatched, stats.nTriangles / fCull * 1e-6);
+		MathBench_Report(line);
+		sprintf(line, "mathbench: vertex pipe drew %d triangles of %d, %d outside, %d across the near plane clipped into %d, %d dropped\n",
+			nKept, stats.nTriangles, stats.nRejected, stats.nNear, stats.nClipped, stats.nDropped);
+		MathBench_Report(line);
+		if (nKept - stats.nClipped + stats.nRejected + stats.nNear != stats.nTriangles || stats.nDropped != 0 || nWrong != 0 ||
+			output[1] != scalar[1] || sse[1] != scalar[1])
+			g_nFailed++;
+	}
+}
+
+int MathBench_Run(MATHBENCHREPORT pReport)
+{
+	char line[256];
+	g_pReport = pReport;
+	g_nFailed = 0;
+
+	MathBench_References();
+
+	// random worlds by the Matrices demo's view-projection, and points through it
+	unsigned int seed = 1;
+	MAT4 viewProj, view, proj;
+	Mat4_LookAtLH(&view, Vec3(0.0f, 3.0f, -5.0f), Vec3(0.0f, 0.0f, 0.0f), Vec3(0.0f, 1.0f, 0.0f));
+	Mat4_PerspectiveFovLH(&proj, VECMATH_PI / 2, 1.0f, 1.0f, 100.0f);
+	Mat4_Multiply(&viewProj, view, proj);
+
+	std::vector<MAT4> worlds(MATHBENCH_MATRICES), results(MATHBENCH_MATRICES), scalar(MATHBENCH_MATRICES);
+	for (int i = 0; i < MATHBENCH_MATRICES; i++)
+		for (int j = 0; j < 16; j++)
+			worlds[i].m[j / 4][j % 4] = MathBench_Random(&seed);
+
+	std::vector<VEC3> points(MATHBENCH_POINTS), transformed(MATHBENCH_POINTS), reference(MATHBENCH_POINTS);
+	for (int i = 0; i < MATHBENCH_POINTS; i++)
+		points[i] = Vec3(MathBench_Random(&seed) * 10.0f, MathBench_Random(&seed) * 10.0f, MathBench_Random(&seed) * 10.0f);
+
+	Mat4_MultiplyArray(&results[0], &worlds[0], viewProj, MATHBENCH_MATRICES);
+	Vec3_TransformCoordArray(&transformed[0], sizeof(VEC3), &points[0], sizeof(VEC3), viewProj, MATHBENCH_POINTS);
+	for (int i = 0; i < MATHBENCH_MATRICES; i++)
+		VecMath_MultiplyScalar(&scalar[i], worlds[i], viewProj);
+	for (int i = 0; i < MATHBENCH_POINTS; i++)
+		reference[i] = MathBench_TransformScalar(points[i], viewProj);
+
+	int nMismatched = 0;
+	if (memcmp(&results[0], &scalar[0], MATHBENCH_MATRICES * sizeof(MAT4)) != 0)
+		nMismatched++;
+	if (memcmp(&transformed[0], &reference[0], MATHBENCH_POINTS * sizeof(VEC3)) != 0)
+		nMismatched++;
+	g_nFailed += nMismatched;
+
+#if defined(VECMATH_AVX2)
+	const char* pPath = "AVX2";
+#elif defined(VECMATH_SSE)
+	const char* pPath = "SSE";
+#else
+	const char* pPath = "scalar";
+#endif
+	sprintf(line, "mathbench: %s kernels, %d of 2 batches differ from the scalar fallback\n", pPath, nMismatched);
+	MathBench_Report(line);
+
+	// each batch fits in L2, so this is the arithmetic and not the memory
+	const int nRepeats = 200;
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for (int r = 0; r < nRepeats; r++)
+		Mat4_MultiplyArray(&results[0], &worlds[0], viewProj, MATHBENCH_MATRICES);
+	double fBatched = MathBench_Seconds(start);
+
+	start = std::chrono::steady_clock::now();
+	for (int r = 0; r < nRepeats; r++)
+		for (int i = 0; i < MATHBENCH_MATRICES; i++)
+			VecMath_MultiplyScalar(&scalar[i], worlds[i], viewProj);
+	double fScalar = MathBench_Seconds(start);
+
+	double nMatrices = (double)nRepeats * MATHBENCH_MATRICES;
+	sprintf(line, "mathbench: multiply %.2f ns per matrix, one by one %.2f ns (%.1fx)\n",
+		fBatched * 1e9 / nMatrices, fScalar * 1e9 / nMatrices, fScalar / fBatched);
+	MathBench_Report(line);
+
+	start = std::chrono::steady_clock::now();
+	for (int r = 0; r < nRepeats / 10; r++)
+		Vec3_TransformCoordArray(&transformed[0], sizeof(VEC3), &points[0], sizeof(VEC3), viewProj, MATHBENCH_POINTS);
+	fBatched = MathBench_Seconds(start);
+
+	start = std::chrono::steady_clock::now();
+	for (int r = 0; r < nRepeats / 10; r++)
+		for (int i = 0; i < MATHBENCH_POINTS; i++)
+			reference[i] = MathBench_TransformScalar(points[i], viewProj);
+	fScalar = MathBench_Seconds(start);
+
+	double nPoints = (double)(nRepeats / 10) * MATHBENCH_POINTS;
+	sprintf(line, "mathbench: transform %.1f M points/s, one by one %.1f M points/s (%.1fx)\n",
+		nPoints / fBatched * 1e-6, nPoints / fScalar * 1e-6, fScalar / fBatched);
+	MathBench_Report(line);
+
+	// keeps the timed loops from being thrown away
+	if (results[1].m[0][0] != scalar[1].m[0][0] || transformed[1].x != reference[1].x)
+		g_nFailed++;
+
+	MathBench_Mesh();
+	MathBench_Instancing();
+	MathBench_VertexPipe();
+
+	sprintf(line, "mathbench: %d checks failed\n", g_nFailed);
+	MathBench_Report(line);
+	return g_nFailed;
+}
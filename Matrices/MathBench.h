@@ -0,0 +1,21 @@
+#pragma once
+
+// VecMath checks and timings.
+// Free of Windows like VecMath.h, so the same run works from the demo's
+// "-mathbench" mode and from a two line main() on any platform. The checks
+// compare the builders with values worked out from the D3DX formulas and
+// the SSE/AVX2 kernels with the scalar fallback, bit for bit; the timings
+// are the batched matrix multiplies and point transforms against calling
+// the scalar code once per item. The generated star mesh is compared with
+// the triangle list the demo used to have written out. The instanced stars
+// get the same treatment as the math: their stream layout is checked
+// against the vertex shader's arithmetic, and expanding them on the CPU is
+// timed with the bytes each way of drawing them uploads. The software
+// vertex pipeline is checked against a known point, a triangle clipped
+// against the near plane and its scalar version, and timed in vertices per
+// second for both vertex formats. Every line of the report goes through
+// the callback.
+
+typedef void (*MATHBENCHREPORT)(const char* pLine);
+
+int MathBench_Run(MATHBENCHREPORT pReport);    // returns the number of failed checks
@@ -16,16 +16,23 @@
 //       transform is the projection transform, which "projects" the 3D scene
 //       into our 2D viewport.
 //
-//       Note that in this tutorial, we are introducing the use of D3DX, which
-//       is a set of helper utilities for D3D. In this case, we are using some
-//       of D3DX's useful matrix initialization functions. To use D3DX, simply
-//       include <d3dx9.h> and link with d3dx9.lib.
+//       The matrices are built with VecMath.h, which follows the D3DX
+//       conventions (left handed, row vectors) but runs on any platform, so
+//       a MAT4 goes to SetTransform() as it is. Run with -mathbench to check
+//       it against the D3DX results and time its batched kernels, and with
+//       -swvp to do the vertex processing in VertexPipe.h instead of D3D.
 //
 // Copyright (c) Microsoft Corporation. All rights reserved.
 //-----------------------------------------------------------------------------
 #include <Windows.h>
 #include <mmsystem.h>
-#include <d3dx9.h>
+#include <d3d9.h>
+#include "VecMath.h"
+#include "Scene.h"
+#include "Mesh.h"
+#include "Instance.h"
+#include "VertexPipe.h"
+#include "MathBench.h"
 #pragma warning( disable : 4996 ) // disable deprecated warning 
 #include <strsafe.h>
 #pragma warning( default : 4996 )
@@ -39,8 +46,18 @@ float B = 0;
 //-----------------------------------------------------------------------------
 LPDIRECT3D9             g_pD3D = NULL; // Used to create the D3DDevice
 LPDIRECT3DDEVICE9       g_pd3dDevice = NULL; // Our rendering device
-LPDIRECT3DVERTEXBUFFER9 g_pVB01 = NULL; // Buffer to hold vertices
-LPDIRECT3DVERTEXBUFFER9 g_pVB02 = NULL;
+LPDIRECT3DVERTEXBUFFER9 g_pVB = NULL; // The star mesh, stream 0
+LPDIRECT3DINDEXBUFFER9  g_pIB = NULL; // Its indices, instanced draws are indexed
+LPDIRECT3DVERTEXBUFFER9 g_pInstanceVB = NULL; // An INSTANCE per star, stream 1
+LPDIRECT3DVERTEXDECLARATION9 g_pDecl = NULL; // Both streams, for the shaders
+LPDIRECT3DVERTEXSHADER9 g_pVS = NULL;
+LPDIRECT3DPIXELSHADER9  g_pPS = NULL;
+LPDIRECT3DVERTEXBUFFER9 g_pExpandVB = NULL; // Stars expanded on the CPU, when instancing is not there
+LPDIRECT3DINDEXBUFFER9  g_pBatchIB = NULL; // The mesh's indices once for every star of a batch
+LPDIRECT3DINDEXBUFFER9  g_pExpandIB = NULL; // The triangles VertexPipe_Cull() kept, with -swvp
+BOOL                    g_bInstancing = FALSE;
+BOOL                    g_bSoftwarePipe = FALSE; // -swvp: our own vertex processing
+VERTEXPIPE              g_Pipe; // View-projection and viewport for it
 
 // A structure for our custom vertex type
 struct CUSTOMVERTEX
@@ -52,6 +69,79 @@ struct CUSTOMVERTEX
 // Our custom FVF, which describes our custom vertex structure
 #define D3DFVF_CUSTOMVERTEX (D3DFVF_XYZ|D3DFVF_DIFFUSE)
 
+// What VertexPipe_Transform() makes of a CUSTOMVERTEX
+struct PIPEVERTEX
+{
+    FLOAT x, y, z, rhw; // The screen position
+    DWORD color;
+};
+
+#define D3DFVF_PIPEVERTEX (D3DFVF_XYZRHW|D3DFVF_DIFFUSE)
+
+// The star mesh: five points, white at the tips and the center and black at
+// the inner corners where each instance adds its color. InitGeometry()
+// generates it, 11 vertices and 30 indices where a list of triangles takes 30
+// vertices.
+#define STAR_POINTS 5
+#define STAR_VERTICES Mesh_StarVertices( STAR_POINTS )
+#define STAR_INDICES Mesh_StarIndices( STAR_POINTS )
+
+MESHVERTEX g_StarVertices[STAR_VERTICES];
+WORD g_StarIndices[STAR_INDICES];
+
+// Stream 0 is the mesh, stream 1 an INSTANCE per star (see Instance.h)
+D3DVERTEXELEMENT9 g_InstanceElements[] =
+{
+    { 0, 0, D3DDECLTYPE_FLOAT3, D3DDECLMETHOD_DEFAULT, D3DDECLUSAGE_POSITION, 0 },
+    { 0, 12, D3DDECLTYPE_D3DCOLOR, D3DDECLMETHOD_DEFAULT, D3DDECLUSAGE_COLOR, 0 },
+    { 1, 0, D3DDECLTYPE_FLOAT4, D3DDECLMETHOD_DEFAULT, D3DDECLUSAGE_TEXCOORD, 0 },
+    { 1, 16, D3DDECLTYPE_FLOAT4, D3DDECLMETHOD_DEFAULT, D3DDECLUSAGE_TEXCOORD, 1 },
+    { 1, 32, D3DDECLTYPE_FLOAT4, D3DDECLMETHOD_DEFAULT, D3DDECLUSAGE_TEXCOORD, 2 },
+    { 1, 48, D3DDECLTYPE_D3DCOLOR, D3DDECLMETHOD_DEFAULT, D3DDECLUSAGE_COLOR, 1 },
+    D3DDECL_END()
+};
+
+// How a star's world matrix follows A and B: the first grows with A, the
+// others move B along vMove and turn A about the axes in vTurn
+struct STAR
+{
+    BOOL bGrow;
+    VEC3 vMove;
+    VEC3 vTurn;
+    DWORD color;
+    int node;           // in g_Scene
+};
+
+#define NUM_STARS 9
+#define MAX_STARS 100000    // with the still ones -stars N adds
+#define EXPAND_BATCH 1024   // stars per draw when expanding on the CPU
+
+static_assert( Mesh_Fits16( EXPAND_BATCH * STAR_VERTICES ), "a batch of stars needs 16 bit indices" );
+// With -swvp a batch also holds what clipping against the near plane adds
+#define PIPE_TRIANGLES ( EXPAND_BATCH * STAR_INDICES / 3 )
+#define PIPE_VERTICES ( EXPAND_BATCH * STAR_VERTICES + VertexPipe_ClipVertices( PIPE_TRIANGLES ) )
+static_assert( Mesh_Fits16( PIPE_VERTICES ), "a clipped batch of stars needs 16 bit indices" );
+
+SCENE g_Scene;
+STAR g_Stars[NUM_STARS] =
+{
+    { TRUE,  {  0.0f,  0.0f,  0.0f }, {  0.0f,  0.0f,  0.0f }, 0xff0000ff },
+    { FALSE, {  1.0f,  0.0f,  0.0f }, {  1.0f,  1.0f,  0.0f }, 0xffff0000 },
+    { FALSE, { -1.0f,  0.0f,  0.0f }, {  1.0f,  0.0f,  1.0f }, 0xffff0000 },
+    { FALSE, {  0.0f,  0.0f,  1.0f }, { -1.0f,  0.0f, -1.0f }, 0xffff0000 },
+    { FALSE, {  0.0f,  0.0f, -1.0f }, { -1.0f,  0.0f, -1.0f }, 0xffff0000 },
+    { FALSE, {  0.0f,  1.0f,  0.0f }, {  0.0f,  1.0f,  1.0f }, 0xffff0000 },
+    { FALSE, {  0.0f, -1.0f,  0.0f }, {  0.0f, -1.0f, -1.0f }, 0xffff0000 },
+    { FALSE, {  0.0f,  0.0f, -1.0f }, {  0.0f,  1.0f,  1.0f }, 0xffff0000 },
+    { FALSE, {  0.0f,  0.0f,  1.0f }, {  0.0f, -1.0f, -1.0f }, 0xffff0000 },
+};
+
+INSTANCE* g_pInstances = NULL; // The moving stars first, then the still ones
+int g_nStars = NUM_STARS;
+INSTANCEVERTEX* g_pExpanded = NULL; // A batch in world space, on the way into the pipeline
+BYTE* g_pClip = NULL; // And its clip codes
+WORD* g_pBatchIndices = NULL; // What g_pBatchIB holds, for VertexPipe_Cull()
+
 
 
 
@@ -98,120 +188,116 @@ HRESULT InitD3D( HWND hWnd )
 //-----------------------------------------------------------------------------
 HRESULT InitGeometry()
 {
-    // Initialize three vertices for rendering a triangle
-    CUSTOMVERTEX g_Vertices01[] =
-    {
-        {-0.224513988289793f, 0.309016994374947f, 0.0f, 0xffff0000, },
-        { 0.0f, 0.0f, 0.0f, 0xffffffff, },
-		{ 0.224513988289793f, 0.309016994374947f, 0.0f, 0xffff0000, },
-
-		{ 0.0f, 1.0f, 0.0f, 0xffffffff, },
-		{-0.224513988289793f, 0.309016994374947f, 0.0f, 0xffff0000, },
-		{ 0.224513988289793f, 0.309016994374947f, 0.0f, 0xffff0000, },
-
-		{ 0.224513988289793f, 0.309016994374947f, 0.0f, 0xffff0000, },
-		{ 0.0f, 0.0f, 0.0f, 0xffffffff, },
-		{ 0.36327126400268f, -0.118033988749895f, 0.0f, 0xffff0000, },
-
-		{ 0.951056516295154f, 0.3090169943374947f, 0.0f, 0xffffffff, },
-		{ 0.224513988289793f, 0.309016994374947f, 0.0f, 0xffff0000, },
-		{ 0.36327126400268f, -0.118033988749895f, 0.0f, 0xffff0000, },
-
-		{ 0.36327126400268f, -0.118033988749895f, 0.0f, 0xffff0000, },
-		{ 0.0f, 0.0f, 0.0f, 0xffffffff, },
-		{ 0.0f, -0.381966011250105f, 0.0f, 0xffff0000, },
-
-		{ 0.587785252292473f, -0.809016994374948f, 0.0f, 0xffffffff, },
-		{ 0.36327126400268f, -0.118033988749895f, 0.0f, 0xffff0000, },
-		{ 0.0f, -0.381966011250105f, 0.0f, 0xffff0000, },
-		
-		{ 0.0f, -0.381966011250105f, 0.0f, 0xffff0000, },
-		{ 0.0f, 0.0f, 0.0f, 0xffffffff, },
-		{-0.36327126400268f, -0.118033988749895f, 0.0f, 0xffff0000, },
-
-		{-0.587785252292473f, -0.809016994374947f, 0.0f, 0xffffffff, },
-		{ 0.0f, -0.381966011250105f, 0.0f, 0xffff0000, },
-		{-0.36327126400268f, -0.118033988749895f, 0.0f, 0xffff0000, },
-
-		{-0.36327126400268f, -0.118033988749895f, 0.0f, 0xffff0000, },
-		{ 0.0f, 0.0f, 0.0f, 0xffffffff, },
-		{-0.224513988289793f, 0.309016994374947f, 0.0f, 0xffff0000, },
-
-		{-0.951056516295154f, 0.309016994374948f, 0.0f, 0xffffffff, },
-		{-0.36327126400268f, -0.118033988749895f, 0.0f, 0xffff0000, },
-		{-0.224513988289793f, 0.309016994374947f, 0.0f, 0xffff0000, },
-    };
-
-	CUSTOMVERTEX g_Vertices02[] =
-	{
-		{ -0.224513988289793f, 0.309016994374947f, 0.0f, 0xff0000ff, },
-		{ 0.0f, 0.0f, 0.0f, 0xffffffff, },
-		{ 0.224513988289793f, 0.309016994374947f, 0.0f, 0xff0000ff, },
-
-		{ 0.0f, 1.0f, 0.0f, 0xffffffff, },
-		{ -0.224513988289793f, 0.309016994374947f, 0.0f, 0xff0000ff, },
-		{ 0.224513988289793f, 0.309016994374947f, 0.0f, 0xff0000ff, },
-
-		{ 0.224513988289793f, 0.309016994374947f, 0.0f, 0xff0000ff, },
-		{ 0.0f, 0.0f, 0.0f, 0xffffffff, },
-		{ 0.36327126400268f, -0.118033988749895f, 0.0f, 0xff0000ff, },
-
-		{ 0.951056516295154f, 0.3090169943374947f, 0.0f, 0xffffffff, },
-		{ 0.224513988289793f, 0.309016994374947f, 0.0f, 0xff0000ff, },
-		{ 0.36327126400268f, -0.118033988749895f, 0.0f, 0xff0000ff, },
-
-		{ 0.36327126400268f, -0.118033988749895f, 0.0f, 0xff0000ff, },
-		{ 0.0f, 0.0f, 0.0f, 0xffffffff, },
-		{ 0.0f, -0.381966011250105f, 0.0f, 0xff0000ff, },
-
-		{ 0.587785252292473f, -0.809016994374948f, 0.0f, 0xffffffff, },
-		{ 0.36327126400268f, -0.118033988749895f, 0.0f, 0xff0000ff, },
-		{ 0.0f, -0.381966011250105f, 0.0f, 0xff0000ff, },
-
-		{ 0.0f, -0.381966011250105f, 0.0f, 0xff0000ff, },
-		{ 0.0f, 0.0f, 0.0f, 0xffffffff, },
-		{ -0.36327126400268f, -0.118033988749895f, 0.0f, 0xff0000ff, },
-
-		{ -0.587785252292473f, -0.809016994374947f, 0.0f, 0xffffffff, },
-		{ 0.0f, -0.381966011250105f, 0.0f, 0xff0000ff, },
-		{ -0.36327126400268f, -0.118033988749895f, 0.0f, 0xff0000ff, },
-
-		{ -0.36327126400268f, -0.118033988749895f, 0.0f, 0xff0000ff, },
-		{ 0.0f, 0.0f, 0.0f, 0xffffffff, },
-		{ -0.224513988289793f, 0.309016994374947f, 0.0f, 0xff0000ff, },
-
-		{ -0.951056516295154f, 0.309016994374948f, 0.0f, 0xffffffff, },
-		{ -0.36327126400268f, -0.118033988749895f, 0.0f, 0xff0000ff, },
-		{ -0.224513988289793f, 0.309016994374947f, 0.0f, 0xff0000ff, },
-	};
+    // Generate the star mesh. A regular pentagram's inner corners are
+    // cos( 2pi/5 ) / cos( pi/5 ) from the center.
+    MESH mesh;
+    Mesh_Init( &mesh, g_StarVertices, STAR_VERTICES, g_StarIndices, sizeof( WORD ), STAR_INDICES );
+    if( !Mesh_Star( &mesh, STAR_POINTS, 1.0f, 0.381966011f, 0xffffffff, 0xff000000 ) )
+        return E_FAIL;
 
     // Create the vertex buffer.
-    if( FAILED( g_pd3dDevice->CreateVertexBuffer( 30 * sizeof( CUSTOMVERTEX ),
+    if( FAILED( g_pd3dDevice->CreateVertexBuffer( STAR_VERTICES * sizeof( CUSTOMVERTEX ),
                                                   0, D3DFVF_CUSTOMVERTEX,
-                                                  D3DPOOL_DEFAULT, &g_pVB01, NULL ) ) )
+                                                  D3DPOOL_DEFAULT, &g_pVB, NULL ) ) )
     {
         return E_FAIL;
     }
 
-	if (FAILED(g_pd3dDevice->CreateVertexBuffer(30 * sizeof(CUSTOMVERTEX),
-												0, D3DFVF_CUSTOMVERTEX,
-												D3DPOOL_DEFAULT, &g_pVB02, NULL)))
-	{
-		return E_FAIL;
-	}
-
     // Fill the vertex buffer.
-    VOID* pVertices01;
-    if( FAILED( g_pVB01->Lock( 0, sizeof( g_Vertices01 ), ( void** )&pVertices01, 0 ) ) )
+    VOID* pVertices;
+    if( FAILED( g_pVB->Lock( 0, sizeof( g_StarVertices ), ( void** )&pVertices, 0 ) ) )
         return E_FAIL;
-    memcpy( pVertices01, g_Vertices01, sizeof( g_Vertices01 ) );
-    g_pVB01->Unlock();
+    memcpy( pVertices, g_StarVertices, sizeof( g_StarVertices ) );
+    g_pVB->Unlock();
+
+    // And the index buffer
+    WORD* pIndices;
+    if( FAILED( g_pd3dDevice->CreateIndexBuffer( sizeof( g_StarIndices ), 0, D3DFMT_INDEX16,
+                                                 D3DPOOL_DEFAULT, &g_pIB, NULL ) ) ||
+        FAILED( g_pIB->Lock( 0, 0, ( void** )&pIndices, 0 ) ) )
+        return E_FAIL;
+    memcpy( pIndices, g_StarIndices, sizeof( g_StarIndices ) );
+    g_pIB->Unlock();
+
+    // One INSTANCE per star. The moving ones are rewritten when the scene
+    // recomposes them; the still ones are placed here once.
+    g_pInstances = new INSTANCE[g_nStars]();
+    unsigned int nSeed = 1;
+    for( int i = NUM_STARS; i < g_nStars; i++ )
+    {
+        static const DWORD colors[] = { 0xffff0000, 0xff00ff00, 0xff0000ff, 0xffffff00, 0xff00ffff, 0xffff00ff };
+        float fRandom[4];
+        for( int j = 0; j < 4; j++ )
+        {
+            nSeed = nSeed * 1664525u + 1013904223u;
+            fRandom[j] = ( nSeed >> 8 ) / 16777216.0f;
+        }
+
+        MAT4 matWorld, matTurn;
+        Mat4_Scaling( &matWorld, 0.15f, 0.15f, 0.15f );
+        Mat4_RotationZ( &matTurn, fRandom[3] * 2 * VECMATH_PI );
+        Mat4_Multiply( &matWorld, matWorld, matTurn );
+        matWorld.m[3][0] = fRandom[0] * 24.0f - 12.0f;
+        matWorld.m[3][1] = fRandom[1] * 16.0f - 6.0f;
+        matWorld.m[3][2] = fRandom[2] * 40.0f + 2.0f;
+        Instance_Set( &g_pInstances[i], matWorld, colors[( nSeed >> 16 ) % 6] );
+    }
+
+    if( FAILED( g_pd3dDevice->CreateVertexBuffer( g_nStars * sizeof( INSTANCE ), D3DUSAGE_WRITEONLY, 0,
+                                                  D3DPOOL_MANAGED, &g_pInstanceVB, NULL ) ) )
+        return E_FAIL;
+    VOID* pInstances;
+    if( FAILED( g_pInstanceVB->Lock( 0, 0, &pInstances, 0 ) ) )
+        return E_FAIL;
+    memcpy( pInstances, g_pInstances, g_nStars * sizeof( INSTANCE ) );
+    g_pInstanceVB->Unlock();
+
+    // vs_3_0 needs ps_3_0 next to it. Without them the stars are expanded
+    // on the CPU by the same code the shader mirrors, in batches.
+    D3DCAPS9 caps;
+    g_pd3dDevice->GetDeviceCaps( &caps );
+    g_bInstancing = !g_bSoftwarePipe && caps.PixelShaderVersion >= D3DPS_VERSION( 3, 0 ) &&
+                    SUCCEEDED( g_pd3dDevice->CreateVertexDeclaration( g_InstanceElements, &g_pDecl ) ) &&
+                    SUCCEEDED( g_pd3dDevice->CreateVertexShader( ( const DWORD* )g_InstanceShader, &g_pVS ) ) &&
+                    SUCCEEDED( g_pd3dDevice->CreatePixelShader( ( const DWORD* )g_InstancePixelShader, &g_pPS ) );
+    // An expanded batch is drawn with the mesh's indices repeated for each
+    // star, offset by the star's first vertex
+    if( !g_bInstancing )
+    {
+        g_pBatchIndices = new WORD[EXPAND_BATCH * STAR_INDICES];
+        for( int i = 0; i < EXPAND_BATCH; i++ )
+            for( int j = 0; j < STAR_INDICES; j++ )
+                g_pBatchIndices[i * STAR_INDICES + j] = ( WORD )( i * STAR_VERTICES + g_StarIndices[j] );
+    }
+    if( !g_bInstancing && !g_bSoftwarePipe )
+    {
+        if( FAILED( g_pd3dDevice->CreateVertexBuffer( EXPAND_BATCH * STAR_VERTICES * sizeof( CUSTOMVERTEX ),
+                                                      D3DUSAGE_DYNAMIC | D3DUSAGE_WRITEONLY, D3DFVF_CUSTOMVERTEX,
+                                                      D3DPOOL_DEFAULT, &g_pExpandVB, NULL ) ) ||
+            FAILED( g_pd3dDevice->CreateIndexBuffer( EXPAND_BATCH * STAR_INDICES * sizeof( WORD ),
+                                                     D3DUSAGE_WRITEONLY, D3DFMT_INDEX16,
+                                                     D3DPOOL_DEFAULT, &g_pBatchIB, NULL ) ) ||
+            FAILED( g_pBatchIB->Lock( 0, 0, ( void** )&pIndices, 0 ) ) )
+            return E_FAIL;
+        memcpy( pIndices, g_pBatchIndices, EXPAND_BATCH * STAR_INDICES * sizeof( WORD ) );
+        g_pBatchIB->Unlock();
+    }
 
-	VOID* pVertices02;
-	if (FAILED(g_pVB02->Lock(0, sizeof(g_Vertices02), (void**)&pVertices02, 0)))
-		return E_FAIL;
-	memcpy(pVertices02, g_Vertices02, sizeof(g_Vertices02));
-	g_pVB02->Unlock();
+    // With -swvp the expanded batch goes through VertexPipe_Transform() into
+    // screen space, and only the triangles VertexPipe_Cull() keeps or clips
+    // are drawn
+    if( g_bSoftwarePipe )
+    {
+        if( FAILED( g_pd3dDevice->CreateVertexBuffer( PIPE_VERTICES * sizeof( PIPEVERTEX ),
+                                                      D3DUSAGE_DYNAMIC | D3DUSAGE_WRITEONLY, D3DFVF_PIPEVERTEX,
+                                                      D3DPOOL_DEFAULT, &g_pExpandVB, NULL ) ) ||
+            FAILED( g_pd3dDevice->CreateIndexBuffer( VertexPipe_ClipIndices( PIPE_TRIANGLES ) * sizeof( WORD ),
+                                                     D3DUSAGE_DYNAMIC | D3DUSAGE_WRITEONLY, D3DFMT_INDEX16,
+                                                     D3DPOOL_DEFAULT, &g_pExpandIB, NULL ) ) )
+            return E_FAIL;
+        g_pExpanded = new INSTANCEVERTEX[EXPAND_BATCH * STAR_VERTICES];
+        g_pClip = new BYTE[EXPAND_BATCH * STAR_VERTICES];
+    }
 
     return S_OK;
 }
@@ -225,11 +311,37 @@ HRESULT InitGeometry()
 //-----------------------------------------------------------------------------
 VOID Cleanup()
 {
-    if( g_pVB01 != NULL )
-        g_pVB01->Release();
+    if( g_pVB != NULL )
+        g_pVB->Release();
+
+    if( g_pIB != NULL )
+        g_pIB->Release();
+
+    if( g_pInstanceVB != NULL )
+        g_pInstanceVB->Release();
+
+    if( g_pExpandVB != NULL )
+        g_pExpandVB->Release();
+
+    if( g_pBatchIB != NULL )
+        g_pBatchIB->Release();
+
+    if( g_pExpandIB != NULL )
+        g_pExpandIB->Release();
+
+    if( g_pDecl != NULL )
+        g_pDecl->Release();
 
-	if (g_pVB02 != NULL)
-		g_pVB02->Release();
+    if( g_pVS != NULL )
+        g_pVS->Release();
+
+    if( g_pPS != NULL )
+        g_pPS->Release();
+
+    delete[] g_pInstances;
+    delete[] g_pExpanded;
+    delete[] g_pClip;
+    delete[] g_pBatchIndices;
 
     if( g_pd3dDevice != NULL )
         g_pd3dDevice->Release();
@@ -241,34 +353,37 @@ VOID Cleanup()
 
 
 //-----------------------------------------------------------------------------
-// Name: SetupMatrices()
-// Desc: Sets up the world, view, and projection transform Matrices.
+// Name: UpdateStars()
+// Desc: Feeds A and B into the star nodes. Only the nodes whose inputs
+//       changed are marked dirty, so nothing is recomposed until a key moves
+//       them.
 //-----------------------------------------------------------------------------
-VOID SetupMatrices01()
+VOID UpdateStars()
 {
-    // For our world matrix, we will just rotate the object about the y-axis.
-    D3DXMATRIXA16 matWorld;
+    for( int i = 0; i < NUM_STARS; i++ )
+    {
+        const STAR& star = g_Stars[i];
+        VEC3 vScale = star.bGrow ? Vec3( A / 10, A / 10, A / 10 ) : Vec3( 1.0f, 1.0f, 1.0f );
+        Scene_SetNode( &g_Scene, star.node, vScale, Vec3_Scale( star.vMove, B ), Vec3_Scale( star.vTurn, A ) );
+    }
+}
+
 
-    // Set up the rotation matrix to generate 1 full rotation (2*PI radians) 
-    // every 1000 ms. To avoid the loss of precision inherent in very high 
-    // floating point numbers, the system time is modulated by the rotation 
-    // period before conversion to a radian angle.
-    
-	D3DXMatrixScaling(&matWorld, A/10, A/10, A/10 );
 
-    g_pd3dDevice->SetTransform( D3DTS_WORLD, &matWorld );
-	
+
+//-----------------------------------------------------------------------------
+// Name: InitScene()
+// Desc: Sets up the camera once and adds a node for each star
+//-----------------------------------------------------------------------------
+VOID InitScene()
+{
+    Scene_Init( &g_Scene );
 
     // Set up our view matrix. A view matrix can be defined given an eye point,
     // a point to lookat, and a direction for which way is up. Here, we set the
     // eye five units back along the z-axis and up three units, look at the
     // origin, and define "up" to be in the y-direction.
-    D3DXVECTOR3 vEyePt( 0.0f, 3.0f,-5.0f );
-    D3DXVECTOR3 vLookatPt( 0.0f, 0.0f, 0.0f );
-    D3DXVECTOR3 vUpVec( 0.0f, 1.0f, 0.0f );
-    D3DXMATRIXA16 matView;
-    D3DXMatrixLookAtLH( &matView, &vEyePt, &vLookatPt, &vUpVec );
-    g_pd3dDevice->SetTransform( D3DTS_VIEW, &matView );
+    Scene_SetCamera( &g_Scene, Vec3( 0.0f, 3.0f, -5.0f ), Vec3( 0.0f, 0.0f, 0.0f ), Vec3( 0.0f, 1.0f, 0.0f ) );
 
     // For the projection matrix, we set up a perspective transform (which
     // transforms geometry from 3D view space to 2D viewport space, with
@@ -276,353 +391,147 @@ VOID SetupMatrices01()
     // a perpsective transform, we need the field of view (1/4 pi is common),
     // the aspect ratio, and the near and far clipping planes (which define at
     // what distances geometry should be no longer be rendered).
-    D3DXMATRIXA16 matProj;
-    D3DXMatrixPerspectiveFovLH( &matProj, D3DX_PI / 2, 1.0f, 1.0f, 100.0f );
-    g_pd3dDevice->SetTransform( D3DTS_PROJECTION, &matProj );
-}
+    Scene_SetProjection( &g_Scene, VECMATH_PI / 2, 1.0f, 1.0f, 100.0f );
 
-VOID SetupMatrices02()
-{
-	// For our world matrix, we will just rotate the object about the y-axis.
-	D3DXMATRIXA16 matWorld01;
-	D3DXMATRIXA16 matWorld02;
-	D3DXMATRIXA16 matWorld03;
-
-	// Set up the rotation matrix to generate 1 full rotation (2*PI radians) 
-	// every 1000 ms. To avoid the loss of precision inherent in very high 
-	// floating point numbers, the system time is modulated by the rotation 
-	// period before conversion to a radian angle.
-
-	D3DXMatrixTranslation(&matWorld01, B, 0.0f, 0.0f);
-	D3DXMatrixRotationX(&matWorld02, A);
-	D3DXMatrixRotationY(&matWorld03, A);
-	D3DXMatrixMultiply(&matWorld02, &matWorld02, &matWorld03);
-	D3DXMatrixMultiply(&matWorld01, &matWorld01, &matWorld02);
-	
-	g_pd3dDevice->SetTransform(D3DTS_WORLD, &matWorld01);
-
-
-	// Set up our view matrix. A view matrix can be defined given an eye point,
-	// a point to lookat, and a direction for which way is up. Here, we set the
-	// eye five units back along the z-axis and up three units, look at the
-	// origin, and define "up" to be in the y-direction.
-	D3DXVECTOR3 vEyePt(0.0f, 3.0f, -5.0f);
-	D3DXVECTOR3 vLookatPt(0.0f, 0.0f, 0.0f);
-	D3DXVECTOR3 vUpVec(0.0f, 1.0f, 0.0f);
-	D3DXMATRIXA16 matView;
-	D3DXMatrixLookAtLH(&matView, &vEyePt, &vLookatPt, &vUpVec);
-	g_pd3dDevice->SetTransform(D3DTS_VIEW, &matView);
-
-	// For the projection matrix, we set up a perspective transform (which
-	// transforms geometry from 3D view space to 2D viewport space, with
-	// a perspective divide making objects smaller in the distance). To build
-	// a perpsective transform, we need the field of view (1/4 pi is common),
-	// the aspect ratio, and the near and far clipping planes (which define at
-	// what distances geometry should be no longer be rendered).
-	D3DXMATRIXA16 matProj;
-	D3DXMatrixPerspectiveFovLH(&matProj, D3DX_PI / 2, 1.0f, 1.0f, 100.0f);
-	g_pd3dDevice->SetTransform(D3DTS_PROJECTION, &matProj);
+    for( int i = 0; i < NUM_STARS; i++ )
+        g_Stars[i].node = Scene_AddNode( &g_Scene, -1 );
+    UpdateStars();
 }
 
-VOID SetupMatrices03()
-{
-	// For our world matrix, we will just rotate the object about the y-axis.
-	D3DXMATRIXA16 matWorld01;
-	D3DXMATRIXA16 matWorld02;
-	D3DXMATRIXA16 matWorld03;
-
-	// Set up the rotation matrix to generate 1 full rotation (2*PI radians) 
-	// every 1000 ms. To avoid the loss of precision inherent in very high 
-	// floating point numbers, the system time is modulated by the rotation 
-	// period before conversion to a radian angle.
-
-	D3DXMatrixTranslation(&matWorld01, -B, 0.0f, 0.0f);
-	D3DXMatrixRotationX(&matWorld02, A);
-	D3DXMatrixRotationZ(&matWorld03, A);
-	D3DXMatrixMultiply(&matWorld02, &matWorld02, &matWorld03);
-	D3DXMatrixMultiply(&matWorld01, &matWorld01, &matWorld02);
-	
-	g_pd3dDevice->SetTransform(D3DTS_WORLD, &matWorld01);
-
-
-	// Set up our view matrix. A view matrix can be defined given an eye point,
-	// a point to lookat, and a direction for which way is up. Here, we set the
-	// eye five units back along the z-axis and up three units, look at the
-	// origin, and define "up" to be in the y-direction.
-	D3DXVECTOR3 vEyePt(0.0f, 3.0f, -5.0f);
-	D3DXVECTOR3 vLookatPt(0.0f, 0.0f, 0.0f);
-	D3DXVECTOR3 vUpVec(0.0f, 1.0f, 0.0f);
-	D3DXMATRIXA16 matView;
-	D3DXMatrixLookAtLH(&matView, &vEyePt, &vLookatPt, &vUpVec);
-	g_pd3dDevice->SetTransform(D3DTS_VIEW, &matView);
-
-	// For the projection matrix, we set up a perspective transform (which
-	// transforms geometry from 3D view space to 2D viewport space, with
-	// a perspective divide making objects smaller in the distance). To build
-	// a perpsective transform, we need the field of view (1/4 pi is common),
-	// the aspect ratio, and the near and far clipping planes (which define at
-	// what distances geometry should be no longer be rendered).
-	D3DXMATRIXA16 matProj;
-	D3DXMatrixPerspectiveFovLH(&matProj, D3DX_PI / 2, 1.0f, 1.0f, 100.0f);
-	g_pd3dDevice->SetTransform(D3DTS_PROJECTION, &matProj);
-}
 
-VOID SetupMatrices04()
-{
-	// For our world matrix, we will just rotate the object about the y-axis.
-	D3DXMATRIXA16 matWorld01;
-	D3DXMATRIXA16 matWorld02;
-	D3DXMATRIXA16 matWorld03;
-
-	// Set up the rotation matrix to generate 1 full rotation (2*PI radians) 
-	// every 1000 ms. To avoid the loss of precision inherent in very high 
-	// floating point numbers, the system time is modulated by the rotation 
-	// period before conversion to a radian angle.
-
-	D3DXMatrixTranslation(&matWorld01, 0.0f, 0.0f, B);
-	D3DXMatrixRotationX(&matWorld02, -A);
-	D3DXMatrixRotationZ(&matWorld03, -A);
-	D3DXMatrixMultiply(&matWorld02, &matWorld02, &matWorld03);
-	D3DXMatrixMultiply(&matWorld01, &matWorld01, &matWorld02);
-
-	g_pd3dDevice->SetTransform(D3DTS_WORLD, &matWorld01);
-
-
-	// Set up our view matrix. A view matrix can be defined given an eye point,
-	// a point to lookat, and a direction for which way is up. Here, we set the
-	// eye five units back along the z-axis and up three units, look at the
-	// origin, and define "up" to be in the y-direction.
-	D3DXVECTOR3 vEyePt(0.0f, 3.0f, -5.0f);
-	D3DXVECTOR3 vLookatPt(0.0f, 0.0f, 0.0f);
-	D3DXVECTOR3 vUpVec(0.0f, 1.0f, 0.0f);
-	D3DXMATRIXA16 matView;
-	D3DXMatrixLookAtLH(&matView, &vEyePt, &vLookatPt, &vUpVec);
-	g_pd3dDevice->SetTransform(D3DTS_VIEW, &matView);
-
-	// For the projection matrix, we set up a perspective transform (which
-	// transforms geometry from 3D view space to 2D viewport space, with
-	// a perspective divide making objects smaller in the distance). To build
-	// a perpsective transform, we need the field of view (1/4 pi is common),
-	// the aspect ratio, and the near and far clipping planes (which define at
-	// what distances geometry should be no longer be rendered).
-	D3DXMATRIXA16 matProj;
-	D3DXMatrixPerspectiveFovLH(&matProj, D3DX_PI / 2, 1.0f, 1.0f, 100.0f);
-	g_pd3dDevice->SetTransform(D3DTS_PROJECTION, &matProj);
-}
 
-VOID SetupMatrices05()
-{
-	// For our world matrix, we will just rotate the object about the y-axis.
-	D3DXMATRIXA16 matWorld01;
-	D3DXMATRIXA16 matWorld02;
-	D3DXMATRIXA16 matWorld03;
-
-	// Set up the rotation matrix to generate 1 full rotation (2*PI radians) 
-	// every 1000 ms. To avoid the loss of precision inherent in very high 
-	// floating point numbers, the system time is modulated by the rotation 
-	// period before conversion to a radian angle.
-
-	D3DXMatrixTranslation(&matWorld01, 0.0f, 0.0f, -B );
-	D3DXMatrixRotationX(&matWorld02, -A);
-	D3DXMatrixRotationZ(&matWorld03, -A);
-	D3DXMatrixMultiply(&matWorld02, &matWorld02, &matWorld03);
-	D3DXMatrixMultiply(&matWorld01, &matWorld01, &matWorld02);
-
-	g_pd3dDevice->SetTransform(D3DTS_WORLD, &matWorld01);
-
-
-	// Set up our view matrix. A view matrix can be defined given an eye point,
-	// a point to lookat, and a direction for which way is up. Here, we set the
-	// eye five units back along the z-axis and up three units, look at the
-	// origin, and define "up" to be in the y-direction.
-	D3DXVECTOR3 vEyePt(0.0f, 3.0f, -5.0f);
-	D3DXVECTOR3 vLookatPt(0.0f, 0.0f, 0.0f);
-	D3DXVECTOR3 vUpVec(0.0f, 1.0f, 0.0f);
-	D3DXMATRIXA16 matView;
-	D3DXMatrixLookAtLH(&matView, &vEyePt, &vLookatPt, &vUpVec);
-	g_pd3dDevice->SetTransform(D3DTS_VIEW, &matView);
-
-	// For the projection matrix, we set up a perspective transform (which
-	// transforms geometry from 3D view space to 2D viewport space, with
-	// a perspective divide making objects smaller in the distance). To build
-	// a perpsective transform, we need the field of view (1/4 pi is common),
-	// the aspect ratio, and the near and far clipping planes (which define at
-	// what distances geometry should be no longer be rendered).
-	D3DXMATRIXA16 matProj;
-	D3DXMatrixPerspectiveFovLH(&matProj, D3DX_PI / 2, 1.0f, 1.0f, 100.0f);
-	g_pd3dDevice->SetTransform(D3DTS_PROJECTION, &matProj);
-}
 
-VOID SetupMatrices06()
+//-----------------------------------------------------------------------------
+// Name: SetupMatrices()
+// Desc: Recomposes the world matrices that changed and copies them into the
+//       instance stream. When the camera moved, view times projection goes
+//       to the shader's constants, or with the fixed function pipeline to
+//       the projection transform with an identity world and view, so D3D
+//       gets the camera once per change instead of once per star. With
+//       -swvp it goes to the software pipeline with the viewport instead.
+//-----------------------------------------------------------------------------
+VOID SetupMatrices()
 {
-	// For our world matrix, we will just rotate the object about the y-axis.
-	D3DXMATRIXA16 matWorld01;
-	D3DXMATRIXA16 matWorld02;
-	D3DXMATRIXA16 matWorld03;
-
-	// Set up the rotation matrix to generate 1 full rotation (2*PI radians) 
-	// every 1000 ms. To avoid the loss of precision inherent in very high 
-	// floating point numbers, the system time is modulated by the rotation 
-	// period before conversion to a radian angle.
-
-	D3DXMatrixTranslation(&matWorld01, 0.0f, B, 0.0f);
-	D3DXMatrixRotationY(&matWorld02, A);
-	D3DXMatrixRotationZ(&matWorld03, A);
-	D3DXMatrixMultiply(&matWorld02, &matWorld02, &matWorld03);
-	D3DXMatrixMultiply(&matWorld01, &matWorld01, &matWorld02);
-
-	g_pd3dDevice->SetTransform(D3DTS_WORLD, &matWorld01);
-
-
-	// Set up our view matrix. A view matrix can be defined given an eye point,
-	// a point to lookat, and a direction for which way is up. Here, we set the
-	// eye five units back along the z-axis and up three units, look at the
-	// origin, and define "up" to be in the y-direction.
-	D3DXVECTOR3 vEyePt(0.0f, 3.0f, -5.0f);
-	D3DXVECTOR3 vLookatPt(0.0f, 0.0f, 0.0f);
-	D3DXVECTOR3 vUpVec(0.0f, 1.0f, 0.0f);
-	D3DXMATRIXA16 matView;
-	D3DXMatrixLookAtLH(&matView, &vEyePt, &vLookatPt, &vUpVec);
-	g_pd3dDevice->SetTransform(D3DTS_VIEW, &matView);
-
-	// For the projection matrix, we set up a perspective transform (which
-	// transforms geometry from 3D view space to 2D viewport space, with
-	// a perspective divide making objects smaller in the distance). To build
-	// a perpsective transform, we need the field of view (1/4 pi is common),
-	// the aspect ratio, and the near and far clipping planes (which define at
-	// what distances geometry should be no longer be rendered).
-	D3DXMATRIXA16 matProj;
-	D3DXMatrixPerspectiveFovLH(&matProj, D3DX_PI / 2, 1.0f, 1.0f, 100.0f);
-	g_pd3dDevice->SetTransform(D3DTS_PROJECTION, &matProj);
-}
+    BOOL bCamera = Scene_Update( &g_Scene );
 
-VOID SetupMatrices07()
-{
-	// For our world matrix, we will just rotate the object about the y-axis.
-	D3DXMATRIXA16 matWorld01;
-	D3DXMATRIXA16 matWorld02;
-	D3DXMATRIXA16 matWorld03;
-
-	// Set up the rotation matrix to generate 1 full rotation (2*PI radians) 
-	// every 1000 ms. To avoid the loss of precision inherent in very high 
-	// floating point numbers, the system time is modulated by the rotation 
-	// period before conversion to a radian angle.
-
-	D3DXMatrixTranslation(&matWorld01, 0.0f, -B, 0.0f);
-	D3DXMatrixRotationY(&matWorld02, -A);
-	D3DXMatrixRotationZ(&matWorld03, -A);
-	D3DXMatrixMultiply(&matWorld02, &matWorld02, &matWorld03);
-	D3DXMatrixMultiply(&matWorld01, &matWorld01, &matWorld02);
-
-	g_pd3dDevice->SetTransform(D3DTS_WORLD, &matWorld01);
-
-
-	// Set up our view matrix. A view matrix can be defined given an eye point,
-	// a point to lookat, and a direction for which way is up. Here, we set the
-	// eye five units back along the z-axis and up three units, look at the
-	// origin, and define "up" to be in the y-direction.
-	D3DXVECTOR3 vEyePt(0.0f, 3.0f, -5.0f);
-	D3DXVECTOR3 vLookatPt(0.0f, 0.0f, 0.0f);
-	D3DXVECTOR3 vUpVec(0.0f, 1.0f, 0.0f);
-	D3DXMATRIXA16 matView;
-	D3DXMatrixLookAtLH(&matView, &vEyePt, &vLookatPt, &vUpVec);
-	g_pd3dDevice->SetTransform(D3DTS_VIEW, &matView);
-
-	// For the projection matrix, we set up a perspective transform (which
-	// transforms geometry from 3D view space to 2D viewport space, with
-	// a perspective divide making objects smaller in the distance). To build
-	// a perpsective transform, we need the field of view (1/4 pi is common),
-	// the aspect ratio, and the near and far clipping planes (which define at
-	// what distances geometry should be no longer be rendered).
-	D3DXMATRIXA16 matProj;
-	D3DXMatrixPerspectiveFovLH(&matProj, D3DX_PI / 2, 1.0f, 1.0f, 100.0f);
-	g_pd3dDevice->SetTransform(D3DTS_PROJECTION, &matProj);
-}
+    if( g_Scene.stats.nComposed > 0 )
+    {
+        for( int i = 0; i < NUM_STARS; i++ )
+            Instance_Set( &g_pInstances[i], Scene_GetWorld( &g_Scene, g_Stars[i].node ), g_Stars[i].color );
 
-VOID SetupMatrices08()
-{
-	// For our world matrix, we will just rotate the object about the y-axis.
-	D3DXMATRIXA16 matWorld01;
-	D3DXMATRIXA16 matWorld02;
-	D3DXMATRIXA16 matWorld03;
-
-	// Set up the rotation matrix to generate 1 full rotation (2*PI radians) 
-	// every 1000 ms. To avoid the loss of precision inherent in very high 
-	// floating point numbers, the system time is modulated by the rotation 
-	// period before conversion to a radian angle.
-
-	D3DXMatrixTranslation(&matWorld01, 0.0f, 0.0f, -B);
-	D3DXMatrixRotationY(&matWorld02, A);
-	D3DXMatrixRotationZ(&matWorld03, A);
-	D3DXMatrixMultiply(&matWorld02, &matWorld02, &matWorld03);
-	D3DXMatrixMultiply(&matWorld01, &matWorld01, &matWorld02);
-
-	g_pd3dDevice->SetTransform(D3DTS_WORLD, &matWorld01);
-
-
-	// Set up our view matrix. A view matrix can be defined given an eye point,
-	// a point to lookat, and a direction for which way is up. Here, we set the
-	// eye five units back along the z-axis and up three units, look at the
-	// origin, and define "up" to be in the y-direction.
-	D3DXVECTOR3 vEyePt(0.0f, 3.0f, -5.0f);
-	D3DXVECTOR3 vLookatPt(0.0f, 0.0f, 0.0f);
-	D3DXVECTOR3 vUpVec(0.0f, 1.0f, 0.0f);
-	D3DXMATRIXA16 matView;
-	D3DXMatrixLookAtLH(&matView, &vEyePt, &vLookatPt, &vUpVec);
-	g_pd3dDevice->SetTransform(D3DTS_VIEW, &matView);
-
-	// For the projection matrix, we set up a perspective transform (which
-	// transforms geometry from 3D view space to 2D viewport space, with
-	// a perspective divide making objects smaller in the distance). To build
-	// a perpsective transform, we need the field of view (1/4 pi is common),
-	// the aspect ratio, and the near and far clipping planes (which define at
-	// what distances geometry should be no longer be rendered).
-	D3DXMATRIXA16 matProj;
-	D3DXMatrixPerspectiveFovLH(&matProj, D3DX_PI / 2, 1.0f, 1.0f, 100.0f);
-	g_pd3dDevice->SetTransform(D3DTS_PROJECTION, &matProj);
+        VOID* pInstances;
+        if( SUCCEEDED( g_pInstanceVB->Lock( 0, NUM_STARS * sizeof( INSTANCE ), &pInstances, 0 ) ) )
+        {
+            memcpy( pInstances, g_pInstances, NUM_STARS * sizeof( INSTANCE ) );
+            g_pInstanceVB->Unlock();
+        }
+    }
+
+    if( !bCamera )
+        return;
+
+    if( g_bSoftwarePipe )
+    {
+        D3DVIEWPORT9 vp;
+        g_pd3dDevice->GetViewport( &vp );
+        VertexPipe_Init( &g_Pipe, g_Scene.camera.viewProj, ( float )vp.X, ( float )vp.Y,
+                         ( float )vp.Width, ( float )vp.Height, vp.MinZ, vp.MaxZ );
+    }
+    else if( g_bInstancing )
+    {
+        MAT4 matViewProj;
+        Mat4_Transpose( &matViewProj, g_Scene.camera.viewProj );
+        g_pd3dDevice->SetVertexShaderConstantF( 0, matViewProj.m[0], 4 );
+    }
+    else
+    {
+        MAT4 matIdentity;
+        Mat4_Identity( &matIdentity );
+        g_pd3dDevice->SetTransform( D3DTS_WORLD, (D3DMATRIX*)&matIdentity );
+        g_pd3dDevice->SetTransform( D3DTS_VIEW, (D3DMATRIX*)&matIdentity );
+        g_pd3dDevice->SetTransform( D3DTS_PROJECTION, (const D3DMATRIX*)&g_Scene.camera.viewProj );
+    }
 }
 
-VOID SetupMatrices09()
+
+
+
+//-----------------------------------------------------------------------------
+// Name: DrawStars()
+// Desc: Draws every star with one instanced call, or expands them on the
+//       CPU a batch at a time; with -swvp the batches are also transformed
+//       and culled on the CPU and drawn already in screen space
+//-----------------------------------------------------------------------------
+VOID DrawStars()
 {
-	// For our world matrix, we will just rotate the object about the y-axis.
-	D3DXMATRIXA16 matWorld01;
-	D3DXMATRIXA16 matWorld02;
-	D3DXMATRIXA16 matWorld03;
-
-	// Set up the rotation matrix to generate 1 full rotation (2*PI radians) 
-	// every 1000 ms. To avoid the loss of precision inherent in very high 
-	// floating point numbers, the system time is modulated by the rotation 
-	// period before conversion to a radian angle.
-
-	D3DXMatrixTranslation(&matWorld01, 0.0f, 0.0f, B);
-	D3DXMatrixRotationY(&matWorld02, -A);
-	D3DXMatrixRotationZ(&matWorld03, -A);
-	D3DXMatrixMultiply(&matWorld02, &matWorld02, &matWorld03);
-	D3DXMatrixMultiply(&matWorld01, &matWorld01, &matWorld02);
-
-	g_pd3dDevice->SetTransform(D3DTS_WORLD, &matWorld01);
-
-
-	// Set up our view matrix. A view matrix can be defined given an eye point,
-	// a point to lookat, and a direction for which way is up. Here, we set the
-	// eye five units back along the z-axis and up three units, look at the
-	// origin, and define "up" to be in the y-direction.
-	D3DXVECTOR3 vEyePt(0.0f, 3.0f, -5.0f);
-	D3DXVECTOR3 vLookatPt(0.0f, 0.0f, 0.0f);
-	D3DXVECTOR3 vUpVec(0.0f, 1.0f, 0.0f);
-	D3DXMATRIXA16 matView;
-	D3DXMatrixLookAtLH(&matView, &vEyePt, &vLookatPt, &vUpVec);
-	g_pd3dDevice->SetTransform(D3DTS_VIEW, &matView);
-
-	// For the projection matrix, we set up a perspective transform (which
-	// transforms geometry from 3D view space to 2D viewport space, with
-	// a perspective divide making objects smaller in the distance). To build
-	// a perpsective transform, we need the field of view (1/4 pi is common),
-	// the aspect ratio, and the near and far clipping planes (which define at
-	// what distances geometry should be no longer be rendered).
-	D3DXMATRIXA16 matProj;
-	D3DXMatrixPerspectiveFovLH(&matProj, D3DX_PI / 2, 1.0f, 1.0f, 100.0f);
-	g_pd3dDevice->SetTransform(D3DTS_PROJECTION, &matProj);
+    if( g_bSoftwarePipe )
+    {
+        g_pd3dDevice->SetFVF( D3DFVF_PIPEVERTEX );
+        g_pd3dDevice->SetStreamSource( 0, g_pExpandVB, 0, sizeof( PIPEVERTEX ) );
+        g_pd3dDevice->SetIndices( g_pExpandIB );
+        for( int first = 0; first < g_nStars; first += EXPAND_BATCH )
+        {
+            int nCount = min( g_nStars - first, EXPAND_BATCH );
+            int nVertices = nCount * STAR_VERTICES;
+            Instance_Expand( g_pExpanded, ( const INSTANCEVERTEX* )g_StarVertices, STAR_VERTICES,
+                             g_pInstances + first, nCount );
+
+            // The clipped vertices go in behind the transformed ones, so the
+            // vertex buffer stays locked until the culling is done
+            VOID* pVertices;
+            WORD* pIndices;
+            int nTriangles = nCount * STAR_INDICES / 3;
+            if( FAILED( g_pExpandVB->Lock( 0, ( nVertices + VertexPipe_ClipVertices( nTriangles ) ) * sizeof( PIPEVERTEX ),
+                                           &pVertices, D3DLOCK_DISCARD ) ) )
+                return;
+            VertexPipe_Transform( &g_Pipe, pVertices, g_pExpanded, sizeof( INSTANCEVERTEX ), nVertices, g_pClip );
+            if( FAILED( g_pExpandIB->Lock( 0, VertexPipe_ClipIndices( nTriangles ) * sizeof( WORD ), ( void** )&pIndices, D3DLOCK_DISCARD ) ) )
+            {
+                g_pExpandVB->Unlock();
+                return;
+            }
+            int nDrawn = nVertices;
+            nTriangles = VertexPipe_Cull( &g_Pipe, g_pExpanded, sizeof( INSTANCEVERTEX ), pVertices, &nDrawn, PIPE_VERTICES,
+                                          pIndices, g_pClip, g_pBatchIndices, nTriangles, NULL );
+            g_pExpandIB->Unlock();
+            g_pExpandVB->Unlock();
+
+            if( nTriangles > 0 )
+                g_pd3dDevice->DrawIndexedPrimitive( D3DPT_TRIANGLELIST, 0, 0, nDrawn, 0, nTriangles );
+        }
+        return;
+    }
+
+    if( g_bInstancing )
+    {
+        g_pd3dDevice->SetVertexDeclaration( g_pDecl );
+        g_pd3dDevice->SetVertexShader( g_pVS );
+        g_pd3dDevice->SetPixelShader( g_pPS );
+        g_pd3dDevice->SetStreamSource( 0, g_pVB, 0, sizeof( CUSTOMVERTEX ) );
+        g_pd3dDevice->SetStreamSourceFreq( 0, D3DSTREAMSOURCE_INDEXEDDATA | g_nStars );
+        g_pd3dDevice->SetStreamSource( 1, g_pInstanceVB, 0, sizeof( INSTANCE ) );
+        g_pd3dDevice->SetStreamSourceFreq( 1, D3DSTREAMSOURCE_INSTANCEDATA | 1 );
+        g_pd3dDevice->SetIndices( g_pIB );
+        g_pd3dDevice->DrawIndexedPrimitive( D3DPT_TRIANGLELIST, 0, 0, STAR_VERTICES, 0, STAR_INDICES / 3 );
+        g_pd3dDevice->SetStreamSourceFreq( 0, 1 );
+        g_pd3dDevice->SetStreamSourceFreq( 1, 1 );
+        return;
+    }
+
+    g_pd3dDevice->SetFVF( D3DFVF_CUSTOMVERTEX );
+    g_pd3dDevice->SetStreamSource( 0, g_pExpandVB, 0, sizeof( CUSTOMVERTEX ) );
+    g_pd3dDevice->SetIndices( g_pBatchIB );
+    for( int first = 0; first < g_nStars; first += EXPAND_BATCH )
+    {
+        int nCount = min( g_nStars - first, EXPAND_BATCH );
+        VOID* pVertices;
+        if( FAILED( g_pExpandVB->Lock( 0, nCount * STAR_VERTICES * sizeof( CUSTOMVERTEX ), &pVertices, D3DLOCK_DISCARD ) ) )
+            return;
+        Instance_Expand( ( INSTANCEVERTEX* )pVertices, ( const INSTANCEVERTEX* )g_StarVertices, STAR_VERTICES,
+                         g_pInstances + first, nCount );
+        g_pExpandVB->Unlock();
+        g_pd3dDevice->DrawIndexedPrimitive( D3DPT_TRIANGLELIST, 0, 0, nCount * STAR_VERTICES, 0, nCount * STAR_INDICES / 3 );
+    }
 }
 
 //-----------------------------------------------------------------------------
@@ -638,59 +547,10 @@ VOID Render()
     if( SUCCEEDED( g_pd3dDevice->BeginScene() ) )
     {
         // Setup the world, view, and projection Matrices
-        SetupMatrices01();
-        // Render the vertex buffer contents
-        g_pd3dDevice->SetStreamSource( 0, g_pVB02, 0, sizeof( CUSTOMVERTEX ) );
-        g_pd3dDevice->SetFVF( D3DFVF_CUSTOMVERTEX );
-        g_pd3dDevice->DrawPrimitive( D3DPT_TRIANGLELIST, 0, 10 );
-
-		SetupMatrices02();
-		// Render the vertex buffer contents
-		g_pd3dDevice->SetStreamSource(0, g_pVB01, 0, sizeof(CUSTOMVERTEX));
-		g_pd3dDevice->SetFVF(D3DFVF_CUSTOMVERTEX);
-		g_pd3dDevice->DrawPrimitive(D3DPT_TRIANGLELIST, 0, 10);
-
-		SetupMatrices03();
-		// Render the vertex buffer contents
-		g_pd3dDevice->SetStreamSource(0, g_pVB01, 0, sizeof(CUSTOMVERTEX));
-		g_pd3dDevice->SetFVF(D3DFVF_CUSTOMVERTEX);
-		g_pd3dDevice->DrawPrimitive(D3DPT_TRIANGLELIST, 0, 10);
-
-		SetupMatrices04();
-		// Render the vertex buffer contents
-		g_pd3dDevice->SetStreamSource(0, g_pVB01, 0, sizeof(CUSTOMVERTEX));
-		g_pd3dDevice->SetFVF(D3DFVF_CUSTOMVERTEX);
-		g_pd3dDevice->DrawPrimitive(D3DPT_TRIANGLELIST, 0, 10);
-
-		SetupMatrices05();
-		// Render the vertex buffer contents
-		g_pd3dDevice->SetStreamSource(0, g_pVB01, 0, sizeof(CUSTOMVERTEX));
-		g_pd3dDevice->SetFVF(D3DFVF_CUSTOMVERTEX);
-		g_pd3dDevice->DrawPrimitive(D3DPT_TRIANGLELIST, 0, 10);
-
-		SetupMatrices06();
-		// Render the vertex buffer contents
-		g_pd3dDevice->SetStreamSource(0, g_pVB01, 0, sizeof(CUSTOMVERTEX));
-		g_pd3dDevice->SetFVF(D3DFVF_CUSTOMVERTEX);
-		g_pd3dDevice->DrawPrimitive(D3DPT_TRIANGLELIST, 0, 10);
-
-		SetupMatrices07();
-		// Render the vertex buffer contents
-		g_pd3dDevice->SetStreamSource(0, g_pVB01, 0, sizeof(CUSTOMVERTEX));
-		g_pd3dDevice->SetFVF(D3DFVF_CUSTOMVERTEX);
-		g_pd3dDevice->DrawPrimitive(D3DPT_TRIANGLELIST, 0, 10);
-
-		SetupMatrices08();
-		// Render the vertex buffer contents
-		g_pd3dDevice->SetStreamSource(0, g_pVB01, 0, sizeof(CUSTOMVERTEX));
-		g_pd3dDevice->SetFVF(D3DFVF_CUSTOMVERTEX);
-		g_pd3dDevice->DrawPrimitive(D3DPT_TRIANGLELIST, 0, 10);
-
-		SetupMatrices09();
-		// Render the vertex buffer contents
-		g_pd3dDevice->SetStreamSource(0, g_pVB01, 0, sizeof(CUSTOMVERTEX));
-		g_pd3dDevice->SetFVF(D3DFVF_CUSTOMVERTEX);
-		g_pd3dDevice->DrawPrimitive(D3DPT_TRIANGLELIST, 0, 10);
+        SetupMatrices();
+
+        // Render all the stars in one go
+        DrawStars();
 
         // End the scene
         g_pd3dDevice->EndScene();
@@ -714,6 +574,7 @@ LRESULT WINAPI MsgProc( HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam )
 		case WM_KEYDOWN:
 			A = A + 0.1f;
 			B = B + 0.01f;
+			UpdateStars();
 			return 0;
         case WM_DESTROY:
             Cleanup();
@@ -727,14 +588,36 @@ LRESULT WINAPI MsgProc( HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam )
 
 
 
+//-----------------------------------------------------------------------------
+// Name: ReportMathBench()
+// Desc: Sends a line of the -mathbench report to the debugger
+//-----------------------------------------------------------------------------
+VOID ReportMathBench( const char* pLine )
+{
+    OutputDebugStringA( pLine );
+}
+
+
+
+
 //-----------------------------------------------------------------------------
 // Name: WinMain()
 // Desc: The application's entry point
 //-----------------------------------------------------------------------------
-INT WINAPI wWinMain( HINSTANCE hInst, HINSTANCE, LPWSTR, INT )
+INT WINAPI wWinMain( HINSTANCE hInst, HINSTANCE, LPWSTR lpCmdLine, INT )
 {
     UNREFERENCED_PARAMETER( hInst );
 
+    // Check the math against the D3DX results and time it, no window needed
+    if( wcsstr( lpCmdLine, L"-mathbench" ) != NULL )
+        return MathBench_Run( ReportMathBench );
+
+    // -stars N draws N stars, still ones scattered behind the nine
+    const WCHAR* pStars = wcsstr( lpCmdLine, L"-stars" );
+    if( pStars != NULL )
+        g_nStars = max( NUM_STARS, min( _wtoi( pStars + 6 ), MAX_STARS ) );
+    g_bSoftwarePipe = wcsstr( lpCmdLine, L"-swvp" ) != NULL;
+
     // Register the window class
     WNDCLASSEX wc =
     {
@@ -755,6 +638,8 @@ INT WINAPI wWinMain( HINSTANCE hInst, HINSTANCE, LPWSTR, INT )
         // Create the scene geometry
         if( SUCCEEDED( InitGeometry() ) )
         {
+            InitScene();
+
             // Show the window
             ShowWindow( hWnd, SW_SHOWDEFAULT );
             UpdateWindow( hWnd );
@@ -0,0 +1,139 @@
+#include "Mesh.h"
+#include <math.h>
+
+void Mesh_Init(MESH* pMesh, MESHVERTEX* pVertices, int nMaxVertices, void* pIndices, int nIndexSize, int nMaxIndices)
+{
+	pMesh->pVertices = pVertices;
+	pMesh->pIndices = pIndices;
+	pMesh->nIndexSize = nIndexSize;
+	pMesh->nMaxVertices = nMaxVertices;
+	pMesh->nMaxIndices = nMaxIndices;
+	pMesh->nVertices = 0;
+	pMesh->nIndices = 0;
+}
+
+unsigned int Mesh_GetIndex(const MESH* pMesh, int i)
+{
+	if (pMesh->nIndexSize == 2)
+		return ((const unsigned short*)pMesh->pIndices)[i];
+	return ((const unsigned int*)pMesh->pIndices)[i];
+}
+
+static bool Mesh_HasRoom(const MESH* pMesh, int nVertices, int nIndices)
+{
+	int nTotal = pMesh->nVertices + nVertices;
+	return nTotal <= pMesh->nMaxVertices && pMesh->nIndices + nIndices <= pMesh->nMaxIndices &&
+		(pMesh->nIndexSize == 4 || Mesh_Fits16(nTotal));
+}
+
+static void Mesh_PutVertex(MESH* pMesh, float x, float y, unsigned int color)
+{
+	MESHVERTEX& v = pMesh->pVertices[pMesh->nVertices++];
+	v.x = x;
+	v.y = y;
+	v.z = 0.0f;
+	v.color = color;
+}
+
+static void Mesh_PutTriangle(MESH* pMesh, unsigned int a, unsigned int b, unsigned int c)
+{
+	unsigned int triangle[3] = { a, b, c };
+	for (int i = 0; i < 3; i++, pMesh->nIndices++)
+	{
+		if (pMesh->nIndexSize == 2)
+			((unsigned short*)pMesh->pIndices)[pMesh->nIndices] = (unsigned short)triangle[i];
+		else
+			((unsigned int*)pMesh->pIndices)[pMesh->nIndices] = triangle[i];
+	}
+}
+
+// the vertex fRadius from the center, step nSteps-ths of a turn clockwise from the top
+static void Mesh_PutRing(MESH* pMesh, float fRadius, double step, int nSteps, unsigned int color)
+{
+	const double PI = 3.14159265358979323846;
+	double angle = PI / 2 - step * 2 * PI / nSteps;
+	Mesh_PutVertex(pMesh, (float)(fRadius * cos(angle)), (float)(fRadius * sin(angle)), color);
+}
+
+//Mesh_Star() : tip k comes after the center, inner corner k is between tips k and k + 1
+bool Mesh_Star(MESH* pMesh, int nPoints, float fRadius, float fInnerRadius, unsigned int color, unsigned int innerColor)
+{
+	if (nPoints < 2 || Mesh_HasRoom(pMesh, Mesh_StarVertices(nPoints), Mesh_StarIndices(nPoints)) == false)
+		return false;
+
+	unsigned int center = pMesh->nVertices;
+	unsigned int tips = center + 1;
+	unsigned int corners = tips + nPoints;
+
+	Mesh_PutVertex(pMesh, 0.0f, 0.0f, color);
+	for (int k = 0; k < nPoints; k++)
+		Mesh_PutRing(pMesh, fRadius, k, nPoints, color);
+	for (int k = 0; k < nPoints; k++)
+		Mesh_PutRing(pMesh, fInnerRadius, k + 0.5, nPoints, innerColor);
+
+	for (int k = 0; k < nPoints; k++)
+	{
+		unsigned int before = corners + (k + nPoints - 1) % nPoints;
+		unsigned int after = corners + k;
+		Mesh_PutTriangle(pMesh, center, before, after);
+		Mesh_PutTriangle(pMesh, tips + k, after, before);
+	}
+
+	return true;
+}
+
+bool Mesh_Polygon(MESH* pMesh, int nSides, float fRadius, unsigned int color, unsigned int edgeColor)
+{
+	if (nSides < 3 || Mesh_HasRoom(pMesh, Mesh_PolygonVertices(nSides), Mesh_PolygonIndices(nSides)) == false)
+		return false;
+
+	unsigned int center = pMesh->nVertices;
+	unsigned int corners = center + 1;
+
+	Mesh_PutVertex(pMesh, 0.0f, 0.0f, color);
+	for (int k = 0; k < nSides; k++)
+		Mesh_PutRing(pMesh, fRadius, k, nSides, edgeColor);
+
+	for (int k = 0; k < nSides; k++)
+		Mesh_PutTriangle(pMesh, center, corners + k, corners + (k + 1) % nSides);
+
+	return true;
+}
+
+static bool Mesh_Equal(const MESHVERTEX& a, const MESHVERTEX& b)
+{
+	return a.x == b.x && a.y == b.y && a.z == b.z && a.color == b.color;
+}
+
+//Mesh_AddTriangleList() : the winding is kept as it is
+bool Mesh_AddTriangleList(MESH* pMesh, const MESHVERTEX* pVertices, int nVertices)
+{
+	int nOldVertices = pMesh->nVertices;
+	int nOldIndices = pMesh->nIndices;
+	if (Mesh_HasRoom(pMesh, 0, nVertices) == false)
+		return false;
+
+	unsigned int triangle[3];
+	for (int i = 0; i < nVertices; i++)
+	{
+		int found = 0;
+		while (found < pMesh->nVertices && Mesh_Equal(pMesh->pVertices[found], pVertices[i]) == false)
+			found++;
+		if (found == pMesh->nVertices)
+		{
+			if (Mesh_HasRoom(pMesh, 1, 0) == false)
+			{
+				pMesh->nVertices = nOldVertices;
+				pMesh->nIndices = nOldIndices;
+				return false;
+			}
+			pMesh->pVertices[pMesh->nVertices++] = pVertices[i];
+		}
+
+		triangle[i % 3] = found;
+		if (i % 3 == 2)
+			Mesh_PutTriangle(pMesh, triangle[0], triangle[1], triangle[2]);
+	}
+
+	return true;
+}
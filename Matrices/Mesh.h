@@ -0,0 +1,49 @@
+#pragma once
+
+// Indexed meshes.
+// The generators write each distinct vertex once and describe the triangles
+// with indices, 16 or 32 bits wide, into buffers the caller owns; several
+// primitives can go into the same buffers one after the other. Shapes lie
+// in the z = 0 plane around the origin, start at the top and go clockwise,
+// and their triangles wind clockwise, D3D's front face. Colors are
+// parameters, so one mesh serves every tint. The vertex and index counts
+// are constexpr, which lets a mesh's arrays be sized at compile time; the
+// positions need sines and cosines and are worked out at run time.
+// Mesh_AddTriangleList() welds a list of triangles without indices, such as
+// the tutorials' hand written arrays, comparing every vertex with the ones
+// already there, which is fine for meshes this small.
+
+// same layout as the demo's CUSTOMVERTEX (D3DFVF_XYZ|D3DFVF_DIFFUSE)
+struct MESHVERTEX
+{
+	float x, y, z;
+	unsigned int color;
+};
+
+struct MESH
+{
+	MESHVERTEX* pVertices;
+	void* pIndices;         // unsigned short or unsigned int, by nIndexSize
+	int nIndexSize;         // 2 or 4 bytes
+	int nMaxVertices;
+	int nMaxIndices;
+	int nVertices;          // written so far
+	int nIndices;
+};
+
+// a star is its center, the tips and the corners between them
+constexpr int Mesh_StarVertices(int nPoints) { return 2 * nPoints + 1; }
+constexpr int Mesh_StarIndices(int nPoints) { return 6 * nPoints; }
+// a polygon is its center and the corners
+constexpr int Mesh_PolygonVertices(int nSides) { return nSides + 1; }
+constexpr int Mesh_PolygonIndices(int nSides) { return 3 * nSides; }
+constexpr bool Mesh_Fits16(int nVertices) { return nVertices <= 65536; }
+
+void Mesh_Init(MESH* pMesh, MESHVERTEX* pVertices, int nMaxVertices, void* pIndices, int nIndexSize, int nMaxIndices);
+unsigned int Mesh_GetIndex(const MESH* pMesh, int i);
+
+// each returns false and leaves the mesh as it was when there is no room or
+// the indices would not fit their size
+bool Mesh_Star(MESH* pMesh, int nPoints, float fRadius, float fInnerRadius, unsigned int color, unsigned int innerColor);    // the tips and center take color, the inner corners innerColor
+bool Mesh_Polygon(MESH* pMesh, int nSides, float fRadius, unsigned int color, unsigned int edgeColor);    // the center takes color, the corners edgeColor
+bool Mesh_AddTriangleList(MESH* pMesh, const MESHVERTEX* pVertices, int nVertices);
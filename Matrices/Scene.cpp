@@ -0,0 +1,142 @@
+#include "Scene.h"
+#include <string.h>
+
+static bool Scene_Equal(const VEC3& a, const VEC3& b)
+{
+	return a.x == b.x && a.y == b.y && a.z == b.z;
+}
+
+//Scene_Init() : no nodes, and a camera at the origin looking down z with a quarter pi field of view
+void Scene_Init(SCENE* pScene)
+{
+	memset(pScene, 0, sizeof(*pScene));
+	Scene_SetCamera(pScene, Vec3(0.0f, 0.0f, 0.0f), Vec3(0.0f, 0.0f, 1.0f), Vec3(0.0f, 1.0f, 0.0f));
+	Scene_SetProjection(pScene, VECMATH_PI / 4, 1.0f, 1.0f, 100.0f);
+}
+
+void Scene_SetCamera(SCENE* pScene, const VEC3& eye, const VEC3& at, const VEC3& up)
+{
+	SCENECAMERA& camera = pScene->camera;
+	if (Scene_Equal(camera.eye, eye) && Scene_Equal(camera.at, at) && Scene_Equal(camera.up, up))
+		return;
+
+	camera.eye = eye;
+	camera.at = at;
+	camera.up = up;
+	camera.bDirty = true;
+}
+
+void Scene_SetProjection(SCENE* pScene, float fovy, float aspect, float zn, float zf)
+{
+	SCENECAMERA& camera = pScene->camera;
+	if (camera.fovy == fovy && camera.aspect == aspect && camera.zn == zn && camera.zf == zf)
+		return;
+
+	camera.fovy = fovy;
+	camera.aspect = aspect;
+	camera.zn = zn;
+	camera.zf = zf;
+	camera.bDirty = true;
+}
+
+//Scene_AddNode() : a new node has unit scale and no translation or rotation
+int Scene_AddNode(SCENE* pScene, int parent)
+{
+	if (pScene->nNodes >= SCENE_MAX_NODES || parent >= pScene->nNodes)
+		return -1;
+
+	int node = pScene->nNodes++;
+	SCENENODE& n = pScene->nodes[node];
+	n.parent = parent < 0 ? -1 : parent;
+	n.scale = Vec3(1.0f, 1.0f, 1.0f);
+	n.translation = Vec3(0.0f, 0.0f, 0.0f);
+	n.rotation = Vec3(0.0f, 0.0f, 0.0f);
+	n.bDirty = true;
+
+	return node;
+}
+
+void Scene_SetNode(SCENE* pScene, int node, const VEC3& scale, const VEC3& translation, const VEC3& rotation)
+{
+	if (node < 0 || node >= pScene->nNodes)
+		return;
+
+	SCENENODE& n = pScene->nodes[node];
+	if (Scene_Equal(n.scale, scale) && Scene_Equal(n.translation, translation) && Scene_Equal(n.rotation, rotation))
+		return;
+
+	n.scale = scale;
+	n.translation = translation;
+	n.rotation = rotation;
+	n.bDirty = true;
+}
+
+// scale, translation, then rotation; the identity parts are skipped
+static void Scene_Compose(SCENENODE* pNode)
+{
+	MAT4 m;
+
+	Mat4_Scaling(&pNode->local, pNode->scale.x, pNode->scale.y, pNode->scale.z);
+	pNode->local.m[3][0] = pNode->translation.x;
+	pNode->local.m[3][1] = pNode->translation.y;
+	pNode->local.m[3][2] = pNode->translation.z;
+
+	if (pNode->rotation.x != 0.0f)
+	{
+		Mat4_RotationX(&m, pNode->rotation.x);
+		Mat4_Multiply(&pNode->local, pNode->local, m);
+	}
+	if (pNode->rotation.y != 0.0f)
+	{
+		Mat4_RotationY(&m, pNode->rotation.y);
+		Mat4_Multiply(&pNode->local, pNode->local, m);
+	}
+	if (pNode->rotation.z != 0.0f)
+	{
+		Mat4_RotationZ(&m, pNode->rotation.z);
+		Mat4_Multiply(&pNode->local, pNode->local, m);
+	}
+}
+
+//Scene_Update() : a node is recomposed when it is dirty or its parent was recomposed in this pass
+bool Scene_Update(SCENE* pScene)
+{
+	bool moved[SCENE_MAX_NODES];
+	pScene->stats.nComposed = 0;
+
+	for (int i = 0; i < pScene->nNodes; i++)
+	{
+		SCENENODE& node = pScene->nodes[i];
+		bool bParentMoved = node.parent >= 0 && moved[node.parent];
+		moved[i] = node.bDirty || bParentMoved;
+		if (moved[i] == false)
+			continue;
+
+		if (node.bDirty)
+			Scene_Compose(&node);
+		if (node.parent >= 0)
+			Mat4_Multiply(&node.world, node.local, pScene->nodes[node.parent].world);
+		else
+			node.world = node.local;
+
+		node.bDirty = false;
+		pScene->stats.nComposed++;
+	}
+
+	SCENECAMERA& camera = pScene->camera;
+	if (camera.bDirty == false)
+		return false;
+
+	Mat4_LookAtLH(&camera.view, camera.eye, camera.at, camera.up);
+	Mat4_PerspectiveFovLH(&camera.proj, camera.fovy, camera.aspect, camera.zn, camera.zf);
+	Mat4_Multiply(&camera.viewProj, camera.view, camera.proj);
+	camera.bDirty = false;
+	pScene->stats.nCameraUpdates++;
+
+	return true;
+}
+
+const MAT4& Scene_GetWorld(const SCENE* pScene, int node)
+{
+	return pScene->nodes[node].world;
+}
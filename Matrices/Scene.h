@@ -0,0 +1,58 @@
+#pragma once
+#include "VecMath.h"
+
+// Transform hierarchy.
+// A node's local matrix is scale, then translation, then rotation about x,
+// y and z, in that order; its world matrix is the local one times its
+// parent's world. Setting a node's inputs only marks it dirty when they
+// change, and Scene_Update() recomposes the dirty nodes and the children
+// below them, so a still frame multiplies no matrices. Parents come before
+// their children in the node array, which makes one pass in order enough.
+// The camera works the same way: its view, projection and their product
+// are rebuilt only when it moves, and Scene_Update() tells the caller when
+// the view-projection needs uploading.
+
+#define SCENE_MAX_NODES  64
+
+struct SCENECAMERA
+{
+	VEC3 eye, at, up;
+	float fovy, aspect, zn, zf;
+	MAT4 view;
+	MAT4 proj;
+	MAT4 viewProj;
+	bool bDirty;
+};
+
+struct SCENENODE
+{
+	int parent;          // -1 for a root, always below the node's own index
+	VEC3 scale;
+	VEC3 translation;
+	VEC3 rotation;       // radians about x, y and z, applied in that order
+	MAT4 local;
+	MAT4 world;
+	bool bDirty;         // inputs changed since the last update
+};
+
+struct SCENESTATS
+{
+	int nComposed;       // world matrices rebuilt by the last update
+	int nCameraUpdates;  // view-projections rebuilt since Scene_Init()
+};
+
+struct SCENE
+{
+	int nNodes;
+	SCENENODE nodes[SCENE_MAX_NODES];
+	SCENECAMERA camera;
+	SCENESTATS stats;
+};
+
+void Scene_Init(SCENE* pScene);
+void Scene_SetCamera(SCENE* pScene, const VEC3& eye, const VEC3& at, const VEC3& up);
+void Scene_SetProjection(SCENE* pScene, float fovy, float aspect, float zn, float zf);
+int Scene_AddNode(SCENE* pScene, int parent);    // returns -1 when full or the parent is not there yet
+void Scene_SetNode(SCENE* pScene, int node, const VEC3& scale, const VEC3& translation, const VEC3& rotation);
+bool Scene_Update(SCENE* pScene);    // returns true when the view-projection changed
+const MAT4& Scene_GetWorld(const SCENE* pScene, int node);
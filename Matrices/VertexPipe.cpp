@@ -0,0 +1,440 @@
+#include "VertexPipe.h"
+#include <string.h>
+
+// The four wide blocks need SSE2, which every x64 target and the projects'
+// Win32 configurations have.
+#if defined(VECMATH_SSE) && (defined(_M_X64) || defined(__x86_64__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__))
+#define VERTEXPIPE_SSE2
+#include <emmintrin.h>
+#endif
+
+// The AVX2 blocks are built with every compiler that can emit them, whatever
+// the project's instruction set, and VertexPipe_HasAVX2() picks them at run
+// time; a build for AVX2 (VECMATH_AVX2) skips the question.
+#if defined(VECMATH_SSE) && (defined(_MSC_VER) || defined(__GNUC__))
+#define VERTEXPIPE_AVX2
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define VERTEXPIPE_TARGET_AVX2
+#else
+#define VERTEXPIPE_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+void VertexPipe_Init(VERTEXPIPE* pPipe, const MAT4& matrix, float x, float y, float width, float height, float minZ, float maxZ)
+{
+	pPipe->matrix = matrix;
+	pPipe->scale[0] = width * 0.5f;
+	pPipe->scale[1] = height * -0.5f;
+	pPipe->scale[2] = maxZ - minZ;
+	pPipe->offset[0] = x + width * 0.5f;
+	pPipe->offset[1] = y + height * 0.5f;
+	pPipe->offset[2] = minZ;
+}
+
+// the color, and the texture coordinates when there are any
+static inline void VertexPipe_CopyAttributes(unsigned int* pOut, const unsigned int* pIn, int nWords)
+{
+	pOut[0] = pIn[0];
+	if (nWords == 3)
+	{
+		pOut[1] = pIn[1];
+		pOut[2] = pIn[2];
+	}
+}
+
+// the position in clip space
+static inline void VertexPipe_ToClip(const MAT4& m, const float* v, float* c)
+{
+	c[0] = v[0] * m.m[0][0] + v[1] * m.m[1][0] + v[2] * m.m[2][0] + m.m[3][0];
+	c[1] = v[0] * m.m[0][1] + v[1] * m.m[1][1] + v[2] * m.m[2][1] + m.m[3][1];
+	c[2] = v[0] * m.m[0][2] + v[1] * m.m[1][2] + v[2] * m.m[2][2] + m.m[3][2];
+	c[3] = v[0] * m.m[0][3] + v[1] * m.m[1][3] + v[2] * m.m[2][3] + m.m[3][3];
+}
+
+// the divide by w and the viewport
+static inline void VertexPipe_Project(const VERTEXPIPE* pPipe, const float* c, float* o)
+{
+	float rhw = 1.0f / c[3];
+	o[0] = c[0] * rhw * pPipe->scale[0] + pPipe->offset[0];
+	o[1] = c[1] * rhw * pPipe->scale[1] + pPipe->offset[1];
+	o[2] = c[2] * rhw * pPipe->scale[2] + pPipe->offset[2];
+	o[3] = rhw;
+}
+
+void VertexPipe_TransformScalar(const VERTEXPIPE* pPipe, void* pOut, const void* pIn, int nInStride, int nCount, unsigned char* pClip)
+{
+	const unsigned char* pSrc = (const unsigned char*)pIn;
+	unsigned char* pDst = (unsigned char*)pOut;
+	int nOutStride = nInStride + 4;
+
+	for (int i = 0; i < nCount; i++, pSrc += nInStride, pDst += nOutStride)
+	{
+		const float* v = (const float*)pSrc;
+		float c[4];
+		VertexPipe_ToClip(pPipe->matrix, v, c);
+		float nw = -c[3];
+
+		pClip[i] = (unsigned char)((c[0] < nw ? VERTEXPIPE_CLIP_LEFT : 0) | (c[0] > c[3] ? VERTEXPIPE_CLIP_RIGHT : 0) |
+			(c[1] < nw ? VERTEXPIPE_CLIP_BOTTOM : 0) | (c[1] > c[3] ? VERTEXPIPE_CLIP_TOP : 0) |
+			(c[2] < 0.0f ? VERTEXPIPE_CLIP_NEAR : 0) | (c[2] > c[3] ? VERTEXPIPE_CLIP_FAR : 0));
+
+		float* o = (float*)pDst;
+		VertexPipe_Project(pPipe, c, o);
+		VertexPipe_CopyAttributes((unsigned int*)(o + 4), (const unsigned int*)(v + 3), nInStride / 4 - 3);
+	}
+}
+
+#ifdef VERTEXPIPE_SSE2
+// a column of the matrix against four positions
+static inline __m128 VertexPipe_Dot4(__m128 x, __m128 y, __m128 z, const MAT4& m, int c)
+{
+	__m128 r = _mm_mul_ps(x, _mm_set1_ps(m.m[0][c]));
+	r = _mm_add_ps(r, _mm_mul_ps(y, _mm_set1_ps(m.m[1][c])));
+	r = _mm_add_ps(r, _mm_mul_ps(z, _mm_set1_ps(m.m[2][c])));
+	return _mm_add_ps(r, _mm_set1_ps(m.m[3][c]));
+}
+
+// blocks of four, loaded a vertex at a time and transposed into a register
+// per coordinate; returns how many vertices that was
+static int VertexPipe_Blocks4(const VERTEXPIPE* pPipe, void* pOut, const void* pIn, int nInStride, int nCount, unsigned char* pClip)
+{
+	const MAT4& m = pPipe->matrix;
+	const unsigned char* pSrc = (const unsigned char*)pIn;
+	unsigned char* pDst = (unsigned char*)pOut;
+	int nOutStride = nInStride + 4;
+	int nWords = nInStride / 4 - 3;
+	int s = nInStride / 4;
+
+	__m128 scaleX = _mm_set1_ps(pPipe->scale[0]), offsetX = _mm_set1_ps(pPipe->offset[0]);
+	__m128 scaleY = _mm_set1_ps(pPipe->scale[1]), offsetY = _mm_set1_ps(pPipe->offset[1]);
+	__m128 scaleZ = _mm_set1_ps(pPipe->scale[2]), offsetZ = _mm_set1_ps(pPipe->offset[2]);
+	__m128 zero = _mm_setzero_ps();
+	__m128 one = _mm_set1_ps(1.0f);
+
+	int i = 0;
+	for (; i + 4 <= nCount; i += 4)
+	{
+		// x, y, z and the color word of each vertex; the colors end up in the
+		// fourth register and are not used
+		const float* v = (const float*)(pSrc + i * nInStride);
+		__m128 vx = _mm_loadu_ps(v);
+		__m128 vy = _mm_loadu_ps(v + s);
+		__m128 vz = _mm_loadu_ps(v + 2 * s);
+		__m128 vc = _mm_loadu_ps(v + 3 * s);
+		_MM_TRANSPOSE4_PS(vx, vy, vz, vc);
+
+		__m128 x = VertexPipe_Dot4(vx, vy, vz, m, 0);
+		__m128 y = VertexPipe_Dot4(vx, vy, vz, m, 1);
+		__m128 z = VertexPipe_Dot4(vx, vy, vz, m, 2);
+		__m128 w = VertexPipe_Dot4(vx, vy, vz, m, 3);
+		__m128 nw = _mm_sub_ps(zero, w);
+
+		// a code in each lane's low byte, packed down to four bytes
+		__m128i code = _mm_and_si128(_mm_castps_si128(_mm_cmplt_ps(x, nw)), _mm_set1_epi32(VERTEXPIPE_CLIP_LEFT));
+		code = _mm_or_si128(code, _mm_and_si128(_mm_castps_si128(_mm_cmpgt_ps(x, w)), _mm_set1_epi32(VERTEXPIPE_CLIP_RIGHT)));
+		code = _mm_or_si128(code, _mm_and_si128(_mm_castps_si128(_mm_cmplt_ps(y, nw)), _mm_set1_epi32(VERTEXPIPE_CLIP_BOTTOM)));
+		code = _mm_or_si128(code, _mm_and_si128(_mm_castps_si128(_mm_cmpgt_ps(y, w)), _mm_set1_epi32(VERTEXPIPE_CLIP_TOP)));
+		code = _mm_or_si128(code, _mm_and_si128(_mm_castps_si128(_mm_cmplt_ps(z, zero)), _mm_set1_epi32(VERTEXPIPE_CLIP_NEAR)));
+		code = _mm_or_si128(code, _mm_and_si128(_mm_castps_si128(_mm_cmpgt_ps(z, w)), _mm_set1_epi32(VERTEXPIPE_CLIP_FAR)));
+		code = _mm_packs_epi32(code, code);
+		int codes = _mm_cvtsi128_si32(_mm_packus_epi16(code, code));
+		memcpy(pClip + i, &codes, 4);
+
+		__m128 rhw = _mm_div_ps(one, w);
+		x = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(x, rhw), scaleX), offsetX);
+		y = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(y, rhw), scaleY), offsetY);
+		z = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(z, rhw), scaleZ), offsetZ);
+		_MM_TRANSPOSE4_PS(x, y, z, rhw);
+
+		unsigned char* d = pDst + i * nOutStride;
+		_mm_storeu_ps((float*)d, x);
+		_mm_storeu_ps((float*)(d + nOutStride), y);
+		_mm_storeu_ps((float*)(d + 2 * nOutStride), z);
+		_mm_storeu_ps((float*)(d + 3 * nOutStride), rhw);
+		for (int n = 0; n < 4; n++)
+			VertexPipe_CopyAttributes((unsigned int*)(d + n * nOutStride + 16), (const unsigned int*)(v + n * s + 3), nWords);
+	}
+
+	return i;
+}
+#endif
+
+#ifdef VERTEXPIPE_AVX2
+// a column of the matrix against eight positions
+static inline VERTEXPIPE_TARGET_AVX2 __m256 VertexPipe_Dot8(__m256 x, __m256 y, __m256 z, const MAT4& m, int c)
+{
+	__m256 r = _mm256_mul_ps(x, _mm256_set1_ps(m.m[0][c]));
+	r = _mm256_add_ps(r, _mm256_mul_ps(y, _mm256_set1_ps(m.m[1][c])));
+	r = _mm256_add_ps(r, _mm256_mul_ps(z, _mm256_set1_ps(m.m[2][c])));
+	return _mm256_add_ps(r, _mm256_set1_ps(m.m[3][c]));
+}
+
+static inline VERTEXPIPE_TARGET_AVX2 __m256i VertexPipe_Code(__m256 mask, int code)
+{
+	return _mm256_and_si256(_mm256_castps_si256(mask), _mm256_set1_epi32(code));
+}
+
+// blocks of eight, gathered into a register per coordinate and transposed
+// back on the way out; returns how many vertices that was
+static VERTEXPIPE_TARGET_AVX2 int VertexPipe_Blocks8(const VERTEXPIPE* pPipe, void* pOut, const void* pIn, int nInStride, int nCount, unsigned char* pClip)
+{
+	const MAT4& m = pPipe->matrix;
+	const unsigned char* pSrc = (const unsigned char*)pIn;
+	unsigned char* pDst = (unsigned char*)pOut;
+	int nOutStride = nInStride + 4;
+	int nWords = nInStride / 4 - 3;
+
+	int s = nInStride / 4;
+	__m256i index = _mm256_setr_epi32(0, s, 2 * s, 3 * s, 4 * s, 5 * s, 6 * s, 7 * s);
+	__m256 scaleX = _mm256_set1_ps(pPipe->scale[0]), offsetX = _mm256_set1_ps(pPipe->offset[0]);
+	__m256 scaleY = _mm256_set1_ps(pPipe->scale[1]), offsetY = _mm256_set1_ps(pPipe->offset[1]);
+	__m256 scaleZ = _mm256_set1_ps(pPipe->scale[2]), offsetZ = _mm256_set1_ps(pPipe->offset[2]);
+	__m256 zero = _mm256_setzero_ps();
+	__m256 one = _mm256_set1_ps(1.0f);
+
+	int i = 0;
+	for (; i + 8 <= nCount; i += 8)
+	{
+		const float* v = (const float*)(pSrc + i * nInStride);
+		__m256 vx = _mm256_i32gather_ps(v, index, 4);
+		__m256 vy = _mm256_i32gather_ps(v + 1, index, 4);
+		__m256 vz = _mm256_i32gather_ps(v + 2, index, 4);
+
+		__m256 x = VertexPipe_Dot8(vx, vy, vz, m, 0);
+		__m256 y = VertexPipe_Dot8(vx, vy, vz, m, 1);
+		__m256 z = VertexPipe_Dot8(vx, vy, vz, m, 2);
+		__m256 w = VertexPipe_Dot8(vx, vy, vz, m, 3);
+		__m256 nw = _mm256_sub_ps(zero, w);
+
+		__m256i code = VertexPipe_Code(_mm256_cmp_ps(x, nw, _CMP_LT_OQ), VERTEXPIPE_CLIP_LEFT);
+		code = _mm256_or_si256(code, VertexPipe_Code(_mm256_cmp_ps(x, w, _CMP_GT_OQ), VERTEXPIPE_CLIP_RIGHT));
+		code = _mm256_or_si256(code, VertexPipe_Code(_mm256_cmp_ps(y, nw, _CMP_LT_OQ), VERTEXPIPE_CLIP_BOTTOM));
+		code = _mm256_or_si256(code, VertexPipe_Code(_mm256_cmp_ps(y, w, _CMP_GT_OQ), VERTEXPIPE_CLIP_TOP));
+		code = _mm256_or_si256(code, VertexPipe_Code(_mm256_cmp_ps(z, zero, _CMP_LT_OQ), VERTEXPIPE_CLIP_NEAR));
+		code = _mm256_or_si256(code, VertexPipe_Code(_mm256_cmp_ps(z, w, _CMP_GT_OQ), VERTEXPIPE_CLIP_FAR));
+		// every code fits the low byte of its lane, so two packs leave them in order
+		__m128i code16 = _mm_packus_epi32(_mm256_castsi256_si128(code), _mm256_extracti128_si256(code, 1));
+		_mm_storel_epi64((__m128i*)(pClip + i), _mm_packus_epi16(code16, code16));
+
+		__m256 rhw = _mm256_div_ps(one, w);
+		x = _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(x, rhw), scaleX), offsetX);
+		y = _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(y, rhw), scaleY), offsetY);
+		z = _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(z, rhw), scaleZ), offsetZ);
+
+		// x, y, z, rhw of vertex n in the low half and of n + 4 in the high one
+		__m256 xy0 = _mm256_unpacklo_ps(x, y);
+		__m256 xy1 = _mm256_unpackhi_ps(x, y);
+		__m256 zw0 = _mm256_unpacklo_ps(z, rhw);
+		__m256 zw1 = _mm256_unpackhi_ps(z, rhw);
+		__m256 out[4];
+		out[0] = _mm256_shuffle_ps(xy0, zw0, _MM_SHUFFLE(1, 0, 1, 0));
+		out[1] = _mm256_shuffle_ps(xy0, zw0, _MM_SHUFFLE(3, 2, 3, 2));
+		out[2] = _mm256_shuffle_ps(xy1, zw1, _MM_SHUFFLE(1, 0, 1, 0));
+		out[3] = _mm256_shuffle_ps(xy1, zw1, _MM_SHUFFLE(3, 2, 3, 2));
+
+		unsigned char* d = pDst + i * nOutStride;
+		for (int n = 0; n < 4; n++)
+		{
+			_mm_storeu_ps((float*)(d + n * nOutStride), _mm256_castps256_ps128(out[n]));
+			_mm_storeu_ps((float*)(d + (n + 4) * nOutStride), _mm256_extractf128_ps(out[n], 1));
+		}
+		for (int n = 0; n < 8; n++)
+			VertexPipe_CopyAttributes((unsigned int*)(d + n * nOutStride + 16), (const unsigned int*)(v + n * s + 3), nWords);
+	}
+
+	// the code around it may be built without AVX
+	_mm256_zeroupper();
+	return i;
+}
+#endif
+
+#if defined(VERTEXPIPE_AVX2) && !defined(VECMATH_AVX2)
+static int g_nVertexPipeAVX2 = -1;    // not asked yet
+#endif
+
+bool VertexPipe_HasAVX2(void)
+{
+#if defined(VECMATH_AVX2)
+	return true;
+#elif defined(VERTEXPIPE_AVX2)
+	if (g_nVertexPipeAVX2 < 0)
+	{
+#ifdef _MSC_VER
+		// AVX2 needs the AVX bit, and the OS saving the ymm registers
+		int info[4];
+		__cpuid(info, 0);
+		bool bAVX2 = info[0] >= 7;
+		if (bAVX2)
+		{
+			__cpuid(info, 1);
+			bAVX2 = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0 && (_xgetbv(0) & 6) == 6;
+		}
+		if (bAVX2)
+		{
+			__cpuidex(info, 7, 0);
+			bAVX2 = (info[1] & (1 << 5)) != 0;
+		}
+		g_nVertexPipeAVX2 = bAVX2 ? 1 : 0;
+#else
+		g_nVertexPipeAVX2 = __builtin_cpu_supports("avx2") ? 1 : 0;
+#endif
+	}
+	return g_nVertexPipeAVX2 != 0;
+#else
+	return false;
+#endif
+}
+
+//VertexPipe_Transform() : blocks of eight when the CPU has AVX2, then what VertexPipe_TransformSSE2() does with the rest
+void VertexPipe_Transform(const VERTEXPIPE* pPipe, void* pOut, const void* pIn, int nInStride, int nCount, unsigned char* pClip)
+{
+	int i = 0;
+
+#ifdef VERTEXPIPE_AVX2
+	if (VertexPipe_HasAVX2())
+		i = VertexPipe_Blocks8(pPipe, pOut, pIn, nInStride, nCount, pClip);
+#endif
+
+	if (i < nCount)
+		VertexPipe_TransformSSE2(pPipe, (unsigned char*)pOut + i * (nInStride + 4), (const unsigned char*)pIn + i * nInStride,
+			nInStride, nCount - i, pClip + i);
+}
+
+//VertexPipe_TransformSSE2() : blocks of four with SSE2, the rest and everything without it one by one
+void VertexPipe_TransformSSE2(const VERTEXPIPE* pPipe, void* pOut, const void* pIn, int nInStride, int nCount, unsigned char* pClip)
+{
+	int i = 0;
+
+#ifdef VERTEXPIPE_SSE2
+	i = VertexPipe_Blocks4(pPipe, pOut, pIn, nInStride, nCount, pClip);
+#endif
+
+	if (i < nCount)
+		VertexPipe_TransformScalar(pPipe, (unsigned char*)pOut + i * (nInStride + 4), (const unsigned char*)pIn + i * nInStride,
+			nInStride, nCount - i, pClip + i);
+}
+
+// where the edge from vertex a, in front of the near plane, to vertex b,
+// behind it, meets z = 0, with the color and texture coordinates taken
+// along; the edge is always walked from the front, so the two triangles
+// sharing it make the same vertex
+static void VertexPipe_Intersect(const VERTEXPIPE* pPipe, const unsigned char* pIn, int nInStride, unsigned int a, unsigned int b, float* o)
+{
+	const float* va = (const float*)(pIn + a * nInStride);
+	const float* vb = (const float*)(pIn + b * nInStride);
+	float ca[4], cb[4], c[4];
+	VertexPipe_ToClip(pPipe->matrix, va, ca);
+	VertexPipe_ToClip(pPipe->matrix, vb, cb);
+
+	float t = ca[2] / (ca[2] - cb[2]);
+	c[0] = ca[0] + (cb[0] - ca[0]) * t;
+	c[1] = ca[1] + (cb[1] - ca[1]) * t;
+	c[2] = 0.0f;
+	c[3] = ca[3] + (cb[3] - ca[3]) * t;
+	VertexPipe_Project(pPipe, c, o);
+
+	unsigned int colorA = ((const unsigned int*)va)[3];
+	unsigned int colorB = ((const unsigned int*)vb)[3];
+	unsigned int color = 0;
+	for (int shift = 0; shift < 32; shift += 8)
+	{
+		float fA = (float)((colorA >> shift) & 0xff);
+		float fB = (float)((colorB >> shift) & 0xff);
+		color |= (unsigned int)(fA + (fB - fA) * t + 0.5f) << shift;
+	}
+	((unsigned int*)o)[4] = color;
+
+	if (nInStride == 24)
+	{
+		o[5] = va[4] + (vb[4] - va[4]) * t;
+		o[6] = va[5] + (vb[5] - va[5]) * t;
+	}
+}
+
+//VertexPipe_Cull() : a clipped triangle keeps its corners in front of the near plane and gets the two where its edges cross it, fanned out in the same winding
+int VertexPipe_Cull(const VERTEXPIPE* pPipe, const void* pIn, int nInStride, void* pVertices, int* pnVertices, int nMaxVertices,
+	unsigned short* pOut, const unsigned char* pClip, const unsigned short* pIndices, int nTriangles, VERTEXPIPESTATS* pStats)
+{
+	int nKept = 0, nRejected = 0, nNear = 0, nClipped = 0, nDropped = 0;
+	int nVertices = *pnVertices;
+	int nOutStride = nInStride + 4;
+
+	for (int t = 0; t < nTriangles; t++)
+	{
+		unsigned short triangle[3];
+		if (pIndices != NULL)
+		{
+			triangle[0] = pIndices[t * 3];
+			triangle[1] = pIndices[t * 3 + 1];
+			triangle[2] = pIndices[t * 3 + 2];
+		}
+		else
+		{
+			triangle[0] = (unsigned short)(t * 3);
+			triangle[1] = (unsigned short)(t * 3 + 1);
+			triangle[2] = (unsigned short)(t * 3 + 2);
+		}
+
+		unsigned char a = pClip[triangle[0]], b = pClip[triangle[1]], c = pClip[triangle[2]];
+		if ((a & b & c) != 0)
+		{
+			nRejected++;
+			continue;
+		}
+		if (((a | b | c) & VERTEXPIPE_CLIP_NEAR) == 0)
+		{
+			pOut[nKept * 3] = triangle[0];
+			pOut[nKept * 3 + 1] = triangle[1];
+			pOut[nKept * 3 + 2] = triangle[2];
+			nKept++;
+			continue;
+		}
+
+		if (nVertices + 2 > nMaxVertices)
+		{
+			nDropped++;
+			continue;
+		}
+		nNear++;
+
+		unsigned short polygon[4];
+		int nCorners = 0;
+		for (int k = 0; k < 3; k++)
+		{
+			unsigned short p = triangle[k], q = triangle[(k + 1) % 3];
+			bool bFront = (pClip[p] & VERTEXPIPE_CLIP_NEAR) == 0;
+			if (bFront)
+				polygon[nCorners++] = p;
+			if (bFront != ((pClip[q] & VERTEXPIPE_CLIP_NEAR) == 0))
+			{
+				float* o = (float*)((unsigned char*)pVertices + nVertices * nOutStride);
+				if (bFront)
+					VertexPipe_Intersect(pPipe, (const unsigned char*)pIn, nInStride, p, q, o);
+				else
+					VertexPipe_Intersect(pPipe, (const unsigned char*)pIn, nInStride, q, p, o);
+				polygon[nCorners++] = (unsigned short)nVertices++;
+			}
+		}
+
+		for (int k = 2; k < nCorners; k++, nKept++, nClipped++)
+		{
+			pOut[nKept * 3] = polygon[0];
+			pOut[nKept * 3 + 1] = polygon[k - 1];
+			pOut[nKept * 3 + 2] = polygon[k];
+		}
+	}
+
+	*pnVertices = nVertices;
+	if (pStats != NULL)
+	{
+		pStats->nTriangles += nTriangles;
+		pStats->nRejected += nRejected;
+		pStats->nNear += nNear;
+		pStats->nClipped += nClipped;
+		pStats->nDropped += nDropped;
+	}
+
+	return nKept;
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include "VecMath.h"
+
+// Software vertex processing.
+// Takes the demos' vertex formats, XYZ|DIFFUSE and XYZ|DIFFUSE|TEX1, through
+// what D3D's fixed function vertex stage does with them: the transform to
+// clip space, the clip codes, the divide by w and the viewport mapping. The
+// output is the same vertex with XYZRHW in place of XYZ, ready to draw with
+// D3DFVF_XYZRHW, and the color and texture coordinates copied behind it.
+// With SSE2 the vertices go four at a time, transposed into one register
+// per coordinate and back on the way out, and on a CPU with AVX2 eight at a
+// time, gathered; the AVX2 blocks are picked at run time, so the SSE2 builds
+// get them too. The scalar version does the same operations in the same
+// order one vertex at a time, so all three give the same bits (see VecMath.h
+// for the compiler settings that takes).
+// VertexPipe_Cull() drops the triangles wholly outside a plane and keeps the
+// ones inside or only crossing the sides of the view, which the rasterizer
+// scissors. The ones crossing the near plane would divide by a w at or
+// below zero, so they are clipped against it in clip space: the vertices
+// behind it are replaced by where the edges cross it, which leaves a
+// triangle or a quad drawn as two.
+
+#define VERTEXPIPE_CLIP_LEFT    0x01    // x < -w
+#define VERTEXPIPE_CLIP_RIGHT   0x02    // x > w
+#define VERTEXPIPE_CLIP_BOTTOM  0x04    // y < -w
+#define VERTEXPIPE_CLIP_TOP     0x08    // y > w
+#define VERTEXPIPE_CLIP_NEAR    0x10    // z < 0
+#define VERTEXPIPE_CLIP_FAR     0x20    // z > w
+
+struct VERTEXPIPE
+{
+	MAT4 matrix;        // world, view and projection in one
+	float scale[3];     // screen = clip / w * scale + offset
+	float offset[3];
+};
+
+struct VERTEXPIPESTATS
+{
+	int nTriangles;     // triangles given to VertexPipe_Cull()
+	int nRejected;      // outside one of the planes
+	int nNear;          // crossing the near plane and clipped against it
+	int nClipped;       // the triangles the clipping made of them
+	int nDropped;       // crossing the near plane with no room left for the new vertices
+};
+
+// the viewport is D3DVIEWPORT9's X, Y, Width, Height, MinZ and MaxZ
+void VertexPipe_Init(VERTEXPIPE* pPipe, const MAT4& matrix, float x, float y, float width, float height, float minZ, float maxZ);
+
+// nInStride is 16 or 24 bytes, the output stride 4 more; pClip gets a code per vertex
+void VertexPipe_Transform(const VERTEXPIPE* pPipe, void* pOut, const void* pIn, int nInStride, int nCount, unsigned char* pClip);
+void VertexPipe_TransformSSE2(const VERTEXPIPE* pPipe, void* pOut, const void* pIn, int nInStride, int nCount, unsigned char* pClip);    // never the AVX2 blocks
+void VertexPipe_TransformScalar(const VERTEXPIPE* pPipe, void* pOut, const void* pIn, int nInStride, int nCount, unsigned char* pClip);
+bool VertexPipe_HasAVX2(void);    // whether VertexPipe_Transform() uses the AVX2 blocks
+
+// a triangle crossing the near plane makes at most two triangles and two vertices
+constexpr int VertexPipe_ClipVertices(int nTriangles) { return 2 * nTriangles; }
+constexpr int VertexPipe_ClipIndices(int nTriangles) { return 6 * nTriangles; }
+
+// writes the kept and clipped triangles' indices and returns how many
+// triangles that is, so pOut needs room for VertexPipe_ClipIndices(). The
+// clipped vertices are worked out again from pIn, the vertices given to
+// VertexPipe_Transform(), and go into its output, pVertices, after the
+// *pnVertices there, up to nMaxVertices; *pnVertices is moved past them.
+// pIndices is NULL for a triangle list without indices, and the counts are
+// added to pStats when it is not NULL.
+int VertexPipe_Cull(const VERTEXPIPE* pPipe, const void* pIn, int nInStride, void* pVertices, int* pnVertices, int nMaxVertices,
+	unsigned short* pOut, const unsigned char* pClip, const unsigned short* pIndices, int nTriangles, VERTEXPIPESTATS* pStats);
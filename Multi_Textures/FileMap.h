@@ -0,0 +1,23 @@
+#pragma once
+#include <stddef.h>
+
+// Read only file mappings.
+// The cooked texture, WAV and sound bank readers all work on a view of the
+// whole file instead of reading it into a buffer, so pages are faulted in
+// as they are touched and nothing is copied. This is the one place that
+// knows how to map a file on Win32 and on POSIX.
+
+struct FILEMAP
+{
+	const unsigned char* pBase;    // NULL when nothing is mapped
+	size_t nSize;
+#ifdef _WIN32
+	void* hFile;
+	void* hMapping;
+#else
+	int fd;
+#endif
+};
+
+bool FileMap_Open(const char* pFile, FILEMAP* pMap);    // false for missing and empty files
+void FileMap_Close(FILEMAP* pMap);                      // the view is gone after it, safe to call twice
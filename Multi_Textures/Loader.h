@@ -0,0 +1,47 @@
+#pragma once
+#include <d3d9.h>
+#include <d3dx9.h>
+
+// Asynchronous texture loader.
+// Image files are read and decoded by a pool of worker threads, so startup
+// costs roughly the slowest file instead of the sum of all of them. Workers
+// create the textures themselves, which needs a device created with
+// D3DCREATE_MULTITHREADED. Finished textures are handed over by
+// Loader_Poll() on the main thread: it stores each one in its target
+// pointer and uploads it, so code that reads those pointers never sees a
+// half-built texture. Textures are queued in groups so a scene can start
+// as soon as the group it needs is in.
+// A cooked .ctex file next to the source image (see TexFile.h) is used
+// instead of the image when it is up to date and matches the request; a
+// cook function, when set, supplies the cooked file instead. Loaded files
+// can be queued again with Loader_Reload() to swap in a new version.
+
+#define LOADER_MAX_JOBS    32
+#define LOADER_MAX_GROUPS  4
+
+// returns the path of an up to date .ctex for the source file, called from the workers
+typedef bool (*LOADERCOOKFUNC)(LPCWSTR pFile, char* pCooked, size_t nCooked);
+
+struct LOADERSTATS
+{
+	int nQueued;
+	int nLoaded;
+	int nFailed;
+	int nCooked;          // loaded from .ctex files instead of decoding
+	int nReloaded;
+	float fFirstFrame;    // seconds from program start to the first presented frame
+	float fAllLoaded;     // seconds from program start until the last texture was handed over
+	float fDecodeTime;    // read + decode seconds, summed over all workers
+};
+
+bool Loader_Init(LPDIRECT3DDEVICE9 pDevice, int nThreads, DWORD dwStartTime);    // nThreads 0 = one per core, minus one
+bool Loader_Queue(LPCWSTR pFile, UINT width, UINT height, D3DFORMAT format, D3DCOLOR colorKey,
+	LPDIRECT3DTEXTURE9* ppTexture, int group);
+int Loader_Poll(void);                  // hands over finished textures, returns how many are still pending
+bool Loader_Reload(LPCWSTR pFile);
+void Loader_SetCookFunc(LOADERCOOKFUNC pCook);
+bool Loader_IsGroupReady(int group);
+void Loader_WaitGroup(int group);
+void Loader_FirstFrame(void);           // call after the first Present
+const LOADERSTATS& Loader_GetStats(void);
+void Loader_Release(void);              // stops the workers; handed over textures stay with their owners
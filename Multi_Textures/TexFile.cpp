@@ -0,0 +1,100 @@
+#include "TexFile.h"
+#include <string.h>
+
+unsigned int TexFile_Hash(const void* pData, size_t nSize)
+{
+	const unsigned char* p = (const unsigned char*)pData;
+	unsigned int hash = 2166136261u;
+
+	for (size_t i = 0; i < nSize; i++)
+	{
+		hash ^= p[i];
+		hash *= 16777619u;
+	}
+
+	return hash;
+}
+
+static unsigned int TexFile_Rows(unsigned int format, unsigned int height)
+{
+	return (format == TEXFILE_FORMAT_A8R8G8B8) ? height : (height + 3) / 4;
+}
+
+static unsigned int TexFile_MinPitch(unsigned int format, unsigned int width)
+{
+	if (format == TEXFILE_FORMAT_A8R8G8B8)
+		return width * 4;
+
+	return (width + 3) / 4 * (format == TEXFILE_FORMAT_DXT1 ? 8 : 16);
+}
+
+//TexFile_Validate() : checks the header and that every level lies inside the file
+static bool TexFile_Validate(const TEXFILE* pTex)
+{
+	if (pTex->map.nSize < sizeof(TEXFILEHEADER))
+		return false;
+
+	const TEXFILEHEADER* pHeader = pTex->pHeader;
+	if (pHeader->magic != TEXFILE_MAGIC || pHeader->version != TEXFILE_VERSION ||
+		(pHeader->format != TEXFILE_FORMAT_A8R8G8B8 && pHeader->format != TEXFILE_FORMAT_DXT1 &&
+		pHeader->format != TEXFILE_FORMAT_DXT5) || pHeader->levels == 0 || pHeader->levels > TEXFILE_MAX_LEVELS)
+		return false;
+
+	if (pTex->map.nSize < sizeof(TEXFILEHEADER) + pHeader->levels * sizeof(TEXFILELEVEL))
+		return false;
+
+	for (unsigned int i = 0; i < pHeader->levels; i++)
+	{
+		const TEXFILELEVEL& level = pTex->pLevels[i];
+
+		if (level.width == 0 || level.height == 0 || level.pitch < TexFile_MinPitch(pHeader->format, level.width) ||
+			level.offset % TEXFILE_ALIGN != 0)
+			return false;
+		if (level.offset > pTex->map.nSize ||
+			(size_t)level.pitch * TexFile_Rows(pHeader->format, level.height) > pTex->map.nSize - level.offset)
+			return false;
+	}
+
+	return pTex->pLevels[0].width == pHeader->width && pTex->pLevels[0].height == pHeader->height;
+}
+
+bool TexFile_Open(const char* pFile, TEXFILE* pTex)
+{
+	memset(pTex, 0, sizeof(*pTex));
+
+	if (!FileMap_Open(pFile, &pTex->map))
+		return false;
+
+	pTex->pHeader = (const TEXFILEHEADER*)pTex->map.pBase;
+	pTex->pLevels = (const TEXFILELEVEL*)(pTex->map.pBase + sizeof(TEXFILEHEADER));
+
+	if (!TexFile_Validate(pTex))
+	{
+		TexFile_Close(pTex);
+		return false;
+	}
+
+	return true;
+}
+
+const void* TexFile_GetPixels(const TEXFILE* pTex, unsigned int level)
+{
+	if (pTex->map.pBase == NULL || level >= pTex->pHeader->levels)
+		return NULL;
+
+	return pTex->map.pBase + pTex->pLevels[level].offset;
+}
+
+unsigned int TexFile_GetRows(const TEXFILE* pTex, unsigned int level)
+{
+	if (pTex->map.pBase == NULL || level >= pTex->pHeader->levels)
+		return 0;
+
+	return TexFile_Rows(pTex->pHeader->format, pTex->pLevels[level].height);
+}
+
+void TexFile_Close(TEXFILE* pTex)
+{
+	FileMap_Close(&pTex->map);
+	memset(pTex, 0, sizeof(*pTex));
+}
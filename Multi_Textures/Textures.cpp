@@ -1,34 +1,38 @@
 #include <Windows.h>
 #include <Mmsystem.h>
 #include <d3dx9.h>
+#include "Loader.h"
+#include "ResManager.h"
+#include "VecMath.h"
 
 LPDIRECT3D9 g_pD3D = nullptr;  // D3D 
-LPDIRECT3DDEVICE9 g_pd3dDevice = nullptr;  // ϴ D3D ̽
-LPDIRECT3DVERTEXBUFFER9 g_pVB = nullptr;    //  
-LPDIRECT3DTEXTURE9 g_pTexture0 = nullptr;    // ؽó0()
-LPDIRECT3DTEXTURE9 g_pTexture1 = nullptr;    // ؽó1(Light Map)
-LPDIRECT3DTEXTURE9 g_pTexture2 = nullptr;
-LPDIRECT3DTEXTURE9 g_pTexture3 = nullptr;
-LPDIRECT3DTEXTURE9 g_pTexture4 = nullptr;
-LPDIRECT3DTEXTURE9 g_pTexture5 = nullptr;
-LPDIRECT3DTEXTURE9 g_pTexture6 = nullptr;
-LPDIRECT3DTEXTURE9 g_pTexture7 = nullptr;
-LPDIRECT3DTEXTURE9 g_pTexture8 = nullptr;
-LPDIRECT3DTEXTURE9 g_pTexture9 = nullptr;
-LPDIRECT3DTEXTURE9 g_pTexture10 = nullptr;
-LPDIRECT3DTEXTURE9 g_pTexture11 = nullptr;
-LPDIRECT3DTEXTURE9 g_pTexture12 = nullptr;
+LPDIRECT3DDEVICE9 g_pd3dDevice = nullptr;  // 렌더링하는 D3D 디바이스
+LPDIRECT3DVERTEXBUFFER9 g_pVB = nullptr;    // 정점 버퍼
+TEXTUREHANDLE g_hTexture0 = { 0 };    // 텍스처0(벽)
+TEXTUREHANDLE g_hTexture1 = { 0 };    // 텍스처1(Light Map)
+TEXTUREHANDLE g_hTexture2 = { 0 };
+TEXTUREHANDLE g_hTexture3 = { 0 };
+TEXTUREHANDLE g_hTexture4 = { 0 };
+TEXTUREHANDLE g_hTexture5 = { 0 };
+TEXTUREHANDLE g_hTexture6 = { 0 };
+TEXTUREHANDLE g_hTexture7 = { 0 };
+TEXTUREHANDLE g_hTexture8 = { 0 };
+TEXTUREHANDLE g_hTexture9 = { 0 };
+TEXTUREHANDLE g_hTexture10 = { 0 };
+TEXTUREHANDLE g_hTexture11 = { 0 };
+TEXTUREHANDLE g_hTexture12 = { 0 };
 
 static float counter1 = 0;
 static float counter2 = 0;
-											 //    ü
+DWORD g_dwStartTime = 0;    // time-to-first-frame 기준 시각
+											 // 사용자 정의 정점 구조체
 struct CUSTOMVERTEX {
-	D3DXVECTOR3 position;   //  ǥ
-	D3DCOLOR color;         //  
-	FLOAT tu, tv;           // ؽó ǥ
+	VEC3 position;          // 정점 좌표
+	D3DCOLOR color;         // 정점 색깔
+	FLOAT tu, tv;           // 텍스처 좌표
 };
 
-// ڰ     Ÿ FVF 
+// 사용자가 설정한 정점에 대한 정보를 나타내는 FVF 값
 #define D3DFVF_CUSTOMVERTEX (D3DFVF_XYZ | D3DFVF_DIFFUSE | D3DFVF_TEX1 | D3DFVF_TEX2)
 
 HRESULT InitD3D(HWND hWnd);
@@ -41,35 +45,39 @@ LRESULT WINAPI MsgProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam);
 
 INT WINAPI WinMain(HINSTANCE hInst, HINSTANCE, LPSTR, INT)
 {
-	//  Ŭ   ʱȭ, 
+	g_dwStartTime = timeGetTime();
+
+	// 윈도우 클래스 선언 및 초기화, 등록
 	WNDCLASSEX wc = { sizeof(WNDCLASSEX), CS_CLASSDC, MsgProc, 0L, 0L, GetModuleHandle(NULL), NULL, NULL, NULL, NULL, L"D3D Tutorial", NULL };
 	RegisterClassEx(&wc);
 
-	//  
+	// 윈도우 생성
 	HWND hWnd = CreateWindow(L"D3D Tutorial", L"D3D Tutorial 01: CreateDevice", WS_OVERLAPPEDWINDOW, 100, 100, 800, 800, GetDesktopWindow(), NULL, wc.hInstance, NULL);
 
-	// Direct3D ʱȭ
+	// Direct3D 초기화
 	if (SUCCEEDED(InitD3D(hWnd))) {
-		//   ʱȭ
+		// 정점 버퍼 초기화
 		if (SUCCEEDED(InitGeometry())) {
-			// ؽó ʱȭ
+			// 텍스처 초기화
 			if (SUCCEEDED(InitTexture())) {
-				//  
+				// 윈도우 출력
 				ShowWindow(hWnd, SW_SHOWDEFAULT);
 				UpdateWindow(hWnd);
 
-				// ޼ 
+				// 메세지 루프
 				MSG msg;
 				ZeroMemory(&msg, sizeof(msg));
 
 				while (msg.message != WM_QUIT) {
-					// GetMessage() Լ ޸  ʴ´.
+					// GetMessage() 함수의 달리 대기하지 않는다.
 					if (PeekMessage(&msg, NULL, 0U, 0U, PM_REMOVE)) {
 						TranslateMessage(&msg);
 						DispatchMessage(&msg);
 					}
 					else {
-						// ó ޼  Ѵ.
+						// 로딩이 끝난 텍스처를 넘겨받고, 처리할 메세지가 없으면 렌더링한다.
+						Loader_Poll();
+						Res_Update();
 						Render();
 					}
 				}
@@ -77,7 +85,7 @@ INT WINAPI WinMain(HINSTANCE hInst, HINSTANCE, LPSTR, INT)
 		}
 	}
 
-	//  Ŭ ޸𸮸 ȯϰ, Ͽ Ѵ.
+	// 등록한 클래스의 메모리를 반환하고, 등록에서 제외한다.
 	UnregisterClass(L"D3D Tutorial", wc.hInstance);
 
 	return 0;
@@ -85,61 +93,62 @@ INT WINAPI WinMain(HINSTANCE hInst, HINSTANCE, LPSTR, INT)
 
 HRESULT InitD3D(HWND hWnd)
 {
-	// D3D ü 
+	// D3D 객체 생성
 	if (nullptr == (g_pD3D = Direct3DCreate9(D3D_SDK_VERSION))) {
 		return E_FAIL;
 	}
 
-	// D3D ̽ ϱ ؼ ʿ ü
+	// D3D 디바이스를 생성하기 위해서 필요한 구조체
 	D3DPRESENT_PARAMETERS d3dpp;
-	ZeroMemory(&d3dpp, sizeof(D3DPRESENT_PARAMETERS));  // 0 ʱȭ      ִ.
+	ZeroMemory(&d3dpp, sizeof(D3DPRESENT_PARAMETERS));  // 0으로 초기화하지 않으면 결과가 나오지 않을 수 있다.
 
-	d3dpp.Windowed = TRUE;  // â
+	d3dpp.Windowed = TRUE;  // 창모드
 	d3dpp.SwapEffect = D3DSWAPEFFECT_DISCARD;
 	d3dpp.BackBufferFormat = D3DFMT_UNKNOWN;
 	d3dpp.EnableAutoDepthStencil = TRUE;
 	d3dpp.AutoDepthStencilFormat = D3DFMT_D16;
 
-	// D3DDEVTYPE_HAL ϵ  ϵ Ѵ. 
-	//  g_pd3dDevice D3D ̽ ͸ Ѵ. 
-	if (FAILED(g_pD3D->CreateDevice(D3DADAPTER_DEFAULT, D3DDEVTYPE_HAL, hWnd, D3DCREATE_SOFTWARE_VERTEXPROCESSING, &d3dpp, &g_pd3dDevice))) {
+	// D3DDEVTYPE_HAL은 하드웨어 가속을 지원하도록 설정한다. 
+	// 로더 스레드에서 텍스처를 만들기 때문에 D3DCREATE_MULTITHREADED로 생성한다.
+	// 전역변수 g_pd3dDevice에 D3D 디바이스 포인터를 저장한다. 
+	if (FAILED(g_pD3D->CreateDevice(D3DADAPTER_DEFAULT, D3DDEVTYPE_HAL, hWnd, D3DCREATE_SOFTWARE_VERTEXPROCESSING | D3DCREATE_MULTITHREADED, &d3dpp, &g_pd3dDevice))) {
 		return E_FAIL;
 	}
 
-	// ﰢ ޸ ǥϱ  ڵ, ø  .
+	// 삼각형의 뒷면을 표시하기 위한 코드, 컬링 기능을 끈다.
 	g_pd3dDevice->SetRenderState(D3DRS_CULLMODE, D3DCULL_NONE);
 
-	//  
+	// 조명 끄기
 	g_pd3dDevice->SetRenderState(D3DRS_LIGHTING, FALSE);
 
-	// z   Ҵ.
+	// z 버퍼 기능을 켠다.
 	g_pd3dDevice->SetRenderState(D3DRS_ZENABLE, TRUE);
 
 	return S_OK;
 }
 
-//   ʱȭ, ؽó ʱȭ
+// 정점 버퍼 초기화, 텍스처 초기화
 HRESULT InitGeometry()
 {
 	CUSTOMVERTEX vertecies[] = {
-		{ D3DXVECTOR3(-1.0f, 1.0f, 0.f), D3DCOLOR(0xffffffff), 0.f, 0.f },
-		{ D3DXVECTOR3(1.0f, 1.0f, 0.f), D3DCOLOR(0xffffffff), 1.f, 0.f },
-		{ D3DXVECTOR3(-1.0f, -1.0f, 0.f), D3DCOLOR(0xffffffff), 0.f, 1.f },
+		{ { -1.0f, 1.0f, 0.f }, D3DCOLOR(0xffffffff), 0.f, 0.f },
+		{ { 1.0f, 1.0f, 0.f }, D3DCOLOR(0xffffffff), 1.f, 0.f },
+		{ { -1.0f, -1.0f, 0.f }, D3DCOLOR(0xffffffff), 0.f, 1.f },
 
-		{ D3DXVECTOR3(1.0f, 1.0f, 0.f), D3DCOLOR(0xffffffff), 1.f, 0.f },
-		{ D3DXVECTOR3(-1.0f, -1.0f, 0.f), D3DCOLOR(0xffffffff), 0.f, 1.f },
-		{ D3DXVECTOR3(1.0f, -1.0f, 0.f), D3DCOLOR(0xffffffff), 1.f, 1.f },
+		{ { 1.0f, 1.0f, 0.f }, D3DCOLOR(0xffffffff), 1.f, 0.f },
+		{ { -1.0f, -1.0f, 0.f }, D3DCOLOR(0xffffffff), 0.f, 1.f },
+		{ { 1.0f, -1.0f, 0.f }, D3DCOLOR(0xffffffff), 1.f, 1.f },
 	};
 
-	//   
+	// 정점 버퍼 생성
 	if (FAILED(g_pd3dDevice->CreateVertexBuffer(sizeof(vertecies), 0, D3DFVF_CUSTOMVERTEX, D3DPOOL_DEFAULT, &g_pVB, NULL))) {
 		return E_FAIL;
 	}
 
 	CUSTOMVERTEX* pVertices;
 
-	// Lock() Լ ù °  ° ڸ 0 ϸ
-	// Vertex Buffer ü  ũ 
+	// Lock() 함수의 첫 번째와 두 번째 인자를 0으로 전달하면
+	// Vertex Buffer의 전체 버퍼 크기로 설정
 	if (FAILED(g_pVB->Lock(0, 0, (void**)&pVertices, 0))) {
 		return E_FAIL;
 	}
@@ -152,38 +161,43 @@ HRESULT InitGeometry()
 
 HRESULT InitTexture()
 {
-	// ؽó Ѵ.
-	D3DXCreateTextureFromFile(g_pd3dDevice, L"attack_1.png", &g_pTexture0);
-	D3DXCreateTextureFromFile(g_pd3dDevice, L"attack_2.png", &g_pTexture1);
-	D3DXCreateTextureFromFile(g_pd3dDevice, L"attack_3.png", &g_pTexture2);
-	D3DXCreateTextureFromFile(g_pd3dDevice, L"attack_4.png", &g_pTexture3);
-	D3DXCreateTextureFromFile(g_pd3dDevice, L"attack_5.png", &g_pTexture4);
-	D3DXCreateTextureFromFile(g_pd3dDevice, L"effect_1.png", &g_pTexture5);
-	D3DXCreateTextureFromFile(g_pd3dDevice, L"effect_2.png", &g_pTexture6);
-	D3DXCreateTextureFromFile(g_pd3dDevice, L"effect_3.png", &g_pTexture7);
-	D3DXCreateTextureFromFile(g_pd3dDevice, L"effect_4.png", &g_pTexture8);
-	D3DXCreateTextureFromFile(g_pd3dDevice, L"effect_5.png", &g_pTexture9);
-	D3DXCreateTextureFromFile(g_pd3dDevice, L"effect_6.png", &g_pTexture10);
-	D3DXCreateTextureFromFile(g_pd3dDevice, L"effect_7.png", &g_pTexture11);
-	D3DXCreateTextureFromFile(g_pd3dDevice, L"effect_8.png", &g_pTexture12);
+	// 텍스처를 설정한다.
+	// 텍스처는 로더 스레드에서 병렬로 읽고 디코딩한다.
+	Loader_Init(g_pd3dDevice, 0, g_dwStartTime);
+	Res_Init(0);
+	g_hTexture0 = Res_AcquireTexture(L"attack_1.png", D3DX_DEFAULT, D3DX_DEFAULT, D3DFMT_UNKNOWN, 0, 0, 0);
+	g_hTexture1 = Res_AcquireTexture(L"attack_2.png", D3DX_DEFAULT, D3DX_DEFAULT, D3DFMT_UNKNOWN, 0, 0, 0);
+	g_hTexture2 = Res_AcquireTexture(L"attack_3.png", D3DX_DEFAULT, D3DX_DEFAULT, D3DFMT_UNKNOWN, 0, 0, 0);
+	g_hTexture3 = Res_AcquireTexture(L"attack_4.png", D3DX_DEFAULT, D3DX_DEFAULT, D3DFMT_UNKNOWN, 0, 0, 0);
+	g_hTexture4 = Res_AcquireTexture(L"attack_5.png", D3DX_DEFAULT, D3DX_DEFAULT, D3DFMT_UNKNOWN, 0, 0, 0);
+	g_hTexture5 = Res_AcquireTexture(L"effect_1.png", D3DX_DEFAULT, D3DX_DEFAULT, D3DFMT_UNKNOWN, 0, 0, 0);
+	g_hTexture6 = Res_AcquireTexture(L"effect_2.png", D3DX_DEFAULT, D3DX_DEFAULT, D3DFMT_UNKNOWN, 0, 0, 0);
+	g_hTexture7 = Res_AcquireTexture(L"effect_3.png", D3DX_DEFAULT, D3DX_DEFAULT, D3DFMT_UNKNOWN, 0, 0, 0);
+	g_hTexture8 = Res_AcquireTexture(L"effect_4.png", D3DX_DEFAULT, D3DX_DEFAULT, D3DFMT_UNKNOWN, 0, 0, 0);
+	g_hTexture9 = Res_AcquireTexture(L"effect_5.png", D3DX_DEFAULT, D3DX_DEFAULT, D3DFMT_UNKNOWN, 0, 0, 0);
+	g_hTexture10 = Res_AcquireTexture(L"effect_6.png", D3DX_DEFAULT, D3DX_DEFAULT, D3DFMT_UNKNOWN, 0, 0, 0);
+	g_hTexture11 = Res_AcquireTexture(L"effect_7.png", D3DX_DEFAULT, D3DX_DEFAULT, D3DFMT_UNKNOWN, 0, 0, 0);
+	g_hTexture12 = Res_AcquireTexture(L"effect_8.png", D3DX_DEFAULT, D3DX_DEFAULT, D3DFMT_UNKNOWN, 0, 0, 0);
 	
 	return S_OK;
 }
 
-// ü ҽ ȯϴ Լ
+// 객체 리소스를 반환하는 함수
 VOID Cleanup()
 {
-	// ü ҽ ȯϴ  ߿ϴ.
-	//   ߸Ǹ  ߻Ų.
-	//  
+	// 객체의 리소스를 반환하는 순서가 중요하다.
+	// 이 순서가 잘못되면 에러를 발생시킨다.
+	// 생성의 역순
 
-	if (g_pTexture0 != nullptr) {
-		g_pTexture0->Release();
-	}
+	Loader_Release();
 
-	if (g_pTexture1 != nullptr) {
-		g_pTexture1->Release();
+	// 핸들을 모두 반환하고, 남은 참조는 디버그 출력으로 보고한다.
+	TEXTUREHANDLE* textures[] = { &g_hTexture0, &g_hTexture1, &g_hTexture2, &g_hTexture3, &g_hTexture4, &g_hTexture5, &g_hTexture6,
+		&g_hTexture7, &g_hTexture8, &g_hTexture9, &g_hTexture10, &g_hTexture11, &g_hTexture12 };
+	for (int i = 0; i < (int)(sizeof(textures) / sizeof(textures[0])); i++) {
+		Res_Release(textures[i]);
 	}
+	Res_Shutdown();
 
 	if (g_pVB != nullptr) {
 		g_pVB->Release();
@@ -198,94 +212,95 @@ VOID Cleanup()
 	}
 }
 
-// ȭ ׸ Լ
+// 화면을 그리는 함수
 VOID Render()
 {
-	if (nullptr == g_pD3D || nullptr == g_pd3dDevice || nullptr == g_pVB || nullptr == g_pTexture0 || nullptr == g_pTexture1) {
+	// 텍스처는 로딩되는 동안 nullptr일 수 있다.
+	if (nullptr == g_pD3D || nullptr == g_pd3dDevice || nullptr == g_pVB) {
 		return;
 	}
 
-	// ĸ ۸ Ķ ä. z۸ .
+	// 후면 버퍼를 파란색으로 채운다. z버퍼를 지운다.
 	g_pd3dDevice->Clear(0, NULL, D3DCLEAR_TARGET | D3DCLEAR_ZBUFFER, D3DCOLOR_XRGB(0, 0, 0), 1.0f, 0);
 
-	// ̾  .
+	// 와이어 프레임으로 본다.
 	//g_pd3dDevice->SetRenderState(D3DRS_FILLMODE, D3DFILL_WIREFRAME);
 
-	// BeginScene() Լ ̽ Rendering  ˸.
+	// BeginScene() 함수로 디바이스에게 Rendering 시작을 알린다.
 	if (SUCCEEDED(g_pd3dDevice->BeginScene())) {
 
 		SetupMatrices();
 
-		//  ؽó  ҴѴ.
+		// 생성한 텍스처에 스테이지를 할당한다.
 
 		switch ((int)counter1 % 7)
 		{
 		case 0:
-			g_pd3dDevice->SetTexture(0, g_pTexture0);
+			g_pd3dDevice->SetTexture(0, Res_GetTexture(g_hTexture0));
 			break;
 		case 1:
-			g_pd3dDevice->SetTexture(0, g_pTexture1);
+			g_pd3dDevice->SetTexture(0, Res_GetTexture(g_hTexture1));
 			break;
 		case 2:
-			g_pd3dDevice->SetTexture(0, g_pTexture2);
+			g_pd3dDevice->SetTexture(0, Res_GetTexture(g_hTexture2));
 			break;
 		case 3:
-			g_pd3dDevice->SetTexture(0, g_pTexture3);
+			g_pd3dDevice->SetTexture(0, Res_GetTexture(g_hTexture3));
 			break;
 		case 4:
-			g_pd3dDevice->SetTexture(0, g_pTexture4);
+			g_pd3dDevice->SetTexture(0, Res_GetTexture(g_hTexture4));
 			break;
 		case 5:
-			g_pd3dDevice->SetTexture(0, g_pTexture1);
+			g_pd3dDevice->SetTexture(0, Res_GetTexture(g_hTexture1));
 			break;
 		case 6:
-			g_pd3dDevice->SetTexture(0, g_pTexture0);
+			g_pd3dDevice->SetTexture(0, Res_GetTexture(g_hTexture0));
 			break;
 		}
 
 		switch ((int)counter2 % 8)
 		{
 		case 0:
-			g_pd3dDevice->SetTexture(1, g_pTexture5);
+			g_pd3dDevice->SetTexture(1, Res_GetTexture(g_hTexture5));
 			break;					
 		case 1:						 
-			g_pd3dDevice->SetTexture(1, g_pTexture6);
+			g_pd3dDevice->SetTexture(1, Res_GetTexture(g_hTexture6));
 			break;					 
 		case 2:						 
-			g_pd3dDevice->SetTexture(1, g_pTexture7);
+			g_pd3dDevice->SetTexture(1, Res_GetTexture(g_hTexture7));
 			break;					 
 		case 3:						 
-			g_pd3dDevice->SetTexture(1, g_pTexture8);
+			g_pd3dDevice->SetTexture(1, Res_GetTexture(g_hTexture8));
 			break;					 
 		case 4:						 
-			g_pd3dDevice->SetTexture(1, g_pTexture9);
+			g_pd3dDevice->SetTexture(1, Res_GetTexture(g_hTexture9));
 			break;					 
 		case 5:						 
-			g_pd3dDevice->SetTexture(1, g_pTexture10);
+			g_pd3dDevice->SetTexture(1, Res_GetTexture(g_hTexture10));
 			break;
 		case 6:
-			g_pd3dDevice->SetTexture(1, g_pTexture11);
+			g_pd3dDevice->SetTexture(1, Res_GetTexture(g_hTexture11));
 			break;
 		case 7:
-			g_pd3dDevice->SetTexture(1, g_pTexture12);
+			g_pd3dDevice->SetTexture(1, Res_GetTexture(g_hTexture12));
 			break;
 		}
 
 
 
 
-		// 0 ؽó 0 ؽó ε Ѵ.(FVF  8 ؽó ε ִ)
+		// 0번 텍스처에 0번 텍스처 인덱스를 사용한다.(FVF에 정점마다 8개의 텍스처 인덱스가 있다)
 		g_pd3dDevice->SetTextureStageState(0, D3DTSS_TEXCOORDINDEX, 0);
-		// 1 ؽó 0 ؽó ε Ѵ.
+		// 1번 텍스처에 0번 텍스처 인덱스를 사용한다.
 		g_pd3dDevice->SetTextureStageState(1, D3DTSS_TEXCOORDINDEX, 0);
 
-		// ؽó  Ҷ Ȯ ͸ ϰ, Linear  Ѵ.
+		// 텍스처 맵핑을 할때 확대 필터를 사용하고, Linear 방식으로 보간한다.
 		g_pd3dDevice->SetSamplerState(0, D3DSAMP_MAGFILTER, D3DTEXF_LINEAR);
 		g_pd3dDevice->SetSamplerState(1, D3DSAMP_MAGFILTER, D3DTEXF_LINEAR);
 
-		// D3DTSS_COLOROP, D3DTSS_ALPHAOP Բ
-		// D3DTOP_SELECTARG1 ϸ ̹ stage input ٷ output Ѵ.
-		// 0  ÷    ״ output ޵ȴ.
+		// D3DTSS_COLOROP, D3DTSS_ALPHAOP과 함께
+		// D3DTOP_SELECTARG1를 사용하면 이번 stage에 input를 바로 output으로 전달한다.
+		// 0번 스테이지의 컬러 값과 알파 값이 그대로 output으로 전달된다.
 		g_pd3dDevice->SetTextureStageState(0, D3DTSS_COLOROP, D3DTOP_SELECTARG1);
 
 		g_pd3dDevice->SetTextureStageState(0, D3DTSS_COLORARG1, D3DTA_TEXTURE);
@@ -294,81 +309,83 @@ VOID Render()
 
 		g_pd3dDevice->SetTextureStageState(0, D3DTSS_ALPHAARG1, D3DTA_TEXTURE);
 
-		// color operation modulate 
+		// color operation을 modulate로 설정
 		g_pd3dDevice->SetTextureStageState(1, D3DTSS_COLOROP, D3DTOP_ADD);
 
 		g_pd3dDevice->SetTextureStageState(1, D3DTSS_ALPHAOP, D3DTOP_MODULATE);
 
-		// ÷ ù ° ڴ   ؽó ÷ 
+		// 컬러의 첫 번째 인자는 현재 스테이지의 텍스처의 컬러 값
 		g_pd3dDevice->SetTextureStageState(1, D3DTSS_COLORARG1, D3DTA_TEXTURE);
 
-		// ÷  ° ڴ   ޵ ÷ 
+		// 컬러의 두 번째 인자는 이전 스테이지에서 전달된 컬러 값
 		g_pd3dDevice->SetTextureStageState(1, D3DTSS_COLORARG2, D3DTA_CURRENT);
 
-		//  ù ° ڴ   ؽó  
+		// 알파의 첫 번째 인자는 현재 스테이지의 텍스처의 알파 값
 		g_pd3dDevice->SetTextureStageState(1, D3DTSS_ALPHAARG1, D3DTA_TEXTURE);
 
-		//   ° ڴ   ޵  
+		// 알파의 두 번째 인자는 이전 스테이지에서 전달된 알파 값
 		g_pd3dDevice->SetTextureStageState(1, D3DTSS_ALPHAARG2, D3DTA_CURRENT);
 
-		// ᱹ SetTextureStageState() Լ Ͽ ؽó1 ؽó2  Ͽ.
+		// 결국 SetTextureStageState() 함수를 사용하여 텍스처1과 텍스처2의 알파 블랜딩하였다.
 
 
-		// 3° ʹ ÷ İ    ʴ´.
+		// 3번째 스테이지에서부터는 컬러와 알파값에 대한 연산을 하지 않는다.
 		g_pd3dDevice->SetTextureStageState(2, D3DTSS_COLOROP, D3DTOP_DISABLE);
 		g_pd3dDevice->SetTextureStageState(2, D3DTSS_ALPHAOP, D3DTOP_DISABLE);
 
 
-		//  ۸  Ʈ Ѵ.
+		// 정점 버퍼를 출력 스트림으로 설정한다.
 		g_pd3dDevice->SetStreamSource(0, g_pVB, 0, sizeof(CUSTOMVERTEX));
 
-		// D3D   Ѵ.
+		// D3D에 정점 정보를 제공한다.
 		g_pd3dDevice->SetFVF(D3DFVF_CUSTOMVERTEX);
 
-		//   ü ׸.
+		// 실제 기하 물체를 그린다.
 		g_pd3dDevice->DrawPrimitive(D3DPT_TRIANGLELIST, 0, 2);
 
-		// Rendering  ˸.
+		// Rendering이 끝났음을 알린다.
 		g_pd3dDevice->EndScene();
 	}
 
-	// ĸ ۸  ׸ ۷ Ѵ.
-	// Double Buffering( ) õ ̴.
-	//  ۸ ϸ鼭  Լ    ׷ ʴ´.
+	// 후면 버퍼를 현재 그리는 버퍼로 설정한다.
+	// Double Buffering(이중 버퍼)와 관련된 내용이다.
+	// 이중 버퍼를 사용하면서 이 함수를 실행하지 않으면 제대로 그려지지 않는다.
 	g_pd3dDevice->Present(NULL, NULL, NULL, NULL);
+
+	Loader_FirstFrame();
 }
 
-// , ,   
+// 월드, 뷰, 프로젝션 행렬 설정
 VOID SetupMatrices()
 {
-	//   
-	D3DXMATRIXA16 matWorld;
-
-	D3DXMatrixIdentity(&matWorld);
-	// Ʒ ּ ϸ  x  ȸѴ.
-	//D3DXMatrixRotationX( &matWorld, timeGetTime() / 500.0f );
-	g_pd3dDevice->SetTransform(D3DTS_WORLD, &matWorld);
-
-	//   
-	D3DXVECTOR3 vEyePt(0.0f, 0.0f, -3.0f);  // ī޶ ġ
-	D3DXVECTOR3 vLookatPt(0.0f, 0.0f, 0.0f);    // ī޶ ٶ󺸴 
-	D3DXVECTOR3 vUpVec(0.0f, 1.0f, 0.0f);   // ī޶ ⺤
-
-	D3DXMATRIXA16 matView;
-	// ī޶ ȯ  
-	D3DXMatrixLookAtLH(&matView, &vEyePt, &vLookatPt, &vUpVec);
-	//  ī޶ ȯ  
-	g_pd3dDevice->SetTransform(D3DTS_VIEW, &matView);
-
-	//   
-	D3DXMATRIXA16 matProj;
-	//  ȯ  
-	D3DXMatrixPerspectiveFovLH(&matProj, D3DX_PI / 2, 1.0f, 1.0f, 100.f);
-	//   ȯ  
-	g_pd3dDevice->SetTransform(D3DTS_PROJECTION, &matProj);
+	// 월드 행렬 설정
+	MAT4 matWorld;
+
+	Mat4_Identity(&matWorld);
+	// 아래줄의 주석을 해제하면 원통이 x축을 기준으로 회전한다.
+	//Mat4_RotationX( &matWorld, timeGetTime() / 500.0f );
+	g_pd3dDevice->SetTransform(D3DTS_WORLD, (D3DMATRIX*)&matWorld);
+
+	// 뷰 행렬 설정
+	VEC3 vEyePt = Vec3(0.0f, 0.0f, -3.0f);  // 카메라의 위치
+	VEC3 vLookatPt = Vec3(0.0f, 0.0f, 0.0f);    // 카메라가 바라보는 지점
+	VEC3 vUpVec = Vec3(0.0f, 1.0f, 0.0f);   // 카메라의 상향벡터
+
+	MAT4 matView;
+	// 카메라 변환 행렬 계산
+	Mat4_LookAtLH(&matView, vEyePt, vLookatPt, vUpVec);
+	// 계산된 카메라 변환 행렬을 적용
+	g_pd3dDevice->SetTransform(D3DTS_VIEW, (D3DMATRIX*)&matView);
+
+	// 프로젝션 행렬 설정
+	MAT4 matProj;
+	// 투영 변환 행렬 계산
+	Mat4_PerspectiveFovLH(&matProj, VECMATH_PI / 2, 1.0f, 1.0f, 100.f);
+	// 계산된 투영 변환 행렬을 적용
+	g_pd3dDevice->SetTransform(D3DTS_PROJECTION, (D3DMATRIX*)&matProj);
 }
 
-//  ν Լ
+// 윈도우 프로시저 함수
 LRESULT WINAPI MsgProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam)
 {
 	switch (msg) {
@@ -380,7 +397,7 @@ LRESULT WINAPI MsgProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam)
 		PostQuitMessage(0);
 		return 0;
 
-		// ޼  
+		// 메세지 루프 변경
 		/*case WM_PAINT:
 		Render();
 		ValidateRect(hWnd, NULL);
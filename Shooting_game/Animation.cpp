@@ -0,0 +1,169 @@
+#include "Animation.h"
+#include <math.h>
+
+// Clip table. Frame times keep the pace the old per-frame counters had at
+// 60 Hz (half a sheet frame per rendered frame).
+static const ANIMCLIP g_AnimClips[CLIP_NUM] =
+{
+	//  x  y   w    h  count  sec/frame   mode
+	{ 0, 0,  64,  64, 11, 1.0f / 30.0f, ANIM_LOOP },	// CLIP_HERO_IDLE   img\sasuke(w).png
+	{ 0, 0,  64,  64,  4, 1.0f / 30.0f, ANIM_ONCE },	// CLIP_HERO_ATTACK img\attack(w).png
+	{ 0, 0,  64,  64,  3, 1.0f / 30.0f, ANIM_LOOP },	// CLIP_BULLET      img\weapon.png
+	{ 0, 0, 300, 100,  1, 1.0f,         ANIM_LOOP },	// CLIP_SKILL       img\skill.png
+	{ 0, 0,  64,  64, 18, 1.0f / 30.0f, ANIM_LOOP },	// CLIP_ENEMY       img\enemy_1.png
+	{ 0, 0,  80,  80,  6, 1.0f / 30.0f, ANIM_LOOP },	// CLIP_EXPLOSION   img\explosion.png
+};
+
+// precomputed source rects, all clips back to back
+static ANIMRECT g_AnimRects[ANIM_MAX_RECTS];
+static int g_AnimFirstRect[CLIP_NUM];
+
+// player state, one slot per animated entity
+static int   g_nAnimPlayers = 0;
+static int   g_AnimClip[ANIM_MAX_PLAYERS];
+static float g_AnimTime[ANIM_MAX_PLAYERS];
+static float g_AnimLength[ANIM_MAX_PLAYERS];	// clip length in seconds
+static float g_AnimRate[ANIM_MAX_PLAYERS];		// frames per second
+static float g_AnimLoop[ANIM_MAX_PLAYERS];		// 1 = loop, 0 = hold last frame
+static int   g_AnimLast[ANIM_MAX_PLAYERS];		// index of the last frame
+static int   g_AnimFrame[ANIM_MAX_PLAYERS];
+
+//Anim_Init() : builds the source rect table from the clip table
+void Anim_Init(void)
+{
+	int nRect = 0;
+
+	for (int i = 0; i < CLIP_NUM; i++)
+	{
+		const ANIMCLIP& clip = g_AnimClips[i];
+
+		g_AnimFirstRect[i] = nRect;
+		for (int f = 0; f < clip.frameCount && nRect < ANIM_MAX_RECTS; f++, nRect++)
+		{
+			g_AnimRects[nRect].left = clip.x + f * clip.frameWidth;
+			g_AnimRects[nRect].top = clip.y;
+			g_AnimRects[nRect].right = clip.x + (f + 1) * clip.frameWidth;
+			g_AnimRects[nRect].bottom = clip.y + clip.frameHeight;
+		}
+	}
+
+	Anim_Reset();
+}
+
+//Anim_Reset() : frees every player slot
+void Anim_Reset(void)
+{
+	g_nAnimPlayers = 0;
+}
+
+//Anim_Create() : takes a new player slot and starts nClip on it, -1 when full
+int Anim_Create(int nClip)
+{
+	if (g_nAnimPlayers >= ANIM_MAX_PLAYERS)
+		return -1;
+
+	int nPlayer = g_nAnimPlayers++;
+	Anim_Play(nPlayer, nClip);
+
+	return nPlayer;
+}
+
+//Anim_Play() : switches a player to nClip and rewinds it
+void Anim_Play(int nPlayer, int nClip)
+{
+	if (nPlayer < 0 || nPlayer >= g_nAnimPlayers)
+		return;
+
+	const ANIMCLIP& clip = g_AnimClips[nClip];
+
+	g_AnimClip[nPlayer] = nClip;
+	g_AnimTime[nPlayer] = 0.0f;
+	g_AnimLength[nPlayer] = clip.frameCount * clip.frameTime;
+	g_AnimRate[nPlayer] = 1.0f / clip.frameTime;
+	g_AnimLoop[nPlayer] = (clip.loopMode == ANIM_LOOP) ? 1.0f : 0.0f;
+	g_AnimLast[nPlayer] = clip.frameCount - 1;
+	g_AnimFrame[nPlayer] = 0;
+}
+
+//Anim_Restart() : rewinds a player without changing its clip
+void Anim_Restart(int nPlayer)
+{
+	if (nPlayer < 0 || nPlayer >= g_nAnimPlayers)
+		return;
+
+	g_AnimTime[nPlayer] = 0.0f;
+	g_AnimFrame[nPlayer] = 0;
+}
+
+//Anim_Stop() : jumps to the end of the clip, so a ANIM_ONCE player reads as done
+void Anim_Stop(int nPlayer)
+{
+	if (nPlayer < 0 || nPlayer >= g_nAnimPlayers)
+		return;
+
+	g_AnimTime[nPlayer] = g_AnimLength[nPlayer];
+	g_AnimFrame[nPlayer] = g_AnimLast[nPlayer];
+}
+
+//Anim_Update() : advances all players by fElapsed seconds
+//Straight-line float math over the state arrays so the compiler can vectorize it.
+void Anim_Update(float fElapsed)
+{
+	for (int i = 0; i < g_nAnimPlayers; i++)
+	{
+		float time = g_AnimTime[i] + fElapsed;
+		float length = g_AnimLength[i];
+
+		float wrapped = time - length * floorf(time / length);
+		float held = (time < length) ? time : length;
+
+		time = g_AnimLoop[i] * wrapped + (1.0f - g_AnimLoop[i]) * held;
+		g_AnimTime[i] = time;
+
+		int frame = (int)(time * g_AnimRate[i]);
+		g_AnimFrame[i] = (frame < g_AnimLast[i]) ? frame : g_AnimLast[i];
+	}
+}
+
+//Anim_IsDone() : true once a ANIM_ONCE player has reached the end of its clip
+bool Anim_IsDone(int nPlayer)
+{
+	if (nPlayer < 0 || nPlayer >= g_nAnimPlayers)
+		return true;
+
+	return g_AnimLoop[nPlayer] == 0.0f && g_AnimTime[nPlayer] >= g_AnimLength[nPlayer];
+}
+
+int Anim_GetFrame(int nPlayer)
+{
+	if (nPlayer < 0 || nPlayer >= g_nAnimPlayers)
+		return 0;
+
+	return g_AnimFrame[nPlayer];
+}
+
+//Anim_GetRect() : source rect of the player's current frame
+const ANIMRECT* Anim_GetRect(int nPlayer)
+{
+	if (nPlayer < 0 || nPlayer >= g_nAnimPlayers)
+		return &g_AnimRects[0];
+
+	return &g_AnimRects[g_AnimFirstRect[g_AnimClip[nPlayer]] + g_AnimFrame[nPlayer]];
+}
+
+int Anim_GetClipFrames(int nClip)
+{
+	return g_AnimClips[nClip].frameCount;
+}
+
+//Anim_GetClipRect() : source rect of one frame of a clip, for sprites driven
+//by something other than a player slot
+const ANIMRECT* Anim_GetClipRect(int nClip, int nFrame)
+{
+	if (nFrame < 0)
+		nFrame = 0;
+	if (nFrame >= g_AnimClips[nClip].frameCount)
+		nFrame = g_AnimClips[nClip].frameCount - 1;
+
+	return &g_AnimRects[g_AnimFirstRect[nClip] + nFrame];
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+// Sprite sheet animation.
+// Clips are described by a data table (sheet origin, frame size, frame count,
+// seconds per frame, loop mode); their source rects are precomputed once in
+// Anim_Init(). Each animated entity owns a player slot, and all players are
+// advanced together by elapsed time in Anim_Update().
+
+#ifdef _WIN32
+#include <windows.h>
+typedef RECT ANIMRECT;
+#else
+struct ANIMRECT
+{
+	long left, top, right, bottom;
+};
+#endif
+
+#define ANIM_MAX_PLAYERS 256
+#define ANIM_MAX_RECTS   128
+
+enum { ANIM_LOOP, ANIM_ONCE };
+
+enum
+{
+	CLIP_HERO_IDLE,
+	CLIP_HERO_ATTACK,
+	CLIP_BULLET,
+	CLIP_SKILL,
+	CLIP_ENEMY,
+	CLIP_EXPLOSION,
+	CLIP_NUM
+};
+
+struct ANIMCLIP
+{
+	int x, y;                      // upper-left corner of the first frame in the sheet
+	int frameWidth, frameHeight;
+	int frameCount;                // frames laid out left to right
+	float frameTime;               // seconds per frame
+	int loopMode;                  // ANIM_LOOP or ANIM_ONCE
+};
+
+void Anim_Init(void);
+void Anim_Reset(void);
+int Anim_Create(int nClip);
+void Anim_Play(int nPlayer, int nClip);
+void Anim_Restart(int nPlayer);
+void Anim_Stop(int nPlayer);
+void Anim_Update(float fElapsed);
+bool Anim_IsDone(int nPlayer);
+int Anim_GetFrame(int nPlayer);
+const ANIMRECT* Anim_GetRect(int nPlayer);
+int Anim_GetClipFrames(int nClip);
+const ANIMRECT* Anim_GetClipRect(int nClip, int nFrame);
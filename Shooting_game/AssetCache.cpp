@@ -0,0 +1,489 @@
+#include "AssetCache.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#ifdef _WIN32
+#include <windows.h>
+#include <direct.h>
+#else
+#include <poll.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+struct ASSETENTRY
+{
+	char szSource[ASSETCACHE_PATH_LEN];
+	int type;
+	TEXCOOKSETTINGS settings;
+	unsigned long long contentHash;    // of the bytes seen by the last AssetCache_Poll()
+	bool bTouched;                     // the watcher saw a write since the last poll
+};
+
+struct ASSETWATCH
+{
+	char szDir[ASSETCACHE_PATH_LEN];
+	std::thread thread;
+#ifdef _WIN32
+	HANDLE hDir;
+#else
+	int fd;
+#endif
+};
+
+static char g_szCacheDir[ASSETCACHE_PATH_LEN];
+static std::mutex g_CacheLock;
+static ASSETENTRY g_Assets[ASSETCACHE_MAX_ASSETS];
+static int g_nAssets = 0;
+static ASSETWATCH g_Watches[ASSETCACHE_MAX_WATCHES];
+static int g_nWatches = 0;
+static std::atomic<bool> g_bCacheClosing(false);
+static std::atomic<unsigned int> g_nCacheTemp(0);
+static ASSETCACHESTATS g_CacheStats;
+
+static unsigned long long AssetCache_Hash(unsigned long long hash, const void* pData, size_t nSize)
+{
+	const unsigned char* p = (const unsigned char*)pData;
+
+	for (size_t i = 0; i < nSize; i++)
+	{
+		hash ^= p[i];
+		hash *= 1099511628211ull;
+	}
+
+	return hash;
+}
+
+static unsigned char* AssetCache_ReadFile(const char* pFile, size_t* pSize)
+{
+	FILE* fp = fopen(pFile, "rb");
+	if (fp == NULL)
+		return NULL;
+
+	fseek(fp, 0, SEEK_END);
+	long nSize = ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+
+	unsigned char* pData = (nSize > 0) ? (unsigned char*)malloc(nSize) : NULL;
+	if (pData != NULL && fread(pData, 1, nSize, fp) != (size_t)nSize)
+	{
+		free(pData);
+		pData = NULL;
+	}
+	fclose(fp);
+
+	*pSize = (size_t)nSize;
+	return pData;
+}
+
+// 0 when the file cannot be read
+static unsigned long long AssetCache_HashFile(const char* pFile)
+{
+	size_t nSize;
+	unsigned char* pData = AssetCache_ReadFile(pFile, &nSize);
+	if (pData == NULL)
+		return 0;
+
+	unsigned long long hash = AssetCache_Hash(14695981039346656037ull, pData, nSize);
+	free(pData);
+
+	return hash;
+}
+
+// separators match either way, and case is ignored where the file system ignores it
+static bool AssetCache_SamePath(const char* pA, const char* pB)
+{
+	for (; *pA != '\0' && *pB != '\0'; pA++, pB++)
+	{
+		char a = (*pA == '\\') ? '/' : *pA;
+		char b = (*pB == '\\') ? '/' : *pB;
+#ifdef _WIN32
+		a = (char)tolower((unsigned char)a);
+		b = (char)tolower((unsigned char)b);
+#endif
+		if (a != b)
+			return false;
+	}
+
+	return *pA == *pB;
+}
+
+static void AssetCache_MakeDir(const char* pDir)
+{
+#ifdef _WIN32
+	_mkdir(pDir);
+#else
+	mkdir(pDir, 0755);
+#endif
+}
+
+bool AssetCache_Init(const char* pCacheDir)
+{
+	std::lock_guard<std::mutex> lock(g_CacheLock);
+
+	snprintf(g_szCacheDir, sizeof(g_szCacheDir), "%s", pCacheDir);
+	AssetCache_MakeDir(pCacheDir);
+
+	g_nAssets = 0;
+	g_bCacheClosing = false;
+	memset(&g_CacheStats, 0, sizeof(g_CacheStats));
+
+	return true;
+}
+
+int AssetCache_Register(const char* pSource, int type, const TEXCOOKSETTINGS* pSettings)
+{
+	std::lock_guard<std::mutex> lock(g_CacheLock);
+
+	if (g_nAssets >= ASSETCACHE_MAX_ASSETS)
+		return -1;
+
+	ASSETENTRY& entry = g_Assets[g_nAssets];
+	snprintf(entry.szSource, sizeof(entry.szSource), "%s", pSource);
+	entry.type = type;
+	memset(&entry.settings, 0, sizeof(entry.settings));
+	if (pSettings != NULL)
+		entry.settings = *pSettings;
+	entry.contentHash = 0;    // taken by the watcher of its folder, startup does not read the file
+	entry.bTouched = false;
+
+	return g_nAssets++;
+}
+
+int AssetCache_Find(const char* pSource)
+{
+	std::lock_guard<std::mutex> lock(g_CacheLock);
+
+	for (int i = 0; i < g_nAssets; i++)
+	{
+		if (AssetCache_SamePath(g_Assets[i].szSource, pSource))
+			return i;
+	}
+
+	return -1;
+}
+
+const char* AssetCache_GetSource(int asset)
+{
+	return g_Assets[asset].szSource;
+}
+
+int AssetCache_GetType(int asset)
+{
+	return g_Assets[asset].type;
+}
+
+//AssetCache_GetCooked() : the cache key covers the source bytes, the cook
+//settings and the container version, so a hit never needs a timestamp check
+bool AssetCache_GetCooked(int asset, char* pCooked, size_t nCooked)
+{
+	char szSource[ASSETCACHE_PATH_LEN];
+	TEXCOOKSETTINGS settings;
+	{
+		std::lock_guard<std::mutex> lock(g_CacheLock);
+
+		if (asset < 0 || asset >= g_nAssets || g_Assets[asset].type != ASSET_TEXTURE)
+			return false;
+		memcpy(szSource, g_Assets[asset].szSource, sizeof(szSource));
+		settings = g_Assets[asset].settings;
+	}
+
+	size_t nSize;
+	unsigned char* pData = AssetCache_ReadFile(szSource, &nSize);
+	if (pData == NULL)
+		return false;
+
+	unsigned int key[6] = { TEXFILE_VERSION, settings.bColorKey ? settings.colorKey : 0,
+		(unsigned int)settings.bColorKey, (unsigned int)settings.bPremultiply, (unsigned int)settings.bMips,
+		(unsigned int)settings.format };
+	unsigned long long hash = AssetCache_Hash(14695981039346656037ull, pData, nSize);
+	hash = AssetCache_Hash(hash, key, sizeof(key));
+
+	snprintf(pCooked, nCooked, "%s/%016llx.ctex", g_szCacheDir, hash);
+
+	TEXFILE tex;
+	if (TexFile_Open(pCooked, &tex))
+	{
+		TexFile_Close(&tex);
+		free(pData);
+
+		std::lock_guard<std::mutex> lock(g_CacheLock);
+		g_CacheStats.nHits++;
+		return true;
+	}
+
+	// cooked under a private name and renamed, so no reader sees a half-written file
+	char szTemp[ASSETCACHE_PATH_LEN + 16];
+	snprintf(szTemp, sizeof(szTemp), "%s.%u.tmp", pCooked, g_nCacheTemp++);
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	bool bOk = TexFile_CookMemory(pData, nSize, szTemp, settings, NULL);
+	float fTime = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+	free(pData);
+
+	// another thread may have cooked the same content meanwhile
+	if (bOk && rename(szTemp, pCooked) != 0)
+	{
+		remove(szTemp);
+		bOk = TexFile_Open(pCooked, &tex);
+		if (bOk)
+			TexFile_Close(&tex);
+	}
+
+	std::lock_guard<std::mutex> lock(g_CacheLock);
+	g_CacheStats.fCookTime += fTime;
+	if (bOk)
+		g_CacheStats.nCooked++;
+	else
+		g_CacheStats.nFailed++;
+
+	return bOk;
+}
+
+//AssetCache_Touch() : called by the watchers with the path of a written file
+static void AssetCache_Touch(const char* pDir, const char* pName)
+{
+	char szPath[ASSETCACHE_PATH_LEN];
+	snprintf(szPath, sizeof(szPath), "%s/%s", pDir, pName);
+
+	std::lock_guard<std::mutex> lock(g_CacheLock);
+
+	for (int i = 0; i < g_nAssets; i++)
+	{
+		if (AssetCache_SamePath(g_Assets[i].szSource, szPath))
+			g_Assets[i].bTouched = true;
+	}
+}
+
+//AssetCache_HashDir() : takes the content hashes AssetCache_Poll() compares
+//against for the assets in the folder; the folder is already watched, so a
+//write during hashing is still reported
+static void AssetCache_HashDir(const char* pDir)
+{
+	size_t nDir = strlen(pDir);
+
+	for (int i = 0; ; i++)
+	{
+		char szSource[ASSETCACHE_PATH_LEN];
+		{
+			std::lock_guard<std::mutex> lock(g_CacheLock);
+
+			if (i >= g_nAssets)
+				break;
+			if (g_Assets[i].contentHash != 0)
+				continue;
+			memcpy(szSource, g_Assets[i].szSource, sizeof(szSource));
+		}
+
+		if (strlen(szSource) <= nDir || (szSource[nDir] != '/' && szSource[nDir] != '\\'))
+			continue;
+		szSource[nDir] = '\0';
+		if (!AssetCache_SamePath(szSource, pDir))
+			continue;
+		szSource[nDir] = '/';
+
+		unsigned long long hash = AssetCache_HashFile(szSource);
+
+		std::lock_guard<std::mutex> lock(g_CacheLock);
+		if (g_Assets[i].contentHash == 0)
+			g_Assets[i].contentHash = hash;
+	}
+}
+
+#ifdef _WIN32
+static void AssetCache_WatchProc(ASSETWATCH* pWatch)
+{
+	DWORD buffer[4096];
+	OVERLAPPED overlapped;
+	ZeroMemory(&overlapped, sizeof(overlapped));
+	overlapped.hEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
+
+	AssetCache_HashDir(pWatch->szDir);
+
+	while (!g_bCacheClosing)
+	{
+		DWORD nBytes = 0;
+		if (!ReadDirectoryChangesW(pWatch->hDir, buffer, sizeof(buffer), FALSE,
+			FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME, NULL, &overlapped, NULL))
+			break;
+
+		while (!g_bCacheClosing && WaitForSingleObject(overlapped.hEvent, 100) == WAIT_TIMEOUT);
+
+		if (g_bCacheClosing)
+		{
+			CancelIo(pWatch->hDir);
+			GetOverlappedResult(pWatch->hDir, &overlapped, &nBytes, TRUE);
+			break;
+		}
+
+		if (!GetOverlappedResult(pWatch->hDir, &overlapped, &nBytes, FALSE))
+			break;
+		ResetEvent(overlapped.hEvent);
+
+		// nBytes is 0 when the buffer overflowed, the events are lost then
+		const BYTE* p = (const BYTE*)buffer;
+		for (DWORD offset = 0; nBytes > 0; )
+		{
+			const FILE_NOTIFY_INFORMATION* pInfo = (const FILE_NOTIFY_INFORMATION*)(p + offset);
+			char szName[ASSETCACHE_PATH_LEN];
+			int nName = WideCharToMultiByte(CP_ACP, 0, pInfo->FileName, pInfo->FileNameLength / sizeof(WCHAR),
+				szName, sizeof(szName) - 1, NULL, NULL);
+
+			if (nName > 0 && (pInfo->Action == FILE_ACTION_MODIFIED || pInfo->Action == FILE_ACTION_ADDED ||
+				pInfo->Action == FILE_ACTION_RENAMED_NEW_NAME))
+			{
+				szName[nName] = '\0';
+				AssetCache_Touch(pWatch->szDir, szName);
+			}
+
+			if (pInfo->NextEntryOffset == 0)
+				break;
+			offset += pInfo->NextEntryOffset;
+		}
+	}
+
+	CloseHandle(overlapped.hEvent);
+}
+#else
+static void AssetCache_WatchProc(ASSETWATCH* pWatch)
+{
+	char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+	struct pollfd pfd;
+	pfd.fd = pWatch->fd;
+	pfd.events = POLLIN;
+
+	AssetCache_HashDir(pWatch->szDir);
+
+	while (!g_bCacheClosing)
+	{
+		if (poll(&pfd, 1, 100) <= 0)
+			continue;
+
+		ssize_t nBytes = read(pWatch->fd, buffer, sizeof(buffer));
+		for (ssize_t offset = 0; offset < nBytes; )
+		{
+			const struct inotify_event* pEvent = (const struct inotify_event*)(buffer + offset);
+
+			if (pEvent->len > 0)
+				AssetCache_Touch(pWatch->szDir, pEvent->name);
+			offset += sizeof(struct inotify_event) + pEvent->len;
+		}
+	}
+}
+#endif
+
+bool AssetCache_Watch(const char* pDir)
+{
+	std::lock_guard<std::mutex> lock(g_CacheLock);
+
+	if (g_nWatches >= ASSETCACHE_MAX_WATCHES)
+		return false;
+
+	ASSETWATCH& watch = g_Watches[g_nWatches];
+	snprintf(watch.szDir, sizeof(watch.szDir), "%s", pDir);
+
+#ifdef _WIN32
+	watch.hDir = CreateFileA(pDir, FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+		NULL, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, NULL);
+	if (watch.hDir == INVALID_HANDLE_VALUE)
+		return false;
+#else
+	watch.fd = inotify_init1(IN_NONBLOCK);
+	if (watch.fd < 0)
+		return false;
+	if (inotify_add_watch(watch.fd, pDir, IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+	{
+		close(watch.fd);
+		return false;
+	}
+#endif
+
+	watch.thread = std::thread(AssetCache_WatchProc, &watch);
+	g_nWatches++;
+
+	return true;
+}
+
+//AssetCache_Poll() : editors often write a file several times or rewrite it
+//unchanged, so touched assets are compared by content before being reported
+int AssetCache_Poll(int* pChanged, int nMax)
+{
+	int touched[ASSETCACHE_MAX_ASSETS];
+	int nTouched = 0;
+	{
+		std::lock_guard<std::mutex> lock(g_CacheLock);
+
+		for (int i = 0; i < g_nAssets; i++)
+		{
+			if (g_Assets[i].bTouched)
+			{
+				g_Assets[i].bTouched = false;
+				touched[nTouched++] = i;
+			}
+		}
+	}
+
+	int nChanged = 0;
+	for (int i = 0; i < nTouched; i++)
+	{
+		ASSETENTRY& entry = g_Assets[touched[i]];
+
+		// no room left, keep it for the next call
+		if (nChanged == nMax)
+		{
+			std::lock_guard<std::mutex> lock(g_CacheLock);
+			entry.bTouched = true;
+			continue;
+		}
+
+		unsigned long long hash = AssetCache_HashFile(entry.szSource);
+
+		// a file caught halfway through a save shows up again when it is closed
+		if (hash == 0)
+			continue;
+		{
+			std::lock_guard<std::mutex> lock(g_CacheLock);
+			if (hash == entry.contentHash)
+				continue;
+			entry.contentHash = hash;
+		}
+
+		pChanged[nChanged++] = touched[i];
+	}
+
+	std::lock_guard<std::mutex> lock(g_CacheLock);
+	g_CacheStats.nChanged += nChanged;
+
+	return nChanged;
+}
+
+const ASSETCACHESTATS& AssetCache_GetStats(void)
+{
+	return g_CacheStats;
+}
+
+void AssetCache_Release(void)
+{
+	g_bCacheClosing = true;
+
+	for (int i = 0; i < g_nWatches; i++)
+	{
+		g_Watches[i].thread.join();
+#ifdef _WIN32
+		CloseHandle(g_Watches[i].hDir);
+#else
+		close(g_Watches[i].fd);
+#endif
+	}
+
+	g_nWatches = 0;
+	g_nAssets = 0;
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include "TexCook.h"
+
+// Content-addressed asset cache with hot reload.
+// Cooked textures are kept in the cache folder under a 64-bit hash of the
+// source bytes and the cook settings, so each distinct content is cooked
+// once: later runs, reverted edits and identical copies all reuse the
+// cooked file. Watched folders are monitored by background threads
+// (ReadDirectoryChangesW on Windows, inotify elsewhere). AssetCache_Poll()
+// re-hashes the registered assets that were touched and reports only the
+// ones whose bytes actually changed, so the owner can reload and swap them.
+// Registering does not read the asset; the watcher of its folder takes the
+// first hash in the background, so startup pays nothing for the watch.
+
+#define ASSETCACHE_MAX_ASSETS   64
+#define ASSETCACHE_MAX_WATCHES  8
+#define ASSETCACHE_PATH_LEN     260
+
+enum { ASSET_TEXTURE, ASSET_RAW };    // raw assets are watched but not cooked
+
+struct ASSETCACHESTATS
+{
+	int nHits;          // cooked files reused from the cache
+	int nCooked;
+	int nFailed;
+	int nChanged;       // assets reported by AssetCache_Poll()
+	float fCookTime;    // seconds, summed over threads
+};
+
+bool AssetCache_Init(const char* pCacheDir);
+int AssetCache_Register(const char* pSource, int type, const TEXCOOKSETTINGS* pSettings);    // returns the asset id, -1 when full
+int AssetCache_Find(const char* pSource);
+const char* AssetCache_GetSource(int asset);
+int AssetCache_GetType(int asset);
+bool AssetCache_GetCooked(int asset, char* pCooked, size_t nCooked);    // cooks on a miss, any thread
+bool AssetCache_Watch(const char* pDir);
+int AssetCache_Poll(int* pChanged, int nMax);    // ids of assets whose content changed since the last call
+const ASSETCACHESTATS& AssetCache_GetStats(void);
+void AssetCache_Release(void);
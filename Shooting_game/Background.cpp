@@ -0,0 +1,369 @@
+#include "Background.h"
+#include "Loader.h"
+#include "TexCook.h"
+#include "FileMap.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+
+#define BG_SCREEN_WIDTH 800
+#define BG_TILE_DIR     "cache\\bg"
+#define BG_COLOR_KEY    0xffff00ff
+
+// layer table, back to front: the whole sky far away, and its lowest band
+// again in front of it, closer and faster
+static const BGLAYER g_BGLayers[] =
+{
+	{ "img\\nightskycut.png", 800, 560, 50, 500, 50.0f, 0.25f },
+	{ "img\\nightskycut.png", 800, 560, 400, 160, 390.0f, 0.6f },
+};
+static const int g_nBGLayers = sizeof(g_BGLayers) / sizeof(g_BGLayers[0]);
+
+enum { BGTILE_EMPTY, BGTILE_LOADING, BGTILE_READY, BGTILE_FAILED };
+enum { BGCOOK_NONE, BGCOOK_RUNNING, BGCOOK_DONE, BGCOOK_FAILED };
+
+// tile cache slot; a worker owns it while it is BGTILE_LOADING
+struct BGTILE
+{
+	LPDIRECT3DTEXTURE9 pTexture;
+	int layer;
+	int column;          // column of the layer's stretch, -1 when the slot is empty
+	DWORD lastUsed;
+	std::atomic<int> state;
+};
+
+static LPDIRECT3DDEVICE9 g_pBGDevice = NULL;
+static BGTILE g_BGCache[BG_CACHE_SIZE];
+static DWORD g_dwBGTick = 0;
+static float g_fBGScroll = 0.0f;
+static BGSTATS g_BGStats;
+static std::atomic<int> g_nBGCook(BGCOOK_NONE);
+
+//Background_Init() : creates the empty tile textures of the cache
+HRESULT Background_Init(LPDIRECT3DDEVICE9 pDevice)
+{
+	g_pBGDevice = pDevice;
+	g_fBGScroll = 0.0f;
+	g_dwBGTick = 0;
+	ZeroMemory(&g_BGStats, sizeof(g_BGStats));
+	g_nBGCook = BGCOOK_NONE;
+
+	for (int i = 0; i < BG_CACHE_SIZE; i++)
+	{
+		g_BGCache[i].layer = -1;
+		g_BGCache[i].column = -1;
+		g_BGCache[i].lastUsed = 0;
+		g_BGCache[i].state = BGTILE_EMPTY;
+
+		if (FAILED(pDevice->CreateTexture(BG_TILE_WIDTH, BG_TILE_HEIGHT, 1, 0, D3DFMT_A8R8G8B8,
+			D3DPOOL_MANAGED, &g_BGCache[i].pTexture, NULL)))
+		{
+			g_BGCache[i].pTexture = NULL;
+			return E_FAIL;
+		}
+	}
+
+	return S_OK;
+}
+
+//Background_Scroll() : moves the camera fDistance pixels along the level
+void Background_Scroll(float fDistance)
+{
+	g_fBGScroll += fDistance;
+}
+
+float Background_GetScroll(void)
+{
+	return g_fBGScroll;
+}
+
+// columns in one stretch of the layer: the source forward, then mirrored back
+static int BG_GetPeriod(const BGLAYER& desc)
+{
+	return 2 * (desc.srcWidth / BG_TILE_WIDTH);
+}
+
+static void BG_GetTileFile(char* pFile, size_t nFile, int layer, int column)
+{
+	snprintf(pFile, nFile, "%s\\%d_%d.ctex", BG_TILE_DIR, layer, column);
+}
+
+//BG_CutTile() : copies a column of the layer out of its source image; the
+//mirrored ones start where the source ends, so the seam is invisible
+static void BG_CutTile(const IMAGE* pSource, const BGLAYER& desc, int column, IMAGE* pTile)
+{
+	int nColumns = desc.srcWidth / BG_TILE_WIDTH;
+	bool bMirror = column >= nColumns;
+	int srcColumn = bMirror ? 2 * nColumns - 1 - column : column;
+
+	for (int y = 0; y < desc.tileHeight; y++)
+	{
+		const unsigned int* pRow = pSource->pixels + (desc.srcTop + y) * pSource->width + srcColumn * BG_TILE_WIDTH;
+		unsigned int* pDst = pTile->pixels + y * BG_TILE_WIDTH;
+		for (int x = 0; x < BG_TILE_WIDTH; x++)
+			pDst[x] = bMirror ? pRow[BG_TILE_WIDTH - 1 - x] : pRow[x];
+	}
+}
+
+//BG_IsCooked() : whether every tile file of the layer is there and was cut
+//from this version of the source
+static bool BG_IsCooked(int layer, unsigned int sourceHash)
+{
+	const BGLAYER& desc = g_BGLayers[layer];
+	char szFile[MAX_PATH];
+
+	for (int column = 0; column < BG_GetPeriod(desc); column++)
+	{
+		TEXFILE tex;
+		BG_GetTileFile(szFile, sizeof(szFile), layer, column);
+		if (!TexFile_Open(szFile, &tex))
+			return false;
+
+		bool bOk = tex.pHeader->sourceHash == sourceHash && tex.pHeader->format == TEXFILE_FORMAT_A8R8G8B8 &&
+			tex.pHeader->width == BG_TILE_WIDTH && tex.pHeader->height == (unsigned int)desc.tileHeight;
+		TexFile_Close(&tex);
+		if (!bOk)
+			return false;
+	}
+
+	return true;
+}
+
+//BG_CookTiles() : the loader task that cuts the layers into tile files once;
+//a source is only decoded when its tiles are missing or older than it, and
+//layers sharing a source decode it once
+static void BG_CookTiles(LPDIRECT3DDEVICE9 pDevice, void* pContext)
+{
+	TEXCOOKSETTINGS settings;
+	settings.bColorKey = true;
+	settings.colorKey = BG_COLOR_KEY;
+	settings.bPremultiply = false;
+	settings.bMips = false;
+	settings.format = TEXCOOK_A8R8G8B8;
+
+	IMAGE source;
+	source.pixels = NULL;
+	const char* pDecoded = NULL;
+	bool bOk = true;
+	char szFile[MAX_PATH];
+
+	CreateDirectoryA("cache", NULL);    // normally there already, AssetCache_Init() makes it
+	CreateDirectoryA(BG_TILE_DIR, NULL);
+
+	for (int layer = 0; layer < g_nBGLayers; layer++)
+	{
+		const BGLAYER& desc = g_BGLayers[layer];
+		FILEMAP map;
+		if (!FileMap_Open(desc.pSrcFile, &map))
+		{
+			bOk = false;
+			continue;
+		}
+
+		unsigned int hash = TexFile_Hash(map.pBase, map.nSize);
+		if (!BG_IsCooked(layer, hash))
+		{
+			if (pDecoded == NULL || strcmp(pDecoded, desc.pSrcFile) != 0)
+			{
+				Image_Free(&source);
+				pDecoded = Image_Decode(map.pBase, map.nSize, &source) ? desc.pSrcFile : NULL;
+			}
+
+			IMAGE tile;
+			if (pDecoded != NULL && source.width >= desc.srcWidth && source.height >= desc.srcTop + desc.tileHeight &&
+				Image_Create(&tile, BG_TILE_WIDTH, desc.tileHeight))
+			{
+				for (int column = 0; column < BG_GetPeriod(desc); column++)
+				{
+					BG_CutTile(&source, desc, column, &tile);
+					BG_GetTileFile(szFile, sizeof(szFile), layer, column);
+					if (!TexFile_CookImage(&tile, hash, szFile, settings, NULL))
+						bOk = false;
+				}
+				Image_Free(&tile);
+			}
+			else
+				bOk = false;
+		}
+
+		FileMap_Close(&map);
+	}
+
+	Image_Free(&source);
+	g_nBGCook.store(bOk ? BGCOOK_DONE : BGCOOK_FAILED, std::memory_order_release);
+}
+
+//BG_LoadTile() : the loader task that copies a cooked tile file into its
+//slot's texture; only that tile's rows are read
+static void BG_LoadTile(LPDIRECT3DDEVICE9 pDevice, void* pContext)
+{
+	BGTILE* pTile = (BGTILE*)pContext;
+	const BGLAYER& desc = g_BGLayers[pTile->layer];
+	char szFile[MAX_PATH];
+	BG_GetTileFile(szFile, sizeof(szFile), pTile->layer, pTile->column);
+
+	HRESULT hr = E_FAIL;
+	TEXFILE tex;
+	if (TexFile_Open(szFile, &tex))
+	{
+		const TEXFILELEVEL& level = tex.pLevels[0];
+		D3DLOCKED_RECT locked;
+
+		if (tex.pHeader->format == TEXFILE_FORMAT_A8R8G8B8 && level.width == BG_TILE_WIDTH &&
+			level.height == (unsigned int)desc.tileHeight && SUCCEEDED(pTile->pTexture->LockRect(0, &locked, NULL, 0)))
+		{
+			const unsigned char* pSrc = (const unsigned char*)TexFile_GetPixels(&tex, 0);
+			for (int y = 0; y < desc.tileHeight; y++)
+				memcpy((unsigned char*)locked.pBits + y * locked.Pitch, pSrc + y * level.pitch, BG_TILE_WIDTH * 4);
+			hr = pTile->pTexture->UnlockRect(0);
+		}
+
+		TexFile_Close(&tex);
+	}
+
+	pTile->state.store(SUCCEEDED(hr) ? BGTILE_READY : BGTILE_FAILED, std::memory_order_release);
+}
+
+//BG_GetTile() : returns the cached tile for a layer column, or NULL while it
+//is loading; a miss queues the load over the least recently used slot that
+//is not loading and was not drawn this frame
+static LPDIRECT3DTEXTURE9 BG_GetTile(int layer, int column)
+{
+	BGTILE* pVictim = NULL;
+
+	for (int i = 0; i < BG_CACHE_SIZE; i++)
+	{
+		BGTILE* pTile = &g_BGCache[i];
+		int state = pTile->state.load(std::memory_order_acquire);
+
+		if (pTile->layer == layer && pTile->column == column)
+		{
+			if (state != BGTILE_READY)
+				return NULL;
+
+			pTile->lastUsed = g_dwBGTick;
+			g_BGStats.nTileHits++;
+			return pTile->pTexture;
+		}
+
+		if (state == BGTILE_LOADING || pTile->pTexture == NULL || pTile->lastUsed == g_dwBGTick)
+			continue;
+		if (pVictim == NULL || pTile->column < 0 || (pVictim->column >= 0 && pTile->lastUsed < pVictim->lastUsed))
+			pVictim = pTile;
+	}
+
+	if (pVictim == NULL)
+		return NULL;
+
+	if (pVictim->column >= 0)
+		g_BGStats.nEvictions++;
+	pVictim->layer = layer;
+	pVictim->column = column;
+	pVictim->lastUsed = g_dwBGTick;
+	pVictim->state.store(BGTILE_LOADING, std::memory_order_relaxed);
+
+	if (!Loader_QueueTask(BG_LoadTile, pVictim))
+	{
+		pVictim->column = -1;
+		pVictim->state.store(BGTILE_EMPTY, std::memory_order_relaxed);
+		return NULL;
+	}
+
+	g_BGStats.nTileLoads++;
+
+	return NULL;
+}
+
+//BG_GetStandIn() : the loaded tile of the layer with the nearest column
+static LPDIRECT3DTEXTURE9 BG_GetStandIn(int layer, int column)
+{
+	BGTILE* pBest = NULL;
+
+	for (int i = 0; i < BG_CACHE_SIZE; i++)
+	{
+		BGTILE* pTile = &g_BGCache[i];
+		if (pTile->layer != layer || pTile->state.load(std::memory_order_acquire) != BGTILE_READY)
+			continue;
+		if (pBest == NULL || abs(pTile->column - column) < abs(pBest->column - column))
+			pBest = pTile;
+	}
+
+	if (pBest == NULL)
+		return NULL;
+
+	pBest->lastUsed = g_dwBGTick;
+	g_BGStats.nStandIns++;
+
+	return pBest->pTexture;
+}
+
+//Background_Draw() : draws the visible tile columns of every layer with the
+//camera at fScroll; takes the position as an argument so a render thread can
+//draw from a frame packet while the game keeps scrolling
+void Background_Draw(LPD3DXSPRITE pSprite, float fScroll, D3DCOLOR color)
+{
+	g_dwBGTick++;
+	g_BGStats.nTilesDrawn = 0;
+	g_BGStats.nStandIns = 0;
+
+	// nothing to draw until the tile files are there
+	int cook = g_nBGCook.load(std::memory_order_acquire);
+	if (cook == BGCOOK_NONE)
+	{
+		g_nBGCook.store(BGCOOK_RUNNING, std::memory_order_relaxed);
+		if (!Loader_QueueTask(BG_CookTiles, NULL))
+			g_nBGCook.store(BGCOOK_NONE, std::memory_order_relaxed);
+	}
+	if (cook != BGCOOK_DONE)
+		return;
+
+	for (int layer = 0; layer < g_nBGLayers; layer++)
+	{
+		const BGLAYER& desc = g_BGLayers[layer];
+		int nPeriod = BG_GetPeriod(desc);
+		float offset = fScroll * desc.scrollRate;
+
+		int first = (int)(offset / BG_TILE_WIDTH);
+		float x = first * BG_TILE_WIDTH - offset;
+		RECT src;
+		SetRect(&src, 0, 0, BG_TILE_WIDTH, desc.tileHeight);
+
+		for (int c = first; x < BG_SCREEN_WIDTH; c++, x += BG_TILE_WIDTH)
+		{
+			LPDIRECT3DTEXTURE9 pTexture = BG_GetTile(layer, c % nPeriod);
+			if (pTexture == NULL)
+				pTexture = BG_GetStandIn(layer, c % nPeriod);
+			if (pTexture == NULL)
+				continue;
+
+			D3DXVECTOR3 position(x, desc.screenTop, 0.0f);
+			pSprite->Draw(pTexture, &src, NULL, &position, color);
+			g_BGStats.nTilesDrawn++;
+		}
+	}
+
+	g_BGStats.nTilesPending = 0;
+	for (int i = 0; i < BG_CACHE_SIZE; i++)
+		if (g_BGCache[i].state.load(std::memory_order_relaxed) == BGTILE_LOADING)
+			g_BGStats.nTilesPending++;
+}
+
+const BGSTATS& Background_GetStats(void)
+{
+	return g_BGStats;
+}
+
+//Background_Release() : releases the tile cache, after Loader_Release() has
+//stopped the workers that might be filling it
+void Background_Release(void)
+{
+	for (int i = 0; i < BG_CACHE_SIZE; i++)
+	{
+		if (g_BGCache[i].pTexture != NULL)
+			g_BGCache[i].pTexture->Release();
+		g_BGCache[i].pTexture = NULL;
+		g_BGCache[i].column = -1;
+		g_BGCache[i].state = BGTILE_EMPTY;
+	}
+}
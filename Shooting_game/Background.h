@@ -0,0 +1,51 @@
+#pragma once
+#include <d3d9.h>
+#include <d3dx9.h>
+
+// Scrolling parallax background.
+// Each layer is a strip of fixed-width tile columns cut from a source image,
+// scrolling at its own rate. A stretch of the level runs the source columns
+// forward and then mirrored back, which meets without a seam, and the
+// stretches repeat. The tiles are cut once, on a Loader worker the first
+// time the background is drawn, into cooked files (TexCook.h) under
+// cache\bg; they are cut again only when the source changes. Tiles are then
+// loaded on demand into a small LRU cache of textures, so memory stays
+// constant however long the level runs, and only the columns overlapping
+// the screen are drawn. A missing tile is copied out of its mapped file by a
+// Loader worker (Loader_QueueTask()) and handed over through its slot's
+// state; until then the layer's nearest loaded tile stands in for it, so a
+// miss never stalls the frame. The two layers have 20 tiles between them
+// and the screen shows at most 12, so the cache keeps evicting as the
+// level scrolls.
+
+#define BG_TILE_WIDTH   160
+#define BG_TILE_HEIGHT  500
+#define BG_CACHE_SIZE   16
+
+struct BGLAYER
+{
+	const char* pSrcFile;    // source image
+	int srcWidth;        // source image size the tiles are cut from
+	int srcHeight;
+	int srcTop;          // first source row used by the tiles
+	int tileHeight;      // rows per tile, at most BG_TILE_HEIGHT
+	float screenTop;     // where the layer is drawn
+	float scrollRate;    // 1.0 = moves with the foreground
+};
+
+struct BGSTATS
+{
+	int nTilesDrawn;
+	int nTileLoads;
+	int nTileHits;
+	int nTilesPending;   // queued or loading
+	int nStandIns;       // tiles drawn in place of one still loading
+	int nEvictions;      // loads over a slot that held another tile
+};
+
+HRESULT Background_Init(LPDIRECT3DDEVICE9 pDevice);
+void Background_Scroll(float fDistance);
+float Background_GetScroll(void);
+void Background_Draw(LPD3DXSPRITE pSprite, float fScroll, D3DCOLOR color);
+const BGSTATS& Background_GetStats(void);
+void Background_Release(void);
@@ -0,0 +1,194 @@
+#include "BlockBench.h"
+#include "BlockCompress.h"
+#include "Image.h"
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#define BLOCKBENCH_SIZE     1024
+#define BLOCKBENCH_DECODES  20
+#define BLOCKBENCH_MIN_PSNR 30.0    // dB, the generated sheets are smooth
+
+static BLOCKBENCHREPORT g_pBlockReport;
+static int g_nBlockFailed;
+
+static void BlockBench_Report(const char* pLine)
+{
+	if (g_pBlockReport != NULL)
+		g_pBlockReport(pLine);
+}
+
+static double BlockBench_Seconds(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+//BlockBench_Sheet() : rows of shaded balls on a transparent background; soft
+//balls fade out over their last few pixels, the others end in a hard edge
+static void BlockBench_Sheet(IMAGE* pImage, bool bSoft)
+{
+	const int cell = 64;
+
+	for (int y = 0; y < pImage->height; y++)
+	{
+		for (int x = 0; x < pImage->width; x++)
+		{
+			int cx = x / cell, cy = y / cell;
+			float dx = (float)(x % cell) - cell * 0.5f + 0.5f;
+			float dy = (float)(y % cell) - cell * 0.5f + 0.5f;
+			float fRadius = cell * (0.3f + 0.15f * ((cx * 7 + cy * 3) % 5) / 4.0f);
+			float d = sqrtf(dx * dx + dy * dy);
+
+			unsigned int a = 0;
+			if (bSoft)
+				a = d < fRadius - 6.0f ? 255 : d < fRadius ? (unsigned int)((fRadius - d) / 6.0f * 255.0f) : 0;
+			else
+				a = d < fRadius ? 255 : 0;
+
+			// a light from the top left over a color that changes per cell
+			float fLight = 0.35f + 0.65f * (1.0f - (d / fRadius) * 0.5f - (dx + dy) / (fRadius * 4.0f));
+			fLight = fLight < 0.0f ? 0.0f : fLight > 1.0f ? 1.0f : fLight;
+			unsigned int r = (unsigned int)(fLight * (128 + (cx * 37) % 128));
+			unsigned int g = (unsigned int)(fLight * (128 + (cy * 53) % 128));
+			unsigned int b = (unsigned int)(fLight * (128 + ((cx + cy) * 29) % 128));
+
+			pImage->pixels[y * pImage->width + x] = a == 0 ? 0 : (a << 24) | (r << 16) | (g << 8) | b;
+		}
+	}
+}
+
+//BlockBench_PSNR() : like the cooker's, colors under texels that are not
+//drawn do not count
+static double BlockBench_PSNR(int format, const IMAGE* pSource, const IMAGE* pDecoded)
+{
+	IMAGE source, decoded;
+	if (!Image_Create(&source, pSource->width, pSource->height) || !Image_Create(&decoded, pSource->width, pSource->height))
+	{
+		Image_Free(&source);
+		return 0.0;
+	}
+
+	unsigned int threshold = (format == BC_FORMAT_BC1) ? 128 : 1;
+	for (int i = 0; i < source.width * source.height; i++)
+	{
+		source.pixels[i] = pSource->pixels[i];
+		decoded.pixels[i] = pDecoded->pixels[i];
+		if ((source.pixels[i] >> 24) < threshold)
+			source.pixels[i] = decoded.pixels[i] = 0;
+	}
+
+	IMAGEDIFF diff;
+	Image_Compare(&source, &decoded, 0, &diff, NULL);
+
+	Image_Free(&source);
+	Image_Free(&decoded);
+	return diff.psnr;
+}
+
+//BlockBench_Agree() : both decoders on a sheet cut to width x height
+static bool BlockBench_Agree(int format, const IMAGE* pSheet, int width, int height)
+{
+	std::vector<unsigned int> pixels(width * height);
+	for (int y = 0; y < height; y++)
+		memcpy(&pixels[y * width], pSheet->pixels + y * pSheet->width, width * sizeof(unsigned int));
+
+	std::vector<unsigned char> blocks(BC_GetSize(format, width, height));
+	BC_Encode(format, &pixels[0], width, height, &blocks[0]);
+
+	// different fills, so a texel neither path writes shows up too
+	std::vector<unsigned int> decoded(width * height, 0xdeadbeef);
+	std::vector<unsigned int> scalar(width * height, 0x12345678);
+	BC_Decode(format, &blocks[0], width, height, &decoded[0]);
+	BC_DecodeScalar(format, &blocks[0], width, height, &scalar[0]);
+
+	return memcmp(&decoded[0], &scalar[0], decoded.size() * sizeof(unsigned int)) == 0;
+}
+
+static void BlockBench_Format(int format, const IMAGE* pSheet)
+{
+	static const int sizes[][2] = { { BLOCKBENCH_SIZE, BLOCKBENCH_SIZE }, { 37, 21 }, { 3, 5 }, { 64, 1 } };
+	const char* pName = (format == BC_FORMAT_BC1) ? "bc1" : "bc3";
+	char line[256];
+
+	for (int i = 0; i < (int)(sizeof(sizes) / sizeof(sizes[0])); i++)
+	{
+		if (!BlockBench_Agree(format, pSheet, sizes[i][0], sizes[i][1]))
+		{
+			sprintf(line, "blockbench: %s %dx%d, the sse2 and c decoders wrote different texels\n", pName, sizes[i][0], sizes[i][1]);
+			BlockBench_Report(line);
+			g_nBlockFailed++;
+		}
+	}
+
+	int width = pSheet->width, height = pSheet->height;
+	double fMegaPixels = width * height / 1000000.0;
+	std::vector<unsigned char> blocks(BC_GetSize(format, width, height));
+	IMAGE decoded;
+	if (!Image_Create(&decoded, width, height))
+	{
+		g_nBlockFailed++;
+		return;
+	}
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	BC_Encode(format, pSheet->pixels, width, height, &blocks[0]);
+	double fEncode = BlockBench_Seconds(start);
+
+	start = std::chrono::steady_clock::now();
+	for (int i = 0; i < BLOCKBENCH_DECODES; i++)
+		BC_DecodeScalar(format, &blocks[0], width, height, decoded.pixels);
+	double fScalar = BlockBench_Seconds(start) / BLOCKBENCH_DECODES;
+
+	start = std::chrono::steady_clock::now();
+	for (int i = 0; i < BLOCKBENCH_DECODES; i++)
+		BC_Decode(format, &blocks[0], width, height, decoded.pixels);
+	double fVector = BlockBench_Seconds(start) / BLOCKBENCH_DECODES;
+
+	double psnr = BlockBench_PSNR(format, pSheet, &decoded);
+	if (psnr < BLOCKBENCH_MIN_PSNR)
+		g_nBlockFailed++;
+
+	sprintf(line, "blockbench: %s %dx%d, psnr %.2f dB, encode %.1f MP/s\n", pName, width, height, psnr, fMegaPixels / fEncode);
+	BlockBench_Report(line);
+	if (BC_HasSSE2())
+		sprintf(line, "blockbench: %s decode sse2 %.0f MP/s\n", pName, fMegaPixels / fVector);
+	else
+		sprintf(line, "blockbench: %s decode sse2 not built for this target\n", pName);
+	BlockBench_Report(line);
+	sprintf(line, "blockbench: %s decode c    %.0f MP/s\n", pName, fMegaPixels / fScalar);
+	BlockBench_Report(line);
+
+	Image_Free(&decoded);
+}
+
+int BlockBench_Run(BLOCKBENCHREPORT pReport)
+{
+	char line[256];
+	g_pBlockReport = pReport;
+	g_nBlockFailed = 0;
+
+	IMAGE keyed, soft;
+	if (!Image_Create(&keyed, BLOCKBENCH_SIZE, BLOCKBENCH_SIZE) || !Image_Create(&soft, BLOCKBENCH_SIZE, BLOCKBENCH_SIZE))
+	{
+		Image_Free(&keyed);
+		BlockBench_Report("blockbench: could not allocate the sheets\n");
+		return 1;
+	}
+
+	BlockBench_Sheet(&keyed, false);
+	BlockBench_Sheet(&soft, true);
+	if (BC_HasSoftAlpha(keyed.pixels, keyed.width, keyed.height) || !BC_HasSoftAlpha(soft.pixels, soft.width, soft.height))
+		g_nBlockFailed++;
+
+	BlockBench_Format(BC_FORMAT_BC1, &keyed);
+	BlockBench_Format(BC_FORMAT_BC3, &soft);
+
+	Image_Free(&keyed);
+	Image_Free(&soft);
+
+	sprintf(line, "blockbench: %d checks failed\n", g_nBlockFailed);
+	BlockBench_Report(line);
+	return g_nBlockFailed;
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+// Block compression checks and timings.
+// Needs only BlockCompress.cpp and Image.cpp, so the same run works from
+// the game's "-bcbench" mode and from a two line main() on any platform.
+// Two generated sprite sheets are used: a color keyed one for BC1 and one
+// with soft edges for BC3. Each is encoded and decoded, and the report
+// gives the encode rate, the PSNR over the texels that are drawn, and the
+// decode rates of the SSE2 and plain C paths on their own lines. The
+// checks make sure both decoders write the same texels, also for sizes
+// that are not a multiple of 4, and that the quality stays above a floor.
+// Every line of the report goes through the callback.
+
+typedef void (*BLOCKBENCHREPORT)(const char* pLine);
+
+int BlockBench_Run(BLOCKBENCHREPORT pReport);    // returns the number of failed checks
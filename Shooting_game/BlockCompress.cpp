@@ -0,0 +1,532 @@
+#include "BlockCompress.h"
+#include <string.h>
+#include <math.h>
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define BC_SSE2
+#endif
+
+size_t BC_GetPitch(int format, int width)
+{
+	return (size_t)((width + 3) / 4) * (format == BC_FORMAT_BC1 ? 8 : 16);
+}
+
+size_t BC_GetSize(int format, int width, int height)
+{
+	return BC_GetPitch(format, width) * ((height + 3) / 4);
+}
+
+bool BC_HasSoftAlpha(const unsigned int* pPixels, int width, int height)
+{
+	size_t nPixels = (size_t)width * height;
+
+	for (size_t i = 0; i < nPixels; i++)
+	{
+		unsigned int a = pPixels[i] >> 24;
+		if (a != 0 && a != 255)
+			return true;
+	}
+
+	return false;
+}
+
+static inline unsigned int BC_To565(int r, int g, int b)
+{
+	return ((unsigned int)(r * 31 + 127) / 255 << 11) | ((unsigned int)(g * 63 + 127) / 255 << 5) | ((unsigned int)(b * 31 + 127) / 255);
+}
+
+static inline unsigned int BC_From565(unsigned int c)
+{
+	unsigned int r = (c >> 11) & 31, g = (c >> 5) & 63, b = c & 31;
+	return 0xff000000 | (((r << 3) | (r >> 2)) << 16) | (((g << 2) | (g >> 4)) << 8) | ((b << 3) | (b >> 2));
+}
+
+//BC_Palette() : the four colors of a BC1 block; in three color mode the
+//last entry is transparent black
+static void BC_Palette(unsigned int c0, unsigned int c1, bool bFourColor, unsigned int palette[4])
+{
+	unsigned int a = BC_From565(c0), b = BC_From565(c1);
+	palette[0] = a;
+	palette[1] = b;
+
+	unsigned int mix2 = 0xff000000, mix3 = 0xff000000;
+	for (int shift = 0; shift < 24; shift += 8)
+	{
+		unsigned int ca = (a >> shift) & 0xff, cb = (b >> shift) & 0xff;
+
+		if (bFourColor)
+		{
+			mix2 |= ((2 * ca + cb) / 3) << shift;
+			mix3 |= ((ca + 2 * cb) / 3) << shift;
+		}
+		else
+			mix2 |= ((ca + cb) / 2) << shift;
+	}
+
+	palette[2] = mix2;
+	palette[3] = bFourColor ? mix3 : 0;
+}
+
+static inline int BC_ColorError(unsigned int a, unsigned int b)
+{
+	int dr = (int)((a >> 16) & 0xff) - (int)((b >> 16) & 0xff);
+	int dg = (int)((a >> 8) & 0xff) - (int)((b >> 8) & 0xff);
+	int db = (int)(a & 0xff) - (int)(b & 0xff);
+
+	return dr * dr + dg * dg + db * db;
+}
+
+//BC_ChooseIndices() : nearest palette entry for each texel that is drawn,
+//returns the summed error
+static int BC_ChooseIndices(const unsigned int block[16], const bool bUsed[16], const unsigned int palette[4],
+	int nColors, unsigned int* pIndices)
+{
+	int total = 0;
+	*pIndices = 0;
+
+	for (int i = 0; i < 16; i++)
+	{
+		int best = 0, bestError = 1 << 30;
+
+		if (bUsed[i])
+		{
+			for (int k = 0; k < nColors; k++)
+			{
+				int error = BC_ColorError(block[i], palette[k]);
+				if (error < bestError)
+				{
+					best = k;
+					bestError = error;
+				}
+			}
+			total += bestError;
+		}
+		else
+			best = (nColors == 3) ? 3 : 0;
+
+		*pIndices |= (unsigned int)best << (i * 2);
+	}
+
+	return total;
+}
+
+//BC_FitEndpoints() : principal axis by power iteration, endpoints at the
+//extremes of the projections pulled in by 1/16 of the range
+static void BC_FitEndpoints(const unsigned int block[16], const bool bUsed[16], unsigned int* pC0, unsigned int* pC1)
+{
+	float mean[3] = { 0, 0, 0 };
+	int n = 0;
+
+	for (int i = 0; i < 16; i++)
+	{
+		if (!bUsed[i])
+			continue;
+		mean[0] += (block[i] >> 16) & 0xff;
+		mean[1] += (block[i] >> 8) & 0xff;
+		mean[2] += block[i] & 0xff;
+		n++;
+	}
+
+	for (int c = 0; c < 3; c++)
+		mean[c] /= n;
+
+	float cov[6] = { 0, 0, 0, 0, 0, 0 };
+	for (int i = 0; i < 16; i++)
+	{
+		if (!bUsed[i])
+			continue;
+		float r = ((block[i] >> 16) & 0xff) - mean[0];
+		float g = ((block[i] >> 8) & 0xff) - mean[1];
+		float b = (block[i] & 0xff) - mean[2];
+		cov[0] += r * r; cov[1] += r * g; cov[2] += r * b;
+		cov[3] += g * g; cov[4] += g * b; cov[5] += b * b;
+	}
+
+	float axis[3] = { 0.9f, 1.0f, 0.7f };
+	for (int iter = 0; iter < 4; iter++)
+	{
+		float x = cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2];
+		float y = cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2];
+		float z = cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2];
+		float len = fabsf(x) > fabsf(y) ? fabsf(x) : fabsf(y);
+		len = len > fabsf(z) ? len : fabsf(z);
+		if (len < 1e-6f)
+			break;
+		axis[0] = x / len;
+		axis[1] = y / len;
+		axis[2] = z / len;
+	}
+
+	float minDot = 1e30f, maxDot = -1e30f;
+	for (int i = 0; i < 16; i++)
+	{
+		if (!bUsed[i])
+			continue;
+		float dot = (((block[i] >> 16) & 0xff) - mean[0]) * axis[0] + (((block[i] >> 8) & 0xff) - mean[1]) * axis[1] +
+			((block[i] & 0xff) - mean[2]) * axis[2];
+		minDot = dot < minDot ? dot : minDot;
+		maxDot = dot > maxDot ? dot : maxDot;
+	}
+
+	float inset = (maxDot - minDot) / 16.0f;
+	minDot += inset;
+	maxDot -= inset;
+
+	int ends[2][3];
+	float len2 = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+	for (int c = 0; c < 3; c++)
+	{
+		float scale = len2 > 1e-6f ? axis[c] / len2 : 0.0f;
+		float lo = mean[c] + minDot * scale, hi = mean[c] + maxDot * scale;
+		ends[0][c] = (int)(hi < 0 ? 0 : hi > 255 ? 255 : hi + 0.5f);
+		ends[1][c] = (int)(lo < 0 ? 0 : lo > 255 ? 255 : lo + 0.5f);
+	}
+
+	*pC0 = BC_To565(ends[0][0], ends[0][1], ends[0][2]);
+	*pC1 = BC_To565(ends[1][0], ends[1][1], ends[1][2]);
+}
+
+//BC_Refine() : least squares endpoints for the chosen indices
+static bool BC_Refine(const unsigned int block[16], const bool bUsed[16], unsigned int indices, int nColors,
+	unsigned int* pC0, unsigned int* pC1)
+{
+	// palette position of each index, from c0 (1) to c1 (0)
+	static const float weights4[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+	static const float weights3[4] = { 1.0f, 0.0f, 0.5f, 0.0f };
+	const float* weights = (nColors == 4) ? weights4 : weights3;
+
+	float aa = 0, bb = 0, ab = 0;
+	float ax[3] = { 0, 0, 0 }, bx[3] = { 0, 0, 0 };
+
+	for (int i = 0; i < 16; i++)
+	{
+		int index = (indices >> (i * 2)) & 3;
+		if (!bUsed[i] || (nColors == 3 && index == 3))
+			continue;
+
+		float a = weights[index], b = 1.0f - a;
+		float x[3] = { (float)((block[i] >> 16) & 0xff), (float)((block[i] >> 8) & 0xff), (float)(block[i] & 0xff) };
+
+		aa += a * a; bb += b * b; ab += a * b;
+		for (int c = 0; c < 3; c++)
+		{
+			ax[c] += a * x[c];
+			bx[c] += b * x[c];
+		}
+	}
+
+	float det = aa * bb - ab * ab;
+	if (fabsf(det) < 1e-6f)
+		return false;
+
+	int ends[2][3];
+	for (int c = 0; c < 3; c++)
+	{
+		float e0 = (ax[c] * bb - bx[c] * ab) / det;
+		float e1 = (bx[c] * aa - ax[c] * ab) / det;
+		ends[0][c] = (int)(e0 < 0 ? 0 : e0 > 255 ? 255 : e0 + 0.5f);
+		ends[1][c] = (int)(e1 < 0 ? 0 : e1 > 255 ? 255 : e1 + 0.5f);
+	}
+
+	*pC0 = BC_To565(ends[0][0], ends[0][1], ends[0][2]);
+	*pC1 = BC_To565(ends[1][0], ends[1][1], ends[1][2]);
+
+	return true;
+}
+
+//BC_EncodeColor() : 8-byte color block; bAlphaBit selects three color mode
+//for blocks with transparent texels, bUsed marks the texels that matter
+static void BC_EncodeColor(const unsigned int block[16], const bool bUsed[16], bool bAlphaBit, unsigned char* pOut)
+{
+	bool bAny = false;
+	for (int i = 0; i < 16; i++)
+		bAny |= bUsed[i];
+
+	unsigned int c0 = 0, c1 = 0, indices = bAlphaBit ? 0xffffffff : 0;
+	int nColors = bAlphaBit ? 3 : 4;
+
+	if (bAny)
+	{
+		unsigned int palette[4];
+		BC_FitEndpoints(block, bUsed, &c0, &c1);
+
+		// four color mode needs c0 > c1 and three color mode c0 <= c1
+		if ((nColors == 4) != (c0 > c1))
+		{
+			unsigned int swap = c0;
+			c0 = c1;
+			c1 = swap;
+		}
+
+		BC_Palette(c0, c1, c0 > c1, palette);
+		int error = BC_ChooseIndices(block, bUsed, palette, (c0 > c1 || !bAlphaBit) ? 4 : 3, &indices);
+
+		unsigned int r0 = c0, r1 = c1, rIndices;
+		if (c0 != c1 && BC_Refine(block, bUsed, indices, nColors, &r0, &r1))
+		{
+			if ((nColors == 4) != (r0 > r1))
+			{
+				unsigned int swap = r0;
+				r0 = r1;
+				r1 = swap;
+			}
+
+			BC_Palette(r0, r1, r0 > r1, palette);
+			int refined = BC_ChooseIndices(block, bUsed, palette, (r0 > r1 || !bAlphaBit) ? 4 : 3, &rIndices);
+			if (refined < error && (nColors == 3 || r0 > r1))
+			{
+				c0 = r0;
+				c1 = r1;
+				indices = rIndices;
+			}
+		}
+
+		// equal endpoints in four color mode would decode as three color mode
+		if (nColors == 4 && c0 == c1)
+			indices = 0;
+	}
+
+	pOut[0] = (unsigned char)c0;
+	pOut[1] = (unsigned char)(c0 >> 8);
+	pOut[2] = (unsigned char)c1;
+	pOut[3] = (unsigned char)(c1 >> 8);
+	pOut[4] = (unsigned char)indices;
+	pOut[5] = (unsigned char)(indices >> 8);
+	pOut[6] = (unsigned char)(indices >> 16);
+	pOut[7] = (unsigned char)(indices >> 24);
+}
+
+// the 8 alpha values of a BC3 block with a0 > a1
+static void BC_AlphaPalette(int a0, int a1, int palette[8])
+{
+	palette[0] = a0;
+	palette[1] = a1;
+
+	if (a0 > a1)
+	{
+		for (int i = 1; i < 7; i++)
+			palette[i + 1] = ((7 - i) * a0 + i * a1) / 7;
+	}
+	else
+	{
+		for (int i = 1; i < 5; i++)
+			palette[i + 1] = ((5 - i) * a0 + i * a1) / 5;
+		palette[6] = 0;
+		palette[7] = 255;
+	}
+}
+
+static void BC_EncodeAlpha(const unsigned int block[16], unsigned char* pOut)
+{
+	int a0 = 0, a1 = 255;
+
+	for (int i = 0; i < 16; i++)
+	{
+		int a = block[i] >> 24;
+		a0 = a > a0 ? a : a0;
+		a1 = a < a1 ? a : a1;
+	}
+
+	unsigned long long indices = 0;
+
+	if (a0 > a1)
+	{
+		int palette[8];
+		BC_AlphaPalette(a0, a1, palette);
+
+		for (int i = 0; i < 16; i++)
+		{
+			int a = block[i] >> 24, best = 0, bestError = 256;
+
+			for (int k = 0; k < 8; k++)
+			{
+				int error = a > palette[k] ? a - palette[k] : palette[k] - a;
+				if (error < bestError)
+				{
+					best = k;
+					bestError = error;
+				}
+			}
+
+			indices |= (unsigned long long)best << (i * 3);
+		}
+	}
+
+	pOut[0] = (unsigned char)a0;
+	pOut[1] = (unsigned char)a1;
+	for (int i = 0; i < 6; i++)
+		pOut[2 + i] = (unsigned char)(indices >> (i * 8));
+}
+
+void BC_Encode(int format, const unsigned int* pPixels, int width, int height, void* pBlocks)
+{
+	unsigned char* pOut = (unsigned char*)pBlocks;
+
+	for (int by = 0; by < height; by += 4)
+	{
+		for (int bx = 0; bx < width; bx += 4)
+		{
+			unsigned int block[16];
+			bool bUsed[16];
+			bool bAlphaBit = false;
+
+			for (int i = 0; i < 16; i++)
+			{
+				int x = bx + (i & 3), y = by + (i >> 2);
+				block[i] = pPixels[(y < height ? y : height - 1) * width + (x < width ? x : width - 1)];
+
+				// BC1 keeps colors with alpha of at least half, BC3 every color that is visible
+				if (format == BC_FORMAT_BC1)
+				{
+					bUsed[i] = (block[i] >> 24) >= 128;
+					bAlphaBit |= !bUsed[i];
+				}
+				else
+					bUsed[i] = (block[i] >> 24) != 0;
+			}
+
+			if (format == BC_FORMAT_BC3)
+			{
+				BC_EncodeAlpha(block, pOut);
+				pOut += 8;
+			}
+
+			BC_EncodeColor(block, bUsed, bAlphaBit, pOut);
+			pOut += 8;
+		}
+	}
+}
+
+//BC_DecodeColor() : 16 texels of a color block; BC3 color blocks always use
+//four colors
+static void BC_DecodeColor(const unsigned char* pIn, bool bBC1, bool bSSE2, unsigned int texels[16])
+{
+	unsigned int c0 = pIn[0] | (pIn[1] << 8);
+	unsigned int c1 = pIn[2] | (pIn[3] << 8);
+	unsigned int palette[4];
+
+	BC_Palette(c0, c1, !bBC1 || c0 > c1, palette);
+
+#ifdef BC_SSE2
+	if (bSSE2)
+	{
+		// each 32-bit lane holds one texel's 2-bit index, in place, and is
+		// compared against every palette index shifted to the same place
+		const __m128i laneMask = _mm_set_epi32(0xc0, 0x30, 0x0c, 0x03);
+		const __m128i index1 = _mm_set_epi32(0x40, 0x10, 0x04, 0x01);
+		const __m128i index2 = _mm_set_epi32(0x80, 0x20, 0x08, 0x02);
+		const __m128i p0 = _mm_set1_epi32((int)palette[0]);
+		const __m128i p1 = _mm_set1_epi32((int)palette[1]);
+		const __m128i p2 = _mm_set1_epi32((int)palette[2]);
+		const __m128i p3 = _mm_set1_epi32((int)palette[3]);
+
+		for (int row = 0; row < 4; row++)
+		{
+			__m128i bits = _mm_and_si128(_mm_set1_epi32(pIn[4 + row]), laneMask);
+			__m128i is1 = _mm_cmpeq_epi32(bits, index1);
+			__m128i is2 = _mm_cmpeq_epi32(bits, index2);
+			__m128i is3 = _mm_cmpeq_epi32(bits, laneMask);
+			__m128i is0 = _mm_cmpeq_epi32(bits, _mm_setzero_si128());
+
+			__m128i result = _mm_or_si128(_mm_or_si128(_mm_and_si128(is0, p0), _mm_and_si128(is1, p1)),
+				_mm_or_si128(_mm_and_si128(is2, p2), _mm_and_si128(is3, p3)));
+			_mm_storeu_si128((__m128i*)(texels + row * 4), result);
+		}
+		return;
+	}
+#else
+	(void)bSSE2;
+#endif
+	for (int i = 0; i < 16; i++)
+		texels[i] = palette[(pIn[4 + (i >> 2)] >> ((i & 3) * 2)) & 3];
+}
+
+static void BC_DecodeAlpha(const unsigned char* pIn, bool bSSE2, unsigned int texels[16])
+{
+	int palette[8];
+	BC_AlphaPalette(pIn[0], pIn[1], palette);
+
+	unsigned long long indices = 0;
+	for (int i = 0; i < 6; i++)
+		indices |= (unsigned long long)pIn[2 + i] << (i * 8);
+
+	unsigned int alpha[16];
+	for (int i = 0; i < 16; i++)
+		alpha[i] = (unsigned int)palette[(indices >> (i * 3)) & 7] << 24;
+
+#ifdef BC_SSE2
+	if (bSSE2)
+	{
+		const __m128i colorMask = _mm_set1_epi32(0x00ffffff);
+		for (int i = 0; i < 16; i += 4)
+		{
+			__m128i color = _mm_and_si128(_mm_loadu_si128((const __m128i*)(texels + i)), colorMask);
+			__m128i a = _mm_loadu_si128((const __m128i*)(alpha + i));
+			_mm_storeu_si128((__m128i*)(texels + i), _mm_or_si128(color, a));
+		}
+		return;
+	}
+#else
+	(void)bSSE2;
+#endif
+	for (int i = 0; i < 16; i++)
+		texels[i] = (texels[i] & 0x00ffffff) | alpha[i];
+}
+
+//BC_DecodeBlocks() : bSSE2 is a constant in both callers, so each gets its
+//own copy of the loop
+static inline void BC_DecodeBlocks(int format, const void* pBlocks, int width, int height, unsigned int* pPixels, bool bSSE2)
+{
+	const unsigned char* pIn = (const unsigned char*)pBlocks;
+	bool bBC1 = format == BC_FORMAT_BC1;
+
+	for (int by = 0; by < height; by += 4)
+	{
+		for (int bx = 0; bx < width; bx += 4)
+		{
+			unsigned int texels[16];
+
+			BC_DecodeColor(bBC1 ? pIn : pIn + 8, bBC1, bSSE2, texels);
+			if (!bBC1)
+				BC_DecodeAlpha(pIn, bSSE2, texels);
+			pIn += bBC1 ? 8 : 16;
+
+			if (bx + 4 <= width && by + 4 <= height)
+			{
+				for (int row = 0; row < 4; row++)
+					memcpy(pPixels + (by + row) * width + bx, texels + row * 4, 16);
+				continue;
+			}
+
+			for (int i = 0; i < 16; i++)
+			{
+				int x = bx + (i & 3), y = by + (i >> 2);
+				if (x < width && y < height)
+					pPixels[y * width + x] = texels[i];
+			}
+		}
+	}
+}
+
+void BC_Decode(int format, const void* pBlocks, int width, int height, unsigned int* pPixels)
+{
+#ifdef BC_SSE2
+	BC_DecodeBlocks(format, pBlocks, width, height, pPixels, true);
+#else
+	BC_DecodeBlocks(format, pBlocks, width, height, pPixels, false);
+#endif
+}
+
+void BC_DecodeScalar(int format, const void* pBlocks, int width, int height, unsigned int* pPixels)
+{
+	BC_DecodeBlocks(format, pBlocks, width, height, pPixels, false);
+}
+
+bool BC_HasSSE2(void)
+{
+#ifdef BC_SSE2
+	return true;
+#else
+	return false;
+#endif
+}
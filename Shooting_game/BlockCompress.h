@@ -0,0 +1,24 @@
+#pragma once
+#include <stddef.h>
+
+// BC1 (DXT1) and BC3 (DXT5) block compression.
+// Pixels are 0xAARRGGBB rows, as in IMAGE and locked A8R8G8B8 surfaces.
+// BC1 stores 4x4 texels in 8 bytes with 1-bit alpha, which covers the
+// color keyed sprites; BC3 adds an 8-byte interpolated alpha block for
+// soft edges. The encoder fits the endpoints along the principal axis of
+// each block and refines them once by least squares. The decoder expands
+// a whole row of a block with SSE2 compares and selects, with a plain C
+// path for other targets; BC_DecodeScalar() is the C path on every target,
+// so BlockBench can time both and check that they agree. Edge blocks of
+// sizes that are not a multiple of 4 repeat the last row and column.
+
+enum { BC_FORMAT_BC1, BC_FORMAT_BC3 };
+
+size_t BC_GetPitch(int format, int width);     // bytes per row of blocks
+size_t BC_GetSize(int format, int width, int height);
+bool BC_HasSoftAlpha(const unsigned int* pPixels, int width, int height);    // alpha other than 0 and 255
+
+void BC_Encode(int format, const unsigned int* pPixels, int width, int height, void* pBlocks);
+void BC_Decode(int format, const void* pBlocks, int width, int height, unsigned int* pPixels);
+void BC_DecodeScalar(int format, const void* pBlocks, int width, int height, unsigned int* pPixels);
+bool BC_HasSSE2(void);    // whether BC_Decode() uses the SSE2 path
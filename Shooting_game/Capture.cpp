@@ -0,0 +1,535 @@
+#include "Capture.h"
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <sys/types.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <direct.h>
+#endif
+
+#define CAPTURE_PATH_LEN 260
+#define CAPTURE_FILE_LEN (CAPTURE_PATH_LEN + 32)    // a folder and a file name in it
+#define CAPTURE_PACKET_MAGIC 0x544b5043    // "CPKT"
+#define CAPTURE_SPRITE_WORDS 10
+
+struct CAPTUREJOB
+{
+	int frame;
+	IMAGE image;
+};
+
+static std::vector<std::thread> g_CaptureWriters;
+static std::mutex g_CaptureLock;
+static std::condition_variable g_CaptureWake;
+static std::deque<CAPTUREJOB> g_CaptureJobs;
+static bool g_bCaptureClosing = false;
+
+static char g_szCaptureOut[CAPTURE_PATH_LEN];
+static char g_szCaptureGolden[CAPTURE_PATH_LEN];
+static int g_nCaptureTolerance = 0;
+static float g_fCaptureMaxMismatch = 0.0f;
+
+static CAPTURERESULT g_CaptureResults[CAPTURE_MAX_FRAMES];
+static int g_nCaptureResults = 0;
+static int g_nCaptureSubmitted = 0;
+static CAPTURESTATS g_CaptureStats;
+static FILE* g_pCapturePackets = NULL;
+
+bool Capture_IsKeyDown(const CAPTUREKEY* pScript, int nKeys, int frame, int key)
+{
+	for (int i = 0; i < nKeys; i++)
+	{
+		if (pScript[i].key == key && frame >= pScript[i].firstFrame && frame <= pScript[i].lastFrame)
+			return true;
+	}
+
+	return false;
+}
+
+// x * y / 255, rounded
+static inline unsigned int Capture_Mul255(unsigned int x, unsigned int y)
+{
+	unsigned int v = x * y + 128;
+	return (v + (v >> 8)) >> 8;
+}
+
+//Capture_DrawPacket() : draws the sprite instances of a packet in order;
+//texts are not rasterized, the packet keeps them as strings
+void Capture_DrawPacket(IMAGE* pTarget, const FRAMEPACKET* pPacket, const IMAGE* pTextures, int nTextures)
+{
+	for (int i = 0; i < pPacket->nSprites; i++)
+	{
+		const SPRITEINSTANCE& sprite = pPacket->sprites[i];
+		if (sprite.texture < 0 || sprite.texture >= nTextures || pTextures[sprite.texture].pixels == NULL)
+			continue;
+
+		const IMAGE& texture = pTextures[sprite.texture];
+
+		int srcLeft = std::max((int)sprite.src.left, 0);
+		int srcTop = std::max((int)sprite.src.top, 0);
+		int srcRight = std::min((int)sprite.src.right, texture.width);
+		int srcBottom = std::min((int)sprite.src.bottom, texture.height);
+
+		// screen position of the source rect's upper-left texel
+		int dstX = (int)floorf(sprite.x - sprite.centerX + 0.5f) + (srcLeft - (int)sprite.src.left);
+		int dstY = (int)floorf(sprite.y - sprite.centerY + 0.5f) + (srcTop - (int)sprite.src.top);
+
+		int x0 = std::max(dstX, 0);
+		int y0 = std::max(dstY, 0);
+		int x1 = std::min(dstX + srcRight - srcLeft, pTarget->width);
+		int y1 = std::min(dstY + srcBottom - srcTop, pTarget->height);
+
+		unsigned int ca = sprite.color >> 24;
+		unsigned int cr = (sprite.color >> 16) & 0xff;
+		unsigned int cg = (sprite.color >> 8) & 0xff;
+		unsigned int cb = sprite.color & 0xff;
+
+		for (int y = y0; y < y1; y++)
+		{
+			const unsigned int* pSrc = texture.pixels + (srcTop + y - dstY) * texture.width + (srcLeft + x0 - dstX);
+			unsigned int* pDst = pTarget->pixels + y * pTarget->width + x0;
+
+			for (int x = x0; x < x1; x++, pSrc++, pDst++)
+			{
+				unsigned int texel = *pSrc;
+				unsigned int a = Capture_Mul255(texel >> 24, ca);
+				if (a == 0)
+					continue;
+
+				unsigned int r = Capture_Mul255((texel >> 16) & 0xff, cr);
+				unsigned int g = Capture_Mul255((texel >> 8) & 0xff, cg);
+				unsigned int b = Capture_Mul255(texel & 0xff, cb);
+
+				unsigned int dst = *pDst;
+				r = Capture_Mul255(r, a) + Capture_Mul255((dst >> 16) & 0xff, 255 - a);
+				g = Capture_Mul255(g, a) + Capture_Mul255((dst >> 8) & 0xff, 255 - a);
+				b = Capture_Mul255(b, a) + Capture_Mul255(dst & 0xff, 255 - a);
+
+				*pDst = 0xff000000 | (std::min(r, 255u) << 16) | (std::min(g, 255u) << 8) | std::min(b, 255u);
+			}
+		}
+	}
+}
+
+static bool Capture_IsDir(const char* pDir)
+{
+#ifdef _WIN32
+	struct _stat info;
+	return _stat(pDir, &info) == 0 && (info.st_mode & _S_IFDIR) != 0;
+#else
+	struct stat info;
+	return stat(pDir, &info) == 0 && S_ISDIR(info.st_mode);
+#endif
+}
+
+//Capture_MakeDir() : makes the folder and each missing one above it, returns whether it is there
+static bool Capture_MakeDir(const char* pDir)
+{
+	char szDir[CAPTURE_PATH_LEN];
+	if (pDir[0] == '\0' || snprintf(szDir, sizeof(szDir), "%s", pDir) >= (int)sizeof(szDir))
+		return false;
+
+	// every separator but a leading one ends a parent
+	for (char* p = szDir + 1; ; p++)
+	{
+		if (*p != '/' && *p != '\\' && *p != '\0')
+			continue;
+
+		char end = *p;
+		*p = '\0';
+#ifdef _WIN32
+		_mkdir(szDir);
+#else
+		mkdir(szDir, 0755);
+#endif
+		*p = end;
+		if (end == '\0')
+			break;
+	}
+
+	return Capture_IsDir(pDir);
+}
+
+//Capture_Process() : saves one frame and checks it against its golden image
+static void Capture_Process(CAPTUREJOB& job, CAPTURERESULT& result)
+{
+	char szOut[CAPTURE_FILE_LEN];
+	char szGolden[CAPTURE_FILE_LEN];
+	IMAGE golden;
+
+	snprintf(szOut, sizeof(szOut), "%s/frame_%05d.qoi", g_szCaptureOut, job.frame);
+	snprintf(szGolden, sizeof(szGolden), "%s/frame_%05d.qoi", g_szCaptureGolden, job.frame);
+
+	memset(&result, 0, sizeof(result));
+	result.frame = job.frame;
+
+	Image_WriteQOI(szOut, &job.image);
+
+	if (!Image_ReadQOI(szGolden, &golden))
+	{
+		result.bRecorded = Image_WriteQOI(szGolden, &job.image);
+		result.bPassed = result.bRecorded;
+		return;
+	}
+
+	IMAGE diff;
+	diff.pixels = NULL;
+
+	bool bSameSize = Image_Compare(&job.image, &golden, g_nCaptureTolerance, &result.diff, &diff);
+	result.bPassed = bSameSize && result.diff.nMismatched <= (int)(g_fCaptureMaxMismatch * result.diff.nPixels);
+
+	if (!result.bPassed)
+	{
+		snprintf(szOut, sizeof(szOut), "%s/frame_%05d.png", g_szCaptureOut, job.frame);
+		Image_WritePNG(szOut, &job.image);
+
+		if (diff.pixels != NULL)
+		{
+			snprintf(szOut, sizeof(szOut), "%s/frame_%05d_diff.png", g_szCaptureOut, job.frame);
+			Image_WritePNG(szOut, &diff);
+		}
+	}
+
+	if (diff.pixels != NULL)
+		Image_Free(&diff);
+	Image_Free(&golden);
+}
+
+static void Capture_WriterProc(void)
+{
+	for (;;)
+	{
+		CAPTUREJOB job;
+		{
+			std::unique_lock<std::mutex> lock(g_CaptureLock);
+			g_CaptureWake.wait(lock, [] { return g_bCaptureClosing || !g_CaptureJobs.empty(); });
+
+			if (g_CaptureJobs.empty())
+				return;
+
+			job = g_CaptureJobs.front();
+			g_CaptureJobs.pop_front();
+		}
+
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		CAPTURERESULT result;
+		Capture_Process(job, result);
+		Image_Free(&job.image);
+		float fTime = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+
+		std::lock_guard<std::mutex> lock(g_CaptureLock);
+		g_CaptureResults[g_nCaptureResults++] = result;
+		g_CaptureStats.fEncodeTime += fTime;
+	}
+}
+
+// packets.bin is a list of records in 32-bit little endian words: the
+// magic, frame, width, height, camera x, background color and sprite
+// count, then ten words per sprite; fixed sizes, unlike long and RECT
+static void Capture_PutWords(FILE* fp, const unsigned int* pWords, int nWords)
+{
+	unsigned char bytes[CAPTURE_SPRITE_WORDS * 4];
+	for (int i = 0; i < nWords; i++)
+	{
+		bytes[i * 4 + 0] = (unsigned char)pWords[i];
+		bytes[i * 4 + 1] = (unsigned char)(pWords[i] >> 8);
+		bytes[i * 4 + 2] = (unsigned char)(pWords[i] >> 16);
+		bytes[i * 4 + 3] = (unsigned char)(pWords[i] >> 24);
+	}
+	fwrite(bytes, 4, nWords, fp);
+}
+
+static bool Capture_GetWords(FILE* fp, unsigned int* pWords, int nWords)
+{
+	unsigned char bytes[CAPTURE_SPRITE_WORDS * 4];
+	if (fread(bytes, 4, nWords, fp) != (size_t)nWords)
+		return false;
+
+	for (int i = 0; i < nWords; i++)
+		pWords[i] = bytes[i * 4] | (bytes[i * 4 + 1] << 8) | (bytes[i * 4 + 2] << 16) | ((unsigned int)bytes[i * 4 + 3] << 24);
+	return true;
+}
+
+static unsigned int Capture_FloatBits(float f)
+{
+	unsigned int bits;
+	memcpy(&bits, &f, sizeof(bits));
+	return bits;
+}
+
+static float Capture_BitsFloat(unsigned int bits)
+{
+	float f;
+	memcpy(&f, &bits, sizeof(f));
+	return f;
+}
+
+static void Capture_WritePacket(FILE* fp, int frame, int width, int height, const FRAMEPACKET* pPacket)
+{
+	unsigned int header[7] = { CAPTURE_PACKET_MAGIC, (unsigned int)frame, (unsigned int)width, (unsigned int)height,
+		Capture_FloatBits(pPacket->cameraX), (unsigned int)pPacket->bgColor, (unsigned int)pPacket->nSprites };
+	Capture_PutWords(fp, header, 7);
+
+	for (int i = 0; i < pPacket->nSprites; i++)
+	{
+		const SPRITEINSTANCE& sprite = pPacket->sprites[i];
+		unsigned int words[CAPTURE_SPRITE_WORDS] = { (unsigned int)sprite.texture,
+			(unsigned int)sprite.src.left, (unsigned int)sprite.src.top, (unsigned int)sprite.src.right, (unsigned int)sprite.src.bottom,
+			Capture_FloatBits(sprite.centerX), Capture_FloatBits(sprite.centerY), Capture_FloatBits(sprite.x), Capture_FloatBits(sprite.y),
+			(unsigned int)sprite.color };
+		Capture_PutWords(fp, words, CAPTURE_SPRITE_WORDS);
+	}
+}
+
+//Capture_ReadPacket() : false at the end of the file or on a broken record
+static bool Capture_ReadPacket(FILE* fp, int* pFrame, int* pWidth, int* pHeight, FRAMEPACKET* pPacket)
+{
+	unsigned int header[7];
+	if (!Capture_GetWords(fp, header, 7) || header[0] != CAPTURE_PACKET_MAGIC || header[6] > PACKET_MAX_SPRITES)
+		return false;
+
+	*pFrame = (int)header[1];
+	*pWidth = (int)header[2];
+	*pHeight = (int)header[3];
+	pPacket->frame = header[1];
+	pPacket->publishTime = 0.0;
+	pPacket->cameraX = Capture_BitsFloat(header[4]);
+	pPacket->bgColor = header[5];
+	pPacket->nSprites = (int)header[6];
+	pPacket->nTexts = 0;
+
+	for (int i = 0; i < pPacket->nSprites; i++)
+	{
+		unsigned int words[CAPTURE_SPRITE_WORDS];
+		if (!Capture_GetWords(fp, words, CAPTURE_SPRITE_WORDS))
+			return false;
+
+		SPRITEINSTANCE& sprite = pPacket->sprites[i];
+		sprite.texture = (int)words[0];
+		sprite.src.left = (int)words[1];
+		sprite.src.top = (int)words[2];
+		sprite.src.right = (int)words[3];
+		sprite.src.bottom = (int)words[4];
+		sprite.centerX = Capture_BitsFloat(words[5]);
+		sprite.centerY = Capture_BitsFloat(words[6]);
+		sprite.x = Capture_BitsFloat(words[7]);
+		sprite.y = Capture_BitsFloat(words[8]);
+		sprite.color = words[9];
+	}
+
+	return true;
+}
+
+//Capture_Begin() : creates the output folders and starts nThreads writers
+bool Capture_Begin(const char* pOutDir, const char* pGoldenDir, int tolerance, float fMaxMismatch, int nThreads)
+{
+	if (!g_CaptureWriters.empty())
+		return false;
+
+	if (snprintf(g_szCaptureOut, sizeof(g_szCaptureOut), "%s", pOutDir) >= (int)sizeof(g_szCaptureOut) ||
+		snprintf(g_szCaptureGolden, sizeof(g_szCaptureGolden), "%s", pGoldenDir) >= (int)sizeof(g_szCaptureGolden))
+		return false;
+	if (!Capture_MakeDir(pOutDir) || !Capture_MakeDir(pGoldenDir))
+		return false;
+
+	g_nCaptureTolerance = tolerance;
+	g_fCaptureMaxMismatch = fMaxMismatch;
+	g_nCaptureResults = 0;
+	g_nCaptureSubmitted = 0;
+	memset(&g_CaptureStats, 0, sizeof(g_CaptureStats));
+	g_bCaptureClosing = false;
+
+	if (nThreads < 1)
+		nThreads = 1;
+	for (int i = 0; i < nThreads; i++)
+		g_CaptureWriters.push_back(std::thread(Capture_WriterProc));
+
+	return true;
+}
+
+void Capture_Submit(int frame, IMAGE* pImage)
+{
+	CAPTUREJOB job;
+	job.frame = frame;
+	job.image = *pImage;
+	pImage->pixels = NULL;
+
+	{
+		std::lock_guard<std::mutex> lock(g_CaptureLock);
+
+		// results are stored per submitted frame, so the queue is bounded too
+		if (g_CaptureWriters.empty() || g_nCaptureSubmitted >= CAPTURE_MAX_FRAMES)
+		{
+			Image_Free(&job.image);
+			return;
+		}
+
+		g_nCaptureSubmitted++;
+		g_CaptureJobs.push_back(job);
+	}
+
+	g_CaptureWake.notify_one();
+}
+
+//Capture_DrawFrame() : a black width x height frame with the packet drawn on it
+static bool Capture_DrawFrame(IMAGE* pImage, const FRAMEPACKET* pPacket, const IMAGE* pTextures, int nTextures, int width, int height)
+{
+	if (!Image_Create(pImage, width, height))
+		return false;
+
+	Image_Fill(pImage, 0xff000000);
+	Capture_DrawPacket(pImage, pPacket, pTextures, nTextures);
+	return true;
+}
+
+void Capture_SubmitPacket(int frame, const FRAMEPACKET* pPacket, const IMAGE* pTextures, int nTextures, int width, int height)
+{
+	if (g_pCapturePackets == NULL)
+	{
+		char szPackets[CAPTURE_FILE_LEN];
+		snprintf(szPackets, sizeof(szPackets), "%s/packets.bin", g_szCaptureOut);
+		g_pCapturePackets = fopen(szPackets, "wb");
+	}
+	if (g_pCapturePackets != NULL)
+		Capture_WritePacket(g_pCapturePackets, frame, width, height, pPacket);
+
+	IMAGE image;
+	if (Capture_DrawFrame(&image, pPacket, pTextures, nTextures, width, height))
+		Capture_Submit(frame, &image);
+}
+
+static bool Capture_ResultLess(const CAPTURERESULT& a, const CAPTURERESULT& b)
+{
+	return a.frame < b.frame;
+}
+
+//Capture_End() : drains the queue, stops the writers and writes the report
+const CAPTURESTATS& Capture_End(void)
+{
+	{
+		std::lock_guard<std::mutex> lock(g_CaptureLock);
+		g_bCaptureClosing = true;
+	}
+	g_CaptureWake.notify_all();
+
+	for (size_t i = 0; i < g_CaptureWriters.size(); i++)
+		g_CaptureWriters[i].join();
+	g_CaptureWriters.clear();
+
+	if (g_pCapturePackets != NULL)
+	{
+		fclose(g_pCapturePackets);
+		g_pCapturePackets = NULL;
+	}
+
+	std::sort(g_CaptureResults, g_CaptureResults + g_nCaptureResults, Capture_ResultLess);
+
+	g_CaptureStats.nFrames = g_nCaptureResults;
+	for (int i = 0; i < g_nCaptureResults; i++)
+	{
+		if (g_CaptureResults[i].bRecorded)
+			g_CaptureStats.nRecorded++;
+		else if (g_CaptureResults[i].bPassed)
+			g_CaptureStats.nPassed++;
+		else
+			g_CaptureStats.nFailed++;
+	}
+
+	char szReport[CAPTURE_FILE_LEN];
+	snprintf(szReport, sizeof(szReport), "%s/report.txt", g_szCaptureOut);
+
+	FILE* fp = fopen(szReport, "w");
+	if (fp != NULL)
+	{
+		for (int i = 0; i < g_nCaptureResults; i++)
+		{
+			const CAPTURERESULT& result = g_CaptureResults[i];
+
+			if (result.bRecorded)
+				fprintf(fp, "frame %5d  recorded\n", result.frame);
+			else
+				fprintf(fp, "frame %5d  %s  mismatched %d / %d  max delta %d  psnr %.2f dB\n", result.frame,
+					result.bPassed ? "passed" : "FAILED", result.diff.nMismatched, result.diff.nPixels,
+					result.diff.maxDelta, result.diff.psnr);
+		}
+
+		fprintf(fp, "%d frames: %d passed, %d failed, %d recorded, %.3f s in writers\n", g_CaptureStats.nFrames,
+			g_CaptureStats.nPassed, g_CaptureStats.nFailed, g_CaptureStats.nRecorded, g_CaptureStats.fEncodeTime);
+		fclose(fp);
+	}
+
+	return g_CaptureStats;
+}
+
+const CAPTURERESULT* Capture_GetResults(int* pCount)
+{
+	*pCount = g_nCaptureResults;
+	return g_CaptureResults;
+}
+
+bool Capture_LoadTexture(const char* pFile, unsigned int colorKey, IMAGE* pImage)
+{
+	if (!Image_Read(pFile, pImage))
+	{
+		pImage->pixels = NULL;
+		return false;
+	}
+
+	for (int i = 0; i < pImage->width * pImage->height; i++)
+	{
+		if (pImage->pixels[i] == colorKey)
+			pImage->pixels[i] = 0;
+	}
+
+	return true;
+}
+
+//Capture_Replay() : the packets are drawn and compared in the order they
+//were recorded, the output folder gets its own report.txt
+int Capture_Replay(const char* pPacketFile, const char* const* pTextureFiles, int nTextures, unsigned int colorKey,
+	const char* pOutDir, const char* pGoldenDir, int tolerance, float fMaxMismatch, int nThreads)
+{
+	FILE* fp = fopen(pPacketFile, "rb");
+	if (fp == NULL)
+		return -1;
+
+	std::vector<IMAGE> textures(nTextures);
+	bool bTextures = true;
+	for (int i = 0; i < nTextures; i++)
+	{
+		textures[i].pixels = NULL;
+		if (!Capture_LoadTexture(pTextureFiles[i], colorKey, &textures[i]))
+			bTextures = false;
+	}
+
+	int nFailed = -1;
+	if (bTextures && Capture_Begin(pOutDir, pGoldenDir, tolerance, fMaxMismatch, nThreads))
+	{
+		FRAMEPACKET* pPacket = new FRAMEPACKET;
+		int frame, width, height;
+
+		while (Capture_ReadPacket(fp, &frame, &width, &height, pPacket))
+		{
+			IMAGE image;
+			if (Capture_DrawFrame(&image, pPacket, textures.data(), nTextures, width, height))
+				Capture_Submit(frame, &image);
+		}
+
+		delete pPacket;
+		nFailed = Capture_End().nFailed;
+	}
+
+	for (int i = 0; i < nTextures; i++)
+		Image_Free(&textures[i]);
+	fclose(fp);
+
+	return nFailed;
+}
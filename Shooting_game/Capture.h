@@ -0,0 +1,62 @@
+#pragma once
+#include "FramePacket.h"
+#include "Image.h"
+
+// Headless frame capture for rendering regression checks.
+// Frame packets are rasterized on the CPU the same way ID3DXSprite draws
+// them (point sampled, color modulated, alpha blended), so output does not
+// depend on the driver. Captured frames are handed to a pool of writer
+// threads that save them as QOI, compare them against the golden images
+// and write a PNG of the difference for every frame that fails.
+// A missing golden image is recorded from the current output.
+// Frames submitted as packets are also written to packets.bin in the output
+// folder. Capture_Replay() draws those packets again with textures read
+// from the sprite files, so the golden comparison can be rerun from any
+// platform without the game, a window or a device. Texts are not recorded,
+// they are not rasterized either.
+
+#define CAPTURE_MAX_FRAMES  256
+
+// input script entry: key is held from firstFrame to lastFrame inclusive
+struct CAPTUREKEY
+{
+	int firstFrame;
+	int lastFrame;
+	int key;
+};
+
+struct CAPTURERESULT
+{
+	int frame;
+	bool bRecorded;     // no golden image existed, the output became the golden
+	bool bPassed;
+	IMAGEDIFF diff;
+};
+
+struct CAPTURESTATS
+{
+	int nFrames;
+	int nRecorded;
+	int nPassed;
+	int nFailed;
+	float fEncodeTime;  // seconds spent in writer threads, summed over threads
+};
+
+bool Capture_IsKeyDown(const CAPTUREKEY* pScript, int nKeys, int frame, int key);
+void Capture_DrawPacket(IMAGE* pTarget, const FRAMEPACKET* pPacket, const IMAGE* pTextures, int nTextures);
+
+// tolerance is per channel, fMaxMismatch the fraction of pixels allowed over it;
+// the folders are made with any missing parents, and false means one is not there
+bool Capture_Begin(const char* pOutDir, const char* pGoldenDir, int tolerance, float fMaxMismatch, int nThreads);
+void Capture_Submit(int frame, IMAGE* pImage);    // takes ownership of the pixels
+void Capture_SubmitPacket(int frame, const FRAMEPACKET* pPacket, const IMAGE* pTextures, int nTextures, int width, int height);
+const CAPTURESTATS& Capture_End(void);            // waits for the writers, writes report.txt
+const CAPTURERESULT* Capture_GetResults(int* pCount);
+
+// keyed texels become transparent black, like D3DX's color key
+bool Capture_LoadTexture(const char* pFile, unsigned int colorKey, IMAGE* pImage);
+
+// a whole session from packets.bin: returns the number of failed frames, or -1
+// when the packets or a texture could not be read
+int Capture_Replay(const char* pPacketFile, const char* const* pTextureFiles, int nTextures, unsigned int colorKey,
+	const char* pOutDir, const char* pGoldenDir, int tolerance, float fMaxMismatch, int nThreads);
@@ -0,0 +1,64 @@
+#include "Cull.h"
+
+static CULLRECT g_CullView = { 0.0f, 0.0f, 0.0f, 0.0f };
+static CULLSTATS g_CullStats = { 0, 0, 0 };
+
+//Cull_SetViewport() : sets the screen area sprites are tested against
+void Cull_SetViewport(float fLeft, float fTop, float fRight, float fBottom)
+{
+	g_CullView.left = fLeft;
+	g_CullView.top = fTop;
+	g_CullView.right = fRight;
+	g_CullView.bottom = fBottom;
+}
+
+//Cull_BeginFrame() : clears the per-frame counters
+void Cull_BeginFrame(void)
+{
+	g_CullStats.nTested = 0;
+	g_CullStats.nDrawn = 0;
+	g_CullStats.nCulled = 0;
+}
+
+//Cull_Build() : writes the indices of the visible entities into pVisible
+//pX, pY and pActive point at the first entity's members and advance by
+//nStride bytes; pActive may be NULL when every entity is alive. bounds is
+//the sprite's extent relative to its position. Returns the visible count.
+int Cull_Build(int* pVisible, const float* pX, const float* pY, const bool* pActive,
+	int nStride, int nCount, const CULLRECT& bounds)
+{
+	const char* px = (const char*)pX;
+	const char* py = (const char*)pY;
+	const char* pa = (const char*)pActive;
+	int nVisible = 0;
+	int nTested = 0;
+
+	for (int i = 0; i < nCount; i++)
+	{
+		int nOffset = i * nStride;
+
+		if (pa != 0 && *(const bool*)(pa + nOffset) == false)
+			continue;
+
+		float x = *(const float*)(px + nOffset);
+		float y = *(const float*)(py + nOffset);
+		nTested++;
+
+		if (x + bounds.right <= g_CullView.left || x + bounds.left >= g_CullView.right ||
+			y + bounds.bottom <= g_CullView.top || y + bounds.top >= g_CullView.bottom)
+			continue;
+
+		pVisible[nVisible++] = i;
+	}
+
+	g_CullStats.nTested += nTested;
+	g_CullStats.nDrawn += nVisible;
+	g_CullStats.nCulled += nTested - nVisible;
+
+	return nVisible;
+}
+
+const CULLSTATS& Cull_GetStats(void)
+{
+	return g_CullStats;
+}
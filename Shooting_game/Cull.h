@@ -0,0 +1,24 @@
+#pragma once
+
+// Viewport culling for sprites.
+// Cull_Build() tests a strided array of entity positions against the
+// viewport and writes the indices of the sprites that overlap it, so the
+// draw loops only walk what is actually on screen.
+
+struct CULLRECT
+{
+	float left, top, right, bottom;
+};
+
+struct CULLSTATS
+{
+	int nTested;
+	int nDrawn;
+	int nCulled;
+};
+
+void Cull_SetViewport(float fLeft, float fTop, float fRight, float fBottom);
+void Cull_BeginFrame(void);
+int Cull_Build(int* pVisible, const float* pX, const float* pY, const bool* pActive,
+	int nStride, int nCount, const CULLRECT& bounds);
+const CULLSTATS& Cull_GetStats(void);
@@ -1,165 +1,136 @@
 #include "DSound.h"
+#include "WavFile.h"
 #include <dsound.h>
 
-LPDIRECTSOUND8  g_lpDS = NULL;  //̷Ʈ 尳ü
+LPDIRECTSOUND8  g_lpDS = NULL;  //다이렉트 사운드개체
 BOOL                    g_bPlay = FALSE;
 
-//Լ : CreateDirectSound() 
-//   : DirectSound ü ϰ · Ѵ.
+//함수명 : CreateDirectSound() 
+//설명   : DirectSound 객체를 생성하고 협력레벨을 설정한다.
 BOOL CreateDirectSound(HWND hWnd)
 {
-	//̷Ʈ  ü  
+	//다이렉트 사운드 개체 생성 
 	if (DirectSoundCreate8(NULL, &g_lpDS, NULL) != DS_OK)
 		return FALSE;
 
-	//¼ - DSSCL_NORMAL  
+	//협력수준 설정- DSSCL_NORMAL로 설정 
 	if (g_lpDS->SetCooperativeLevel(hWnd, DSSCL_NORMAL) != DS_OK)
 		return FALSE;
 
 	return TRUE;
 }
 
-//Լ : DeleteDirectSound() 
-//   : DirectSound ü Ѵ.
+//함수명 : DeleteDirectSound() 
+//설명   : DirectSound 객체를 해제한다.
 void DeleteDirectSound()
 {
 	g_lpDS->Release();
 	g_lpDS = NULL;
 }
 
-//Լ : LoadWave() 
-//   : Ϸ  wav о ޸𸮿 εѴ.
+//함수명 : LoadWave() 
+//설명   : wav파일을 매핑하여 사운드 버퍼로 바로 복사한다.
+//         파일 전체를 읽거나 WAVEFORMATEX를 할당하지 않는다. (WavFile.h 참고)
 BOOL LoadWave(LPWSTR lpFileName, LPDIRECTSOUNDBUFFER* lpDSBuffer)
 {
-	HMMIO          hmmio;              //wave ڵ
-	MMCKINFO    ckInRIFF, ckIn;  //θ ûũ , ڽ ûũ 
-	PCMWAVEFORMAT  pcmWaveFormat;
-	WAVEFORMATEX*     pWaveFormat;
-
-	//̺  , MMIO ڵ ´.
-	hmmio = mmioOpen(lpFileName, NULL, MMIO_ALLOCBUF | MMIO_READ);
-	if (hmmio == NULL)  return FALSE;
-
-	//  ûũ̸ ϰ,  ġ RIFFûũ WAVEûũ
-	//ã .
-	ckInRIFF.fccType = mmioFOURCC('W', 'A', 'V', 'E');
-	if ((mmioDescend(hmmio, &ckInRIFF, NULL, MMIO_FINDRIFF)) != 0)
-	{
-		mmioClose(hmmio, 0);  //ϸ ִ ̺ ݰ ( ش.)
-		return FALSE;
-	}
-	//  ûũ̸ ϰ,  ġ WAVEûũ fmt ûũ ã .
-	//:  ûũ 4 ڵ带   t  鹮ڰ ִ.
-	ckIn.ckid = mmioFOURCC('f', 'm', 't', ' ');
-	if (mmioDescend(hmmio, &ckIn, &ckInRIFF, MMIO_FINDCHUNK) != 0)
-	{
-		mmioClose(hmmio, 0);//ϸ ִ ̺ ݰ ( ش.)
-		return FALSE;
-	}
-	//fmt ûũ wav (Format) о δ.
-	if (mmioRead(hmmio, (HPSTR)&pcmWaveFormat, sizeof(pcmWaveFormat))
-		!= sizeof(pcmWaveFormat))
-	{
-		mmioClose(hmmio, 0);//ϸ ִ ̺ ݰ ( ش.)
+	char          szFileName[MAX_PATH];
+	WAVFILE       wav;            //매핑된 wav파일, 청크는 모두 파일 안을 가리킨다.
+	WAVEFORMATEX  waveFormat;
+
+	if (WideCharToMultiByte(CP_ACP, 0, lpFileName, -1, szFileName, MAX_PATH, NULL, NULL) == 0)
 		return FALSE;
-	}
-	//WAVEFORMATEX ޸𸮿 Ҵ 
-	pWaveFormat = new WAVEFORMATEX;
-	//PCMWAVEFORMATκ Ѵ.
-	memcpy(pWaveFormat, &pcmWaveFormat, sizeof(pcmWaveFormat));
-	pWaveFormat->cbSize = 0;
-
-	//fmt Chunk  θûũ WAVE Chunk ö󰣴.
-	if (mmioAscend(hmmio, &ckIn, 0))
-	{
-		mmioClose(hmmio, 0);//ϸ ִ ̺ ݰ ( ش.)
+
+	//파일을 매핑하고 청크를 검사한다. 잘못된 파일이면 실패한다.
+	if (WavFile_Open(szFileName, &wav) == false)
 		return FALSE;
-	}
 
-	//  ûũ̸ ϰ,  ġ WAVEûũ data ûũ
-	//ã .
-	ckIn.ckid = mmioFOURCC('d', 'a', 't', 'a');
-	if (mmioDescend(hmmio, &ckIn, &ckInRIFF, MMIO_FINDCHUNK) != 0)
+	//DirectSound는 PCM만 받는다.
+	if (wav.format.formatTag != WAVFILE_FORMAT_PCM || wav.nBytes == 0)
 	{
-		mmioClose(hmmio, 0);//ϸ ִ ̺ ݰ ( ش.)
+		WavFile_Close(&wav);
 		return FALSE;
 	}
 
-	BYTE*   pData = NULL;
-	//data chunk  ŭ ޸ Ҵ
-	pData = new BYTE[ckIn.cksize];
-	//data chunk ִ  wave data о δ. 
-	mmioRead(hmmio, (LPSTR)pData, ckIn.cksize);
+	//fmt 청크로부터 포맷을 채운다.
+	ZeroMemory(&waveFormat, sizeof(WAVEFORMATEX));
+	waveFormat.wFormatTag = WAVE_FORMAT_PCM;
+	waveFormat.nChannels = (WORD)wav.format.channels;
+	waveFormat.nSamplesPerSec = wav.format.sampleRate;
+	waveFormat.nBlockAlign = (WORD)wav.format.blockAlign;
+	waveFormat.nAvgBytesPerSec = wav.format.sampleRate * wav.format.blockAlign;
+	waveFormat.wBitsPerSample = (WORD)wav.format.bitsPerSample;
 
-	//  wavб⿡  ̹Ƿ, ִ wav ݴ´. 
-	mmioClose(hmmio, 0);
-
-	// DSBUFFERDESC ü  ä.
+	// DSBUFFERDESC 구조체 정보를 채운다.
 	DSBUFFERDESC dsbd;
 	ZeroMemory(&dsbd, sizeof(DSBUFFERDESC));
 	dsbd.dwSize = sizeof(DSBUFFERDESC);
 	dsbd.dwFlags = DSBCAPS_CTRLDEFAULT | DSBCAPS_STATIC | DSBCAPS_LOCSOFTWARE;
-	dsbd.dwBufferBytes = ckIn.cksize;
-	dsbd.lpwfxFormat = pWaveFormat;
+	dsbd.dwBufferBytes = wav.nBytes;
+	dsbd.lpwfxFormat = &waveFormat;
 
-	//  
+	//사운드 버퍼의 생성
 	if (g_lpDS->CreateSoundBuffer(&dsbd, lpDSBuffer, NULL) != DS_OK)
+	{
+		WavFile_Close(&wav);
 		return FALSE;
+	}
 
-	VOID* pBuff1 = NULL;  //  ù° ּ  
-	VOID* pBuff2 = NULL;  //  ι° ּ 
-	DWORD dwLength;      //ù° ũ        
-	DWORD dwLength2;     //ι° ũ
-						 // ۿ  wav͸ ϱ   Ǵ.
+	VOID* pBuff1 = NULL;  //사운드 버퍼의 첫번째 영역주소  
+	VOID* pBuff2 = NULL;  //사운드 버퍼의 두번째 영역주소 
+	DWORD dwLength;      //첫번째 영역크기        
+	DWORD dwLength2;     //두번째 영역크기
+						 //사운드 버퍼에 순수한 wav데이터를 복사하기 위해 락을 건다.
 	if ((*lpDSBuffer)->Lock(0, dsbd.dwBufferBytes, &pBuff1, &dwLength,
 		&pBuff2, &dwLength2, 0L) != DS_OK)
 	{
 		(*lpDSBuffer)->Release();
 		(*lpDSBuffer) = NULL;
+		WavFile_Close(&wav);
 		return FALSE;
 	}
 
-	memcpy(pBuff1, pData, dwLength);                     // ù°  
-	memcpy(pBuff2, (pData + dwLength), dwLength2); // ι°  
-												   // ¸ Ǯش.
+	//매핑된 data 청크에서 버퍼로 한 번만 복사한다.
+	const BYTE* pData = (const BYTE*)wav.pSamples;
+	memcpy(pBuff1, pData, dwLength);                     //버퍼의 첫번째 영역을 복사
+	memcpy(pBuff2, (pData + dwLength), dwLength2); //버퍼의 두번째 영역을 복사
+												   //잠금 상태를 풀어준다.
 	(*lpDSBuffer)->Unlock(pBuff1, dwLength, pBuff2, dwLength2);
 	pBuff1 = pBuff2 = NULL;
 
-	//Ҵ ޸𸮸 
-	delete[] pData;
-	delete pWaveFormat;
+	//매핑을 해제
+	WavFile_Close(&wav);
 
 	return TRUE;
 }
 
-//Լ : Play()
-//   : ش 带 ÷ Ѵ.
+//함수명 : Play()
+//설명   : 해당 사운드를 플레이 한다.
 void Play(LPDIRECTSOUNDBUFFER lpDSBuffer, BOOL Loop)
 {
-	//۰   
+	//버퍼가 비어있으면 종료 
 	if (lpDSBuffer == NULL)  return;
 
-	// ϸ  
+	//재생중 실패하면 종료 
 	if (!lpDSBuffer->Play(0, 0, (Loop) ? 1 : 0))  return;
 
 	g_bPlay = TRUE;
 }
 
-//Լ : Stop()
-//   : ش 带 .
+//함수명 : Stop()
+//설명   : 해당 사운드를 멈춘다.
 void Stop(LPDIRECTSOUNDBUFFER lpDSBuffer)
 {
-	//۰  
+	//버퍼가 비어있으면 종료
 	if (lpDSBuffer == NULL)  return;
 
-	lpDSBuffer->Stop();  //
+	lpDSBuffer->Stop();  //멈춤
 
 	g_bPlay = FALSE;
-	lpDSBuffer->SetCurrentPosition(0L); //óġ
+	lpDSBuffer->SetCurrentPosition(0L); //처음위치로
 }
 
-//Լ : SetVolume()
-//   : ش   Ѵ.(100̸ ִ, 0̸ )
+//함수명 : SetVolume()
+//설명   : 해당 사운드의 볼륨을 조절한다.(100이면 최대출력, 0이면 무음)
 BOOL SetVolume(LPDIRECTSOUNDBUFFER lpDSBuffer, LONG lVolume)
 {
 	if (lpDSBuffer->SetVolume(DSVOLUME_TO_DB(lVolume)) != DS_OK)
@@ -168,8 +139,8 @@ BOOL SetVolume(LPDIRECTSOUNDBUFFER lpDSBuffer, LONG lVolume)
 	return TRUE;
 }
 
-//Լ : SetVolume()
-//   : ׷ д( -10000~10000)
+//함수명 : SetVolume()
+//설명   : 스테레오 패닝조절(범위는 -10000~10000)
 BOOL SetPan(LPDIRECTSOUNDBUFFER lpDSBuffer, LONG lPan)
 {
 	if (lpDSBuffer->SetPan(lPan) != DS_OK)
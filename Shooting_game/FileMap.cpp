@@ -0,0 +1,81 @@
+#include "FileMap.h"
+#include <string.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+bool FileMap_Open(const char* pFile, FILEMAP* pMap)
+{
+	memset(pMap, 0, sizeof(*pMap));
+
+#ifdef _WIN32
+	HANDLE hFile = CreateFileA(pFile, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (hFile == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER size;
+	HANDLE hMapping = NULL;
+	const void* pView = NULL;
+
+	if (GetFileSizeEx(hFile, &size) && size.QuadPart > 0 && size.HighPart == 0)
+		hMapping = CreateFileMappingA(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (hMapping != NULL)
+		pView = MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+
+	if (pView == NULL)
+	{
+		if (hMapping != NULL)
+			CloseHandle(hMapping);
+		CloseHandle(hFile);
+		return false;
+	}
+
+	pMap->hFile = hFile;
+	pMap->hMapping = hMapping;
+	pMap->nSize = (size_t)size.QuadPart;
+#else
+	int fd = open(pFile, O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat st;
+	void* pView = MAP_FAILED;
+
+	if (fstat(fd, &st) == 0 && st.st_size > 0)
+		pView = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+	if (pView == MAP_FAILED)
+	{
+		close(fd);
+		return false;
+	}
+
+	pMap->fd = fd;
+	pMap->nSize = (size_t)st.st_size;
+#endif
+
+	pMap->pBase = (const unsigned char*)pView;
+	return true;
+}
+
+void FileMap_Close(FILEMAP* pMap)
+{
+	if (pMap->pBase == NULL)
+		return;
+
+#ifdef _WIN32
+	UnmapViewOfFile(pMap->pBase);
+	CloseHandle(pMap->hMapping);
+	CloseHandle(pMap->hFile);
+#else
+	munmap((void*)pMap->pBase, pMap->nSize);
+	close(pMap->fd);
+#endif
+
+	memset(pMap, 0, sizeof(*pMap));
+}
@@ -0,0 +1,144 @@
+#include "FramePacket.h"
+#include <atomic>
+#include <chrono>
+#include <string.h>
+
+#define PACKET_FRESH 4    // set in g_nMiddle while it holds an unread packet
+
+static FRAMEPACKET g_Packets[3];
+static std::atomic<int> g_nMiddle(2);
+static int g_nBack = 0;       // owned by the game thread
+static int g_nFront = 1;      // owned by the render thread
+static unsigned int g_nFrame = 0;
+
+// writer side counters
+static std::atomic<unsigned int> g_nPublished(0);
+static std::atomic<unsigned int> g_nDropped(0);
+
+// reader side counters, latencies kept in microseconds
+static std::atomic<unsigned int> g_nConsumed(0);
+static std::atomic<unsigned int> g_nLastLatency(0);
+static std::atomic<unsigned int> g_nMaxLatency(0);
+static std::atomic<unsigned int> g_nAvgLatency(0);
+
+//Packet_Reset() : call while the render thread is stopped
+void Packet_Reset(void)
+{
+	g_nMiddle.store(2);
+	g_nBack = 0;
+	g_nFront = 1;
+	g_nFrame = 0;
+	g_nPublished = 0;
+	g_nDropped = 0;
+	g_nConsumed = 0;
+	g_nLastLatency = 0;
+	g_nMaxLatency = 0;
+	g_nAvgLatency = 0;
+}
+
+double Packet_Now(void)
+{
+	using namespace std::chrono;
+	return duration<double>(steady_clock::now().time_since_epoch()).count();
+}
+
+//Packet_BeginWrite() : returns the game thread's packet, emptied
+FRAMEPACKET* Packet_BeginWrite(void)
+{
+	FRAMEPACKET* pPacket = &g_Packets[g_nBack];
+
+	pPacket->nSprites = 0;
+	pPacket->nTexts = 0;
+
+	return pPacket;
+}
+
+void Packet_AddSprite(FRAMEPACKET* pPacket, int texture, const ANIMRECT* pSrc,
+	float centerX, float centerY, float x, float y, unsigned long color)
+{
+	if (pPacket->nSprites >= PACKET_MAX_SPRITES)
+		return;
+
+	SPRITEINSTANCE& sprite = pPacket->sprites[pPacket->nSprites++];
+	sprite.texture = texture;
+	sprite.src = *pSrc;
+	sprite.centerX = centerX;
+	sprite.centerY = centerY;
+	sprite.x = x;
+	sprite.y = y;
+	sprite.color = color;
+}
+
+void Packet_AddText(FRAMEPACKET* pPacket, int font, int x, int y, unsigned long color, const char* pText)
+{
+	if (pPacket->nTexts >= PACKET_MAX_TEXTS)
+		return;
+
+	TEXTINSTANCE& text = pPacket->texts[pPacket->nTexts++];
+	text.font = font;
+	text.x = x;
+	text.y = y;
+	text.color = color;
+	strncpy(text.text, pText, PACKET_TEXT_LEN - 1);
+	text.text[PACKET_TEXT_LEN - 1] = '\0';
+}
+
+//Packet_Publish() : hands the written packet over and takes back whichever
+//packet was waiting in the middle slot
+void Packet_Publish(void)
+{
+	FRAMEPACKET* pPacket = &g_Packets[g_nBack];
+	pPacket->frame = g_nFrame++;
+	pPacket->publishTime = Packet_Now();
+
+	int nPrev = g_nMiddle.exchange(g_nBack | PACKET_FRESH, std::memory_order_acq_rel);
+	if (nPrev & PACKET_FRESH)
+		g_nDropped.fetch_add(1, std::memory_order_relaxed);
+
+	g_nBack = nPrev & ~PACKET_FRESH;
+	g_nPublished.fetch_add(1, std::memory_order_relaxed);
+}
+
+//Packet_AcquireLatest() : returns the newest unread packet, or NULL if the
+//game thread has not published anything since the last call
+const FRAMEPACKET* Packet_AcquireLatest(void)
+{
+	if ((g_nMiddle.load(std::memory_order_relaxed) & PACKET_FRESH) == 0)
+		return NULL;
+
+	int nPrev = g_nMiddle.exchange(g_nFront, std::memory_order_acq_rel);
+	g_nFront = nPrev & ~PACKET_FRESH;
+
+	return &g_Packets[g_nFront];
+}
+
+//Packet_EndRead() : call after the packet has been presented, records latency
+void Packet_EndRead(const FRAMEPACKET* pPacket)
+{
+	unsigned int nLatency = (unsigned int)((Packet_Now() - pPacket->publishTime) * 1000000.0);
+	unsigned int nConsumed = g_nConsumed.fetch_add(1, std::memory_order_relaxed) + 1;
+
+	g_nLastLatency.store(nLatency, std::memory_order_relaxed);
+	if (nLatency > g_nMaxLatency.load(std::memory_order_relaxed))
+		g_nMaxLatency.store(nLatency, std::memory_order_relaxed);
+
+	// running average over roughly the last 32 frames
+	unsigned int nAvg = g_nAvgLatency.load(std::memory_order_relaxed);
+	nAvg = (nConsumed == 1) ? nLatency : nAvg - nAvg / 32 + nLatency / 32;
+	g_nAvgLatency.store(nAvg, std::memory_order_relaxed);
+}
+
+//Packet_GetStats() : snapshot of the pipeline counters, safe from either thread
+PACKETSTATS Packet_GetStats(void)
+{
+	PACKETSTATS stats;
+
+	stats.nPublished = g_nPublished.load(std::memory_order_relaxed);
+	stats.nConsumed = g_nConsumed.load(std::memory_order_relaxed);
+	stats.nDropped = g_nDropped.load(std::memory_order_relaxed);
+	stats.fLastLatency = g_nLastLatency.load(std::memory_order_relaxed) / 1000.0f;
+	stats.fAvgLatency = g_nAvgLatency.load(std::memory_order_relaxed) / 1000.0f;
+	stats.fMaxLatency = g_nMaxLatency.load(std::memory_order_relaxed) / 1000.0f;
+
+	return stats;
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include "Animation.h"
+
+// Frame packets handed from the simulation to the render thread.
+// The game thread fills a packet with everything needed to draw one frame
+// (sprite instances, text, camera) and publishes it; the render thread
+// picks up the newest published packet. Three packets rotate through a
+// single atomic index, so neither side ever waits on the other: the writer
+// always has a free packet, and a packet the renderer did not get to in
+// time is simply replaced by the next one.
+
+#define PACKET_MAX_SPRITES 2560
+#define PACKET_MAX_TEXTS   4
+#define PACKET_TEXT_LEN    100
+
+struct SPRITEINSTANCE
+{
+	int texture;             // game texture id
+	ANIMRECT src;
+	float centerX, centerY;
+	float x, y;
+	unsigned long color;
+};
+
+struct TEXTINSTANCE
+{
+	int font;
+	int x, y;
+	unsigned long color;
+	char text[PACKET_TEXT_LEN];
+};
+
+struct FRAMEPACKET
+{
+	unsigned int frame;
+	double publishTime;      // seconds, Packet_Now() clock
+	float cameraX;           // background scroll position
+	unsigned long bgColor;   // background tint
+	int nSprites;
+	SPRITEINSTANCE sprites[PACKET_MAX_SPRITES];
+	int nTexts;
+	TEXTINSTANCE texts[PACKET_MAX_TEXTS];
+};
+
+struct PACKETSTATS
+{
+	unsigned int nPublished;
+	unsigned int nConsumed;
+	unsigned int nDropped;       // published but replaced before the renderer took it
+	float fLastLatency;          // publish to present, milliseconds
+	float fAvgLatency;
+	float fMaxLatency;
+};
+
+void Packet_Reset(void);
+double Packet_Now(void);
+
+// game thread
+FRAMEPACKET* Packet_BeginWrite(void);
+void Packet_AddSprite(FRAMEPACKET* pPacket, int texture, const ANIMRECT* pSrc,
+	float centerX, float centerY, float x, float y, unsigned long color);
+void Packet_AddText(FRAMEPACKET* pPacket, int font, int x, int y, unsigned long color, const char* pText);
+void Packet_Publish(void);
+
+// render thread
+const FRAMEPACKET* Packet_AcquireLatest(void);
+void Packet_EndRead(const FRAMEPACKET* pPacket);
+
+PACKETSTATS Packet_GetStats(void);
@@ -0,0 +1,921 @@
+#include "Image.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define QOI_OP_INDEX  0x00
+#define QOI_OP_DIFF   0x40
+#define QOI_OP_LUMA   0x80
+#define QOI_OP_RUN    0xc0
+#define QOI_OP_RGB    0xfe
+#define QOI_OP_RGBA   0xff
+#define QOI_MASK_2    0xc0
+#define QOI_HEADER_SIZE 14
+
+static const unsigned char g_QOIPadding[8] = { 0, 0, 0, 0, 0, 0, 0, 1 };
+
+bool Image_Create(IMAGE* pImage, int width, int height)
+{
+	pImage->pixels = (unsigned int*)malloc((size_t)width * height * sizeof(unsigned int));
+	pImage->width = pImage->pixels ? width : 0;
+	pImage->height = pImage->pixels ? height : 0;
+
+	return pImage->pixels != NULL;
+}
+
+void Image_Free(IMAGE* pImage)
+{
+	free(pImage->pixels);
+	pImage->pixels = NULL;
+	pImage->width = 0;
+	pImage->height = 0;
+}
+
+void Image_Fill(IMAGE* pImage, unsigned int color)
+{
+	int nPixels = pImage->width * pImage->height;
+
+	for (int i = 0; i < nPixels; i++)
+		pImage->pixels[i] = color;
+}
+
+static void Image_Put32(unsigned char* p, unsigned int v)
+{
+	p[0] = (unsigned char)(v >> 24);
+	p[1] = (unsigned char)(v >> 16);
+	p[2] = (unsigned char)(v >> 8);
+	p[3] = (unsigned char)v;
+}
+
+static unsigned int Image_Get32(const unsigned char* p)
+{
+	return ((unsigned int)p[0] << 24) | ((unsigned int)p[1] << 16) | ((unsigned int)p[2] << 8) | p[3];
+}
+
+static bool Image_WriteFile(const char* pFile, const unsigned char* pData, size_t nSize)
+{
+	FILE* fp = fopen(pFile, "wb");
+	if (fp == NULL)
+		return false;
+
+	bool bOk = fwrite(pData, 1, nSize, fp) == nSize;
+	return (fclose(fp) == 0) && bOk;
+}
+
+static inline int Image_QOIHash(unsigned int argb)
+{
+	unsigned int a = argb >> 24, r = (argb >> 16) & 0xff, g = (argb >> 8) & 0xff, b = argb & 0xff;
+	return (r * 3 + g * 5 + b * 7 + a * 11) & 63;
+}
+
+//Image_WriteQOI() : encodes in one pass into a worst case sized buffer and
+//writes it with a single fwrite
+bool Image_WriteQOI(const char* pFile, const IMAGE* pImage)
+{
+	int nPixels = pImage->width * pImage->height;
+	size_t nCapacity = QOI_HEADER_SIZE + (size_t)nPixels * 5 + sizeof(g_QOIPadding);
+	unsigned char* pData = (unsigned char*)malloc(nCapacity);
+	if (pData == NULL)
+		return false;
+
+	unsigned char* p = pData;
+	memcpy(p, "qoif", 4);
+	Image_Put32(p + 4, pImage->width);
+	Image_Put32(p + 8, pImage->height);
+	p[12] = 4;    // RGBA
+	p[13] = 0;    // sRGB with linear alpha
+	p += QOI_HEADER_SIZE;
+
+	unsigned int index[64];
+	memset(index, 0, sizeof(index));
+
+	unsigned int prev = 0xff000000;
+	int run = 0;
+
+	for (int i = 0; i < nPixels; i++)
+	{
+		unsigned int px = pImage->pixels[i];
+
+		if (px == prev)
+		{
+			if (++run == 62 || i == nPixels - 1)
+			{
+				*p++ = (unsigned char)(QOI_OP_RUN | (run - 1));
+				run = 0;
+			}
+			continue;
+		}
+
+		if (run > 0)
+		{
+			*p++ = (unsigned char)(QOI_OP_RUN | (run - 1));
+			run = 0;
+		}
+
+		int hash = Image_QOIHash(px);
+		if (index[hash] == px)
+		{
+			*p++ = (unsigned char)(QOI_OP_INDEX | hash);
+		}
+		else
+		{
+			index[hash] = px;
+
+			if ((px >> 24) == (prev >> 24))
+			{
+				signed char vr = (signed char)(((px >> 16) & 0xff) - ((prev >> 16) & 0xff));
+				signed char vg = (signed char)(((px >> 8) & 0xff) - ((prev >> 8) & 0xff));
+				signed char vb = (signed char)((px & 0xff) - (prev & 0xff));
+				signed char vg_r = vr - vg;
+				signed char vg_b = vb - vg;
+
+				if (vr > -3 && vr < 2 && vg > -3 && vg < 2 && vb > -3 && vb < 2)
+				{
+					*p++ = (unsigned char)(QOI_OP_DIFF | (vr + 2) << 4 | (vg + 2) << 2 | (vb + 2));
+				}
+				else if (vg_r > -9 && vg_r < 8 && vg > -33 && vg < 32 && vg_b > -9 && vg_b < 8)
+				{
+					*p++ = (unsigned char)(QOI_OP_LUMA | (vg + 32));
+					*p++ = (unsigned char)((vg_r + 8) << 4 | (vg_b + 8));
+				}
+				else
+				{
+					*p++ = QOI_OP_RGB;
+					*p++ = (unsigned char)(px >> 16);
+					*p++ = (unsigned char)(px >> 8);
+					*p++ = (unsigned char)px;
+				}
+			}
+			else
+			{
+				*p++ = QOI_OP_RGBA;
+				*p++ = (unsigned char)(px >> 16);
+				*p++ = (unsigned char)(px >> 8);
+				*p++ = (unsigned char)px;
+				*p++ = (unsigned char)(px >> 24);
+			}
+		}
+
+		prev = px;
+	}
+
+	memcpy(p, g_QOIPadding, sizeof(g_QOIPadding));
+	p += sizeof(g_QOIPadding);
+
+	bool bOk = Image_WriteFile(pFile, pData, p - pData);
+	free(pData);
+
+	return bOk;
+}
+
+//Image_ReadFile() : reads a whole file into a malloc'd buffer
+static unsigned char* Image_ReadFile(const char* pFile, size_t* pSize)
+{
+	FILE* fp = fopen(pFile, "rb");
+	if (fp == NULL)
+		return NULL;
+
+	fseek(fp, 0, SEEK_END);
+	long nSize = ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+
+	unsigned char* pData = (nSize > 0) ? (unsigned char*)malloc(nSize) : NULL;
+	if (pData != NULL && fread(pData, 1, nSize, fp) != (size_t)nSize)
+	{
+		free(pData);
+		pData = NULL;
+	}
+	fclose(fp);
+
+	*pSize = pData ? (size_t)nSize : 0;
+	return pData;
+}
+
+static bool Image_DecodeQOI(const unsigned char* pData, size_t nSize, IMAGE* pImage)
+{
+	if (nSize < QOI_HEADER_SIZE + sizeof(g_QOIPadding) || memcmp(pData, "qoif", 4) != 0)
+		return false;
+
+	int width = (int)Image_Get32(pData + 4);
+	int height = (int)Image_Get32(pData + 8);
+
+	if (width <= 0 || height <= 0 || width > 16384 || height > 16384 || !Image_Create(pImage, width, height))
+		return false;
+
+	unsigned int index[64];
+	memset(index, 0, sizeof(index));
+
+	const unsigned char* p = pData + QOI_HEADER_SIZE;
+	const unsigned char* pEnd = pData + nSize - sizeof(g_QOIPadding);
+	unsigned int px = 0xff000000;
+	int nPixels = width * height;
+	int run = 0;
+
+	for (int i = 0; i < nPixels; i++)
+	{
+		if (run > 0)
+		{
+			run--;
+		}
+		else if (p < pEnd)
+		{
+			int b1 = *p++;
+
+			if (b1 == QOI_OP_RGB)
+			{
+				px = (px & 0xff000000) | ((unsigned int)p[0] << 16) | ((unsigned int)p[1] << 8) | p[2];
+				p += 3;
+			}
+			else if (b1 == QOI_OP_RGBA)
+			{
+				px = ((unsigned int)p[3] << 24) | ((unsigned int)p[0] << 16) | ((unsigned int)p[1] << 8) | p[2];
+				p += 4;
+			}
+			else if ((b1 & QOI_MASK_2) == QOI_OP_INDEX)
+			{
+				px = index[b1];
+			}
+			else if ((b1 & QOI_MASK_2) == QOI_OP_DIFF)
+			{
+				unsigned int r = (((px >> 16) & 0xff) + ((b1 >> 4) & 3) - 2) & 0xff;
+				unsigned int g = (((px >> 8) & 0xff) + ((b1 >> 2) & 3) - 2) & 0xff;
+				unsigned int b = ((px & 0xff) + (b1 & 3) - 2) & 0xff;
+				px = (px & 0xff000000) | (r << 16) | (g << 8) | b;
+			}
+			else if ((b1 & QOI_MASK_2) == QOI_OP_LUMA)
+			{
+				int b2 = *p++;
+				int vg = (b1 & 0x3f) - 32;
+				unsigned int r = (((px >> 16) & 0xff) + vg - 8 + ((b2 >> 4) & 0x0f)) & 0xff;
+				unsigned int g = (((px >> 8) & 0xff) + vg) & 0xff;
+				unsigned int b = ((px & 0xff) + vg - 8 + (b2 & 0x0f)) & 0xff;
+				px = (px & 0xff000000) | (r << 16) | (g << 8) | b;
+			}
+			else
+			{
+				run = b1 & 0x3f;
+			}
+
+			index[Image_QOIHash(px)] = px;
+		}
+
+		pImage->pixels[i] = px;
+	}
+
+	return true;
+}
+
+//Image_ReadQOI() : loads a QOI file written by Image_WriteQOI() or any other
+//encoder, three channel files come back opaque
+bool Image_ReadQOI(const char* pFile, IMAGE* pImage)
+{
+	size_t nSize;
+	unsigned char* pData = Image_ReadFile(pFile, &nSize);
+	if (pData == NULL)
+		return false;
+
+	bool bOk = Image_DecodeQOI(pData, nSize, pImage);
+	free(pData);
+
+	return bOk;
+}
+
+// inflate (RFC 1951), canonical Huffman decoding one bit at a time; only
+// used when cooking assets, so it favors size over speed
+struct INFLATESTATE
+{
+	const unsigned char* pIn;
+	size_t nIn;
+	size_t inPos;
+	unsigned int bitBuf;
+	int bitCnt;
+	unsigned char* pOut;
+	size_t nOut;
+	size_t outPos;
+};
+
+struct HUFFMAN
+{
+	short count[16];     // codes of each length
+	short symbol[288];   // symbols ordered by code
+};
+
+static const short g_LenBase[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+	35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+static const short g_LenExtra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+	3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+static const short g_DistBase[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+	257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+static const short g_DistExtra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+	7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+// returns -1 when the input runs out
+static int Inflate_Bits(INFLATESTATE* s, int need)
+{
+	unsigned int val = s->bitBuf;
+
+	while (s->bitCnt < need)
+	{
+		if (s->inPos >= s->nIn)
+			return -1;
+		val |= (unsigned int)s->pIn[s->inPos++] << s->bitCnt;
+		s->bitCnt += 8;
+	}
+
+	s->bitBuf = val >> need;
+	s->bitCnt -= need;
+
+	return (int)(val & ((1u << need) - 1));
+}
+
+static int Inflate_Decode(INFLATESTATE* s, const HUFFMAN* h)
+{
+	int code = 0, first = 0, index = 0;
+
+	for (int len = 1; len < 16; len++)
+	{
+		int bit = Inflate_Bits(s, 1);
+		if (bit < 0)
+			return -1;
+
+		code |= bit;
+		int count = h->count[len];
+		if (code - count < first)
+			return h->symbol[index + (code - first)];
+
+		index += count;
+		first = (first + count) << 1;
+		code <<= 1;
+	}
+
+	return -1;
+}
+
+// returns false for an over-subscribed code; incomplete codes are allowed
+static bool Inflate_Build(HUFFMAN* h, const short* pLength, int n)
+{
+	short offs[16];
+
+	memset(h->count, 0, sizeof(h->count));
+	for (int sym = 0; sym < n; sym++)
+		h->count[pLength[sym]]++;
+
+	int left = 1;
+	for (int len = 1; len < 16; len++)
+	{
+		left = (left << 1) - h->count[len];
+		if (left < 0)
+			return false;
+	}
+
+	offs[1] = 0;
+	for (int len = 1; len < 15; len++)
+		offs[len + 1] = offs[len] + h->count[len];
+
+	for (int sym = 0; sym < n; sym++)
+	{
+		if (pLength[sym] != 0)
+			h->symbol[offs[pLength[sym]]++] = (short)sym;
+	}
+
+	return true;
+}
+
+static bool Inflate_Codes(INFLATESTATE* s, const HUFFMAN* pLenCode, const HUFFMAN* pDistCode)
+{
+	for (;;)
+	{
+		int sym = Inflate_Decode(s, pLenCode);
+		if (sym < 0)
+			return false;
+
+		if (sym < 256)
+		{
+			if (s->outPos >= s->nOut)
+				return false;
+			s->pOut[s->outPos++] = (unsigned char)sym;
+		}
+		else if (sym == 256)
+		{
+			return true;
+		}
+		else
+		{
+			sym -= 257;
+			if (sym >= 29)
+				return false;
+
+			int extra = Inflate_Bits(s, g_LenExtra[sym]);
+			int dsym = Inflate_Decode(s, pDistCode);
+			if (extra < 0 || dsym < 0 || dsym >= 30)
+				return false;
+			size_t len = g_LenBase[sym] + extra;
+
+			extra = Inflate_Bits(s, g_DistExtra[dsym]);
+			if (extra < 0)
+				return false;
+			size_t dist = g_DistBase[dsym] + extra;
+
+			if (dist > s->outPos || s->outPos + len > s->nOut)
+				return false;
+
+			for (; len > 0; len--, s->outPos++)
+				s->pOut[s->outPos] = s->pOut[s->outPos - dist];
+		}
+	}
+}
+
+static bool Inflate_Stored(INFLATESTATE* s)
+{
+	s->bitBuf = 0;
+	s->bitCnt = 0;
+
+	if (s->inPos + 4 > s->nIn)
+		return false;
+
+	size_t len = s->pIn[s->inPos] | (s->pIn[s->inPos + 1] << 8);
+	size_t nlen = s->pIn[s->inPos + 2] | (s->pIn[s->inPos + 3] << 8);
+	s->inPos += 4;
+
+	if (len != (~nlen & 0xffff) || s->inPos + len > s->nIn || s->outPos + len > s->nOut)
+		return false;
+
+	memcpy(s->pOut + s->outPos, s->pIn + s->inPos, len);
+	s->inPos += len;
+	s->outPos += len;
+
+	return true;
+}
+
+static bool Inflate_Fixed(INFLATESTATE* s)
+{
+	HUFFMAN lenCode, distCode;
+	short lengths[288];
+
+	for (int sym = 0; sym < 288; sym++)
+		lengths[sym] = (sym < 144) ? 8 : (sym < 256) ? 9 : (sym < 280) ? 7 : 8;
+	Inflate_Build(&lenCode, lengths, 288);
+
+	for (int sym = 0; sym < 30; sym++)
+		lengths[sym] = 5;
+	Inflate_Build(&distCode, lengths, 30);
+
+	return Inflate_Codes(s, &lenCode, &distCode);
+}
+
+static bool Inflate_Dynamic(INFLATESTATE* s)
+{
+	static const short order[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+	HUFFMAN lenCode, distCode;
+	short lengths[320];
+
+	int nLen = Inflate_Bits(s, 5) + 257;
+	int nDist = Inflate_Bits(s, 5) + 1;
+	int nCode = Inflate_Bits(s, 4) + 4;
+	if (nLen > 286 || nDist > 30 || nCode < 4)
+		return false;
+
+	memset(lengths, 0, sizeof(lengths));
+	for (int i = 0; i < nCode; i++)
+	{
+		int len = Inflate_Bits(s, 3);
+		if (len < 0)
+			return false;
+		lengths[order[i]] = (short)len;
+	}
+	if (!Inflate_Build(&lenCode, lengths, 19))
+		return false;
+
+	for (int i = 0; i < nLen + nDist; )
+	{
+		int sym = Inflate_Decode(s, &lenCode);
+		if (sym < 0)
+			return false;
+
+		if (sym < 16)
+		{
+			lengths[i++] = (short)sym;
+			continue;
+		}
+
+		short len = 0;
+		int repeat;
+		if (sym == 16)
+		{
+			if (i == 0)
+				return false;
+			len = lengths[i - 1];
+			repeat = 3 + Inflate_Bits(s, 2);
+		}
+		else if (sym == 17)
+			repeat = 3 + Inflate_Bits(s, 3);
+		else
+			repeat = 11 + Inflate_Bits(s, 7);
+
+		if (repeat < 3 || i + repeat > nLen + nDist)
+			return false;
+		while (repeat--)
+			lengths[i++] = len;
+	}
+
+	if (lengths[256] == 0 || !Inflate_Build(&lenCode, lengths, nLen) || !Inflate_Build(&distCode, lengths + nLen, nDist))
+		return false;
+
+	return Inflate_Codes(s, &lenCode, &distCode);
+}
+
+// inflates a zlib stream into a buffer of known size
+static bool Image_Inflate(const unsigned char* pIn, size_t nIn, unsigned char* pOut, size_t nOut)
+{
+	if (nIn < 2 || (pIn[0] & 0x0f) != 8 || ((pIn[0] << 8) | pIn[1]) % 31 != 0 || (pIn[1] & 0x20))
+		return false;
+
+	INFLATESTATE s;
+	s.pIn = pIn;
+	s.nIn = nIn;
+	s.inPos = 2;
+	s.bitBuf = 0;
+	s.bitCnt = 0;
+	s.pOut = pOut;
+	s.nOut = nOut;
+	s.outPos = 0;
+
+	int last;
+	do
+	{
+		last = Inflate_Bits(&s, 1);
+		int type = Inflate_Bits(&s, 2);
+		bool bOk;
+
+		if (type == 0)
+			bOk = Inflate_Stored(&s);
+		else if (type == 1)
+			bOk = Inflate_Fixed(&s);
+		else if (type == 2)
+			bOk = Inflate_Dynamic(&s);
+		else
+			bOk = false;
+
+		if (!bOk || last < 0)
+			return false;
+	} while (last == 0);
+
+	return s.outPos == nOut;
+}
+
+static inline int Image_Paeth(int a, int b, int c)
+{
+	int p = a + b - c;
+	int pa = abs(p - a), pb = abs(p - b), pc = abs(p - c);
+
+	return (pa <= pb && pa <= pc) ? a : (pb <= pc) ? b : c;
+}
+
+//Image_DecodePNG() : 8-bit, non-interlaced PNGs of any color type
+static bool Image_DecodePNG(const unsigned char* pData, size_t nSize, IMAGE* pImage)
+{
+	static const unsigned char signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+	static const int channels[7] = { 1, 0, 3, 1, 2, 0, 4 };
+
+	if (nSize < 33 || memcmp(pData, signature, 8) != 0 || memcmp(pData + 12, "IHDR", 4) != 0)
+		return false;
+
+	int width = (int)Image_Get32(pData + 16);
+	int height = (int)Image_Get32(pData + 20);
+	int depth = pData[24];
+	int colorType = pData[25];
+
+	if (width <= 0 || height <= 0 || width > 16384 || height > 16384 || depth != 8 ||
+		colorType > 6 || channels[colorType] == 0 || pData[28] != 0)
+		return false;
+
+	// gather IDAT payloads and the palette
+	unsigned int palette[256];
+	for (int i = 0; i < 256; i++)
+		palette[i] = 0xff000000;
+
+	unsigned char* pZlib = (unsigned char*)malloc(nSize);
+	size_t nZlib = 0;
+	size_t pos = 8;
+
+	while (pZlib != NULL && pos + 12 <= nSize)
+	{
+		size_t nChunk = Image_Get32(pData + pos);
+		const unsigned char* pType = pData + pos + 4;
+		const unsigned char* pBody = pData + pos + 8;
+		if (nChunk > nSize - pos - 12)
+			break;
+
+		if (memcmp(pType, "IDAT", 4) == 0)
+		{
+			memcpy(pZlib + nZlib, pBody, nChunk);
+			nZlib += nChunk;
+		}
+		else if (memcmp(pType, "PLTE", 4) == 0)
+		{
+			for (size_t i = 0; i < nChunk / 3 && i < 256; i++)
+				palette[i] = 0xff000000 | (pBody[i * 3] << 16) | (pBody[i * 3 + 1] << 8) | pBody[i * 3 + 2];
+		}
+		else if (memcmp(pType, "tRNS", 4) == 0 && colorType == 3)
+		{
+			for (size_t i = 0; i < nChunk && i < 256; i++)
+				palette[i] = (palette[i] & 0x00ffffff) | ((unsigned int)pBody[i] << 24);
+		}
+		else if (memcmp(pType, "IEND", 4) == 0)
+			break;
+
+		pos += nChunk + 12;
+	}
+
+	int bpp = channels[colorType];
+	size_t nRow = (size_t)width * bpp;
+	unsigned char* pRaw = (unsigned char*)malloc((nRow + 1) * height);
+	bool bOk = pZlib != NULL && pRaw != NULL && Image_Inflate(pZlib, nZlib, pRaw, (nRow + 1) * height) &&
+		Image_Create(pImage, width, height);
+	free(pZlib);
+
+	for (int y = 0; bOk && y < height; y++)
+	{
+		unsigned char* pRow = pRaw + y * (nRow + 1) + 1;
+		const unsigned char* pPrev = (y > 0) ? pRow - (nRow + 1) : NULL;
+		int filter = pRow[-1];
+
+		for (size_t x = 0; x < nRow; x++)
+		{
+			int a = (x >= (size_t)bpp) ? pRow[x - bpp] : 0;
+			int b = pPrev ? pPrev[x] : 0;
+			int c = (pPrev && x >= (size_t)bpp) ? pPrev[x - bpp] : 0;
+
+			switch (filter)
+			{
+			case 0: break;
+			case 1: pRow[x] = (unsigned char)(pRow[x] + a); break;
+			case 2: pRow[x] = (unsigned char)(pRow[x] + b); break;
+			case 3: pRow[x] = (unsigned char)(pRow[x] + ((a + b) >> 1)); break;
+			case 4: pRow[x] = (unsigned char)(pRow[x] + Image_Paeth(a, b, c)); break;
+			default: bOk = false; break;
+			}
+		}
+
+		unsigned int* pDst = pImage->pixels + y * width;
+		for (int x = 0; bOk && x < width; x++)
+		{
+			const unsigned char* p = pRow + x * bpp;
+
+			switch (colorType)
+			{
+			case 0: pDst[x] = 0xff000000 | (p[0] << 16) | (p[0] << 8) | p[0]; break;
+			case 2: pDst[x] = 0xff000000 | (p[0] << 16) | (p[1] << 8) | p[2]; break;
+			case 3: pDst[x] = palette[p[0]]; break;
+			case 4: pDst[x] = ((unsigned int)p[1] << 24) | (p[0] << 16) | (p[0] << 8) | p[0]; break;
+			case 6: pDst[x] = ((unsigned int)p[3] << 24) | (p[0] << 16) | (p[1] << 8) | p[2]; break;
+			}
+		}
+	}
+
+	free(pRaw);
+	if (!bOk && pImage->pixels != NULL)
+		Image_Free(pImage);
+
+	return bOk;
+}
+
+//Image_DecodeBMP() : uncompressed 24 and 32-bit bitmaps, both come back opaque
+static bool Image_DecodeBMP(const unsigned char* pData, size_t nSize, IMAGE* pImage)
+{
+	if (nSize < 54 || pData[0] != 'B' || pData[1] != 'M')
+		return false;
+
+	size_t offset = pData[10] | (pData[11] << 8) | (pData[12] << 16) | ((size_t)pData[13] << 24);
+	int width = (int)(pData[18] | (pData[19] << 8) | (pData[20] << 16) | ((unsigned int)pData[21] << 24));
+	int height = (int)(pData[22] | (pData[23] << 8) | (pData[24] << 16) | ((unsigned int)pData[25] << 24));
+	int bpp = pData[28] | (pData[29] << 8);
+	int compression = pData[30];
+
+	bool bTopDown = height < 0;
+	if (bTopDown)
+		height = -height;
+
+	if (width <= 0 || height <= 0 || width > 16384 || height > 16384 || (bpp != 24 && bpp != 32) || compression != 0)
+		return false;
+
+	size_t nRow = ((size_t)width * (bpp / 8) + 3) & ~(size_t)3;
+	if (offset + nRow * height > nSize || !Image_Create(pImage, width, height))
+		return false;
+
+	for (int y = 0; y < height; y++)
+	{
+		const unsigned char* pSrc = pData + offset + nRow * (bTopDown ? y : height - 1 - y);
+		unsigned int* pDst = pImage->pixels + y * width;
+
+		for (int x = 0; x < width; x++, pSrc += bpp / 8)
+			pDst[x] = 0xff000000 | (pSrc[2] << 16) | (pSrc[1] << 8) | pSrc[0];
+	}
+
+	return true;
+}
+
+//Image_Decode() : PNG, BMP or QOI from memory, picked by signature
+bool Image_Decode(const void* pData, size_t nSize, IMAGE* pImage)
+{
+	const unsigned char* p = (const unsigned char*)pData;
+
+	pImage->pixels = NULL;
+	if (nSize >= 8 && p[0] == 0x89 && p[1] == 'P')
+		return Image_DecodePNG(p, nSize, pImage);
+	if (nSize >= 2 && p[0] == 'B' && p[1] == 'M')
+		return Image_DecodeBMP(p, nSize, pImage);
+
+	return Image_DecodeQOI(p, nSize, pImage);
+}
+
+bool Image_Read(const char* pFile, IMAGE* pImage)
+{
+	size_t nSize;
+	unsigned char* pData = Image_ReadFile(pFile, &nSize);
+	if (pData == NULL)
+		return false;
+
+	bool bOk = Image_Decode(pData, nSize, pImage);
+	free(pData);
+
+	return bOk;
+}
+
+static void Image_CRCTable(unsigned int* pTable)
+{
+	for (unsigned int i = 0; i < 256; i++)
+	{
+		unsigned int c = i;
+		for (int k = 0; k < 8; k++)
+			c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+		pTable[i] = c;
+	}
+}
+
+static unsigned int Image_CRC(const unsigned int* pTable, const unsigned char* p, size_t n)
+{
+	unsigned int crc = 0xffffffffu;
+
+	for (size_t i = 0; i < n; i++)
+		crc = pTable[(crc ^ p[i]) & 0xff] ^ (crc >> 8);
+
+	return ~crc;
+}
+
+//Image_WritePNG() : RGBA PNG with stored (uncompressed) deflate blocks, no
+//compression work at all so it costs little more than the file write
+bool Image_WritePNG(const char* pFile, const IMAGE* pImage)
+{
+	static const unsigned char signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+
+	size_t nRow = (size_t)pImage->width * 4 + 1;
+	size_t nRaw = nRow * pImage->height;
+	size_t nBlocks = (nRaw + 65534) / 65535;
+	size_t nZlib = 2 + nRaw + nBlocks * 5 + 4;
+	size_t nSize = 8 + (12 + 13) + (12 + nZlib) + 12;
+
+	unsigned char* pData = (unsigned char*)malloc(nSize);
+	if (pData == NULL)
+		return false;
+
+	unsigned int crc[256];    // built per call, writers run on several threads
+	Image_CRCTable(crc);
+
+	unsigned char* p = pData;
+	memcpy(p, signature, 8);
+	p += 8;
+
+	// IHDR
+	unsigned char* pChunk = p;
+	Image_Put32(p, 13);
+	memcpy(p + 4, "IHDR", 4);
+	Image_Put32(p + 8, pImage->width);
+	Image_Put32(p + 12, pImage->height);
+	p[16] = 8;    // bits per channel
+	p[17] = 6;    // RGBA
+	p[18] = 0;
+	p[19] = 0;
+	p[20] = 0;
+	Image_Put32(p + 21, Image_CRC(crc, pChunk + 4, 17));
+	p += 25;
+
+	// IDAT: zlib stream of stored blocks, rows are filtered with filter 0
+	pChunk = p;
+	Image_Put32(p, (unsigned int)nZlib);
+	memcpy(p + 4, "IDAT", 4);
+	p += 8;
+	*p++ = 0x78;
+	*p++ = 0x01;
+
+	unsigned char* pRaw = p + 5;    // rows are built in place, then slid behind their block headers
+	for (int y = 0; y < pImage->height; y++)
+	{
+		unsigned char* pRow = pRaw + y * nRow;
+		const unsigned int* pSrc = pImage->pixels + y * pImage->width;
+
+		*pRow++ = 0;
+		for (int x = 0; x < pImage->width; x++, pRow += 4)
+		{
+			pRow[0] = (unsigned char)(pSrc[x] >> 16);
+			pRow[1] = (unsigned char)(pSrc[x] >> 8);
+			pRow[2] = (unsigned char)pSrc[x];
+			pRow[3] = (unsigned char)(pSrc[x] >> 24);
+		}
+	}
+
+	// adler32, reduced every 5552 bytes, the most that cannot overflow 32 bits
+	unsigned int adlerA = 1, adlerB = 0;
+	for (size_t n = 0; n < nRaw; n++)
+	{
+		adlerA += pRaw[n];
+		adlerB += adlerA;
+		if (n % 5552 == 5551)
+		{
+			adlerA %= 65521;
+			adlerB %= 65521;
+		}
+	}
+	adlerA %= 65521;
+	adlerB %= 65521;
+
+	// every block header shifts the data behind it by 5 bytes, so walk from
+	// the last block backwards
+	for (size_t nBlock = nBlocks; nBlock-- > 0; )
+	{
+		size_t nOffset = nBlock * 65535;
+		unsigned int nLen = (unsigned int)((nRaw - nOffset) > 65535 ? 65535 : (nRaw - nOffset));
+		unsigned char* pHeader = p + nOffset + nBlock * 5;
+
+		memmove(pHeader + 5, pRaw + nOffset, nLen);
+		pHeader[0] = (nBlock == nBlocks - 1) ? 1 : 0;
+		pHeader[1] = (unsigned char)nLen;
+		pHeader[2] = (unsigned char)(nLen >> 8);
+		pHeader[3] = (unsigned char)~nLen;
+		pHeader[4] = (unsigned char)(~nLen >> 8);
+	}
+	p += nRaw + nBlocks * 5;
+
+	Image_Put32(p, (adlerB << 16) | adlerA);
+	p += 4;
+	Image_Put32(p, Image_CRC(crc, pChunk + 4, p - pChunk - 4));
+	p += 4;
+
+	// IEND
+	pChunk = p;
+	Image_Put32(p, 0);
+	memcpy(p + 4, "IEND", 4);
+	Image_Put32(p + 8, Image_CRC(crc, pChunk + 4, 4));
+	p += 12;
+
+	bool bOk = Image_WriteFile(pFile, pData, p - pData);
+	free(pData);
+
+	return bOk;
+}
+
+//Image_Compare() : per channel comparison with a tolerance; when pDiffImage is
+//given it is created with mismatched pixels in red over a dimmed copy of pA
+bool Image_Compare(const IMAGE* pA, const IMAGE* pB, int tolerance, IMAGEDIFF* pDiff, IMAGE* pDiffImage)
+{
+	memset(pDiff, 0, sizeof(*pDiff));
+
+	if (pA->width != pB->width || pA->height != pB->height)
+		return false;
+
+	if (pDiffImage != NULL && !Image_Create(pDiffImage, pA->width, pA->height))
+		pDiffImage = NULL;
+
+	int nPixels = pA->width * pA->height;
+	double fSquared = 0.0;
+
+	for (int i = 0; i < nPixels; i++)
+	{
+		unsigned int a = pA->pixels[i];
+		unsigned int b = pB->pixels[i];
+		int delta = 0;
+
+		for (int shift = 0; shift < 32; shift += 8)
+		{
+			int d = abs((int)((a >> shift) & 0xff) - (int)((b >> shift) & 0xff));
+			if (d > delta)
+				delta = d;
+			if (shift < 24)
+				fSquared += d * d;
+		}
+
+		if (delta > pDiff->maxDelta)
+			pDiff->maxDelta = delta;
+		if (delta > tolerance)
+			pDiff->nMismatched++;
+
+		if (pDiffImage != NULL)
+			pDiffImage->pixels[i] = (delta > tolerance) ? 0xffff0000 : 0xff000000 | ((a >> 2) & 0x3f3f3f);
+	}
+
+	pDiff->nPixels = nPixels;
+	pDiff->psnr = (fSquared == 0.0) ? 100.0 : 10.0 * log10(255.0 * 255.0 * 3.0 * nPixels / fSquared);
+
+	return true;
+}
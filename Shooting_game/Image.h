@@ -0,0 +1,36 @@
+#pragma once
+#include <stddef.h>
+
+// 32-bit images in system memory, laid out like a locked D3DFMT_A8R8G8B8
+// surface, and the file formats used by frame capture: QOI for golden
+// images (lossless, and several times faster to write and read back than
+// deflate) and uncompressed PNG for looking at a result in any viewer.
+// PNG and BMP sources can be decoded for the asset cooker.
+
+struct IMAGE
+{
+	int width;
+	int height;
+	unsigned int* pixels;    // 0xAARRGGBB, rows top to bottom, no padding
+};
+
+struct IMAGEDIFF
+{
+	int nPixels;
+	int nMismatched;    // pixels with a channel off by more than the tolerance
+	int maxDelta;       // largest channel difference found
+	double psnr;        // dB over RGB, 100 when the images are identical
+};
+
+bool Image_Create(IMAGE* pImage, int width, int height);
+void Image_Free(IMAGE* pImage);
+void Image_Fill(IMAGE* pImage, unsigned int color);
+
+bool Image_WriteQOI(const char* pFile, const IMAGE* pImage);
+bool Image_ReadQOI(const char* pFile, IMAGE* pImage);
+bool Image_WritePNG(const char* pFile, const IMAGE* pImage);
+
+bool Image_Decode(const void* pData, size_t nSize, IMAGE* pImage);    // PNG, BMP or QOI
+bool Image_Read(const char* pFile, IMAGE* pImage);
+
+bool Image_Compare(const IMAGE* pA, const IMAGE* pB, int tolerance, IMAGEDIFF* pDiff, IMAGE* pDiffImage);
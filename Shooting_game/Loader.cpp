@@ -0,0 +1,463 @@
+#include "Loader.h"
+#include "TexFile.h"
+#include <stdio.h>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#pragma comment (lib, "winmm.lib")
+
+enum { JOB_QUEUED, JOB_LOADING, JOB_DONE, JOB_HANDED };
+
+struct LOADERJOB
+{
+	WCHAR szFile[MAX_PATH];
+	UINT width;
+	UINT height;
+	D3DFORMAT format;
+	D3DCOLOR colorKey;
+	LPDIRECT3DTEXTURE9* ppTexture;    // where Loader_Poll() stores the result
+	int group;
+	int state;
+	LPDIRECT3DTEXTURE9 pResult;
+	HRESULT hr;
+	bool bReload;    // replaces, and releases, the texture already in the target
+};
+
+static LPDIRECT3DDEVICE9 g_pLoaderDevice = NULL;
+static std::vector<std::thread> g_LoaderWorkers;
+static std::mutex g_LoaderLock;
+static std::condition_variable g_LoaderWake;    // workers: a job was queued, or shutdown
+static std::condition_variable g_LoaderDone;    // main thread: a job finished
+static bool g_bLoaderClosing = false;
+
+static LOADERJOB g_LoaderJobs[LOADER_MAX_JOBS];
+static int g_nLoaderJobs = 0;
+static int g_nLoaderNext = 0;    // first job no worker has taken yet
+static int g_nLoaderFinished = 0;    // jobs in JOB_DONE
+static int g_nGroupPending[LOADER_MAX_GROUPS];
+static DWORD g_dwLoaderStart = 0;
+static LOADERCOOKFUNC g_pLoaderCook = NULL;
+
+// tasks wait in a ring; the texture jobs go first
+struct LOADERTASKENTRY
+{
+	LOADERTASK pTask;
+	void* pContext;
+};
+
+static LOADERTASKENTRY g_LoaderTasks[LOADER_MAX_TASKS];
+static int g_nLoaderTaskHead = 0;    // next task to run
+static int g_nLoaderTaskCount = 0;
+static LOADERSTATS g_LoaderStats;
+
+//Loader_FindCooked() : the .ctex next to the source, if it is at least as new
+static bool Loader_FindCooked(LPCWSTR pFile, char* pPath)
+{
+	WCHAR szCooked[MAX_PATH];
+
+	wcscpy_s(szCooked, MAX_PATH, pFile);
+	WCHAR* pExt = wcsrchr(szCooked, L'.');
+	if (pExt == NULL || pExt - szCooked + 6 > MAX_PATH)
+		return false;
+	wcscpy_s(pExt, MAX_PATH - (pExt - szCooked), L".ctex");
+
+	WIN32_FILE_ATTRIBUTE_DATA source, cooked;
+	if (!GetFileAttributesExW(szCooked, GetFileExInfoStandard, &cooked))
+		return false;
+	if (GetFileAttributesExW(pFile, GetFileExInfoStandard, &source) &&
+		CompareFileTime(&cooked.ftLastWriteTime, &source.ftLastWriteTime) < 0)
+		return false;
+
+	return WideCharToMultiByte(CP_ACP, 0, szCooked, -1, pPath, MAX_PATH, NULL, NULL) != 0;
+}
+
+//Loader_LoadCooked() : uses a cooked file made for the same size, format and
+//color key, from the cook function if one is set, otherwise from next to the
+//source; each level is copied once, from the mapped file into the locked texture
+static bool Loader_LoadCooked(const LOADERJOB* pJob, LPDIRECT3DTEXTURE9* ppTexture)
+{
+	char szPath[MAX_PATH];
+
+	if (g_pLoaderCook != NULL)
+	{
+		if (!g_pLoaderCook(pJob->szFile, szPath, MAX_PATH))
+			return false;
+	}
+	else if (!Loader_FindCooked(pJob->szFile, szPath))
+		return false;
+
+	TEXFILE tex;
+	if (!TexFile_Open(szPath, &tex))
+		return false;
+
+	const TEXFILEHEADER* pHeader = tex.pHeader;
+	D3DCOLOR colorKey = (pHeader->flags & TEXFILE_COLORKEY) ? pHeader->colorKey : 0;
+
+	if ((pJob->width != D3DX_DEFAULT && pJob->width != pHeader->width) ||
+		(pJob->height != D3DX_DEFAULT && pJob->height != pHeader->height) ||
+		(pJob->format != D3DFMT_UNKNOWN && pJob->format != (D3DFORMAT)pHeader->format) ||
+		colorKey != pJob->colorKey)
+	{
+		TexFile_Close(&tex);
+		return false;
+	}
+
+	LPDIRECT3DTEXTURE9 pTexture = NULL;
+	HRESULT hr = g_pLoaderDevice->CreateTexture(pHeader->width, pHeader->height, pHeader->levels, 0,
+		(D3DFORMAT)pHeader->format, D3DPOOL_MANAGED, &pTexture, NULL);
+
+	for (UINT level = 0; SUCCEEDED(hr) && level < pHeader->levels; level++)
+	{
+		const TEXFILELEVEL& info = tex.pLevels[level];
+		const BYTE* pSrc = (const BYTE*)TexFile_GetPixels(&tex, level);
+		D3DLOCKED_RECT locked;
+
+		hr = pTexture->LockRect(level, &locked, NULL, 0);
+		if (FAILED(hr))
+			break;
+
+		// rows of texels, or of 4x4 blocks for DXT levels
+		UINT nRows = TexFile_GetRows(&tex, level);
+		if ((UINT)locked.Pitch == info.pitch)
+			memcpy(locked.pBits, pSrc, info.pitch * nRows);
+		else
+		{
+			for (UINT y = 0; y < nRows; y++)
+				memcpy((BYTE*)locked.pBits + y * locked.Pitch, pSrc + y * info.pitch, info.pitch);
+		}
+
+		pTexture->UnlockRect(level);
+	}
+
+	TexFile_Close(&tex);
+
+	if (FAILED(hr))
+	{
+		if (pTexture != NULL)
+			pTexture->Release();
+		return false;
+	}
+
+	*ppTexture = pTexture;
+
+	return true;
+}
+
+static void Loader_WorkerProc(void)
+{
+	for (;;)
+	{
+		LOADERJOB* pJob;
+		{
+			std::unique_lock<std::mutex> lock(g_LoaderLock);
+			g_LoaderWake.wait(lock, [] { return g_bLoaderClosing || g_nLoaderNext < g_nLoaderJobs || g_nLoaderTaskCount > 0; });
+
+			if (g_nLoaderNext >= g_nLoaderJobs)
+			{
+				if (g_bLoaderClosing || g_nLoaderTaskCount == 0)
+					return;
+
+				LOADERTASKENTRY task = g_LoaderTasks[g_nLoaderTaskHead];
+				g_nLoaderTaskHead = (g_nLoaderTaskHead + 1) % LOADER_MAX_TASKS;
+				g_nLoaderTaskCount--;
+				g_LoaderStats.nTasks++;
+				lock.unlock();
+
+				task.pTask(g_pLoaderDevice, task.pContext);
+				continue;
+			}
+
+			pJob = &g_LoaderJobs[g_nLoaderNext++];
+			pJob->state = JOB_LOADING;
+		}
+
+		DWORD dwStart = timeGetTime();
+		LPDIRECT3DTEXTURE9 pTexture = NULL;
+		HRESULT hr = S_OK;
+		bool bCooked = Loader_LoadCooked(pJob, &pTexture);
+
+		if (!bCooked)
+			hr = D3DXCreateTextureFromFileExW(g_pLoaderDevice, pJob->szFile,
+				pJob->width, pJob->height, D3DX_DEFAULT, 0, pJob->format, D3DPOOL_MANAGED,
+				D3DX_DEFAULT, D3DX_DEFAULT, pJob->colorKey, NULL, NULL, &pTexture);
+		float fTime = (timeGetTime() - dwStart) * 0.001f;
+
+		{
+			std::lock_guard<std::mutex> lock(g_LoaderLock);
+			pJob->pResult = SUCCEEDED(hr) ? pTexture : NULL;
+			pJob->hr = hr;
+			pJob->state = JOB_DONE;
+			g_nLoaderFinished++;
+			g_LoaderStats.fDecodeTime += fTime;
+			if (bCooked)
+				g_LoaderStats.nCooked++;
+		}
+		g_LoaderDone.notify_all();
+	}
+}
+
+//Loader_Init() : starts the worker pool; dwStartTime is the timeGetTime() the
+//startup timings are measured from
+bool Loader_Init(LPDIRECT3DDEVICE9 pDevice, int nThreads, DWORD dwStartTime)
+{
+	if (!g_LoaderWorkers.empty())
+		return false;
+
+	g_pLoaderDevice = pDevice;
+	g_dwLoaderStart = dwStartTime;
+	g_bLoaderClosing = false;
+	g_nLoaderJobs = 0;
+	g_nLoaderNext = 0;
+	g_nLoaderFinished = 0;
+	g_nLoaderTaskHead = 0;
+	g_nLoaderTaskCount = 0;
+	ZeroMemory(g_nGroupPending, sizeof(g_nGroupPending));
+	ZeroMemory(&g_LoaderStats, sizeof(g_LoaderStats));
+
+	if (nThreads <= 0)
+		nThreads = (int)std::thread::hardware_concurrency() - 1;
+	if (nThreads < 1)
+		nThreads = 1;
+	if (nThreads > LOADER_MAX_JOBS)
+		nThreads = LOADER_MAX_JOBS;
+
+	for (int i = 0; i < nThreads; i++)
+		g_LoaderWorkers.push_back(std::thread(Loader_WorkerProc));
+
+	return true;
+}
+
+//Loader_Queue() : same parameters as D3DXCreateTextureFromFileEx() with the
+//managed pool and default mip levels and filters
+bool Loader_Queue(LPCWSTR pFile, UINT width, UINT height, D3DFORMAT format, D3DCOLOR colorKey,
+	LPDIRECT3DTEXTURE9* ppTexture, int group)
+{
+	if (group < 0 || group >= LOADER_MAX_GROUPS)
+		return false;
+
+	{
+		std::lock_guard<std::mutex> lock(g_LoaderLock);
+
+		if (g_LoaderWorkers.empty() || g_nLoaderJobs >= LOADER_MAX_JOBS)
+			return false;
+
+		LOADERJOB& job = g_LoaderJobs[g_nLoaderJobs];
+		wcsncpy_s(job.szFile, MAX_PATH, pFile, _TRUNCATE);
+		job.width = width;
+		job.height = height;
+		job.format = format;
+		job.colorKey = colorKey;
+		job.ppTexture = ppTexture;
+		job.group = group;
+		job.state = JOB_QUEUED;
+		job.pResult = NULL;
+		job.hr = S_OK;
+		job.bReload = false;
+
+		g_nLoaderJobs++;
+		g_nGroupPending[group]++;
+		g_LoaderStats.nQueued++;
+	}
+
+	g_LoaderWake.notify_one();
+
+	return true;
+}
+
+//Loader_Poll() : stores finished textures in their targets and starts their
+//upload to video memory, call from the thread that owns those pointers
+int Loader_Poll(void)
+{
+	std::lock_guard<std::mutex> lock(g_LoaderLock);
+	int nPending = 0;
+
+	for (int i = 0; i < g_nLoaderJobs; i++)
+	{
+		LOADERJOB& job = g_LoaderJobs[i];
+
+		if (job.state != JOB_DONE)
+		{
+			if (job.state != JOB_HANDED)
+				nPending++;
+			continue;
+		}
+
+		if (job.pResult != NULL)
+		{
+			if (job.bReload && *job.ppTexture != NULL)
+				(*job.ppTexture)->Release();
+
+			*job.ppTexture = job.pResult;
+			job.pResult->PreLoad();
+			if (job.bReload)
+				g_LoaderStats.nReloaded++;
+			else
+				g_LoaderStats.nLoaded++;
+		}
+		else
+		{
+			char szError[MAX_PATH + 64];
+			sprintf_s(szError, sizeof(szError), "loader: failed to load %ls (0x%08lx)\n", job.szFile, job.hr);
+			OutputDebugStringA(szError);
+			g_LoaderStats.nFailed++;
+		}
+
+		job.state = JOB_HANDED;
+		g_nLoaderFinished--;
+		g_nGroupPending[job.group]--;
+
+		if (!job.bReload && g_LoaderStats.nLoaded + g_LoaderStats.nFailed == g_LoaderStats.nQueued)
+		{
+			char szReport[128];
+			g_LoaderStats.fAllLoaded = (timeGetTime() - g_dwLoaderStart) * 0.001f;
+			sprintf_s(szReport, sizeof(szReport), "loader: %d textures (%d cooked) in %.0f ms (%.0f ms decoding on %d threads)\n",
+				g_LoaderStats.nLoaded, g_LoaderStats.nCooked, g_LoaderStats.fAllLoaded * 1000.0f, g_LoaderStats.fDecodeTime * 1000.0f,
+				(int)g_LoaderWorkers.size());
+			OutputDebugStringA(szReport);
+		}
+	}
+
+	return nPending;
+}
+
+//Loader_Reload() : loads a file again into the target it was first queued for;
+//Loader_Poll() swaps the new texture in and releases the old one, a failed
+//reload leaves the old one in place
+bool Loader_Reload(LPCWSTR pFile)
+{
+	{
+		std::lock_guard<std::mutex> lock(g_LoaderLock);
+
+		int last = -1;
+		bool bIdle = g_nLoaderNext == g_nLoaderJobs;
+		for (int i = 0; i < g_nLoaderJobs; i++)
+		{
+			if (_wcsicmp(g_LoaderJobs[i].szFile, pFile) == 0)
+				last = i;
+			if (g_LoaderJobs[i].state != JOB_HANDED)
+				bIdle = false;
+		}
+
+		if (last < 0 || g_LoaderWorkers.empty())
+			return false;
+
+		LOADERJOB job = g_LoaderJobs[last];
+
+		// with no work in flight the old entry can go, so repeated reloads do not fill the table
+		if (bIdle)
+		{
+			for (int i = last; i < g_nLoaderJobs - 1; i++)
+				g_LoaderJobs[i] = g_LoaderJobs[i + 1];
+			g_nLoaderJobs--;
+			g_nLoaderNext--;
+		}
+
+		if (g_nLoaderJobs >= LOADER_MAX_JOBS)
+			return false;
+
+		job.state = JOB_QUEUED;
+		job.pResult = NULL;
+		job.hr = S_OK;
+		job.bReload = true;
+		g_LoaderJobs[g_nLoaderJobs++] = job;
+		g_nGroupPending[job.group]++;
+	}
+
+	g_LoaderWake.notify_one();
+
+	return true;
+}
+
+//Loader_QueueTask() : a worker calls pTask(device, pContext) after the
+//textures queued before it have been started
+bool Loader_QueueTask(LOADERTASK pTask, void* pContext)
+{
+	{
+		std::lock_guard<std::mutex> lock(g_LoaderLock);
+
+		if (g_LoaderWorkers.empty() || g_bLoaderClosing || g_nLoaderTaskCount >= LOADER_MAX_TASKS)
+			return false;
+
+		LOADERTASKENTRY& task = g_LoaderTasks[(g_nLoaderTaskHead + g_nLoaderTaskCount) % LOADER_MAX_TASKS];
+		task.pTask = pTask;
+		task.pContext = pContext;
+		g_nLoaderTaskCount++;
+	}
+
+	g_LoaderWake.notify_one();
+
+	return true;
+}
+
+void Loader_SetCookFunc(LOADERCOOKFUNC pCook)
+{
+	g_pLoaderCook = pCook;
+}
+
+bool Loader_IsGroupReady(int group)
+{
+	std::lock_guard<std::mutex> lock(g_LoaderLock);
+
+	return g_nGroupPending[group] == 0;
+}
+
+//Loader_WaitGroup() : blocks until every texture of the group is handed over
+void Loader_WaitGroup(int group)
+{
+	for (;;)
+	{
+		Loader_Poll();
+		if (Loader_IsGroupReady(group))
+			return;
+
+		std::unique_lock<std::mutex> lock(g_LoaderLock);
+		g_LoaderDone.wait(lock, [] { return g_nLoaderFinished > 0; });
+	}
+}
+
+void Loader_FirstFrame(void)
+{
+	if (g_LoaderStats.fFirstFrame > 0.0f)
+		return;
+
+	char szReport[64];
+	g_LoaderStats.fFirstFrame = (timeGetTime() - g_dwLoaderStart) * 0.001f;
+	sprintf_s(szReport, sizeof(szReport), "loader: first frame at %.0f ms\n", g_LoaderStats.fFirstFrame * 1000.0f);
+	OutputDebugStringA(szReport);
+}
+
+const LOADERSTATS& Loader_GetStats(void)
+{
+	return g_LoaderStats;
+}
+
+//Loader_Release() : waits for the jobs and tasks in flight, drops the ones not
+//started and releases textures that were never handed over
+void Loader_Release(void)
+{
+	{
+		std::lock_guard<std::mutex> lock(g_LoaderLock);
+		g_bLoaderClosing = true;
+		g_nLoaderJobs = g_nLoaderNext;
+		g_nLoaderTaskCount = 0;
+	}
+	g_LoaderWake.notify_all();
+
+	for (size_t i = 0; i < g_LoaderWorkers.size(); i++)
+		g_LoaderWorkers[i].join();
+	g_LoaderWorkers.clear();
+
+	for (int i = 0; i < g_nLoaderJobs; i++)
+	{
+		if (g_LoaderJobs[i].state == JOB_DONE && g_LoaderJobs[i].pResult != NULL)
+			g_LoaderJobs[i].pResult->Release();
+		g_LoaderJobs[i].state = JOB_HANDED;
+	}
+
+	g_nLoaderJobs = 0;
+	g_nLoaderNext = 0;
+	g_nLoaderFinished = 0;
+	g_pLoaderDevice = NULL;
+}
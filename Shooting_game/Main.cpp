@@ -6,20 +6,46 @@
 #include <iostream>
 #include <stdio.h>
 #include <time.h>
+#include <math.h>
 #include <dsound.h>
 #include "DSound.h"
 #include <fmod.h>
 #include <string>
 #include "Sound.h"
+#include "Animation.h"
+#include "Cull.h"
+#include "Background.h"
+#include "Particle.h"
+#include "MixBench.h"
+#include "ParticleBench.h"
+#include "BlockBench.h"
+#include "FramePacket.h"
+#include "Capture.h"
+#include "Loader.h"
+#include "TexCook.h"
+#include "AssetCache.h"
+#include "ResManager.h"
+#include "Trace.h"
+#include "Mixer.h"
+#include "SoundBank.h"
 
 // define the screen resolution and keyboard macros
 #define SCREEN_WIDTH  800
 #define SCREEN_HEIGHT 600
-#define KEY_DOWN(vk_code) ((GetAsyncKeyState(vk_code) & 0x8000) ? 1 : 0)
-#define KEY_UP(vk_code) ((GetAsyncKeyState(vk_code) & 0x8000) ? 0 : 1)
+#define KEY_DOWN(vk_code) (key_down(vk_code) ? 1 : 0)
+#define KEY_UP(vk_code) (key_down(vk_code) ? 0 : 1)
 
 #define ENEMY_NUM 25
 #define BULLET_NUM 100
+#define PARTICLE_NUM 2048
+
+// capture mode ("-capture" on the command line)
+#define CAPTURE_FRAMES    600     // length of the scripted session
+#define CAPTURE_INTERVAL  60      // every n-th frame is compared
+#define CAPTURE_STEP      10      // fixed frame time in milliseconds
+#define CAPTURE_SEED      1
+#define CAPTURE_TOLERANCE 2       // per channel
+#define CAPTURE_MISMATCH  0.001f  // fraction of the pixels allowed over it
 
 
 
@@ -37,33 +63,128 @@ int t_score = 0;
 char str[100];
 bool keyup = true;
 bool flag_hero;
-bool flag_explosion;
 int gamestate = 1;
 
-// ð
+// 시간
 FLOAT t = .0f;			
+FLOAT elapsed = .0f;	// seconds since the last frame
 DWORD dwOldTime = 0;
 FLOAT starttime;
 FLOAT endtime;
 FLOAT playtime;
 
 // sprite declarations
-LPDIRECT3DTEXTURE9 sprite;    // the pointer to the sprite
-LPDIRECT3DTEXTURE9 sprite_hero;
-LPDIRECT3DTEXTURE9 sprite_hero1; // the pointer to the sprite
-LPDIRECT3DTEXTURE9 sprite_enemy;    // the pointer to the sprite
-LPDIRECT3DTEXTURE9 sprite_bullet;    // the pointer to the sprite
-LPDIRECT3DTEXTURE9 sprite_explosion;
-LPDIRECT3DTEXTURE9 sprite_skill;
+TEXTUREHANDLE sprite_hero;
+TEXTUREHANDLE sprite_hero1; // the handle of the sprite
+TEXTUREHANDLE sprite_enemy;    // the handle of the sprite
+TEXTUREHANDLE sprite_bullet;    // the handle of the sprite
+TEXTUREHANDLE sprite_explosion;
+TEXTUREHANDLE sprite_skill;
 LPDIRECTSOUNDBUFFER   g_lpDSBG[2] = { NULL, };
 
+// texture and font ids used in frame packets
+enum { TEX_HERO, TEX_HERO_ATTACK, TEX_ENEMY, TEX_BULLET, TEX_EXPLOSION, TEX_SKILL, TEX_NUM };
+enum { FONT_SMALL, FONT_LARGE };
+
+// scenes, each one is also the loader group of the textures it draws first
+enum { SCENE_TITLE, SCENE_GAMEPLAY, SCENE_GAMEOVER, SCENE_NUM };
+
+// texture memory categories, and the budget unreferenced textures are evicted to
+enum { RES_CHARACTERS, RES_EFFECTS };
+#define TEXTURE_BUDGET (16 << 20)
+
+// every texture with the scene that first draws it; load_scene() queues a
+// scene's textures, startup waits only for the title's
+struct SCENETEXTURE
+{
+	LPCWSTR file;
+	UINT width, height;
+	int category;
+	int scene;
+	TEXTUREHANDLE* pHandle;
+};
+
+static const SCENETEXTURE scene_textures[] =
+{
+	{ L"img\\sasuke(w).png", 704, 64, RES_CHARACTERS, SCENE_GAMEPLAY, &sprite_hero },
+	{ L"img\\attack(w).png", 256, 64, RES_CHARACTERS, SCENE_GAMEPLAY, &sprite_hero1 },
+	{ L"img\\enemy_1.png", 1152, 64, RES_CHARACTERS, SCENE_GAMEPLAY, &sprite_enemy },
+	{ L"img\\weapon.png", 192, 64, RES_EFFECTS, SCENE_GAMEPLAY, &sprite_bullet },
+	{ L"img\\explosion.png", 480, 80, RES_EFFECTS, SCENE_GAMEPLAY, &sprite_explosion },
+	{ L"img\\skill.png", 300, 100, RES_EFFECTS, SCENE_GAMEPLAY, &sprite_skill },
+};
+
+// game sprites, cooked with a hot-pink color key and straight alpha for D3DXSPRITE_ALPHABLEND
+static const char* sprite_files[] = { "img\\sasuke(w).png", "img\\attack(w).png", "img\\enemy_1.png",
+	"img\\weapon.png", "img\\explosion.png", "img\\skill.png" };
+// block compression costs the hero sheets their outlines (under 29 dB PSNR)
+// to save well under a megabyte, so sprites stay 32-bit; -cook -bc shows the numbers
+static const TEXCOOKSETTINGS sprite_settings = { true, D3DCOLOR_XRGB(255, 0, 255), false, false, TEXCOOK_A8R8G8B8 };
+static const char* sound_files[] = { "sound\\Naruto_bgm.mp3", "sound\\suriken.mp3", "sound\\bomb.mp3", "sound\\whip.mp3" };
+// effects are decoded once into a bank the mixer plays without decoding, "-bank" builds it
+#define EFFECT_BANK "sound\\effects.sbk"
+static const char* effect_files[] = { "sound\\suriken.mp3", "sound\\bomb.mp3", "sound\\whip.mp3" };
+enum { EFF_SHURIKEN, EFF_BOMB, EFF_WHIP, EFF_NUM };    // effect_files order
+static const char* music_files[] = { "sound\\Naruto_bgm.mp3" };    // streamed, not decoded whole
+enum { BGM_GAMEPLAY, BGM_NUM };    // music_files order
+DWORD start_time = 0;    // timeGetTime() at startup, for time-to-first-frame
+
+// startup, time_to_title is the documented startup metric: seconds from
+// WinMain() to the return of the title screen's first Present()
+bool trace_mode = false;    // "-trace" writes startup_trace.json at exit
+float time_to_title = 0.0f;
+HANDLE sound_thread = NULL;    // opens FMOD while the title screen runs
+
+// render thread
+HANDLE render_thread = NULL;
+HANDLE render_event = NULL;    // signaled when a new frame packet is published
+volatile LONG render_running = 0;
+
+// capture mode, the session is driven by a fixed clock and an input script
+bool capture_mode = false;
+int capture_frame = 0;
+
+static const CAPTUREKEY capture_script[] =
+{
+	{   0,  60, VK_DOWN },
+	{  20,  24, VK_SPACE },
+	{  50,  54, VK_SPACE },
+	{  80, 140, VK_RIGHT },
+	{ 100, 104, VK_SPACE },
+	{ 150, 156, VK_LSHIFT },
+	{ 180, 260, VK_UP },
+	{ 200, 204, VK_SPACE },
+	{ 230, 234, VK_SPACE },
+	{ 300, 360, VK_LEFT },
+	{ 320, 324, VK_SPACE },
+	{ 400, 406, VK_LSHIFT },
+	{ 420, 500, VK_DOWN },
+	{ 450, 454, VK_SPACE },
+	{ 480, 484, VK_SPACE },
+	{ 540, 546, VK_LSHIFT },
+};
+
 
 									 // function prototypes
 void initD3D(HWND hWnd);    // sets up and initializes Direct3D
-void render_frame(void);    // renders a single frame
+void build_frame(void);    // fills and publishes the frame packet for the gameplay scene
+void render_frame(const FRAMEPACKET* pPacket);    // renders a single frame packet
+void start_render_thread(void);
+void stop_render_thread(void);
 void render_frame1(void);
 void render_frame2(void);
 void cleanD3D(void);		// closes Direct3D and releases memory
+bool key_down(int vk_code);    // keyboard, or the input script in capture mode
+DWORD game_time(void);    // timeGetTime(), or the fixed capture clock
+int run_capture(void);    // runs the capture session, returns the number of failed frames
+int cook_assets(LPSTR lpCmdLine);    // "-cook" mode, returns the number of files that failed
+void report_bench(const char* pLine);    // where the bench modes send their report lines
+int build_bank(void);    // "-bank" mode, returns the number of effects that failed
+bool cook_texture(LPCWSTR pFile, char* pCooked, size_t nCooked);    // loader cook function, backed by the asset cache
+void reload_assets(void);    // swaps in watched assets that changed on disk
+void load_scene(int scene);    // queues the textures the scene draws first
+bool wait_sound(DWORD dwTimeout);    // true once FMOD is open
+void audio_stats(char* pText);    // one line of audio telemetry for the profile overlay
 
 void init_game(void);
 void do_game_logic(void);
@@ -80,7 +201,7 @@ using namespace std;
 enum { MOVE_UP, MOVE_DOWN, MOVE_LEFT, MOVE_RIGHT };
 
 
-//⺻ Ŭ 
+//기본 클래스 
 class entity {
 
 public:
@@ -88,6 +209,7 @@ public:
 	float y_pos;
 	int status;
 	int HP;
+	int anim;	// animation player slot
 
 };
 
@@ -104,7 +226,7 @@ bool sphere_collision_check(float x0, float y0, float size0, float x1, float y1,
 
 
 
-//ΰ Ŭ 
+//주인공 클래스 
 class Hero :public entity {
 
 public:
@@ -150,7 +272,7 @@ void Hero::move(int i)
 bool Hero::check_collision(float x, float y)
 {
 
-	//浹 ó  
+	//충돌 처리 시 
 	if (sphere_collision_check(x_pos, y_pos, 32, x, y, 32) == true)
 	{
 		return true;
@@ -163,7 +285,7 @@ bool Hero::check_collision(float x, float y)
 
 
 
-//  Ŭ 
+// 적 클래스 
 class Enemy :public entity {
 
 public:
@@ -178,7 +300,7 @@ void Enemy::init(float x, float y)
 
 	x_pos = x;
 	y_pos = y;
-	flag_explosion = false;
+	Anim_Restart(anim);
 }
 
 
@@ -190,7 +312,7 @@ void Enemy::move()
 
 void Enemy::fire()
 {
-	flag_explosion = true;
+	Particle_Emit(EMIT_EXPLOSION, x_pos, y_pos);
 }
 
 
@@ -198,7 +320,7 @@ void Enemy::fire()
 
 
 
-// Ѿ Ŭ 
+// 총알 클래스 
 class Bullet :public entity {
 
 public:
@@ -219,7 +341,7 @@ public:
 bool Bullet::check_collision(float x, float y)
 {
 
-	//浹 ó  
+	//충돌 처리 시 
 	if (sphere_collision_check(x_pos, y_pos, 32, x, y, 32) == true)
 	{
 		t_score = t_score + 10;
@@ -253,6 +375,7 @@ bool Bullet::show()
 void Bullet::active()
 {
 	bShow = true;
+	Anim_Restart(anim);
 
 }
 
@@ -270,13 +393,75 @@ void Bullet::hide()
 
 
 
-//ü  
+//객체 생성 
 Hero hero;
 Enemy enemy[ENEMY_NUM];
 Bullet bullet[BULLET_NUM];
 Bullet skill;
 CSound sound;
+int hero_attack_anim;
 
+//화면에 보이는 객체 목록
+int visible_enemy[ENEMY_NUM];
+int visible_bullet[BULLET_NUM];
+int visible_particle[PARTICLE_NUM];
+
+
+// opening FMOD takes as long as creating the device, so it runs next to startup
+DWORD WINAPI sound_thread_proc(LPVOID lpParam)
+{
+	Trace_SetThreadName("sound");
+	int span = Trace_Begin("sound init");
+	if (sound.Init(32))
+	{
+		string music[BGM_NUM] = { music_files[BGM_GAMEPLAY] };
+		sound.CreateBGsound(BGM_NUM, music);
+
+		// hits outrank shots, and a hero hit is heard once
+		string effects[EFF_NUM] = { effect_files[EFF_SHURIKEN], effect_files[EFF_BOMB], effect_files[EFF_WHIP] };
+		sound.CreateEFFsound(EFF_NUM, effects);
+		sound.SetEFFLimit(EFF_SHURIKEN, 0, 4, 0.03f);
+		sound.SetEFFLimit(EFF_BOMB, 1, 6, 0.0f);
+		sound.SetEFFLimit(EFF_WHIP, 2, 1, 0.0f);
+
+		// effects are heard from where they happen, around the middle of the screen
+		SPATIALLISTENER listener = { SCREEN_WIDTH * 0.5f, SCREEN_HEIGHT * 0.5f, SCREEN_WIDTH * 0.5f, SCREEN_WIDTH * 0.5f, 1.0f };
+		Spatial_SetListener(listener);
+	}
+	Trace_End(span);
+
+	return 0;
+}
+
+bool wait_sound(DWORD dwTimeout)
+{
+	if (sound_thread == NULL)
+		return true;
+
+	if (WaitForSingleObject(sound_thread, dwTimeout) != WAIT_OBJECT_0)
+		return false;
+
+	CloseHandle(sound_thread);
+	sound_thread = NULL;
+
+	return true;
+}
+
+// the software mixer's telemetry while it runs, FMOD's otherwise
+void audio_stats(char* pText)
+{
+	MIXERSTATS mix = Mixer_GetStats();
+	SOUNDSTATS fmod;
+
+	if (mix.nFrames > 0)
+		sprintf(pText, "audio mix %.2f ms (max %.2f) / fill %d ms / %d underruns / trigger p99 %.0f ms",
+			mix.fLastMixTime, mix.fMaxMixTime, mix.nFill * 1000 / MIXER_RATE, mix.nUnderruns,
+			Mixer_Percentile(mix.latency, 0.99f));
+	else if (wait_sound(0) && sound.GetStats(&fmod))
+		sprintf(pText, "audio cpu %.1f%% / buffer %.0f ms / %d effects", fmod.fCPU, fmod.fBufferTime, fmod.nEffects);
+	else
+		sprintf(pText, "audio off");
+}
 
 
 // the entry point for any Windows program
@@ -288,6 +473,10 @@ int WINAPI WinMain(HINSTANCE hInstance,
 	HWND hWnd;
 	WNDCLASSEX wc;
 
+	start_time = timeGetTime();
+	Trace_Init();
+	Trace_SetThreadName("main");
+
 	ZeroMemory(&wc, sizeof(WNDCLASSEX));
 
 	wc.cbSize = sizeof(WNDCLASSEX);
@@ -297,15 +486,42 @@ int WINAPI WinMain(HINSTANCE hInstance,
 	wc.hCursor = LoadCursor(NULL, IDC_ARROW);
 	wc.lpszClassName = L"WindowClass";
 
+	capture_mode = strstr(lpCmdLine, "-capture") != NULL;
+	trace_mode = strstr(lpCmdLine, "-trace") != NULL;
+
+	// cooking needs no window or device
+	if (strstr(lpCmdLine, "-cook") != NULL)
+		return cook_assets(lpCmdLine);
+	if (strstr(lpCmdLine, "-mixbench") != NULL)
+		return MixBench_Run(report_bench);
+	if (strstr(lpCmdLine, "-particlebench") != NULL)
+		return ParticleBench_Run(report_bench);
+	if (strstr(lpCmdLine, "-bcbench") != NULL)
+		return BlockBench_Run(report_bench);
+	if (strstr(lpCmdLine, "-bank") != NULL)
+		return build_bank();
+
+	// the capture session draws on the CPU, so it needs no window or device
+	// either; -replay draws the packets it recorded again the portable way
+	if (capture_mode)
+		return run_capture();
+	if (strstr(lpCmdLine, "-replay") != NULL)
+		return Capture_Replay("capture\\out\\packets.bin", sprite_files, TEX_NUM, sprite_settings.colorKey,
+			"capture\\replay", "capture\\golden", CAPTURE_TOLERANCE, CAPTURE_MISMATCH, 4);
+
+	// nothing before gameplay makes a sound
+	sound_thread = CreateThread(NULL, 0, sound_thread_proc, NULL, 0, NULL);
+
+	int span = Trace_Begin("window");
 	RegisterClassEx(&wc);
 
 	hWnd = CreateWindowEx(NULL, L"WindowClass", L"ninja flight",
 		WS_EX_TOPMOST | WS_POPUP, 0, 0, SCREEN_WIDTH, SCREEN_HEIGHT,
 		NULL, NULL, hInstance, NULL);
 
-	ShowWindow(hWnd, nCmdShow);
-
 	// set up and initialize Direct3D
+	ShowWindow(hWnd, nCmdShow);
+	Trace_End(span);
 	initD3D(hWnd);
 
 	// enter the main loop:
@@ -320,7 +536,8 @@ int WINAPI WinMain(HINSTANCE hInstance,
 		while (TRUE)
 		{
 			DWORD starting_point = GetTickCount();
-			sound.Update();
+			if (wait_sound(0))
+				sound.Update();
 
 			if (PeekMessage(&msg, NULL, 0, 0, PM_REMOVE))
 			{
@@ -331,6 +548,9 @@ int WINAPI WinMain(HINSTANCE hInstance,
 				DispatchMessage(&msg);
 			}
 
+			reload_assets();
+			Loader_Poll();
+			Res_Update();
 			render_frame1();
 
 			// check the 'escape' key
@@ -343,9 +563,14 @@ int WINAPI WinMain(HINSTANCE hInstance,
 	}
 	case 2:
 	{
+		Loader_WaitGroup(SCENE_GAMEPLAY);
+		load_scene(SCENE_GAMEOVER);
 		init_game();
 
-		sound.PlaySoundBG(1);
+		wait_sound(INFINITE);
+		sound.PlaySoundBG(BGM_GAMEPLAY);
+
+		start_render_thread();
 
 
 		while (TRUE)
@@ -363,9 +588,10 @@ int WINAPI WinMain(HINSTANCE hInstance,
 				DispatchMessage(&msg);
 			}
 
+			reload_assets();
 			do_game_logic();
 
-			render_frame();
+			build_frame();
 
 			// check the 'escape' key
 			if (hero.HP == 0)
@@ -380,7 +606,9 @@ int WINAPI WinMain(HINSTANCE hInstance,
 			playtime += (endtime - starttime);
 		}
 
-		sound.StopSoundBG(1);
+		stop_render_thread();
+
+		sound.StopSoundBG(BGM_GAMEPLAY);
 	}
 	case 3:
 	{
@@ -461,127 +689,60 @@ void initD3D(HWND hWnd)
 
 
 	// create a device class using this information and the info from the d3dpp stuct
+	int span = Trace_Begin("device");
 	d3d->CreateDevice(D3DADAPTER_DEFAULT,
 		D3DDEVTYPE_HAL,
 		hWnd,
-		D3DCREATE_SOFTWARE_VERTEXPROCESSING,
+		D3DCREATE_SOFTWARE_VERTEXPROCESSING | D3DCREATE_MULTITHREADED,    // the loader creates textures from its threads
 		&d3dpp,
 		&d3ddev);
+	Trace_End(span);
 
-	////ʱȭ ϴ  ̷Ʈ  ü Ѵ.
+	////초기화 하는 곳에서 다이렉트 사운드 객체를 생성한다.
 	//CreateDirectSound(hWnd);
-	////׸, wav εϿ, ۸ Ѵ.
+	////그리고, wav파일을 로드하여, 보조버퍼를 생성한다.
 	//LoadWave( L"sound\\Naruto_bgm.mp3", &g_lpDSBG[0]);
 
+	span = Trace_Begin("sprite and background");
 	D3DXCreateSprite(d3ddev, &d3dspt);    // create the Direct3D Sprite object
 
-	D3DXCreateTextureFromFileEx(d3ddev,    // the device pointer
-		L"img\\nightskycut.png",    // the file name
-		800,    // default width
-		560,    // default height
-		D3DX_DEFAULT,    // no mip mapping
-		NULL,    // regular usage
-		D3DFMT_A8R8G8B8,    // 32-bit pixels with alpha
-		D3DPOOL_MANAGED,    // typical memory handling
-		D3DX_DEFAULT,    // no filtering
-		D3DX_DEFAULT,    // no mip filtering
-		D3DCOLOR_XRGB(255, 0, 255),    // the hot-pink color key
-		NULL,    // no image info struct
-		NULL,    // not using 256 colors
-		&sprite);    // load to sprite
-
-
-	D3DXCreateTextureFromFileEx(d3ddev,    // the device pointer
-		L"img\\sasuke(w).png",    // the file name
-		704,    // default width
-		64,    // default height
-		D3DX_DEFAULT,    // no mip mapping
-		NULL,    // regular usage
-		D3DFMT_A8R8G8B8,    // 32-bit pixels with alpha
-		D3DPOOL_MANAGED,    // typical memory handling
-		D3DX_DEFAULT,    // no filtering
-		D3DX_DEFAULT,    // no mip filtering
-		D3DCOLOR_XRGB(255, 0, 255),    // the hot-pink color key
-		NULL,    // no image info struct
-		NULL,    // not using 256 colors
-		&sprite_hero);    // load to sprite
-
-	D3DXCreateTextureFromFileEx(d3ddev,    // the device pointer
-		L"img\\attack(w).png",    // the file name
-		256,    // default width
-		64,    // default height
-		D3DX_DEFAULT,    // no mip mapping
-		NULL,    // regular usage
-		D3DFMT_A8R8G8B8,    // 32-bit pixels with alpha
-		D3DPOOL_MANAGED,    // typical memory handling
-		D3DX_DEFAULT,    // no filtering
-		D3DX_DEFAULT,    // no mip filtering
-		D3DCOLOR_XRGB(255, 0, 255),    // the hot-pink color key
-		NULL,    // no image info struct
-		NULL,    // not using 256 colors
-		&sprite_hero1);    // load to sprite
-
-	D3DXCreateTextureFromFileEx(d3ddev,    // the device pointer
-		L"img\\enemy_1.png",    // the file name
-		1152,    // default width
-		64,    // default height
-		D3DX_DEFAULT,    // no mip mapping
-		NULL,    // regular usage
-		D3DFMT_A8R8G8B8,    // 32-bit pixels with alpha
-		D3DPOOL_MANAGED,    // typical memory handling
-		D3DX_DEFAULT,    // no filtering
-		D3DX_DEFAULT,    // no mip filtering
-		D3DCOLOR_XRGB(255, 0, 255),    // the hot-pink color key
-		NULL,    // no image info struct
-		NULL,    // not using 256 colors
-		&sprite_enemy);    // load to sprite
-
-
-	D3DXCreateTextureFromFileEx(d3ddev,    // the device pointer
-		L"img\\weapon.png",    // the file name
-		192,    // default width
-		64,    // default height
-		D3DX_DEFAULT,    // no mip mapping
-		NULL,    // regular usage
-		D3DFMT_A8R8G8B8,    // 32-bit pixels with alpha
-		D3DPOOL_MANAGED,    // typical memory handling
-		D3DX_DEFAULT,    // no filtering
-		D3DX_DEFAULT,    // no mip filtering
-		D3DCOLOR_XRGB(255, 0, 255),    // the hot-pink color key
-		NULL,    // no image info struct
-		NULL,    // not using 256 colors
-		&sprite_bullet);    // load to sprite
-
-	D3DXCreateTextureFromFileEx(d3ddev,    // the device pointer
-		L"img\\explosion.png",    // the file name
-		480,    // default width
-		80,    // default height
-		D3DX_DEFAULT,    // no mip mapping
-		NULL,    // regular usage
-		D3DFMT_A8R8G8B8,    // 32-bit pixels with alpha
-		D3DPOOL_MANAGED,    // typical memory handling
-		D3DX_DEFAULT,    // no filtering
-		D3DX_DEFAULT,    // no mip filtering
-		D3DCOLOR_XRGB(255, 0, 255),    // the hot-pink color key
-		NULL,    // no image info struct
-		NULL,    // not using 256 colors
-		&sprite_explosion);    // load to sprite
-
-	D3DXCreateTextureFromFileEx(d3ddev,    // the device pointer
-		L"img\\skill.png",    // the file name
-		300,    // default width
-		100,    // default height
-		D3DX_DEFAULT,    // no mip mapping
-		NULL,    // regular usage
-		D3DFMT_A8R8G8B8,    // 32-bit pixels with alpha
-		D3DPOOL_MANAGED,    // typical memory handling
-		D3DX_DEFAULT,    // no filtering
-		D3DX_DEFAULT,    // no mip filtering
-		D3DCOLOR_XRGB(255, 0, 255),    // the hot-pink color key
-		NULL,    // no image info struct
-		NULL,    // not using 256 colors
-		&sprite_skill);    // load to sprite
-
+	Background_Init(d3ddev);    // img\nightskycut.png is cut into tiles on first draw, then streamed in
+	Trace_End(span);
+
+	// sprites come cooked from the asset cache, which re-cooks only changed content;
+	// registering reads no files, the watcher hashes them on its own thread
+	span = Trace_Begin("asset cache");
+	AssetCache_Init("cache");
+	for (int i = 0; i < (int)(sizeof(sprite_files) / sizeof(sprite_files[0])); i++)
+		AssetCache_Register(sprite_files[i], ASSET_TEXTURE, &sprite_settings);
+	for (int i = 0; i < (int)(sizeof(sound_files) / sizeof(sound_files[0])); i++)
+		AssetCache_Register(sound_files[i], ASSET_RAW, NULL);
+#ifdef _DEBUG
+	AssetCache_Watch("img");
+	AssetCache_Watch("sound");
+#endif
+	Trace_End(span);
+
+	// the title's textures are waited for, gameplay's are decoded in the
+	// background while the title screen runs
+	span = Trace_Begin("loader");
+	Loader_Init(d3ddev, 0, start_time);
+	Loader_SetCookFunc(cook_texture);
+	Res_Init(TEXTURE_BUDGET);
+	Res_SetCategoryName(RES_CHARACTERS, "characters");
+	Res_SetCategoryName(RES_EFFECTS, "effects");
+	load_scene(SCENE_TITLE);
+	Loader_WaitGroup(SCENE_TITLE);
+	load_scene(SCENE_GAMEPLAY);
+	Trace_End(span);
+
+	span = Trace_Begin("game init");
+	Anim_Init();
+	Particle_Init(PARTICLE_NUM);
+	Cull_SetViewport(0.0f, 0.0f, (float)SCREEN_WIDTH, (float)SCREEN_HEIGHT);
+	Trace_End(span);
+
+	span = Trace_Begin("fonts");
 	D3DXCreateFont(d3ddev,    // the D3D Device
 		20,    // font height of 30
 		0,    // default font width
@@ -607,31 +768,60 @@ void initD3D(HWND hWnd)
 		DEFAULT_PITCH | FF_DONTCARE,    // default pitch and family
 		L"Arial",    // use Facename Arial
 		&dxfont1);    // the font object
+	Trace_End(span);
 
 
 	return;
 }
 
 
+//load_scene() : queues every texture the scene draws first, in its loader group
+void load_scene(int scene)
+{
+	for (int i = 0; i < (int)(sizeof(scene_textures) / sizeof(scene_textures[0])); i++)
+	{
+		const SCENETEXTURE& texture = scene_textures[i];
+		if (texture.scene != scene || Res_IsValid(*texture.pHandle))
+			continue;
+
+		*texture.pHandle = Res_AcquireTexture(texture.file, texture.width, texture.height, D3DFMT_A8R8G8B8,
+			D3DCOLOR_XRGB(255, 0, 255), texture.category, scene);
+	}
+}
+
+
 void init_game(void)
 {
-	//ü ʱȭ 
+	//애니메이션 슬롯 할당
+	Anim_Reset();
+	hero.anim = Anim_Create(CLIP_HERO_IDLE);
+	hero_attack_anim = Anim_Create(CLIP_HERO_ATTACK);
+	Anim_Stop(hero_attack_anim);
+	skill.anim = Anim_Create(CLIP_SKILL);
+	for (int i = 0; i < ENEMY_NUM; i++)
+		enemy[i].anim = Anim_Create(CLIP_ENEMY);
+	for (int i = 0; i < BULLET_NUM; i++)
+		bullet[i].anim = Anim_Create(CLIP_BULLET);
+
+	Particle_Clear();
+
+	//객체 초기화 
 	hero.init(50, 250);
 	hero.HP = 4;
 
-	// ʱȭ 
+	//적들 초기화 
 	for (int i = 0; i<ENEMY_NUM; i++)
 	{
 		enemy[i].init((float)(rand() % 300 + 700), rand() % 430 + 60);
 	}
 
-	//Ѿ ʱȭ
+	//총알 초기화
 	for (int i = 0; i < BULLET_NUM; i++)
 	{
 		bullet[i].init(hero.x_pos + 0.5f, hero.y_pos);
 	}
 
-	//ų ʱȭ
+	//스킬 초기화
 	skill.init(hero.x_pos + 0.5f, hero.y_pos);
 
 
@@ -644,7 +834,7 @@ void init_game(void)
 
 void do_game_logic(void)
 {
-	//ΰ ó 
+	//주인공 처리 
 	if (KEY_DOWN(VK_UP))
 		hero.move(MOVE_UP);
 
@@ -662,13 +852,18 @@ void do_game_logic(void)
 		if (hero.check_collision(enemy[i].x_pos, enemy[i].y_pos) == true)
 		{
 			hero.HP--;
-			//sound.PlaySoundEFF(3);
+			sound.PlaySoundEFF(EFF_WHIP, hero.x_pos, hero.y_pos);
+			Particle_Emit(EMIT_HERO_HIT, hero.x_pos, hero.y_pos);
+			enemy[i].fire();
 			hero.init(50, 250);
 			enemy[i].init((float)(rand() % 300 + 700), rand() % 430 + 60);
 		}
 	}
 
-	// ó 
+	//배경 스크롤
+	Background_Scroll(1 * t);
+
+	//적들 처리 
 	for (int i = 0; i < ENEMY_NUM; i++)
 	{
 		if (enemy[i].x_pos < 0)
@@ -678,7 +873,7 @@ void do_game_logic(void)
 	}
 
 
-	//Ѿ ó
+	//총알 처리
 
 	if (KEY_DOWN(VK_LSHIFT))
 	{
@@ -701,6 +896,7 @@ void do_game_logic(void)
 		{
 			if (skill.check_collision(enemy[i].x_pos, enemy[i].y_pos) == true)
 			{
+				enemy[i].fire();
 				enemy[i].init((float)(rand() % 300 + 700), rand() % 430 + 60);
 			}
 		}
@@ -714,7 +910,7 @@ void do_game_logic(void)
 			{
 				if (bullet[i].show() == false)
 				{
-					//sound.PlaySoundEFF(1);
+					sound.PlaySoundEFF(EFF_SHURIKEN, hero.x_pos, hero.y_pos);
 					bullet[i].active();
 					bullet[i].init(hero.x_pos + 0.5f, hero.y_pos);
 					break;
@@ -744,7 +940,8 @@ void do_game_logic(void)
 			{
 				if (bullet[i].check_collision(enemy[j].x_pos, enemy[j].y_pos) == true)
 				{
-					//sound.PlaySoundEFF(2);
+					sound.PlaySoundEFF(EFF_BOMB, enemy[j].x_pos, enemy[j].y_pos);
+					enemy[j].fire();
 					enemy[j].init((float)(rand() % 300 + 700), rand() % 430 + 60);
 					bullet[i].hide();
 				}
@@ -752,67 +949,76 @@ void do_game_logic(void)
 		}
 	}
 
-
+	//파티클 처리
+	Particle_Update(elapsed);
 }
 	
 
 
-// this is the function used to render a single frame
-void render_frame(void)
+// this is the function that builds the frame packet of the gameplay scene
+// everything the render thread needs is copied into the packet, so the
+// game state can keep changing while the frame is being drawn
+void build_frame(void)
 {
-	t = (timeGetTime() - dwOldTime) *.05f;
-	dwOldTime = timeGetTime();
+	DWORD dwNowTime = game_time();
+	t = (dwNowTime - dwOldTime) *.05f;
+	elapsed = (dwNowTime - dwOldTime) * .001f;
+	Anim_Update(elapsed);
+	dwOldTime = dwNowTime;
+
+	FRAMEPACKET* pPacket = Packet_BeginWrite();
+	pPacket->cameraX = Background_GetScroll();
+	pPacket->bgColor = D3DCOLOR_ARGB(255, 255, 255, 255);
+
+
+	// build the visible sets before any sprite is submitted
+	static const CULLRECT bounds64 = { 0.0f, 0.0f, 64.0f, 64.0f };
+	static const CULLRECT bounds_e = { -8.0f, -8.0f, 72.0f, 72.0f };
+	static const CULLRECT bounds_s = { 0.0f, -20.0f, 300.0f, 80.0f };
+
+	Cull_BeginFrame();
+	int nVisibleEnemy = Cull_Build(visible_enemy, &enemy[0].x_pos, &enemy[0].y_pos, NULL,
+		sizeof(Enemy), ENEMY_NUM, bounds64);
+	int nVisibleBullet = Cull_Build(visible_bullet, &bullet[0].x_pos, &bullet[0].y_pos, &bullet[0].bShow,
+		sizeof(Bullet), BULLET_NUM, bounds64);
+	int nVisibleParticle = Cull_Build(visible_particle, Particle_GetX(), Particle_GetY(), NULL,
+		sizeof(float), Particle_Count(), bounds_e);
+	int visible_skill;
+	int nVisibleSkill = Cull_Build(&visible_skill, &skill.x_pos, &skill.y_pos, &skill.bShow,
+		sizeof(Bullet), 1, bounds_s);
 
-	// clear the window to a deep blue
-	d3ddev->Clear(0, NULL, D3DCLEAR_TARGET, D3DCOLOR_XRGB(0, 0, 0), 1.0f, 0);
-
-	d3ddev->BeginScene();    // begins the 3D scene
-
-
-
-	// create a RECT to contain the text
-	static RECT textbox;
-
-	SetRect(&textbox, 10, 20, 0, 0);
 
 	sprintf( str, "Total Score : %d   Total time : %3.3f", t_score, (playtime/1000));
+	Packet_AddText(pPacket, FONT_SMALL, 10, 20, D3DCOLOR_ARGB(255, 255, 255, 255), str);
 
-	dxfont->DrawTextA(NULL, str, -1, &textbox, DT_NOCLIP, D3DXCOLOR(255.0f, 255.0f, 255.0f, 255.0f));
+#ifdef PROFILE
+	sprintf(str, "sprites drawn %d / culled %d", Cull_GetStats().nDrawn, Cull_GetStats().nCulled);
+	Packet_AddText(pPacket, FONT_SMALL, 560, 20, D3DCOLOR_ARGB(255, 255, 255, 255), str);
+	audio_stats(str);
+	Packet_AddText(pPacket, FONT_SMALL, 560, 60, D3DCOLOR_ARGB(255, 255, 255, 255), str);
+#endif
 
 
-	SetRect(&textbox, 10, 560, 0, 0);
 	switch (hero.HP)
 	{
 	case 4:
-		sprintf(str, "HP     ");
+		sprintf(str, "HP ♥ ♥ ♥ ♥ ♥");
 		break;
 	case 3:
-		sprintf(str, "HP    ");
+		sprintf(str, "HP ♥ ♥ ♥ ♥");
 		break;
 	case 2:
-		sprintf(str, "HP   ");
+		sprintf(str, "HP ♥ ♥ ♥");
 		break;
 	case 1:
-		sprintf(str, "HP  ");
+		sprintf(str, "HP ♥ ♥");
 		break;
 	case 0:
-		sprintf(str, "HP ");
+		sprintf(str, "HP ♥");
 		break;
 	}
 
-	dxfont->DrawTextA(NULL, str, -1, &textbox, DT_NOCLIP, D3DXCOLOR(255.0f, 255.0f, 255.0f, 255.0f));
-
-
-
-	d3dspt->Begin(D3DXSPRITE_ALPHABLEND);    
-
-
-	//BACKGROUND
-	RECT part0;
-	SetRect(&part0, 0, 50, 800, 550);
-	D3DXVECTOR3 center0(0.0f, 0.0f, 0.0f);    // center at the upper-left corner
-	D3DXVECTOR3 position0(0.0f, 50.0f, 0.0f);    // position at 50, 50 with no depth
-	d3dspt->Draw(sprite, &part0, &center0, &position0, D3DCOLOR_ARGB(255, 255, 255, 255));
+	Packet_AddText(pPacket, FONT_SMALL, 10, 560, D3DCOLOR_ARGB(255, 255, 255, 255), str);
 
 
 	if (KEY_DOWN(VK_SPACE))
@@ -825,108 +1031,108 @@ void render_frame(void)
 	if (KEY_UP(VK_LSHIFT))
 		flag_hero = false;
 
-	switch (flag_hero)
-	{
-	case false:
-	{
-		////ΰ 
-		static double frame = 10.0;
-		if (frame == 10.0) frame = 0.0;
-		if (frame < 10.0) frame = frame + 0.5;
-
-		int xpos = (int)frame * 64;
-
-		RECT part;
-		SetRect(&part, xpos, 0, xpos + 64, 64);
-		D3DXVECTOR3 center(0.0f, 0.0f, 0.0f);    // center at the upper-left corner
-		D3DXVECTOR3 position(hero.x_pos, hero.y_pos, 0.0f);    // position at 50, 50 with no depth
-		d3dspt->Draw(sprite_hero, &part, &center, &position, D3DCOLOR_ARGB(255, 255, 255, 255));
-	}
-	case true:
+	////주인공
+	if (flag_hero == false)
+		Packet_AddSprite(pPacket, TEX_HERO, Anim_GetRect(hero.anim), 0.0f, 0.0f,
+			hero.x_pos, hero.y_pos, D3DCOLOR_ARGB(255, 255, 255, 255));
+
+	////주인공 공격시
+	if (KEY_DOWN(VK_SPACE) || KEY_DOWN(VK_LSHIFT))
+		Anim_Restart(hero_attack_anim);
+	if (Anim_IsDone(hero_attack_anim) == false)
+		Packet_AddSprite(pPacket, TEX_HERO_ATTACK, Anim_GetRect(hero_attack_anim), 0.0f, 0.0f,
+			hero.x_pos, hero.y_pos, D3DCOLOR_ARGB(255, 255, 255, 255));
+
+	////총알
+	for (int n = 0; n < nVisibleBullet; n++)
 	{
-		////ΰ ݽ
-		static double frame_a = 5.0;
-		if (KEY_DOWN(VK_SPACE)) frame_a = 0.0;
-		if (KEY_DOWN(VK_LSHIFT)) frame_a = 0.0;
-		if (frame_a < 5.0) frame_a = frame_a + 0.5;
-
-		int xpos_a = (int)frame_a * 64;
-
-		RECT part_a;
-		SetRect(&part_a, xpos_a, 0, xpos_a + 64, 64);
-		D3DXVECTOR3 center_a(0.0f, 0.0f, 0.0f);    // center at the upper-left corner
-		D3DXVECTOR3 position_a(hero.x_pos, hero.y_pos, 0.0f);    // position at 50, 50 with no depth
-		d3dspt->Draw(sprite_hero1, &part_a, &center_a, &position_a, D3DCOLOR_ARGB(255, 255, 255, 255));
-	}
+		int i = visible_bullet[n];
+		Packet_AddSprite(pPacket, TEX_BULLET, Anim_GetRect(bullet[i].anim), 0.0f, 0.0f,
+			bullet[i].x_pos, bullet[i].y_pos, D3DCOLOR_ARGB(255, 255, 255, 255));
 	}
 
-	////Ѿ 
-	for (int i = 0; i < BULLET_NUM; i++)
-	{
-		if (bullet[i].bShow == true)
-		{
-			static double frame1 = 2.0;
-			if (frame1 == 2.0) frame1 = 0.0;
-			if (frame1 < 2.0) frame1 = frame1 + 0.5;
+	if (nVisibleSkill > 0)
+		Packet_AddSprite(pPacket, TEX_SKILL, Anim_GetRect(skill.anim), 0.0f, 20.0f,
+			skill.x_pos, skill.y_pos, D3DCOLOR_ARGB(255, 255, 255, 255));
 
-			int xpos1 = (int)frame1 * 64;
 
-			RECT part1;
-			SetRect(&part1, xpos1, 0, xpos1 + 64, 64);
-			D3DXVECTOR3 center1(0.0f, 0.0f, 0.0f);    // center at the upper-left corner
-			D3DXVECTOR3 position1(bullet[i].x_pos, bullet[i].y_pos, 0.0f);    // position at 50, 50 with no depth
-			d3dspt->Draw(sprite_bullet, &part1, &center1, &position1, D3DCOLOR_ARGB(255, 255, 255, 255));
-		}
+	////enemy
+	for (int n = 0; n < nVisibleEnemy; n++)
+	{
+		int i = visible_enemy[n];
+		Packet_AddSprite(pPacket, TEX_ENEMY, Anim_GetRect(enemy[i].anim), 0.0f, 0.0f,
+			enemy[i].x_pos, enemy[i].y_pos, D3DCOLOR_ARGB(255, 255, 255, 255));
 	}
 
-	if (skill.bShow == true)
+	////explosion particles, the sheet frame follows each particle's age
+	const float* particle_x = Particle_GetX();
+	const float* particle_y = Particle_GetY();
+	int nExplosionFrames = Anim_GetClipFrames(CLIP_EXPLOSION);
+
+	for (int n = 0; n < nVisibleParticle; n++)
 	{
-		RECT part_s;
-		SetRect(&part_s, 0, 0, 300, 100);
-		D3DXVECTOR3 center_s(0.0f, 20.0f, 0.0f);    // center at the upper-left corner
-		D3DXVECTOR3 position_s(skill.x_pos, skill.y_pos, 0.0f);    // position at 50, 50 with no depth
-		d3dspt->Draw(sprite_skill, &part_s, &center_s, &position_s, D3DCOLOR_ARGB(255, 255, 255, 255));
+		int i = visible_particle[n];
+		int frame = (int)(Particle_GetAge(i) * (nExplosionFrames - 1) + 0.5f);
+		Packet_AddSprite(pPacket, TEX_EXPLOSION, Anim_GetClipRect(CLIP_EXPLOSION, frame), 8.0f, 8.0f,
+			particle_x[i], particle_y[i], D3DCOLOR_ARGB(127, 255, 255, 255));
 	}
 
+	Packet_Publish();
+	if (render_event != NULL)
+		SetEvent(render_event);
 
-	////enemy
-	static double frame2 = 17.0;
-	if (frame2 == 17.0) frame2 = 0.0;
-	if (frame2 < 17.0) frame2 = frame2 + 0.5;
+	return;
+}
 
-	int xpos2 = (int)frame2 * 64;
 
-	RECT part2;
-	SetRect(&part2, xpos2, 0, xpos2 + 64, 64);
-	D3DXVECTOR3 center2(0.0f, 0.0f, 0.0f);    // center at the upper-left corner
+// this is the function used to render a single frame, runs on the render thread
+void render_frame(const FRAMEPACKET* pPacket)
+{
+	LPDIRECT3DTEXTURE9 textures[TEX_NUM] = { Res_GetTexture(sprite_hero), Res_GetTexture(sprite_hero1), Res_GetTexture(sprite_enemy),
+		Res_GetTexture(sprite_bullet), Res_GetTexture(sprite_explosion), Res_GetTexture(sprite_skill) };
+	LPD3DXFONT fonts[2] = { dxfont, dxfont1 };
 
-	for (int i = 0; i<ENEMY_NUM; i++)
+	// clear the window to a deep blue
+	d3ddev->Clear(0, NULL, D3DCLEAR_TARGET, D3DCOLOR_XRGB(0, 0, 0), 1.0f, 0);
+
+	d3ddev->BeginScene();    // begins the 3D scene
+
+	// create a RECT to contain the text
+	RECT textbox;
+
+	for (int i = 0; i < pPacket->nTexts; i++)
 	{
+		const TEXTINSTANCE& text = pPacket->texts[i];
 
-		D3DXVECTOR3 position2(enemy[i].x_pos, enemy[i].y_pos, 0.0f);    // position at 50, 50 with no depth
-		d3dspt->Draw(sprite_enemy, &part2, &center2, &position2, D3DCOLOR_ARGB(255, 255, 255, 255));
+		SetRect(&textbox, text.x, text.y, 0, 0);
+		fonts[text.font]->DrawTextA(NULL, text.text, -1, &textbox, DT_NOCLIP, text.color);
 	}
 
-	if (flag_explosion == true)
-	{
-		static double frame2_e = 5.0;
-		if (frame2_e == 5.0) frame2_e = 0.0;
-		if (frame2_e < 5.0) frame2_e = frame2_e + 0.5;
+#ifdef PROFILE
+	PACKETSTATS stats = Packet_GetStats();
+	char latency[PACKET_TEXT_LEN];
 
-		int xpos2_e = (int)frame2_e * 80;
+	SetRect(&textbox, 560, 40, 0, 0);
+	sprintf(latency, "latency %.1f ms (max %.1f) / dropped %u", stats.fAvgLatency, stats.fMaxLatency, stats.nDropped);
+	dxfont->DrawTextA(NULL, latency, -1, &textbox, DT_NOCLIP, D3DCOLOR_ARGB(255, 255, 255, 255));
+#endif
 
-		RECT part2_e;
-		SetRect(&part2_e, xpos2_e, 0, xpos2_e + 80, 80);
-		D3DXVECTOR3 center2_e(8.0f, 8.0f, 0.0f);    // center at the upper-left corner
 
-		for (int i = 0; i < ENEMY_NUM; i++)
-		{
+	d3dspt->Begin(D3DXSPRITE_ALPHABLEND);
 
-			D3DXVECTOR3 position2_e(enemy[i].x_pos, enemy[i].y_pos, 0.0f);    // position at 50, 50 with no depth
-			d3dspt->Draw(sprite_explosion, &part2_e, &center2_e, &position2_e, D3DCOLOR_ARGB(127, 255, 255, 255));
-		}
+
+	//BACKGROUND
+	Background_Draw(d3dspt, pPacket->cameraX, pPacket->bgColor);
+
+	for (int i = 0; i < pPacket->nSprites; i++)
+	{
+		const SPRITEINSTANCE& sprite = pPacket->sprites[i];
+
+		D3DXVECTOR3 center(sprite.centerX, sprite.centerY, 0.0f);
+		D3DXVECTOR3 position(sprite.x, sprite.y, 0.0f);
+		d3dspt->Draw(textures[sprite.texture], &sprite.src, &center, &position, sprite.color);
 	}
-	
+
 
 	d3dspt->End();    // end sprite drawing
 
@@ -937,6 +1143,51 @@ void render_frame(void)
 	return;
 }
 
+
+// this is the render thread, it draws the newest frame packet each time the
+// game thread publishes one
+DWORD WINAPI render_thread_proc(LPVOID lpParam)
+{
+	while (render_running)
+	{
+		WaitForSingleObject(render_event, 100);
+
+		// reloaded sprites are swapped in here, between frames that use them
+		Loader_Poll();
+		Res_Update();
+
+		const FRAMEPACKET* pPacket = Packet_AcquireLatest();
+		if (pPacket == NULL)
+			continue;
+
+		render_frame(pPacket);
+		Packet_EndRead(pPacket);
+	}
+
+	return 0;
+}
+
+// the device is only used by the render thread between these two calls
+void start_render_thread(void)
+{
+	Packet_Reset();
+	render_event = CreateEvent(NULL, FALSE, FALSE, NULL);
+	InterlockedExchange(&render_running, 1);
+	render_thread = CreateThread(NULL, 0, render_thread_proc, NULL, 0, NULL);
+}
+
+void stop_render_thread(void)
+{
+	InterlockedExchange(&render_running, 0);
+	SetEvent(render_event);
+	WaitForSingleObject(render_thread, INFINITE);
+
+	CloseHandle(render_thread);
+	CloseHandle(render_event);
+	render_thread = NULL;
+	render_event = NULL;
+}
+
 void render_frame1(void)
 {
 	t = (timeGetTime() - dwOldTime) *.05f;
@@ -952,11 +1203,7 @@ void render_frame1(void)
 
 
 	//BACKGROUND
-	RECT part0;
-	SetRect(&part0, 0, 50, 800, 550);
-	D3DXVECTOR3 center0(0.0f, 0.0f, 0.0f);    // center at the upper-left corner
-	D3DXVECTOR3 position0(0.0f, 50.0f, 0.0f);    // position at 50, 50 with no depth
-	d3dspt->Draw(sprite, &part0, &center0, &position0, D3DCOLOR_ARGB(50, 255, 255, 255));
+	Background_Draw(d3dspt, Background_GetScroll(), D3DCOLOR_ARGB(50, 255, 255, 255));
 
 	static RECT textbox;
 	SetRect(&textbox, 190, 200, 0, 0);
@@ -964,15 +1211,46 @@ void render_frame1(void)
 	dxfont1->DrawTextA(NULL, str, -1, &textbox, DT_NOCLIP, D3DXCOLOR(255.0f, 255.0f, 255.0f, 255.0f));
 
 	SetRect(&textbox, 310, 350, 0, 0);
-	sprintf(str, "'Enter' ֽʽÿ.");
+	sprintf(str, "'Enter'를 눌러주십시오.");
 	dxfont->DrawTextA(NULL, str, -1, &textbox, DT_NOCLIP, D3DXCOLOR(255.0f, 255.0f, 255.0f, 255.0f));
 
+#ifdef PROFILE
+	const LOADERSTATS& load = Loader_GetStats();
+	const ASSETCACHESTATS& cache = AssetCache_GetStats();
+	const RESSTATS& res = Res_GetStats();
+	SetRect(&textbox, 10, 20, 0, 0);
+	sprintf(str, "title %.0f ms / first frame %.0f ms / textures %d of %d, %.0f ms, %u KB / cache %d hits, %d cooked", time_to_title * 1000.0f, load.fFirstFrame * 1000.0f,
+		load.nLoaded, load.nQueued, load.fAllLoaded * 1000.0f, (unsigned int)(res.nBytes >> 10), cache.nHits, cache.nCooked);
+	dxfont->DrawTextA(NULL, str, -1, &textbox, DT_NOCLIP, D3DXCOLOR(255.0f, 255.0f, 255.0f, 255.0f));
+#endif
+
 	d3dspt->End();    // end sprite drawing
 
 	d3ddev->EndScene();    // ends the 3D scene
 
 	d3ddev->Present(NULL, NULL, NULL, NULL);
 
+	if (time_to_title == 0.0f)
+	{
+		// the startup metric ends here, the title is on screen
+		Trace_Mark("title");
+		time_to_title = (float)Trace_Now();
+		Loader_FirstFrame();
+
+		char szLine[256];
+		sprintf(szLine, "startup: title after %.0f ms (device %.0f ms, loader %.0f ms, fonts %.0f ms)\n",
+			time_to_title * 1000.0f, Trace_GetDuration("device") * 1000.0f,
+			Trace_GetDuration("loader") * 1000.0f, Trace_GetDuration("fonts") * 1000.0f);
+		OutputDebugStringA(szLine);
+	}
+
+	static bool bGameplayReady = false;
+	if (!bGameplayReady && Loader_IsGroupReady(SCENE_GAMEPLAY))
+	{
+		Trace_Mark("gameplay textures loaded");
+		bGameplayReady = true;
+	}
+
 	return;
 }
 
@@ -991,11 +1269,7 @@ void render_frame2(void)
 
 
 	//BACKGROUND
-	RECT part0;
-	SetRect(&part0, 0, 50, 800, 550);
-	D3DXVECTOR3 center0(0.0f, 0.0f, 0.0f);    // center at the upper-left corner
-	D3DXVECTOR3 position0(0.0f, 50.0f, 0.0f);    // position at 50, 50 with no depth
-	d3dspt->Draw(sprite, &part0, &center0, &position0, D3DCOLOR_ARGB(50, 255, 255, 255));
+	Background_Draw(d3dspt, Background_GetScroll(), D3DCOLOR_ARGB(50, 255, 255, 255));
 
 
 	static RECT textbox;
@@ -1008,7 +1282,7 @@ void render_frame2(void)
 	dxfont->DrawTextA(NULL, str, -1, &textbox, DT_NOCLIP, D3DXCOLOR(255.0f, 255.0f, 255.0f, 255.0f));
 
 	SetRect(&textbox, 310, 320, 0, 0);
-	sprintf(str, "'ESC'  մϴ.");
+	sprintf(str, "'ESC'를 누르면 종료합니다.");
 	dxfont->DrawTextA(NULL, str, -1, &textbox, DT_NOCLIP, D3DXCOLOR(255.0f, 255.0f, 255.0f, 255.0f));
 
 
@@ -1021,19 +1295,281 @@ void render_frame2(void)
 	return;
 }
 
+// this is the function that reads the keyboard
+bool key_down(int vk_code)
+{
+	if (capture_mode)
+		return Capture_IsKeyDown(capture_script, sizeof(capture_script) / sizeof(capture_script[0]), capture_frame, vk_code);
+
+	return (GetAsyncKeyState(vk_code) & 0x8000) != 0;
+}
+
+DWORD game_time(void)
+{
+	if (capture_mode)
+		return capture_frame * CAPTURE_STEP;
+
+	return timeGetTime();
+}
+
+
+// this is the function that runs the capture session
+// the game runs on a fixed clock with scripted input and a fixed seed, and
+// every CAPTURE_INTERVAL-th frame packet is drawn on the CPU and checked
+// against capture\golden; results and the packets go to capture\out
+// the sprites are read from their files (sprite_files is in TEX_ order),
+// so the session needs no window or device
+int run_capture(void)
+{
+	IMAGE textures[TEX_NUM];
+
+	// no folders, no goldens or report to show for the session
+	if (!Capture_Begin("capture\\out", "capture\\golden", CAPTURE_TOLERANCE, CAPTURE_MISMATCH, 4))
+		return 1;
+
+	for (int i = 0; i < TEX_NUM; i++)
+		Capture_LoadTexture(sprite_files[i], sprite_settings.colorKey, &textures[i]);
+
+	Anim_Init();
+	Particle_Init(PARTICLE_NUM);
+	Cull_SetViewport(0.0f, 0.0f, (float)SCREEN_WIDTH, (float)SCREEN_HEIGHT);
+
+	srand(CAPTURE_SEED);
+	Particle_Seed(CAPTURE_SEED);
+	init_game();
+	Packet_Reset();
+
+	capture_frame = 0;
+	dwOldTime = game_time();
+	playtime = 0;
+
+	for (capture_frame = 1; capture_frame <= CAPTURE_FRAMES && hero.HP > 0; capture_frame++)
+	{
+		// scripted keys never send WM_KEYUP
+		if (KEY_UP(VK_SPACE))
+			keyup = true;
+
+		do_game_logic();
+		build_frame();
+
+		const FRAMEPACKET* pPacket = Packet_AcquireLatest();
+
+		if (capture_frame % CAPTURE_INTERVAL == 0)
+			Capture_SubmitPacket(capture_frame, pPacket, textures, TEX_NUM, SCREEN_WIDTH, SCREEN_HEIGHT);
+
+		Packet_EndRead(pPacket);
+		playtime += CAPTURE_STEP;
+	}
+
+	const CAPTURESTATS& stats = Capture_End();
+
+	for (int i = 0; i < TEX_NUM; i++)
+		Image_Free(&textures[i]);
+	Particle_Release();
+
+	return stats.nFailed;
+}
+
+
+// this is the function that cooks textures into .ctex files
+// with no file names it cooks the game sprites; otherwise the listed files
+// are cooked with the options given before them, for example
+// -cook -mips -bc ..\Textures\banana.bmp -key FF00FF -premul a.png b.png
+// -bc1 and -bc3 block compress, -bc picks one of them by the alpha channel
+int cook_assets(LPSTR lpCmdLine)
+{
+	TEXCOOKSETTINGS settings;
+	settings.bColorKey = false;
+	settings.colorKey = 0;
+	settings.bPremultiply = false;
+	settings.bMips = false;
+	settings.format = TEXCOOK_A8R8G8B8;
+
+	std::string files[64];
+	TEXCOOKSETTINGS file_settings[64];
+	int nFiles = 0;
+	char line[1024];
+	char* context = NULL;
+
+	strncpy_s(line, sizeof(line), lpCmdLine, _TRUNCATE);
+	for (char* token = strtok_s(line, " ", &context); token != NULL; token = strtok_s(NULL, " ", &context))
+	{
+		if (strcmp(token, "-key") == 0)
+		{
+			char* value = strtok_s(NULL, " ", &context);
+			settings.bColorKey = value != NULL;
+			settings.colorKey = value ? 0xff000000 | strtoul(value, NULL, 16) : 0;
+		}
+		else if (strcmp(token, "-premul") == 0)
+			settings.bPremultiply = true;
+		else if (strcmp(token, "-mips") == 0)
+			settings.bMips = true;
+		else if (strcmp(token, "-bc1") == 0)
+			settings.format = TEXCOOK_BC1;
+		else if (strcmp(token, "-bc3") == 0)
+			settings.format = TEXCOOK_BC3;
+		else if (strcmp(token, "-bc") == 0)
+			settings.format = TEXCOOK_BC;
+		else if (token[0] != '-' && nFiles < 64)
+		{
+			file_settings[nFiles] = settings;
+			files[nFiles++] = token;
+		}
+	}
+
+	if (nFiles == 0)
+	{
+		for (int i = 0; i < (int)(sizeof(sprite_files) / sizeof(sprite_files[0])); i++)
+		{
+			file_settings[nFiles] = sprite_settings;
+			files[nFiles++] = sprite_files[i];
+		}
+	}
+
+	int nFailed = 0;
+	for (int i = 0; i < nFiles; i++)
+	{
+		size_t ext = files[i].find_last_of('.');
+		if (ext == std::string::npos || ext < files[i].find_last_of('\\') + 1)
+			ext = files[i].size();
+		std::string cooked = files[i].substr(0, ext) + ".ctex";
+		TEXCOOKSTATS stats;
+		bool bOk = TexFile_Cook(files[i].c_str(), cooked.c_str(), file_settings[i], &stats);
+
+		char report[MAX_PATH * 2 + 128];
+		if (bOk && stats.format != TEXFILE_FORMAT_A8R8G8B8)
+			sprintf_s(report, sizeof(report), "cook: %s -> %s %s, psnr %.2f dB, encode %.1f MP/s, decode %.0f MP/s\n",
+				files[i].c_str(), cooked.c_str(), stats.format == TEXFILE_FORMAT_DXT1 ? "bc1" : "bc3", stats.psnr,
+				stats.fEncodeRate, stats.fDecodeRate);
+		else
+			sprintf_s(report, sizeof(report), "cook: %s -> %s %s\n", files[i].c_str(), cooked.c_str(), bOk ? "ok" : "FAILED");
+		OutputDebugStringA(report);
+
+		if (bOk == false)
+			nFailed++;
+	}
+
+	return nFailed;
+}
+
+
+// this is the function that builds the effect bank
+// FMOD decodes each effect, the bank resamples it to the mixer's rate
+int build_bank(void)
+{
+	const int nEffects = (int)(sizeof(effect_files) / sizeof(effect_files[0]));
+	vector<short> samples[sizeof(effect_files) / sizeof(effect_files[0])];
+	SOUNDBANKSOURCE sources[sizeof(effect_files) / sizeof(effect_files[0])];
+	char report[MAX_PATH + 128];
+	int nFailed = 0;
+	int nSources = 0;
+
+	if (sound.Init(1) == false)
+		return nEffects;
+
+	for (int i = 0; i < nEffects; i++)
+	{
+		SOUNDBANKSOURCE& source = sources[nSources];
+		if (sound.DecodeSound(effect_files[i], &samples[i], &source.nChannels, &source.sampleRate) == false)
+		{
+			sprintf_s(report, sizeof(report), "bank: %s FAILED\n", effect_files[i]);
+			OutputDebugStringA(report);
+			nFailed++;
+			continue;
+		}
+
+		source.pName = effect_files[i];
+		source.pSamples = &samples[i][0];
+		source.nFrames = (int)samples[i].size() / source.nChannels;
+		nSources++;
+
+		sprintf_s(report, sizeof(report), "bank: %s %d Hz %s, %.2f s\n", effect_files[i], source.sampleRate,
+			source.nChannels == 2 ? "stereo" : "mono", (float)source.nFrames / source.sampleRate);
+		OutputDebugStringA(report);
+	}
+
+	if (nSources > 0 && SoundBank_Write(EFFECT_BANK, sources, nSources) == false)
+		nFailed = nEffects;
+
+	sprintf_s(report, sizeof(report), "bank: %s, %d effects\n", EFFECT_BANK, nSources);
+	OutputDebugStringA(report);
+	sound.ReleaseSound();
+
+	return nFailed;
+}
+
+
+// this is the function that sends a line of a bench report to the debugger
+void report_bench(const char* pLine)
+{
+	OutputDebugStringA(pLine);
+}
+
+
+// this is the function that gets a cooked texture for the loader, on its threads
+bool cook_texture(LPCWSTR pFile, char* pCooked, size_t nCooked)
+{
+	char file[MAX_PATH];
+
+	if (WideCharToMultiByte(CP_ACP, 0, pFile, -1, file, MAX_PATH, NULL, NULL) == 0)
+		return false;
+
+	return AssetCache_GetCooked(AssetCache_Find(file), pCooked, nCooked);
+}
+
+
+// this is the function that reloads assets edited while the game runs
+// changed sprites are re-cooked and swapped in by the loader, sounds are
+// recreated in place
+void reload_assets(void)
+{
+	int changed[ASSETCACHE_MAX_ASSETS];
+	int nChanged = AssetCache_Poll(changed, ASSETCACHE_MAX_ASSETS);
+
+	for (int i = 0; i < nChanged; i++)
+	{
+		const char* file = AssetCache_GetSource(changed[i]);
+		WCHAR wfile[MAX_PATH];
+		char report[MAX_PATH + 32];
+
+		sprintf_s(report, sizeof(report), "reload: %s\n", file);
+		OutputDebugStringA(report);
+
+		if (AssetCache_GetType(changed[i]) == ASSET_RAW)
+		{
+			if (wait_sound(0))
+				sound.ReloadSound(file);
+		}
+		else if (MultiByteToWideChar(CP_ACP, 0, file, -1, wfile, MAX_PATH) != 0)
+			Loader_Reload(wfile);
+	}
+}
+
+
 // this is the function that cleans up Direct3D and COM
 void cleanD3D(void)
 {
-	sprite->Release();
+	Loader_Release();
+
+	//객체 해제, the device goes last
+	for (int i = 0; i < (int)(sizeof(scene_textures) / sizeof(scene_textures[0])); i++)
+		Res_Release(scene_textures[i].pHandle);
+	Res_Shutdown();    // writes leaked textures to the debug output
+
+	AssetCache_Release();
+	Background_Release();
+	Particle_Release();
+	dxfont->Release();
+	dxfont1->Release();
+	d3dspt->Release();
 	d3ddev->Release();
 	d3d->Release();
 
-	//ü  
-	sprite_hero->Release();
-	sprite_enemy->Release();
-	sprite_bullet->Release();
-
+	wait_sound(INFINITE);
 	sound.ReleaseSound();
 
+	if (trace_mode)
+		Trace_Write("startup_trace.json");
+
 	return;
 }
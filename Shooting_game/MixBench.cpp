@@ -0,0 +1,321 @@
+#include "MixBench.h"
+#include "Mixer.h"
+#include "Stream.h"
+#include "WavFile.h"
+#include "Voice.h"
+#include "SoundBank.h"
+#include "Spatial.h"
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <thread>
+
+#define MIXBENCH_SCREEN_WIDTH   800
+#define MIXBENCH_SCREEN_HEIGHT  600
+#define MIXBENCH_EMITTERS       1024
+#define MIXBENCH_EFFECTS        500
+
+static MIXBENCHREPORT g_pMixReport;
+static int g_nMixFailed;
+static char g_szMixLine[256];
+
+static void MixBench_Report(const char* pLine)
+{
+	if (g_pMixReport != NULL)
+		g_pMixReport(pLine);
+}
+
+static double MixBench_Seconds(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+//MixBench_Trigger() : plays a sound through the voice pool on the mixer, as
+//the game would; returns the pool voice, -1 when the trigger was dropped
+static int MixBench_Trigger(VOICEPOOL* pPool, const MIXERSOUND* pSound, int sound, float fVolume, float fPan, float fNow)
+{
+	VOICETRIGGER trigger = Voice_Trigger(pPool, sound, fVolume, fNow);
+	if (trigger.voice < 0)
+		return -1;
+
+	VOICE& voice = pPool->voices[trigger.voice];
+	if (trigger.bCoalesced)
+	{
+		Mixer_SetVolume(voice.handle, voice.volume);
+		return trigger.voice;
+	}
+
+	if (trigger.stolen >= 0)
+		Mixer_Stop(pPool->voices[trigger.stolen].handle);
+	voice.handle = Mixer_Play(pSound, fVolume, fPan, false);
+	return trigger.voice;
+}
+
+static void MixBench_Voices(const MIXERSOUND* pShot, const MIXERSOUND* pExplosion)
+{
+	for (int nVoices = 1; nVoices <= MIXER_MAX_VOICES; nVoices *= 2)
+	{
+		Mixer_Init(Mixer_NullOutput());
+		for (int i = 0; i < nVoices; i++)
+			Mixer_Play(i & 1 ? pExplosion : pShot, 1.0f / MIXER_MAX_VOICES, (i % 3) - 1.0f, true);
+		Mixer_Render(MIXER_RATE * 10);
+
+		MIXERSTATS stats = Mixer_GetStats();
+		sprintf(g_szMixLine, "mixbench: %2d voices %.2f ns per voice frame, %.0fx real time\n", nVoices,
+			stats.fMixTime * 1e9 / (double)stats.nVoiceFrames, 10.0 / stats.fMixTime);
+		MixBench_Report(g_szMixLine);
+		Mixer_Release();
+	}
+}
+
+//MixBench_Script() : a shot every 4th block, an explosion every 16th, panned across
+static bool MixBench_Script(const MIXERSOUND* pShot, const MIXERSOUND* pExplosion)
+{
+	MIXEROUTPUT output;
+	if (Mixer_WavOutput("mixbench.wav", &output) == false)
+		return false;
+	Mixer_Init(output);
+
+	int nMissed = 0;
+	for (int block = 0; block < 256; block++)
+	{
+		if (block % 4 == 0)
+			Mixer_Play(pShot, 0.5f, (block % 16) / 8.0f - 1.0f, false);
+		if (block % 16 == 8)
+			Mixer_Play(pExplosion, 0.8f, 0.0f, false);
+		Mixer_Render(MIXER_BLOCK_FRAMES);
+
+		if (block % 4 == 0 && Mixer_GetStats().nActive == 0)
+			nMissed++;
+	}
+
+	MIXERSTATS stats = Mixer_GetStats();
+	nMissed += stats.nVoiceDrops + stats.nCommandDrops;
+	sprintf(g_szMixLine, "mixbench: mixbench.wav, %d triggers, peak %d voices, %d missed\n",
+		stats.nPlayed, stats.nPeakActive, nMissed);
+	MixBench_Report(g_szMixLine);
+	Mixer_Release();
+
+	g_nMixFailed += nMissed;
+	return true;
+}
+
+//MixBench_Stream() : mixbench.wav (3 s) looped for four seconds of real time
+//under a shot every fourth tick of a 60 Hz game loop, their latency measured
+//to the playback clock
+static bool MixBench_Stream(const MIXERSOUND* pShot)
+{
+	STREAMDECODER decoder;
+	if (Stream_WavDecoder("mixbench.wav", &decoder) == false)
+		return false;
+	Stream_Init();
+	int music = Stream_Open(decoder, true);
+	Stream_Prefill(music);
+	Mixer_Init(Mixer_NullOutput());
+	Mixer_PlayStream(music, 1.0f);
+	Mixer_Start(true);
+	for (int i = 0; i < 250; i++)
+	{
+		if (i % 4 == 0)
+			Mixer_Play(pShot, 0.5f, 0.0f, false);
+		std::this_thread::sleep_for(std::chrono::milliseconds(16));
+	}
+	MIXERSTATS stats = Mixer_GetStats();
+	Mixer_Release();
+
+	sprintf(g_szMixLine, "mixbench: real time mix %.3f / %.3f / %.3f ms (p50 / p99 / max), fill at least %d ms, %d underruns\n",
+		Mixer_Percentile(stats.mixTime, 0.5f), Mixer_Percentile(stats.mixTime, 0.99f), stats.fMaxMixTime,
+		stats.nMinFill * 1000 / MIXER_RATE, stats.nUnderruns);
+	MixBench_Report(g_szMixLine);
+	sprintf(g_szMixLine, "mixbench: trigger to playback %.1f / %.1f / %.1f ms (p50 / p99 / max) over %d triggers\n",
+		Mixer_Percentile(stats.latency, 0.5f), Mixer_Percentile(stats.latency, 0.99f),
+		stats.latency.fMax, stats.latency.nCount);
+	MixBench_Report(g_szMixLine);
+
+	STREAMSTATS music_stats = Stream_GetStats(music);
+	sprintf(g_szMixLine, "mixbench: stream %u KB resident, full decode %u KB, %d loops, %d underruns, decode %.1f ms\n",
+		(unsigned int)(music_stats.nResidentBytes >> 10), (unsigned int)(music_stats.nTrackBytes >> 10),
+		music_stats.nLoops, music_stats.nUnderruns, music_stats.fDecodeTime * 1000.0);
+	MixBench_Report(g_szMixLine);
+	Stream_Release();
+
+	g_nMixFailed += music_stats.nUnderruns;
+	return true;
+}
+
+//MixBench_Load() : loading effects by mapping against reading a copy like LoadWave() did
+static void MixBench_Load(void)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	unsigned int nCopied = 0;
+	for (int i = 0; i < MIXBENCH_EFFECTS; i++)
+	{
+		FILE* fp = fopen("mixbench.wav", "rb");
+		if (fp == NULL)
+			break;
+		fseek(fp, 0, SEEK_END);
+		long nSize = ftell(fp);
+		fseek(fp, 0, SEEK_SET);
+		unsigned char* pData = new unsigned char[nSize];
+		nCopied += (unsigned int)fread(pData, 1, nSize, fp);
+		fclose(fp);
+		delete[] pData;
+	}
+	double fCopyTime = MixBench_Seconds(start);
+
+	start = std::chrono::steady_clock::now();
+	int nMapped = 0;
+	for (int i = 0; i < MIXBENCH_EFFECTS; i++)
+	{
+		WAVFILE wav;
+		if (WavFile_Open("mixbench.wav", &wav) == false)
+			break;
+		nMapped++;
+		WavFile_Close(&wav);
+	}
+	double fMapTime = MixBench_Seconds(start);
+
+	sprintf(g_szMixLine, "mixbench: %d effects read %.1f ms (%u MB copied), mapped %.1f ms\n",
+		MIXBENCH_EFFECTS, fCopyTime * 1000.0, nCopied >> 20, fMapTime * 1000.0);
+	MixBench_Report(g_szMixLine);
+	if (nMapped != MIXBENCH_EFFECTS)
+		g_nMixFailed++;
+}
+
+//MixBench_Pool() : two shots a tick (the second coalesces), an explosion
+//every 5th tick, and every 50th tick the skill bursts 8 explosions at once;
+//the explosions start where the enemies come in and drift left
+static void MixBench_Pool(const MIXERSOUND* pShot, const MIXERSOUND* pExplosion)
+{
+	// the listener is the middle of the screen
+	SPATIALLISTENER listener = { MIXBENCH_SCREEN_WIDTH * 0.5f, MIXBENCH_SCREEN_HEIGHT * 0.5f,
+		MIXBENCH_SCREEN_WIDTH * 0.5f, MIXBENCH_SCREEN_WIDTH * 0.5f, 1.0f };
+	Spatial_SetListener(listener);
+
+	static float emitter_x[MIXBENCH_EMITTERS], emitter_y[MIXBENCH_EMITTERS], emitter_volume[MIXBENCH_EMITTERS];
+	static float emitter_left[MIXBENCH_EMITTERS], emitter_right[MIXBENCH_EMITTERS];
+	for (int i = 0; i < MIXBENCH_EMITTERS; i++)
+	{
+		emitter_x[i] = (float)(i * 37 % 1200) - 200.0f;
+		emitter_y[i] = (float)(i * 53 % 600);
+		emitter_volume[i] = 1.0f;
+	}
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for (int i = 0; i < 1000; i++)
+		Spatial_Gains(emitter_x, emitter_y, emitter_volume, MIXBENCH_EMITTERS, emitter_left, emitter_right);
+	double fSpatialTime = MixBench_Seconds(start);
+	sprintf(g_szMixLine, "mixbench: spatial gains %.2f ns per emitter\n", fSpatialTime * 1e9 / (1000.0 * MIXBENCH_EMITTERS));
+	MixBench_Report(g_szMixLine);
+
+	VOICEPOOL pool;
+	float voice_x[VOICE_MAX_VOICES], voice_y[VOICE_MAX_VOICES];
+	Voice_Init(&pool, 12);
+	Voice_SetSound(&pool, 0, 0, 4, 0.03f, (float)pShot->nFrames / MIXER_RATE);
+	Voice_SetSound(&pool, 1, 1, 6, 0.0f, (float)pExplosion->nFrames / MIXER_RATE);
+	Mixer_Init(Mixer_NullOutput());
+	for (int tick = 0; tick < 200; tick++)
+	{
+		float fNow = tick * (float)MIXER_BLOCK_FRAMES / MIXER_RATE;
+		Voice_Update(&pool, fNow);
+
+		MixBench_Trigger(&pool, pShot, 0, 0.5f, 0.0f, fNow);
+		MixBench_Trigger(&pool, pShot, 0, 0.7f, 0.0f, fNow);
+		int voice = -1;
+		if (tick % 5 == 0 && (voice = MixBench_Trigger(&pool, pExplosion, 1, 0.8f, 0.0f, fNow)) >= 0)
+		{
+			voice_x[voice] = 700.0f;
+			voice_y[voice] = (float)(tick * 7 % 430 + 60);
+		}
+		if (tick % 50 == 25)
+		{
+			for (int i = 0; i < 8; i++)
+			{
+				if ((voice = MixBench_Trigger(&pool, pExplosion, 1, 1.0f, 0.0f, fNow)) >= 0)
+				{
+					voice_x[voice] = i * 100.0f;
+					voice_y[voice] = 300.0f;
+				}
+			}
+		}
+
+		// gather the playing explosions, place them in one pass and hand the gains to their voices
+		int placed[VOICE_MAX_VOICES];
+		int nPlaced = 0;
+		for (int i = 0; i < pool.nVoices; i++)
+		{
+			if (pool.voices[i].sound != 1)
+				continue;
+			voice_x[i] -= 4.0f;
+			emitter_x[nPlaced] = voice_x[i];
+			emitter_y[nPlaced] = voice_y[i];
+			emitter_volume[nPlaced] = pool.voices[i].volume;
+			placed[nPlaced++] = i;
+		}
+		Spatial_Gains(emitter_x, emitter_y, emitter_volume, nPlaced, emitter_left, emitter_right);
+		for (int i = 0; i < nPlaced; i++)
+			Mixer_SetGains(pool.voices[placed[i]].handle, emitter_left[i], emitter_right[i]);
+
+		Mixer_Render(MIXER_BLOCK_FRAMES);
+	}
+
+	MIXERSTATS stats = Mixer_GetStats();
+	sprintf(g_szMixLine, "mixbench: voice pool %d triggers, %d played, %d coalesced, %d stolen, %d dropped, peak %d\n",
+		pool.stats.nTriggered, pool.stats.nPlayed, pool.stats.nCoalesced, pool.stats.nStolen, pool.stats.nDropped,
+		pool.stats.nPeakVoices);
+	MixBench_Report(g_szMixLine);
+	Mixer_Release();
+
+	if (stats.nVoiceDrops != 0 || stats.nPeakActive > 12)
+		g_nMixFailed++;
+	g_nMixFailed += stats.nCommandDrops;
+}
+
+int MixBench_Run(MIXBENCHREPORT pReport)
+{
+	static short tone[MIXER_RATE / 4];    // 250 ms, 440 Hz
+	static short noise[MIXER_RATE / 8];   // 125 ms burst, fading out
+	unsigned int seed = 1;
+
+	g_pMixReport = pReport;
+	g_nMixFailed = 0;
+
+	for (int i = 0; i < MIXER_RATE / 4; i++)
+		tone[i] = (short)(12000.0f * sinf(i * (6.2831853f * 440.0f / MIXER_RATE)));
+	for (int i = 0; i < MIXER_RATE / 8; i++)
+	{
+		seed = seed * 1664525u + 1013904223u;
+		noise[i] = (short)(((int)(seed >> 17) - 16384) * (MIXER_RATE / 8 - i) / (MIXER_RATE / 8));
+	}
+	MIXERSOUND shot = { tone, MIXER_RATE / 4, 1 };
+	MIXERSOUND explosion = { noise, MIXER_RATE / 8, 1 };
+
+	MixBench_Voices(&shot, &explosion);
+
+	if (MixBench_Script(&shot, &explosion) == false || MixBench_Stream(&shot) == false)
+	{
+		MixBench_Report("mixbench: could not write or stream mixbench.wav\n");
+		return g_nMixFailed + 1;
+	}
+
+	MixBench_Load();
+
+	// the bank resamples the shot back up, the explosion goes in as it is
+	SOUNDBANKSOURCE sources[2] =
+	{
+		{ "shot", tone, MIXER_RATE / 8, 1, MIXER_RATE / 2 },
+		{ "explosion", noise, MIXER_RATE / 8, 1, MIXER_RATE },
+	};
+	SOUNDBANK bank;
+	if (SoundBank_Write("mixbench.sbk", sources, 2) == false || SoundBank_Open("mixbench.sbk", &bank) == false)
+	{
+		MixBench_Report("mixbench: could not build mixbench.sbk\n");
+		return g_nMixFailed + 1;
+	}
+	MixBench_Pool(SoundBank_GetSound(&bank, SoundBank_Find(&bank, "shot")),
+		SoundBank_GetSound(&bank, SoundBank_Find(&bank, "explosion")));
+	SoundBank_Close(&bank);
+
+	sprintf(g_szMixLine, "mixbench: %d checks failed\n", g_nMixFailed);
+	MixBench_Report(g_szMixLine);
+	return g_nMixFailed;
+}
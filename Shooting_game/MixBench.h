@@ -0,0 +1,24 @@
+#pragma once
+
+// Software mixer checks and timings.
+// Needs no device or window, so the same run works from the game's
+// "-mixbench" mode and from a two line main() on any platform. It writes
+// mixbench.wav and mixbench.sbk to the working folder. In order:
+// Mixing 1 to MIXER_MAX_VOICES looping voices is timed per voice frame.
+// A scripted run of shots and explosions is rendered into mixbench.wav.
+// Every shot in it has to be playing in the block that triggered it.
+// mixbench.wav is streamed back in a loop for four seconds of real time.
+// Shots fire during that run like the game loop fires them.
+// The stream must not underrun.
+// The stream's resident memory is reported next to a full decode.
+// Mapping 500 effects is timed against reading copies of them.
+// Every one of those mappings has to succeed.
+// Spatializing 1024 emitters is timed on its own.
+// A rapid fire session plays from a bank through a 12 voice pool.
+// Its explosions drift across the screen and are panned every tick.
+// That session must never drop a mixer voice or go past 12 of them.
+// Every line of the report goes through the callback.
+
+typedef void (*MIXBENCHREPORT)(const char* pLine);
+
+int MixBench_Run(MIXBENCHREPORT pReport);    // returns the number of failed checks
@@ -0,0 +1,690 @@
+#include "Mixer.h"
+#include "Stream.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#if defined(_M_X64) || defined(__x86_64__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define MIXER_SSE2
+#include <emmintrin.h>
+#endif
+
+enum { MIXCMD_PLAY, MIXCMD_STOP, MIXCMD_VOLUME, MIXCMD_PAN, MIXCMD_GAINS, MIXCMD_STOPALL };
+
+struct MIXERCOMMAND
+{
+	int type;
+	MIXERVOICE voice;
+	const MIXERSOUND* pSound;
+	int stream;
+	float value;
+	float pan;
+	bool bLoop;
+	double time;      // when it was pushed, Mixer_Now() clock, set by Mixer_Push()
+};
+
+struct MIXERVOICEDATA
+{
+	MIXERVOICE id;    // 0 when free
+	const MIXERSOUND* pSound;
+	int stream;       // -1 when playing pSound
+	int position;     // next frame
+	float volume;
+	float pan;
+	float left, right;                // gains at the start of the next block
+	float targetLeft, targetRight;    // gains at its end
+	bool bLoop;
+};
+
+static MIXEROUTPUT g_MixerOutput = { NULL, NULL, NULL };
+static bool g_bMixerInit = false;
+
+// command ring, written by the game thread and read by the mixer
+static MIXERCOMMAND g_MixerRing[MIXER_RING_SIZE];
+static std::atomic<unsigned int> g_nMixerRingHead(0);    // next command to read
+static std::atomic<unsigned int> g_nMixerRingTail(0);    // next command to write
+static unsigned int g_nMixerNextVoice = 0;
+
+// mixer side, only touched while mixing
+static MIXERVOICEDATA g_MixerVoices[MIXER_MAX_VOICES];
+static float g_MixerAccum[MIXER_BLOCK_FRAMES * 2];
+static short g_MixerBlock[MIXER_BLOCK_FRAMES * 2];
+static short g_MixerStreamBlock[MIXER_BLOCK_FRAMES * 2];
+static MIXERSTATS g_MixerStats;
+static double g_MixerTriggers[MIXER_RING_SIZE];    // push times of the plays started this block
+static int g_nMixerTriggers = 0;
+
+// published once a block for Mixer_GetStats()
+static std::mutex g_MixerStatsLock;
+static MIXERSTATS g_MixerStatsCopy;
+static std::atomic<int> g_nMixerPlayed(0);
+static std::atomic<int> g_nMixerCommandDrops(0);
+
+static std::thread g_MixerThread;
+static std::atomic<bool> g_bMixerRunning(false);
+
+static double Mixer_Now(void)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static bool Mixer_Push(const MIXERCOMMAND& command)
+{
+	unsigned int tail = g_nMixerRingTail.load(std::memory_order_relaxed);
+
+	if (tail - g_nMixerRingHead.load(std::memory_order_acquire) >= MIXER_RING_SIZE)
+	{
+		g_nMixerCommandDrops++;
+		return false;
+	}
+
+	g_MixerRing[tail & (MIXER_RING_SIZE - 1)] = command;
+	g_MixerRing[tail & (MIXER_RING_SIZE - 1)].time = Mixer_Now();
+	g_nMixerRingTail.store(tail + 1, std::memory_order_release);
+	return true;
+}
+
+static MIXERVOICEDATA* Mixer_FindVoice(MIXERVOICE voice)
+{
+	for (int i = 0; i < MIXER_MAX_VOICES; i++)
+	{
+		if (g_MixerVoices[i].id == voice)
+			return &g_MixerVoices[i];
+	}
+
+	return NULL;
+}
+
+// constant power pan, the center is -3 dB on both sides
+static void Mixer_Gains(float fVolume, float fPan, float* pLeft, float* pRight)
+{
+	if (fPan < -1.0f)
+		fPan = -1.0f;
+	if (fPan > 1.0f)
+		fPan = 1.0f;
+
+	float angle = (fPan + 1.0f) * 0.785398163f;
+	*pLeft = fVolume * cosf(angle);
+	*pRight = fVolume * sinf(angle);
+}
+
+static void Mixer_SetTarget(MIXERVOICEDATA* pVoice)
+{
+	Mixer_Gains(pVoice->volume, pVoice->pan, &pVoice->targetLeft, &pVoice->targetRight);
+}
+
+static void Mixer_Execute(const MIXERCOMMAND& command)
+{
+	MIXERVOICEDATA* pVoice;
+
+	switch (command.type)
+	{
+	case MIXCMD_PLAY:
+		pVoice = Mixer_FindVoice(0);
+		if (pVoice == NULL)
+		{
+			g_MixerStats.nVoiceDrops++;
+			break;
+		}
+		pVoice->id = command.voice;
+		pVoice->pSound = command.pSound;
+		pVoice->stream = command.stream;
+		pVoice->position = 0;
+		pVoice->volume = command.value;
+		pVoice->pan = command.pan;
+		pVoice->bLoop = command.bLoop;
+		Mixer_SetTarget(pVoice);
+		pVoice->left = pVoice->targetLeft;
+		pVoice->right = pVoice->targetRight;
+		g_MixerTriggers[g_nMixerTriggers++] = command.time;
+		break;
+
+	case MIXCMD_STOP:
+		pVoice = Mixer_FindVoice(command.voice);
+		if (pVoice != NULL)
+			pVoice->id = 0;
+		break;
+
+	case MIXCMD_VOLUME:
+		pVoice = Mixer_FindVoice(command.voice);
+		if (pVoice != NULL)
+		{
+			pVoice->volume = command.value;
+			Mixer_SetTarget(pVoice);
+		}
+		break;
+
+	case MIXCMD_PAN:
+		pVoice = Mixer_FindVoice(command.voice);
+		if (pVoice != NULL)
+		{
+			pVoice->pan = command.pan;
+			Mixer_SetTarget(pVoice);
+		}
+		break;
+
+	case MIXCMD_GAINS:
+		pVoice = Mixer_FindVoice(command.voice);
+		if (pVoice != NULL)
+		{
+			pVoice->targetLeft = command.value;
+			pVoice->targetRight = command.pan;
+		}
+		break;
+
+	case MIXCMD_STOPALL:
+		for (int i = 0; i < MIXER_MAX_VOICES; i++)
+			g_MixerVoices[i].id = 0;
+		break;
+	}
+}
+
+//Mixer_MixMono() : adds nFrames mono samples into the stereo accumulator
+//the gains move by fStepLeft/fStepRight every frame, so changes ramp instead of stepping
+static void Mixer_MixMono(float* pOut, const short* pIn, int nFrames, float fLeft, float fRight,
+	float fStepLeft, float fStepRight)
+{
+	int i = 0;
+#ifdef MIXER_SSE2
+	// gains of frames i and i + 1, and of i + 2 and i + 3
+	__m128 gain0 = _mm_setr_ps(fLeft, fRight, fLeft + fStepLeft, fRight + fStepRight);
+	__m128 step2 = _mm_setr_ps(fStepLeft * 2.0f, fStepRight * 2.0f, fStepLeft * 2.0f, fStepRight * 2.0f);
+	__m128 step4 = _mm_add_ps(step2, step2);
+	__m128 scale = _mm_set1_ps(1.0f / 32768.0f);
+
+	for (; i + 4 <= nFrames; i += 4)
+	{
+		// sign extend four samples to 32 bits
+		__m128i s16 = _mm_loadl_epi64((const __m128i*)(pIn + i));
+		__m128 s = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(s16, s16), 16)), scale);
+
+		float* p = pOut + i * 2;
+		_mm_storeu_ps(p, _mm_add_ps(_mm_loadu_ps(p), _mm_mul_ps(_mm_unpacklo_ps(s, s), gain0)));
+		_mm_storeu_ps(p + 4, _mm_add_ps(_mm_loadu_ps(p + 4), _mm_mul_ps(_mm_unpackhi_ps(s, s), _mm_add_ps(gain0, step2))));
+		gain0 = _mm_add_ps(gain0, step4);
+	}
+#endif
+	for (; i < nFrames; i++)
+	{
+		float s = pIn[i] * (1.0f / 32768.0f);
+		pOut[i * 2] += s * (fLeft + fStepLeft * i);
+		pOut[i * 2 + 1] += s * (fRight + fStepRight * i);
+	}
+}
+
+//Mixer_MixStereo() : adds nFrames interleaved stereo frames into the accumulator, gains ramp like Mixer_MixMono()
+static void Mixer_MixStereo(float* pOut, const short* pIn, int nFrames, float fLeft, float fRight,
+	float fStepLeft, float fStepRight)
+{
+	int i = 0;
+#ifdef MIXER_SSE2
+	__m128 gain0 = _mm_setr_ps(fLeft, fRight, fLeft + fStepLeft, fRight + fStepRight);
+	__m128 step2 = _mm_setr_ps(fStepLeft * 2.0f, fStepRight * 2.0f, fStepLeft * 2.0f, fStepRight * 2.0f);
+	__m128 step4 = _mm_add_ps(step2, step2);
+	__m128 scale = _mm_set1_ps(1.0f / 32768.0f);
+
+	for (; i + 4 <= nFrames; i += 4)
+	{
+		__m128i s16 = _mm_loadu_si128((const __m128i*)(pIn + i * 2));
+		__m128 lo = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(s16, s16), 16)), scale);
+		__m128 hi = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(s16, s16), 16)), scale);
+
+		float* p = pOut + i * 2;
+		_mm_storeu_ps(p, _mm_add_ps(_mm_loadu_ps(p), _mm_mul_ps(lo, gain0)));
+		_mm_storeu_ps(p + 4, _mm_add_ps(_mm_loadu_ps(p + 4), _mm_mul_ps(hi, _mm_add_ps(gain0, step2))));
+		gain0 = _mm_add_ps(gain0, step4);
+	}
+#endif
+	for (; i < nFrames; i++)
+	{
+		pOut[i * 2] += pIn[i * 2] * (1.0f / 32768.0f) * (fLeft + fStepLeft * i);
+		pOut[i * 2 + 1] += pIn[i * 2 + 1] * (1.0f / 32768.0f) * (fRight + fStepRight * i);
+	}
+}
+
+//Mixer_Clip() : converts the accumulator to 16 bits, saturating
+static void Mixer_Clip(short* pOut, const float* pIn, int nSamples)
+{
+	int i = 0;
+#ifdef MIXER_SSE2
+	__m128 scale = _mm_set1_ps(32767.0f);
+	__m128 lo = _mm_set1_ps(-1.0f);
+	__m128 hi = _mm_set1_ps(1.0f);
+
+	for (; i + 8 <= nSamples; i += 8)
+	{
+		__m128 a = _mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(pIn + i), lo), hi), scale);
+		__m128 b = _mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(pIn + i + 4), lo), hi), scale);
+		_mm_storeu_si128((__m128i*)(pOut + i), _mm_packs_epi32(_mm_cvtps_epi32(a), _mm_cvtps_epi32(b)));
+	}
+#endif
+	for (; i < nSamples; i++)
+	{
+		float s = pIn[i];
+		s = s < -1.0f ? -1.0f : s > 1.0f ? 1.0f : s;
+		pOut[i] = (short)lrintf(s * 32767.0f);
+	}
+}
+
+//Mixer_MixVoice() : mixes one block of the voice, returns false when it ended
+//gains ramp to their targets over the block, which hides the steps of per-tick updates
+static bool Mixer_MixVoice(MIXERVOICEDATA& voice, float* pOut, int nFrames)
+{
+	float fLeft = voice.left;
+	float fRight = voice.right;
+	float fStepLeft = (voice.targetLeft - fLeft) / nFrames;
+	float fStepRight = (voice.targetRight - fRight) / nFrames;
+	voice.left = voice.targetLeft;
+	voice.right = voice.targetRight;
+
+	if (voice.stream >= 0)
+	{
+		Stream_Read(voice.stream, g_MixerStreamBlock, nFrames);
+		Mixer_MixStereo(pOut, g_MixerStreamBlock, nFrames, fLeft, fRight, fStepLeft, fStepRight);
+		g_MixerStats.nVoiceFrames += nFrames;
+		return Stream_IsFinished(voice.stream) == false;
+	}
+
+	const MIXERSOUND& sound = *voice.pSound;
+
+	while (nFrames > 0)
+	{
+		int n = sound.nFrames - voice.position;
+		if (n > nFrames)
+			n = nFrames;
+
+		if (n > 0)
+		{
+			if (sound.nChannels == 2)
+				Mixer_MixStereo(pOut, sound.pSamples + voice.position * 2, n, fLeft, fRight, fStepLeft, fStepRight);
+			else
+				Mixer_MixMono(pOut, sound.pSamples + voice.position, n, fLeft, fRight, fStepLeft, fStepRight);
+			g_MixerStats.nVoiceFrames += n;
+			fLeft += fStepLeft * n;
+			fRight += fStepRight * n;
+		}
+
+		voice.position += n;
+		pOut += n * 2;
+		nFrames -= n;
+
+		if (voice.position >= sound.nFrames)
+		{
+			if (voice.bLoop == false || sound.nFrames == 0)
+				return false;
+			voice.position = 0;
+		}
+	}
+
+	return true;
+}
+
+static void Mixer_HistogramAdd(MIXERHISTOGRAM& histogram, float fValue)
+{
+	int bucket = 0;
+	for (float fTop = MIXER_HISTOGRAM_BASE; bucket < MIXER_HISTOGRAM_BUCKETS - 1 && fValue > fTop; fTop *= 2.0f)
+		bucket++;
+
+	histogram.counts[bucket]++;
+	histogram.nCount++;
+	if (fValue > histogram.fMax)
+		histogram.fMax = fValue;
+}
+
+//Mixer_Block() : fPlayTime is when the block will be heard on the Mixer_Now() clock, 0 when nothing plays it
+static void Mixer_Block(double fPlayTime)
+{
+	unsigned int head = g_nMixerRingHead.load(std::memory_order_relaxed);
+	unsigned int tail = g_nMixerRingTail.load(std::memory_order_acquire);
+
+	g_nMixerTriggers = 0;
+	for (; head != tail; head++)
+		Mixer_Execute(g_MixerRing[head & (MIXER_RING_SIZE - 1)]);
+	g_nMixerRingHead.store(head, std::memory_order_release);
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	memset(g_MixerAccum, 0, sizeof(g_MixerAccum));
+
+	int nActive = 0;
+	for (int i = 0; i < MIXER_MAX_VOICES; i++)
+	{
+		MIXERVOICEDATA& voice = g_MixerVoices[i];
+		if (voice.id == 0)
+			continue;
+
+		if (Mixer_MixVoice(voice, g_MixerAccum, MIXER_BLOCK_FRAMES))
+			nActive++;
+		else
+			voice.id = 0;
+	}
+
+	Mixer_Clip(g_MixerBlock, g_MixerAccum, MIXER_BLOCK_FRAMES * 2);
+
+	double fMixTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	g_MixerStats.fMixTime += fMixTime;
+	g_MixerStats.fLastMixTime = (float)(fMixTime * 1000.0);
+	if (g_MixerStats.fLastMixTime > g_MixerStats.fMaxMixTime)
+		g_MixerStats.fMaxMixTime = g_MixerStats.fLastMixTime;
+	Mixer_HistogramAdd(g_MixerStats.mixTime, g_MixerStats.fLastMixTime);
+
+	// offline the sound is out once it is mixed
+	if (fPlayTime == 0.0)
+		fPlayTime = Mixer_Now();
+	for (int i = 0; i < g_nMixerTriggers; i++)
+	{
+		double fLatency = fPlayTime - g_MixerTriggers[i];
+		Mixer_HistogramAdd(g_MixerStats.latency, fLatency > 0.0 ? (float)(fLatency * 1000.0) : 0.0f);
+	}
+	g_MixerStats.nFrames += MIXER_BLOCK_FRAMES;
+	g_MixerStats.nActive = nActive;
+	if (nActive > g_MixerStats.nPeakActive)
+		g_MixerStats.nPeakActive = nActive;
+
+	if (g_MixerOutput.pWrite != NULL)
+		g_MixerOutput.pWrite(g_MixerOutput.pContext, g_MixerBlock, MIXER_BLOCK_FRAMES);
+
+	std::lock_guard<std::mutex> lock(g_MixerStatsLock);
+	g_MixerStatsCopy = g_MixerStats;
+}
+
+//Mixer_Percentile() : fFraction of the samples are at or below the result
+float Mixer_Percentile(const MIXERHISTOGRAM& histogram, float fFraction)
+{
+	int nNeeded = (int)ceilf(histogram.nCount * fFraction);
+	int nSeen = 0;
+	float fTop = MIXER_HISTOGRAM_BASE;
+
+	for (int i = 0; i < MIXER_HISTOGRAM_BUCKETS - 1; i++, fTop *= 2.0f)
+	{
+		nSeen += histogram.counts[i];
+		if (nSeen >= nNeeded)
+			return fTop < histogram.fMax ? fTop : histogram.fMax;
+	}
+
+	return histogram.fMax;
+}
+
+//Mixer_Init() : the mixer owns the output from here on and closes it in Mixer_Release()
+bool Mixer_Init(const MIXEROUTPUT& output)
+{
+	Mixer_Release();
+
+	memset(g_MixerVoices, 0, sizeof(g_MixerVoices));
+	memset(&g_MixerStats, 0, sizeof(g_MixerStats));
+	g_MixerStatsCopy = g_MixerStats;
+	g_nMixerRingHead = 0;
+	g_nMixerRingTail = 0;
+	g_nMixerPlayed = 0;
+	g_nMixerCommandDrops = 0;
+	g_MixerOutput = output;
+	g_bMixerInit = true;
+
+	return true;
+}
+
+void Mixer_Release(void)
+{
+	if (g_bMixerInit == false)
+		return;
+
+	Mixer_StopThread();
+	if (g_MixerOutput.pClose != NULL)
+		g_MixerOutput.pClose(g_MixerOutput.pContext);
+	g_MixerOutput.pContext = NULL;
+	g_MixerOutput.pWrite = NULL;
+	g_MixerOutput.pClose = NULL;
+	g_bMixerInit = false;
+}
+
+//Mixer_Play() : returns the voice for the other calls, which ignore it once the sound ended
+MIXERVOICE Mixer_Play(const MIXERSOUND* pSound, float fVolume, float fPan, bool bLoop)
+{
+	if (pSound == NULL || pSound->pSamples == NULL)
+		return 0;
+
+	if (++g_nMixerNextVoice == 0)
+		g_nMixerNextVoice = 1;
+
+	MIXERCOMMAND command = { MIXCMD_PLAY, g_nMixerNextVoice, pSound, -1, fVolume, fPan, bLoop, 0.0 };
+	if (Mixer_Push(command) == false)
+		return 0;
+
+	g_nMixerPlayed++;
+	return command.voice;
+}
+
+MIXERVOICE Mixer_PlayStream(int stream, float fVolume)
+{
+	if (stream < 0 || stream >= STREAM_MAX)
+		return 0;
+
+	if (++g_nMixerNextVoice == 0)
+		g_nMixerNextVoice = 1;
+
+	MIXERCOMMAND command = { MIXCMD_PLAY, g_nMixerNextVoice, NULL, stream, fVolume, 0.0f, false, 0.0 };
+	if (Mixer_Push(command) == false)
+		return 0;
+
+	g_nMixerPlayed++;
+	return command.voice;
+}
+
+void Mixer_Stop(MIXERVOICE voice)
+{
+	MIXERCOMMAND command = { MIXCMD_STOP, voice, NULL, -1, 0.0f, 0.0f, false, 0.0 };
+	if (voice != 0)
+		Mixer_Push(command);
+}
+
+void Mixer_SetVolume(MIXERVOICE voice, float fVolume)
+{
+	MIXERCOMMAND command = { MIXCMD_VOLUME, voice, NULL, -1, fVolume, 0.0f, false, 0.0 };
+	if (voice != 0)
+		Mixer_Push(command);
+}
+
+void Mixer_SetPan(MIXERVOICE voice, float fPan)
+{
+	MIXERCOMMAND command = { MIXCMD_PAN, voice, NULL, -1, 0.0f, fPan, false, 0.0 };
+	if (voice != 0)
+		Mixer_Push(command);
+}
+
+//Mixer_SetGains() : sets both sides directly, until the next Mixer_SetVolume() or Mixer_SetPan()
+void Mixer_SetGains(MIXERVOICE voice, float fLeft, float fRight)
+{
+	MIXERCOMMAND command = { MIXCMD_GAINS, voice, NULL, -1, fLeft, fRight, false, 0.0 };
+	if (voice != 0)
+		Mixer_Push(command);
+}
+
+void Mixer_StopAll(void)
+{
+	MIXERCOMMAND command = { MIXCMD_STOPALL, 0, NULL, -1, 0.0f, 0.0f, false, 0.0 };
+	Mixer_Push(command);
+}
+
+//Mixer_GetStats() : as of the last finished block
+MIXERSTATS Mixer_GetStats(void)
+{
+	MIXERSTATS stats;
+	{
+		std::lock_guard<std::mutex> lock(g_MixerStatsLock);
+		stats = g_MixerStatsCopy;
+	}
+	stats.nPlayed = g_nMixerPlayed;
+	stats.nCommandDrops = g_nMixerCommandDrops;
+
+	return stats;
+}
+
+//Mixer_Render() : not while the mixer thread runs
+int Mixer_Render(int nFrames)
+{
+	int nWritten = 0;
+
+	for (; nWritten < nFrames; nWritten += MIXER_BLOCK_FRAMES)
+		Mixer_Block(0.0);
+
+	return nWritten;
+}
+
+//Mixer_ThreadProc() : in real time playback starts when the thread does and runs on the clock;
+//a block mixed after playback reached it is an underrun, and playback restarts from it
+static void Mixer_ThreadProc(bool bRealTime)
+{
+	double fStart = Mixer_Now();
+	long long nFrames = 0;
+
+	g_MixerStats.nMinFill = MIXER_LEAD_BLOCKS * MIXER_BLOCK_FRAMES;
+
+	while (g_bMixerRunning)
+	{
+		if (bRealTime == false)
+		{
+			Mixer_Block(0.0);
+			continue;
+		}
+
+		double fNow = Mixer_Now();
+		long long nPlayed = (long long)((fNow - fStart) * MIXER_RATE);
+		if (nPlayed > nFrames)
+		{
+			g_MixerStats.nUnderruns++;
+			fStart = fNow - (double)nFrames / MIXER_RATE;
+			nPlayed = nFrames;
+		}
+
+		// the buffer starts empty, its low mark counts once the lead was mixed
+		g_MixerStats.nFill = (int)(nFrames - nPlayed);
+		if (nFrames >= MIXER_LEAD_BLOCKS * MIXER_BLOCK_FRAMES && g_MixerStats.nFill < g_MixerStats.nMinFill)
+			g_MixerStats.nMinFill = g_MixerStats.nFill;
+
+		// another block would go past the lead, wait until one has played
+		if (g_MixerStats.nFill > (MIXER_LEAD_BLOCKS - 1) * MIXER_BLOCK_FRAMES)
+		{
+			double fWake = fStart + (double)(nFrames - (MIXER_LEAD_BLOCKS - 1) * MIXER_BLOCK_FRAMES) / MIXER_RATE;
+			std::this_thread::sleep_for(std::chrono::duration<double>(fWake - fNow));
+			continue;
+		}
+
+		Mixer_Block(fStart + (double)nFrames / MIXER_RATE);
+		nFrames += MIXER_BLOCK_FRAMES;
+	}
+}
+
+bool Mixer_Start(bool bRealTime)
+{
+	if (g_bMixerInit == false || g_bMixerRunning)
+		return false;
+
+	g_bMixerRunning = true;
+	g_MixerThread = std::thread(Mixer_ThreadProc, bRealTime);
+	return true;
+}
+
+void Mixer_StopThread(void)
+{
+	if (g_bMixerRunning == false)
+		return;
+
+	g_bMixerRunning = false;
+	g_MixerThread.join();
+}
+
+
+static bool Mixer_NullWrite(void*, const short*, int)
+{
+	return true;
+}
+
+MIXEROUTPUT Mixer_NullOutput(void)
+{
+	MIXEROUTPUT output = { NULL, Mixer_NullWrite, NULL };
+	return output;
+}
+
+struct MIXERWAVFILE
+{
+	FILE* fp;
+	unsigned int nBytes;
+};
+
+static void Mixer_PutU32(unsigned char* p, unsigned int value)
+{
+	p[0] = (unsigned char)value;
+	p[1] = (unsigned char)(value >> 8);
+	p[2] = (unsigned char)(value >> 16);
+	p[3] = (unsigned char)(value >> 24);
+}
+
+// 16-bit stereo PCM header, the sizes are patched when the file is closed
+static void Mixer_WavHeader(unsigned char* pHeader, unsigned int nDataBytes)
+{
+	memcpy(pHeader, "RIFF\0\0\0\0WAVEfmt \x10\0\0\0\x01\0\x02\0\0\0\0\0\0\0\0\0\x04\0\x10\0data\0\0\0\0", 44);
+	Mixer_PutU32(pHeader + 4, 36 + nDataBytes);
+	Mixer_PutU32(pHeader + 24, MIXER_RATE);
+	Mixer_PutU32(pHeader + 28, MIXER_RATE * 4);
+	Mixer_PutU32(pHeader + 40, nDataBytes);
+}
+
+static bool Mixer_WavWrite(void* pContext, const short* pFrames, int nFrames)
+{
+	MIXERWAVFILE* pWav = (MIXERWAVFILE*)pContext;
+	unsigned char bytes[MIXER_BLOCK_FRAMES * 4];
+
+	// little endian on disk whatever the machine is
+	for (int i = 0; i < nFrames * 2; i++)
+	{
+		bytes[i * 2] = (unsigned char)pFrames[i];
+		bytes[i * 2 + 1] = (unsigned char)((unsigned short)pFrames[i] >> 8);
+	}
+
+	if (fwrite(bytes, 4, nFrames, pWav->fp) != (size_t)nFrames)
+		return false;
+	pWav->nBytes += nFrames * 4;
+
+	return true;
+}
+
+static void Mixer_WavClose(void* pContext)
+{
+	MIXERWAVFILE* pWav = (MIXERWAVFILE*)pContext;
+	unsigned char header[44];
+
+	Mixer_WavHeader(header, pWav->nBytes);
+	fseek(pWav->fp, 0, SEEK_SET);
+	fwrite(header, 1, sizeof(header), pWav->fp);
+	fclose(pWav->fp);
+	delete pWav;
+}
+
+//Mixer_WavOutput() : opens a 16-bit stereo .wav file at MIXER_RATE
+bool Mixer_WavOutput(const char* pFile, MIXEROUTPUT* pOutput)
+{
+	FILE* fp = fopen(pFile, "wb");
+	if (fp == NULL)
+		return false;
+
+	unsigned char header[44];
+	Mixer_WavHeader(header, 0);
+	if (fwrite(header, 1, sizeof(header), fp) != sizeof(header))
+	{
+		fclose(fp);
+		return false;
+	}
+
+	MIXERWAVFILE* pWav = new MIXERWAVFILE;
+	pWav->fp = fp;
+	pWav->nBytes = 0;
+
+	pOutput->pContext = pWav;
+	pOutput->pWrite = Mixer_WavWrite;
+	pOutput->pClose = Mixer_WavClose;
+
+	return true;
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+// Software audio mixer.
+// Sounds are 16-bit PCM at MIXER_RATE, mono or interleaved stereo, owned by
+// the caller and kept alive while they play. The game thread never touches
+// the voices: Mixer_Play() and the other calls push commands into a
+// single-producer, single-consumer ring that the mixer drains at the start
+// of every block. Each block mixes the active voices into a float stereo
+// accumulator four samples at a time with SSE2, ramping each voice's gains
+// to their new values across the block so changes do not click, clips it to 16 bits and
+// hands it to the output. Outputs are pluggable; the null output discards
+// the audio and the WAV output writes it to a file, so mixing can be
+// measured and triggers checked without a sound card.
+// Music plays from a stream (see Stream.h) that the mixer drains block by
+// block instead of from a sound held in memory.
+// Mixer_Render() mixes on the calling thread, which is how offline and
+// headless runs drive it; Mixer_Start() runs the same loop on a thread.
+// In real time the thread keeps MIXER_LEAD_BLOCKS mixed ahead of a
+// playback clock, standing in for the device buffer; the stats report how
+// full that buffer is, the blocks that missed it, how long each block took
+// to mix and how long a Mixer_Play() took to be heard, the last two as
+// histograms.
+
+#define MIXER_RATE          44100
+#define MIXER_MAX_VOICES    32
+#define MIXER_RING_SIZE     256      // commands, a power of two
+#define MIXER_BLOCK_FRAMES  512      // frames per block, a multiple of 4
+#define MIXER_LEAD_BLOCKS   3        // mixed ahead of playback in real time, about 35 ms
+
+#define MIXER_HISTOGRAM_BUCKETS  16
+#define MIXER_HISTOGRAM_BASE     0.015625f  // milliseconds, the top of bucket 0; every bucket doubles it, up to 256 ms
+
+struct MIXERSOUND
+{
+	const short* pSamples;    // interleaved when nChannels is 2
+	int nFrames;
+	int nChannels;            // 1 or 2
+};
+
+// receives each mixed block, 16-bit interleaved stereo
+struct MIXEROUTPUT
+{
+	void* pContext;
+	bool (*pWrite)(void* pContext, const short* pFrames, int nFrames);
+	void (*pClose)(void* pContext);
+};
+
+// bucket i counts up to MIXER_HISTOGRAM_BASE << i, the last one everything above
+struct MIXERHISTOGRAM
+{
+	int counts[MIXER_HISTOGRAM_BUCKETS];
+	int nCount;
+	float fMax;              // milliseconds
+};
+
+struct MIXERSTATS
+{
+	int nActive;             // voices playing after the last block
+	int nPeakActive;
+	int nPlayed;
+	int nVoiceDrops;         // Mixer_Play() with every voice busy
+	int nCommandDrops;       // commands lost to a full ring
+	long long nFrames;       // frames mixed
+	long long nVoiceFrames;  // voice frames mixed, the work the mix time is spent on
+	double fMixTime;         // seconds spent mixing, output excluded
+	float fLastMixTime;      // milliseconds, the last block
+	float fMaxMixTime;
+	int nFill;               // frames mixed ahead of playback, real time only
+	int nMinFill;
+	int nUnderruns;          // blocks mixed after playback reached them
+	MIXERHISTOGRAM mixTime;  // per block
+	MIXERHISTOGRAM latency;  // Mixer_Play() to the block that plays it being heard, or mixed when not in real time
+};
+
+typedef unsigned int MIXERVOICE;    // 0 is no voice
+
+bool Mixer_Init(const MIXEROUTPUT& output);
+void Mixer_Release(void);           // stops the thread and closes the output
+
+// game thread
+MIXERVOICE Mixer_Play(const MIXERSOUND* pSound, float fVolume, float fPan, bool bLoop);    // pan -1 left .. 1 right
+MIXERVOICE Mixer_PlayStream(int stream, float fVolume);    // ends when the stream is finished
+void Mixer_Stop(MIXERVOICE voice);
+void Mixer_SetVolume(MIXERVOICE voice, float fVolume);
+void Mixer_SetPan(MIXERVOICE voice, float fPan);
+void Mixer_SetGains(MIXERVOICE voice, float fLeft, float fRight);    // see Spatial.h
+void Mixer_StopAll(void);
+MIXERSTATS Mixer_GetStats(void);
+float Mixer_Percentile(const MIXERHISTOGRAM& histogram, float fFraction);    // milliseconds, the top of the bucket
+
+// mixing
+int Mixer_Render(int nFrames);      // mixes and outputs nFrames, rounded up to whole blocks; returns the frames written
+bool Mixer_Start(bool bRealTime);   // mixes on a thread, paced to MIXER_RATE when bRealTime
+void Mixer_StopThread(void);
+
+// outputs
+MIXEROUTPUT Mixer_NullOutput(void);
+bool Mixer_WavOutput(const char* pFile, MIXEROUTPUT* pOutput);
@@ -0,0 +1,240 @@
+#include "Particle.h"
+#include <stdlib.h>
+#include <string.h>
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+#if defined(_M_X64) || defined(__x86_64__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define PARTICLE_SSE2
+#include <emmintrin.h>
+#endif
+
+// burst settings per emitter
+static const PARTICLEEMITTER g_Emitters[EMIT_NUM] =
+{
+	//count  speed  gravity  life   jitter
+	{ 6,    60.0f,  0.0f,  0.20f, 0.10f },	// EMIT_EXPLOSION
+	{ 12,  120.0f, 90.0f,  0.30f, 0.15f },	// EMIT_HERO_HIT
+};
+
+static int g_nCapacity = 0;
+static int g_nLive = 0;
+static float* g_pX = NULL;
+static float* g_pY = NULL;
+static float* g_pVX = NULL;
+static float* g_pVY = NULL;
+static float* g_pLife = NULL;      // remaining seconds
+static float* g_pInvLife = NULL;   // 1 / initial life
+static float* g_pGravity = NULL;
+static PARTICLESTATS g_ParticleStats;
+static unsigned int g_nParticleSeed = 1;
+
+static float* Particle_Alloc(int nCount)
+{
+#ifdef _WIN32
+	return (float*)_aligned_malloc(nCount * sizeof(float), PARTICLE_ALIGN);
+#else
+	void* p = NULL;
+	if (posix_memalign(&p, PARTICLE_ALIGN, nCount * sizeof(float)) != 0)
+		return NULL;
+	return (float*)p;
+#endif
+}
+
+static void Particle_Free(float* p)
+{
+#ifdef _WIN32
+	_aligned_free(p);
+#else
+	free(p);
+#endif
+}
+
+// small LCG so bursts are reproducible for a given seed
+static float Particle_Random(void)
+{
+	g_nParticleSeed = g_nParticleSeed * 1664525u + 1013904223u;
+	return (g_nParticleSeed >> 8) * (1.0f / 16777216.0f);
+}
+
+//Particle_Init() : allocates the pool, capacity is rounded up to a multiple of 4
+bool Particle_Init(int nCapacity)
+{
+	Particle_Release();
+
+	nCapacity = (nCapacity + 3) & ~3;
+
+	g_pX = Particle_Alloc(nCapacity);
+	g_pY = Particle_Alloc(nCapacity);
+	g_pVX = Particle_Alloc(nCapacity);
+	g_pVY = Particle_Alloc(nCapacity);
+	g_pLife = Particle_Alloc(nCapacity);
+	g_pInvLife = Particle_Alloc(nCapacity);
+	g_pGravity = Particle_Alloc(nCapacity);
+
+	if (!g_pX || !g_pY || !g_pVX || !g_pVY || !g_pLife || !g_pInvLife || !g_pGravity)
+	{
+		Particle_Release();
+		return false;
+	}
+
+	g_nCapacity = nCapacity;
+	Particle_Clear();
+
+	return true;
+}
+
+//Particle_Release() : frees the pool
+void Particle_Release(void)
+{
+	float** arrays[] = { &g_pX, &g_pY, &g_pVX, &g_pVY, &g_pLife, &g_pInvLife, &g_pGravity };
+
+	for (int i = 0; i < (int)(sizeof(arrays) / sizeof(arrays[0])); i++)
+	{
+		if (*arrays[i] != NULL)
+			Particle_Free(*arrays[i]);
+		*arrays[i] = NULL;
+	}
+
+	g_nCapacity = 0;
+	g_nLive = 0;
+}
+
+//Particle_Clear() : kills every particle and resets the counters
+void Particle_Clear(void)
+{
+	g_nLive = 0;
+	memset(&g_ParticleStats, 0, sizeof(g_ParticleStats));
+}
+
+void Particle_Seed(unsigned int nSeed)
+{
+	g_nParticleSeed = nSeed;
+}
+
+//Particle_Spawn() : adds one particle, returns 0 when the pool is full
+int Particle_Spawn(float x, float y, float vx, float vy, float life)
+{
+	if (g_nLive >= g_nCapacity)
+	{
+		g_ParticleStats.nDropped++;
+		return 0;
+	}
+
+	int i = g_nLive++;
+	g_pX[i] = x;
+	g_pY[i] = y;
+	g_pVX[i] = vx;
+	g_pVY[i] = vy;
+	g_pLife[i] = life;
+	g_pInvLife[i] = 1.0f / life;
+	g_pGravity[i] = 0.0f;
+	g_ParticleStats.nSpawned++;
+
+	return 1;
+}
+
+//Particle_Emit() : fires one burst of nEmitter at (x, y), returns the number spawned
+int Particle_Emit(int nEmitter, float x, float y)
+{
+	const PARTICLEEMITTER& emitter = g_Emitters[nEmitter];
+	int nSpawned = 0;
+
+	for (int n = 0; n < emitter.count; n++)
+	{
+		float vx = (Particle_Random() * 2.0f - 1.0f) * emitter.speed;
+		float vy = (Particle_Random() * 2.0f - 1.0f) * emitter.speed;
+		float life = emitter.life + Particle_Random() * emitter.lifeJitter;
+
+		if (Particle_Spawn(x, y, vx, vy, life) == 0)
+			break;
+
+		g_pGravity[g_nLive - 1] = emitter.gravity;
+		nSpawned++;
+	}
+
+	return nSpawned;
+}
+
+//Particle_Update() : integrates every live particle by fElapsed seconds and
+//removes the ones whose lifetime ran out
+void Particle_Update(float fElapsed)
+{
+	int nLive = g_nLive;
+	int i = 0;
+
+#ifdef PARTICLE_SSE2
+	const __m128 dt = _mm_set1_ps(fElapsed);
+
+	for (; i + 4 <= nLive; i += 4)
+	{
+		__m128 vy = _mm_add_ps(_mm_load_ps(g_pVY + i), _mm_mul_ps(_mm_load_ps(g_pGravity + i), dt));
+		__m128 x = _mm_add_ps(_mm_load_ps(g_pX + i), _mm_mul_ps(_mm_load_ps(g_pVX + i), dt));
+		__m128 y = _mm_add_ps(_mm_load_ps(g_pY + i), _mm_mul_ps(vy, dt));
+		__m128 life = _mm_sub_ps(_mm_load_ps(g_pLife + i), dt);
+
+		_mm_store_ps(g_pVY + i, vy);
+		_mm_store_ps(g_pX + i, x);
+		_mm_store_ps(g_pY + i, y);
+		_mm_store_ps(g_pLife + i, life);
+	}
+#endif
+
+	for (; i < nLive; i++)
+	{
+		g_pVY[i] += g_pGravity[i] * fElapsed;
+		g_pX[i] += g_pVX[i] * fElapsed;
+		g_pY[i] += g_pVY[i] * fElapsed;
+		g_pLife[i] -= fElapsed;
+	}
+
+	// compaction: slide survivors down over the dead, keeping their order
+	int nOut = 0;
+	for (i = 0; i < nLive; i++)
+	{
+		if (g_pLife[i] <= 0.0f)
+			continue;
+
+		if (nOut != i)
+		{
+			g_pX[nOut] = g_pX[i];
+			g_pY[nOut] = g_pY[i];
+			g_pVX[nOut] = g_pVX[i];
+			g_pVY[nOut] = g_pVY[i];
+			g_pLife[nOut] = g_pLife[i];
+			g_pInvLife[nOut] = g_pInvLife[i];
+			g_pGravity[nOut] = g_pGravity[i];
+		}
+		nOut++;
+	}
+
+	g_ParticleStats.nDied += nLive - nOut;
+	g_nLive = nOut;
+	g_ParticleStats.nLive = nOut;
+}
+
+int Particle_Count(void)
+{
+	return g_nLive;
+}
+
+const float* Particle_GetX(void)
+{
+	return g_pX;
+}
+
+const float* Particle_GetY(void)
+{
+	return g_pY;
+}
+
+float Particle_GetAge(int i)
+{
+	float age = 1.0f - g_pLife[i] * g_pInvLife[i];
+	return (age < 0.0f) ? 0.0f : (age > 1.0f ? 1.0f : age);
+}
+
+const PARTICLESTATS& Particle_GetStats(void)
+{
+	return g_ParticleStats;
+}
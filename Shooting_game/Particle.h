@@ -0,0 +1,47 @@
+#pragma once
+
+// Particle pool.
+// Live particles are packed at the front of structure-of-arrays storage of
+// fixed capacity. Particle_Update() integrates position, velocity and
+// lifetime four particles at a time with SSE2 and then compacts the dead
+// ones out, so the arrays always hold exactly Particle_Count() particles.
+
+#define PARTICLE_ALIGN 16
+
+enum
+{
+	EMIT_EXPLOSION,      // enemy hit by a bullet or the skill
+	EMIT_HERO_HIT,       // hero ran into an enemy
+	EMIT_NUM
+};
+
+struct PARTICLEEMITTER
+{
+	int count;           // particles per burst
+	float speed;         // initial speed range in pixels per second
+	float gravity;       // downward acceleration in pixels per second^2
+	float life;          // seconds
+	float lifeJitter;    // extra random life, 0..lifeJitter seconds
+};
+
+struct PARTICLESTATS
+{
+	int nLive;
+	int nSpawned;
+	int nDropped;        // requested while the pool was full
+	int nDied;
+};
+
+bool Particle_Init(int nCapacity);
+void Particle_Release(void);
+void Particle_Clear(void);
+void Particle_Seed(unsigned int nSeed);
+int Particle_Emit(int nEmitter, float x, float y);
+int Particle_Spawn(float x, float y, float vx, float vy, float life);
+void Particle_Update(float fElapsed);
+
+int Particle_Count(void);
+const float* Particle_GetX(void);
+const float* Particle_GetY(void);
+float Particle_GetAge(int i);    // 0 at spawn, 1 at death
+const PARTICLESTATS& Particle_GetStats(void);
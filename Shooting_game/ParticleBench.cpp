@@ -0,0 +1,123 @@
+#include "ParticleBench.h"
+#include "Particle.h"
+#include <chrono>
+#include <stdio.h>
+#include <vector>
+
+#define PARTICLEBENCH_COUNT   500000
+#define PARTICLEBENCH_FRAMES  100
+#define PARTICLEBENCH_STEP    (1.0f / 120.0f)
+
+static PARTICLEBENCHREPORT g_pParticleReport;
+static int g_nParticleFailed;
+
+static void ParticleBench_Report(const char* pLine)
+{
+	if (g_pParticleReport != NULL)
+		g_pParticleReport(pLine);
+}
+
+static double ParticleBench_Seconds(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// the pool full of particles spread over the screen; every second one
+// lives for fShortLife, the others for a minute
+static void ParticleBench_Fill(float fShortLife)
+{
+	Particle_Clear();
+	Particle_Seed(1);
+
+	for (int i = 0; i < PARTICLEBENCH_COUNT; i++)
+	{
+		float f = (float)i / PARTICLEBENCH_COUNT;
+		Particle_Spawn(f * 800.0f, (1.0f - f) * 600.0f, f * 120.0f - 60.0f, 60.0f - f * 120.0f, (i & 1) ? 60.0f : fShortLife);
+	}
+}
+
+// one update against the same sums done particle by particle, then a
+// compaction that has to keep exactly the odd particles in order
+static void ParticleBench_Check(void)
+{
+	char line[256];
+
+	ParticleBench_Fill(PARTICLEBENCH_STEP * 0.5f);
+	std::vector<float> x(Particle_GetX(), Particle_GetX() + PARTICLEBENCH_COUNT);
+	std::vector<float> y(Particle_GetY(), Particle_GetY() + PARTICLEBENCH_COUNT);
+	for (int i = 0; i < PARTICLEBENCH_COUNT; i++)
+	{
+		float f = (float)i / PARTICLEBENCH_COUNT;
+		x[i] += (f * 120.0f - 60.0f) * PARTICLEBENCH_STEP;
+		y[i] += (60.0f - f * 120.0f) * PARTICLEBENCH_STEP;
+	}
+
+	Particle_Update(PARTICLEBENCH_STEP);
+
+	int nWrong = 0;
+	if (Particle_Count() != PARTICLEBENCH_COUNT / 2 || Particle_GetStats().nDied != PARTICLEBENCH_COUNT / 2)
+		nWrong++;
+	for (int i = 0; nWrong == 0 && i < Particle_Count(); i++)
+	{
+		if (Particle_GetX()[i] != x[i * 2 + 1] || Particle_GetY()[i] != y[i * 2 + 1])
+			nWrong++;
+	}
+	if (nWrong != 0)
+	{
+		sprintf(line, "particlebench: the update kept %d of %d particles, or moved them wrong\n", Particle_Count(), PARTICLEBENCH_COUNT);
+		ParticleBench_Report(line);
+		g_nParticleFailed++;
+	}
+
+	// a full pool drops the rest of a burst
+	ParticleBench_Fill(60.0f);
+	if (Particle_Emit(EMIT_EXPLOSION, 0.0f, 0.0f) != 0 || Particle_GetStats().nDropped != 1)
+		g_nParticleFailed++;
+}
+
+int ParticleBench_Run(PARTICLEBENCHREPORT pReport)
+{
+	char line[256];
+	g_pParticleReport = pReport;
+	g_nParticleFailed = 0;
+
+	if (!Particle_Init(PARTICLEBENCH_COUNT))
+	{
+		ParticleBench_Report("particlebench: could not allocate the pool\n");
+		return 1;
+	}
+
+	ParticleBench_Check();
+
+	// nothing dies: the integration and a compaction that moves nothing
+	ParticleBench_Fill(60.0f);
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for (int frame = 0; frame < PARTICLEBENCH_FRAMES; frame++)
+		Particle_Update(PARTICLEBENCH_STEP);
+	double fSteady = ParticleBench_Seconds(start) / PARTICLEBENCH_FRAMES;
+
+	// half of them die in the first update and the rest slide down over them
+	double fDying = 0.0;
+	for (int frame = 0; frame < PARTICLEBENCH_FRAMES / 10; frame++)
+	{
+		ParticleBench_Fill(PARTICLEBENCH_STEP * 0.5f);
+		start = std::chrono::steady_clock::now();
+		Particle_Update(PARTICLEBENCH_STEP);
+		fDying += ParticleBench_Seconds(start);
+	}
+	fDying /= PARTICLEBENCH_FRAMES / 10;
+
+	sprintf(line, "particlebench: %d particles, update %.2f ms (%.2f ns each), with half dying %.2f ms\n",
+		PARTICLEBENCH_COUNT, fSteady * 1e3, fSteady * 1e9 / PARTICLEBENCH_COUNT, fDying * 1e3);
+	ParticleBench_Report(line);
+
+	// keeps the timed loops from being thrown away
+	if (Particle_Count() != PARTICLEBENCH_COUNT / 2)
+		g_nParticleFailed++;
+
+	Particle_Release();
+
+	sprintf(line, "particlebench: %d checks failed\n", g_nParticleFailed);
+	ParticleBench_Report(line);
+	return g_nParticleFailed;
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+// Particle pool checks and timings.
+// Free of Windows like Particle.cpp, so the same run works from the game's
+// "-particlebench" mode and from a two line main() on any platform. The
+// checks compare an update of the whole pool with the same arithmetic done
+// one particle at a time, and make sure the compaction keeps exactly the
+// survivors in order. The timings fill the pool with 500000 particles and
+// time Particle_Update() with nothing dying, then with half of them dying.
+// Every line of the report goes through the callback.
+
+typedef void (*PARTICLEBENCHREPORT)(const char* pLine);
+
+int ParticleBench_Run(PARTICLEBENCHREPORT pReport);    // returns the number of failed checks
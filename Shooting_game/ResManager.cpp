@@ -0,0 +1,380 @@
+#include "ResManager.h"
+#include "Loader.h"
+#include <stdio.h>
+#include <string.h>
+
+struct RESENTRY
+{
+	WCHAR szFile[MAX_PATH];    // empty for a free slot
+	UINT width;
+	UINT height;
+	D3DFORMAT format;
+	D3DCOLOR colorKey;
+	int category;
+	int group;
+	LPDIRECT3DTEXTURE9 pTexture;    // the loader's target, NULL while loading and after eviction
+	LPDIRECT3DTEXTURE9 pCounted;    // the texture nBytes was measured on
+	size_t nBytes;
+	int nRefs;
+	unsigned int generation;
+	unsigned int lastUsed;          // frame of the last Res_GetTexture()
+	bool bEvicted;
+};
+
+static RESENTRY g_ResEntries[RES_MAX_TEXTURES];
+static const char* g_pResCategories[RES_MAX_CATEGORIES];
+static RESSTATS g_ResStats;
+static unsigned int g_nResFrame = 0;
+
+static RESENTRY* Res_Lookup(TEXTUREHANDLE handle)
+{
+	unsigned int slot = (handle.value & 0xffff) - 1;
+
+	if (handle.value == 0 || slot >= RES_MAX_TEXTURES)
+		return NULL;
+
+	RESENTRY* pEntry = &g_ResEntries[slot];
+	if (pEntry->szFile[0] == 0 || pEntry->generation != (handle.value >> 16) || pEntry->bEvicted)
+		return NULL;
+
+	return pEntry;
+}
+
+static TEXTUREHANDLE Res_MakeHandle(const RESENTRY* pEntry)
+{
+	TEXTUREHANDLE handle;
+
+	handle.value = pEntry->generation << 16 | (unsigned int)(pEntry - g_ResEntries + 1);
+
+	return handle;
+}
+
+//Res_TextureBytes() : memory of every level of a texture, from the level sizes and the format
+static size_t Res_TextureBytes(LPDIRECT3DTEXTURE9 pTexture)
+{
+	size_t nBytes = 0;
+	DWORD levels = pTexture->GetLevelCount();
+
+	for (DWORD i = 0; i < levels; i++)
+	{
+		D3DSURFACE_DESC desc;
+		if (FAILED(pTexture->GetLevelDesc(i, &desc)))
+			break;
+
+		size_t blocks = (size_t)((desc.Width + 3) / 4) * ((desc.Height + 3) / 4);
+		switch (desc.Format)
+		{
+		case D3DFMT_DXT1:
+			nBytes += blocks * 8;
+			break;
+		case D3DFMT_DXT2:
+		case D3DFMT_DXT3:
+		case D3DFMT_DXT4:
+		case D3DFMT_DXT5:
+			nBytes += blocks * 16;
+			break;
+		case D3DFMT_R5G6B5:
+		case D3DFMT_X1R5G5B5:
+		case D3DFMT_A1R5G5B5:
+		case D3DFMT_A4R4G4B4:
+		case D3DFMT_A8L8:
+			nBytes += (size_t)desc.Width * desc.Height * 2;
+			break;
+		case D3DFMT_A8:
+		case D3DFMT_L8:
+		case D3DFMT_P8:
+			nBytes += (size_t)desc.Width * desc.Height;
+			break;
+		default:
+			nBytes += (size_t)desc.Width * desc.Height * 4;
+			break;
+		}
+	}
+
+	return nBytes;
+}
+
+//Res_Evict() : releases the texture but keeps the slot, so the file can be loaded again
+static void Res_Evict(RESENTRY* pEntry)
+{
+	char szReport[MAX_PATH + 64];
+	sprintf_s(szReport, sizeof(szReport), "res: evicted %ls (%u KB)\n", pEntry->szFile, (unsigned int)(pEntry->nBytes >> 10));
+	OutputDebugStringA(szReport);
+
+	g_ResStats.nBytes -= pEntry->nBytes;
+	g_ResStats.nEvicted++;
+
+	pEntry->pTexture->Release();
+	pEntry->pTexture = NULL;
+	pEntry->pCounted = NULL;
+	pEntry->nBytes = 0;
+	pEntry->generation = (pEntry->generation + 1) & 0xffff;
+	if (pEntry->generation == 0)
+		pEntry->generation = 1;
+	pEntry->bEvicted = true;
+}
+
+bool Res_Init(size_t nBudget)
+{
+	memset(g_ResEntries, 0, sizeof(g_ResEntries));
+	memset(g_pResCategories, 0, sizeof(g_pResCategories));
+	memset(&g_ResStats, 0, sizeof(g_ResStats));
+	g_ResStats.nBudget = nBudget;
+	g_nResFrame = 0;
+
+	return true;
+}
+
+void Res_SetCategoryName(int category, const char* pName)
+{
+	if (category >= 0 && category < RES_MAX_CATEGORIES)
+		g_pResCategories[category] = pName;
+}
+
+//Res_AcquireTexture() : a new reference to the texture of the file; the first
+//acquisition queues it on the loader with these parameters, later ones share it
+TEXTUREHANDLE Res_AcquireTexture(LPCWSTR pFile, UINT width, UINT height, D3DFORMAT format, D3DCOLOR colorKey,
+	int category, int group)
+{
+	TEXTUREHANDLE none = { 0 };
+	RESENTRY* pFree = NULL;
+
+	if (category < 0 || category >= RES_MAX_CATEGORIES)
+		return none;
+
+	for (int i = 0; i < RES_MAX_TEXTURES; i++)
+	{
+		RESENTRY* pEntry = &g_ResEntries[i];
+
+		if (pEntry->szFile[0] == 0)
+		{
+			if (pFree == NULL)
+				pFree = pEntry;
+			continue;
+		}
+		if (_wcsicmp(pEntry->szFile, pFile) != 0)
+			continue;
+
+		// the slot and the loader still know the file, it only has to be read again
+		if (pEntry->bEvicted)
+		{
+			if (!Loader_Reload(pFile) && !Loader_Queue(pFile, pEntry->width, pEntry->height, pEntry->format,
+				pEntry->colorKey, &pEntry->pTexture, pEntry->group))
+				return none;
+			pEntry->bEvicted = false;
+			g_ResStats.nReloaded++;
+		}
+
+		pEntry->nRefs++;
+		pEntry->lastUsed = g_nResFrame;
+		return Res_MakeHandle(pEntry);
+	}
+
+	if (pFree == NULL)
+		return none;
+
+	if (!Loader_Queue(pFile, width, height, format, colorKey, &pFree->pTexture, group))
+		return none;
+
+	unsigned int generation = pFree->generation != 0 ? pFree->generation : 1;
+	memset(pFree, 0, sizeof(RESENTRY));
+	wcsncpy_s(pFree->szFile, MAX_PATH, pFile, _TRUNCATE);
+	pFree->width = width;
+	pFree->height = height;
+	pFree->format = format;
+	pFree->colorKey = colorKey;
+	pFree->category = category;
+	pFree->group = group;
+	pFree->nRefs = 1;
+	pFree->generation = generation;
+	pFree->lastUsed = g_nResFrame;
+
+	return Res_MakeHandle(pFree);
+}
+
+void Res_AddRef(TEXTUREHANDLE handle)
+{
+	RESENTRY* pEntry = Res_Lookup(handle);
+
+	if (pEntry != NULL)
+		pEntry->nRefs++;
+}
+
+//Res_Release() : drops a reference; a texture nobody holds stays resident
+//until the budget needs its memory
+void Res_Release(TEXTUREHANDLE* pHandle)
+{
+	RESENTRY* pEntry = Res_Lookup(*pHandle);
+
+	if (pEntry != NULL && pEntry->nRefs > 0)
+	{
+		pEntry->nRefs--;
+		pEntry->lastUsed = g_nResFrame;
+	}
+
+	pHandle->value = 0;
+}
+
+LPDIRECT3DTEXTURE9 Res_GetTexture(TEXTUREHANDLE handle)
+{
+	RESENTRY* pEntry = Res_Lookup(handle);
+
+	if (pEntry == NULL)
+		return NULL;
+
+	pEntry->lastUsed = g_nResFrame;
+
+	return pEntry->pTexture;
+}
+
+bool Res_IsValid(TEXTUREHANDLE handle)
+{
+	return Res_Lookup(handle) != NULL;
+}
+
+//Res_Trim() : evicts unreferenced textures, oldest use first, until at most
+//nBytes are resident; returns how many were evicted
+int Res_Trim(size_t nBytes)
+{
+	int nEvicted = 0;
+
+	while (g_ResStats.nBytes > nBytes)
+	{
+		RESENTRY* pOldest = NULL;
+
+		for (int i = 0; i < RES_MAX_TEXTURES; i++)
+		{
+			RESENTRY* pEntry = &g_ResEntries[i];
+
+			if (pEntry->szFile[0] == 0 || pEntry->nRefs > 0 || pEntry->pTexture == NULL)
+				continue;
+			if (pOldest == NULL || (int)(pEntry->lastUsed - pOldest->lastUsed) < 0)
+				pOldest = pEntry;
+		}
+
+		// everything left is in use, the budget is only a target
+		if (pOldest == NULL)
+			break;
+
+		Res_Evict(pOldest);
+		nEvicted++;
+	}
+
+	return nEvicted;
+}
+
+//Res_Update() : measures textures the loader handed over or swapped since the
+//last call, then evicts unreferenced textures, oldest use first, while the
+//resident total is over the budget
+void Res_Update(void)
+{
+	for (int i = 0; i < RES_MAX_TEXTURES; i++)
+	{
+		RESENTRY* pEntry = &g_ResEntries[i];
+
+		if (pEntry->szFile[0] == 0 || pEntry->pTexture == pEntry->pCounted)
+			continue;
+
+		g_ResStats.nBytes -= pEntry->nBytes;
+		pEntry->nBytes = pEntry->pTexture != NULL ? Res_TextureBytes(pEntry->pTexture) : 0;
+		pEntry->pCounted = pEntry->pTexture;
+		g_ResStats.nBytes += pEntry->nBytes;
+	}
+
+	if (g_ResStats.nBytes > g_ResStats.nPeakBytes)
+		g_ResStats.nPeakBytes = g_ResStats.nBytes;
+
+	if (g_ResStats.nBudget != 0)
+		Res_Trim(g_ResStats.nBudget);
+
+	g_nResFrame++;
+}
+
+const RESSTATS& Res_GetStats(void)
+{
+	return g_ResStats;
+}
+
+RESCATEGORYSTATS Res_GetCategoryStats(int category)
+{
+	RESCATEGORYSTATS stats;
+
+	memset(&stats, 0, sizeof(stats));
+	if (category < 0 || category >= RES_MAX_CATEGORIES)
+		return stats;
+
+	stats.pName = g_pResCategories[category];
+	for (int i = 0; i < RES_MAX_TEXTURES; i++)
+	{
+		const RESENTRY& entry = g_ResEntries[i];
+
+		if (entry.szFile[0] == 0 || entry.category != category || entry.pTexture == NULL)
+			continue;
+
+		stats.nResident++;
+		if (entry.nRefs > 0)
+			stats.nReferenced++;
+		stats.nBytes += entry.nBytes;
+	}
+
+	return stats;
+}
+
+//Res_Shutdown() : releases every texture; references nobody gave back and
+//textures something else still holds are written to the debug output
+int Res_Shutdown(void)
+{
+	char szReport[MAX_PATH + 96];
+	int nLeaks = 0;
+
+	for (int i = 0; i < RES_MAX_CATEGORIES; i++)
+	{
+		RESCATEGORYSTATS stats = Res_GetCategoryStats(i);
+		if (stats.nResident == 0)
+			continue;
+
+		sprintf_s(szReport, sizeof(szReport), "res: %s, %d textures, %u KB\n", stats.pName != NULL ? stats.pName : "(unnamed)",
+			stats.nResident, (unsigned int)(stats.nBytes >> 10));
+		OutputDebugStringA(szReport);
+	}
+
+	sprintf_s(szReport, sizeof(szReport), "res: peak %u KB, budget %u KB, %d evicted, %d reloaded\n",
+		(unsigned int)(g_ResStats.nPeakBytes >> 10), (unsigned int)(g_ResStats.nBudget >> 10), g_ResStats.nEvicted, g_ResStats.nReloaded);
+	OutputDebugStringA(szReport);
+
+	for (int i = 0; i < RES_MAX_TEXTURES; i++)
+	{
+		RESENTRY* pEntry = &g_ResEntries[i];
+		bool bLeaked = false;
+
+		if (pEntry->szFile[0] == 0)
+			continue;
+
+		if (pEntry->nRefs > 0)
+		{
+			sprintf_s(szReport, sizeof(szReport), "res: leak: %ls still has %d references\n", pEntry->szFile, pEntry->nRefs);
+			OutputDebugStringA(szReport);
+			bLeaked = true;
+		}
+
+		if (pEntry->pTexture != NULL)
+		{
+			ULONG nOther = pEntry->pTexture->Release();
+			if (nOther != 0)
+			{
+				sprintf_s(szReport, sizeof(szReport), "res: leak: %ls is still held %lu more times outside the manager\n",
+					pEntry->szFile, nOther);
+				OutputDebugStringA(szReport);
+				bLeaked = true;
+			}
+		}
+
+		if (bLeaked)
+			nLeaks++;
+	}
+
+	memset(g_ResEntries, 0, sizeof(g_ResEntries));
+	g_ResStats.nBytes = 0;
+
+	return nLeaks;
+}
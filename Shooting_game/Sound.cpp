@@ -1,54 +1,156 @@
 #include "Sound.h"
+#include <chrono>
+#include <math.h>
 
+// music is decoded from the file while it plays instead of all at once,
+// so it costs a small stream buffer however long the track is
+#define FMOD_BGFLAGS (FMOD_CREATESTREAM | FMOD_LOOP_NORMAL)
+
+// repeats of an effect closer than this are one sound
+#define EFF_COOLDOWN 0.03f
+
+static float Sound_Now(void)
+{
+	static const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	return std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+}
+
+// FMOD takes a volume and a pan; with the square-root pan law the volume
+// squared is left^2 + right^2 and the pan is their difference over it
+static void Sound_SetGains(FMOD_CHANNEL* pChannel, float fLeft, float fRight)
+{
+	float fPower = fLeft * fLeft + fRight * fRight;
+	FMOD_Channel_SetVolume(pChannel, sqrtf(fPower));
+	FMOD_Channel_SetPan(pChannel, fPower > 0.0f ? (fRight * fRight - fLeft * fLeft) / fPower : 0.0f);
+}
+
+// FMOD is opened by Init(), so a global CSound costs nothing before main
 CSound::CSound(void)
 {
-	FMOD_System_Create(&gSystem);
-	FMOD_System_Init(gSystem, 32, FMOD_INIT_NORMAL, NULL);
+	gSystem = NULL;
+	ppBGsound = NULL;
+	ppEFFsound = NULL;
+	ppBGchannel = NULL;
+	nBGsoundcount = 0;
+	nEFFsoundcount = 0;
+	pBGfilename = NULL;
+	pEFFfilename = NULL;
+	Voice_Init(&effVoices, 0);
 }
 
 CSound::~CSound(void)
 {
+	if (gSystem == NULL)
+		return;
+
 	FMOD_System_Close(gSystem);
 	FMOD_System_Release(gSystem);
 }
 
+// opens the output device, can run on any thread as long as nothing else uses the object meanwhile
+bool CSound::Init(int nChannels)
+{
+	FMOD_SYSTEM* pSystem = NULL;
+
+	if (FMOD_System_Create(&pSystem) != FMOD_OK)
+		return false;
+	// without an output device the system still decodes, for tools and headless runs
+	if (FMOD_System_Init(pSystem, nChannels, FMOD_INIT_NORMAL, NULL) != FMOD_OK &&
+		(FMOD_System_SetOutput(pSystem, FMOD_OUTPUTTYPE_NOSOUND) != FMOD_OK ||
+		FMOD_System_Init(pSystem, nChannels, FMOD_INIT_NORMAL, NULL) != FMOD_OK))
+	{
+		FMOD_System_Release(pSystem);
+		return false;
+	}
+
+	// one channel stays with the music
+	Voice_Init(&effVoices, nChannels - 1);
+	gSystem = pSystem;
+	return true;
+}
+
 void CSound::CreateBGsound(int nCount, string *SoundFileName)
 {
 	nBGsoundcount = nCount;
 	ppBGsound = new FMOD_SOUND*[nCount];
 	ppBGchannel = new FMOD_CHANNEL*[nCount];
+	pBGfilename = new string[nCount];
 
 	for (int i = 0; i < nCount; i++)
-		FMOD_System_CreateSound(gSystem, SoundFileName[i].data(), FMOD_LOOP_NORMAL, 0, &ppBGsound[i]);
+	{
+		pBGfilename[i] = SoundFileName[i];
+		FMOD_System_CreateSound(gSystem, SoundFileName[i].data(), FMOD_BGFLAGS, 0, &ppBGsound[i]);
+	}
 }
 
 void CSound::CreateEFFsound(int nCount, string *SoundFileName)
 {
 	nEFFsoundcount = nCount;
 	ppEFFsound = new FMOD_SOUND*[nCount];
+	pEFFfilename = new string[nCount];
 
 	for (int i = 0; i < nCount; i++)
 	{
-		FMOD_Channel_SetVolume(ppBGchannel[i], 1.0f);
+		pEFFfilename[i] = SoundFileName[i];
 		FMOD_System_CreateSound(gSystem, SoundFileName[i].data(), FMOD_DEFAULT, 0, &ppEFFsound[i]);
+
+		unsigned int nLength = 0;
+		FMOD_Sound_GetLength(ppEFFsound[i], &nLength, FMOD_TIMEUNIT_MS);
+		Voice_SetSound(&effVoices, i, 0, 4, EFF_COOLDOWN, nLength / 1000.0f);
 	}
 }
 
-void CSound::PlaySoundEFF(int nindex)
+// higher priorities steal channels from lower ones when all are busy
+void CSound::SetEFFLimit(int nindex, int nPriority, int nMaxInstances, float fCooldown)
 {
 	if (nindex < nEFFsoundcount)
+		Voice_SetSound(&effVoices, nindex, nPriority, nMaxInstances, fCooldown, effVoices.sounds[nindex].length);
+}
+
+//PlaySoundEFF() : x and y are where the effect happens, in screen pixels; a
+//coalesced trigger moves the playing instance there
+void CSound::PlaySoundEFF(int nindex, float x, float y, float fVolume)
+{
+	if (nindex >= nEFFsoundcount)
+		return;
+
+	VOICETRIGGER trigger = Voice_Trigger(&effVoices, nindex, fVolume, Sound_Now());
+	if (trigger.voice < 0)
+		return;
+
+	effX[trigger.voice] = x;
+	effY[trigger.voice] = y;
+
+	float fLeft, fRight;
+	Spatial_Gains(&x, &y, &effVoices.voices[trigger.voice].volume, 1, &fLeft, &fRight);
+
+	if (trigger.bCoalesced)
+	{
+		Sound_SetGains(pEFFchannel[trigger.voice], fLeft, fRight);
+		return;
+	}
+
+	if (trigger.stolen >= 0)
+		FMOD_Channel_Stop(pEFFchannel[trigger.stolen]);
+
+	// started paused so the volume is set before the first sample
+	FMOD_CHANNEL* pChannel = NULL;
+	if (FMOD_System_PlaySound(gSystem, ppEFFsound[nindex], 0, 1, &pChannel) != FMOD_OK)
 	{
-		FMOD_CHANNEL *pChannel;
-		FMOD_Channel_SetVolume(pChannel, 1.0f);
-		FMOD_System_PlaySound(gSystem, ppEFFsound[nindex], 0, 0, &pChannel);
+		Voice_Free(&effVoices, trigger.voice);
+		return;
 	}
+	Sound_SetGains(pChannel, fLeft, fRight);
+	FMOD_Channel_SetPaused(pChannel, 0);
+	pEFFchannel[trigger.voice] = pChannel;
 }
 
 void CSound::PlaySoundBG(int nindex)
 {
 	if (nindex < nBGsoundcount)
 	{
-		FMOD_System_PlaySound(gSystem, ppEFFsound[nindex], 0, 0, &ppBGchannel[nindex]);
+		FMOD_System_PlaySound(gSystem, ppBGsound[nindex], 0, 0, &ppBGchannel[nindex]);
 	}
 }
 
@@ -60,6 +162,70 @@ void CSound::StopSoundBG(int nindex)
 	}
 }
 
+// recreates every sound loaded from the file, a playing background is restarted
+bool CSound::ReloadSound(const char* pFileName)
+{
+	bool bFound = false;
+	int i;
+
+	for (i = 0; i < nBGsoundcount; i++)
+	{
+		if (pBGfilename[i] != pFileName)
+			continue;
+
+		FMOD_BOOL bPlaying = 0;
+		FMOD_Channel_IsPlaying(ppBGchannel[i], &bPlaying);
+		FMOD_Channel_Stop(ppBGchannel[i]);
+		FMOD_Sound_Release(ppBGsound[i]);
+		FMOD_System_CreateSound(gSystem, pFileName, FMOD_BGFLAGS, 0, &ppBGsound[i]);
+		if (bPlaying)
+			PlaySoundBG(i);
+		bFound = true;
+	}
+
+	for (i = 0; i < nEFFsoundcount; i++)
+	{
+		if (pEFFfilename[i] != pFileName)
+			continue;
+
+		FMOD_Sound_Release(ppEFFsound[i]);
+		FMOD_System_CreateSound(gSystem, pFileName, FMOD_DEFAULT, 0, &ppEFFsound[i]);
+		bFound = true;
+	}
+
+	return bFound;
+}
+
+// decodes a whole file to 16-bit PCM, for building sound banks
+bool CSound::DecodeSound(const char* pFileName, vector<short>* pSamples, int* pnChannels, int* pnRate)
+{
+	FMOD_SOUND* pSound = NULL;
+	FMOD_SOUND_FORMAT format;
+	int nChannels = 0, nBits = 0;
+	float fRate = 0.0f;
+	unsigned int nBytes = 0, nRead = 0;
+
+	if (FMOD_System_CreateSound(gSystem, pFileName, FMOD_OPENONLY, 0, &pSound) != FMOD_OK)
+		return false;
+
+	bool bOk = FMOD_Sound_GetFormat(pSound, NULL, &format, &nChannels, &nBits) == FMOD_OK &&
+		format == FMOD_SOUND_FORMAT_PCM16 && (nChannels == 1 || nChannels == 2) &&
+		FMOD_Sound_GetDefaults(pSound, &fRate, NULL) == FMOD_OK &&
+		FMOD_Sound_GetLength(pSound, &nBytes, FMOD_TIMEUNIT_PCMBYTES) == FMOD_OK && nBytes > 0;
+
+	if (bOk)
+	{
+		pSamples->resize(nBytes / 2);
+		bOk = FMOD_Sound_ReadData(pSound, &(*pSamples)[0], nBytes, &nRead) == FMOD_OK || nRead > 0;
+		pSamples->resize(nRead / 2);
+		*pnChannels = nChannels;
+		*pnRate = (int)fRate;
+	}
+
+	FMOD_Sound_Release(pSound);
+	return bOk && nRead > 0;
+}
+
 void CSound::ReleaseSound()
 {
 	int i;
@@ -69,13 +235,72 @@ void CSound::ReleaseSound()
 	for (i = 0; i < nBGsoundcount; i++)
 		FMOD_Sound_Release(ppBGsound[i]);
 	delete[] ppBGsound;
-	for (i = 0; i < nBGsoundcount; i++)
+	for (i = 0; i < nEFFsoundcount; i++)
 		FMOD_Sound_Release(ppEFFsound[i]);
 	delete[] ppEFFsound;
+	delete[] pBGfilename;
+	delete[] pEFFfilename;
 }
 
 void CSound::Update()
 {
-	if (!gSystem)
-		FMOD_System_Update(gSystem);
+	if (gSystem == NULL)
+		return;
+	FMOD_System_Update(gSystem);
+
+
+	// channels that finished give their voice back
+	for (int i = 0; i < effVoices.nVoices; i++)
+	{
+		if (effVoices.voices[i].sound < 0)
+			continue;
+
+		FMOD_BOOL bPlaying = 0;
+		if (FMOD_Channel_IsPlaying(pEFFchannel[i], &bPlaying) != FMOD_OK || !bPlaying)
+			Voice_Free(&effVoices, i);
+	}
+
+	// the effects still playing are placed in one pass, once a tick
+	float x[VOICE_MAX_VOICES], y[VOICE_MAX_VOICES], volume[VOICE_MAX_VOICES];
+	float left[VOICE_MAX_VOICES], right[VOICE_MAX_VOICES];
+	int placed[VOICE_MAX_VOICES];
+	int nPlaced = 0;
+	for (int i = 0; i < effVoices.nVoices; i++)
+	{
+		if (effVoices.voices[i].sound < 0)
+			continue;
+		x[nPlaced] = effX[i];
+		y[nPlaced] = effY[i];
+		volume[nPlaced] = effVoices.voices[i].volume;
+		placed[nPlaced++] = i;
+	}
+
+	Spatial_Gains(x, y, volume, nPlaced, left, right);
+	for (int i = 0; i < nPlaced; i++)
+		Sound_SetGains(pEFFchannel[placed[i]], left[i], right[i]);
+}
+
+//GetStats() : false until Init()
+bool CSound::GetStats(SOUNDSTATS* pStats)
+{
+	if (gSystem == NULL)
+		return false;
+
+	float fDSP, fStream, fGeometry, fUpdate;
+	unsigned int nBufferLength = 0;
+	int nBuffers = 0;
+	int nRate = 0;
+
+	if (FMOD_System_GetCPUUsage(gSystem, &fDSP, &fStream, &fGeometry, &fUpdate, &pStats->fCPU) != FMOD_OK)
+		pStats->fCPU = 0.0f;
+	FMOD_System_GetDSPBufferSize(gSystem, &nBufferLength, &nBuffers);
+	FMOD_System_GetSoftwareFormat(gSystem, &nRate, NULL, NULL);
+	pStats->fBufferTime = nRate > 0 ? nBufferLength * nBuffers * 1000.0f / nRate : 0.0f;
+	pStats->nEffects = Voice_Count(&effVoices);
+	return true;
+}
+
+const VOICESTATS& CSound::GetVoiceStats() const
+{
+	return effVoices.stats;
 }
\ No newline at end of file
@@ -1,8 +1,18 @@
 #pragma once
 #include <fmod.h>
+#include "Voice.h"
+#include "Spatial.h"
 #include <string>
+#include <vector>
 using namespace std;
 
+struct SOUNDSTATS
+{
+	float fCPU;           // FMOD's mixer, percent of a core
+	float fBufferTime;    // milliseconds of output buffered, how long a triggered sound takes to be heard
+	int nEffects;         // effect channels playing
+};
+
 class CSound
 {
 private:
@@ -12,15 +22,27 @@ private:
 	FMOD_CHANNEL** ppBGchannel;
 	int nBGsoundcount;
 	int nEFFsoundcount;
+	string* pBGfilename;
+	string* pEFFfilename;
+	VOICEPOOL effVoices;    // which effects own a channel
+	FMOD_CHANNEL* pEFFchannel[VOICE_MAX_VOICES];
+	float effX[VOICE_MAX_VOICES];    // where each voice's effect was triggered, placed by Spatial_Gains()
+	float effY[VOICE_MAX_VOICES];
 
 public:
+	bool Init(int nChannels);
 	void CreateEFFsound(int nCount, string *SoundFileName);
 	void CreateBGsound(int nCount, string *SoundFileName);
-	void PlaySoundEFF(int nindex);
+	void SetEFFLimit(int nindex, int nPriority, int nMaxInstances, float fCooldown);
+	void PlaySoundEFF(int nindex, float x, float y, float fVolume = 1.0f);
 	void PlaySoundBG(int nindex);
 	void StopSoundBG(int nindex);
+	bool ReloadSound(const char* pFileName);
+	bool DecodeSound(const char* pFileName, vector<short>* pSamples, int* pnChannels, int* pnRate);
 	void ReleaseSound();
 	void Update();
+	const VOICESTATS& GetVoiceStats() const;
+	bool GetStats(SOUNDSTATS* pStats);
 
 public:
 	CSound(void);
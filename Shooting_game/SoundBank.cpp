@@ -0,0 +1,210 @@
+#include "SoundBank.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#define SOUNDBANK_LOBES  8
+
+static double SoundBank_Lanczos(double x)
+{
+	if (x < 0.0)
+		x = -x;
+	if (x < 1e-9)
+		return 1.0;
+	if (x >= SOUNDBANK_LOBES)
+		return 0.0;
+
+	double px = 3.14159265358979 * x;
+	return SOUNDBANK_LOBES * sin(px) * sin(px / SOUNDBANK_LOBES) / (px * px);
+}
+
+int SoundBank_ResampledFrames(int nFrames, int inRate, int outRate)
+{
+	return (int)(((long long)nFrames * outRate + inRate - 1) / inRate);
+}
+
+//SoundBank_Resample() : pOut holds SoundBank_ResampledFrames() frames
+//the weights are normalized per sample, so the ends of the sound keep their level
+int SoundBank_Resample(const short* pIn, int nFrames, int nChannels, int inRate, short* pOut, int outRate)
+{
+	int nOut = SoundBank_ResampledFrames(nFrames, inRate, outRate);
+
+	if (inRate == outRate)
+	{
+		memcpy(pOut, pIn, (size_t)nFrames * nChannels * sizeof(short));
+		return nFrames;
+	}
+
+	// going down, the kernel widens to cut what the new rate cannot hold
+	double step = (double)inRate / outRate;
+	double scale = step > 1.0 ? 1.0 / step : 1.0;
+	int radius = (int)ceil(SOUNDBANK_LOBES / scale);
+
+	for (int i = 0; i < nOut; i++)
+	{
+		double t = i * step;
+		int center = (int)floor(t);
+		double sum[2] = { 0.0, 0.0 };
+		double weights = 0.0;
+
+		for (int j = center - radius + 1; j <= center + radius; j++)
+		{
+			if (j < 0 || j >= nFrames)
+				continue;
+
+			double w = SoundBank_Lanczos((t - j) * scale);
+			weights += w;
+			for (int c = 0; c < nChannels; c++)
+				sum[c] += w * pIn[j * nChannels + c];
+		}
+
+		for (int c = 0; c < nChannels; c++)
+		{
+			double s = weights != 0.0 ? sum[c] / weights : 0.0;
+			s = s < -32768.0 ? -32768.0 : s > 32767.0 ? 32767.0 : s;
+			pOut[i * nChannels + c] = (short)floor(s + 0.5);
+		}
+	}
+
+	return nOut;
+}
+
+//SoundBank_Write() : resamples every source to MIXER_RATE and writes the bank
+bool SoundBank_Write(const char* pFile, const SOUNDBANKSOURCE* pSources, int nSources)
+{
+	if (nSources <= 0 || nSources > SOUNDBANK_MAX_SOUNDS)
+		return false;
+
+	SOUNDBANKHEADER header;
+	memset(&header, 0, sizeof(header));
+	header.magic = SOUNDBANK_MAGIC;
+	header.version = SOUNDBANK_VERSION;
+	header.nSounds = nSources;
+	header.sampleRate = MIXER_RATE;
+
+	std::vector<SOUNDBANKENTRY> entries(nSources);
+	std::vector<std::vector<short> > samples(nSources);
+	size_t offset = sizeof(header) + nSources * sizeof(SOUNDBANKENTRY);
+
+	for (int i = 0; i < nSources; i++)
+	{
+		const SOUNDBANKSOURCE& source = pSources[i];
+		if (source.pSamples == NULL || source.nFrames <= 0 || source.sampleRate <= 0 ||
+			(source.nChannels != 1 && source.nChannels != 2) || strlen(source.pName) >= SOUNDBANK_NAME_LEN)
+			return false;
+
+		int nFrames = SoundBank_ResampledFrames(source.nFrames, source.sampleRate, MIXER_RATE);
+		samples[i].resize((size_t)nFrames * source.nChannels);
+		SoundBank_Resample(source.pSamples, source.nFrames, source.nChannels, source.sampleRate, &samples[i][0], MIXER_RATE);
+
+		offset = (offset + SOUNDBANK_ALIGN - 1) & ~(size_t)(SOUNDBANK_ALIGN - 1);
+		SOUNDBANKENTRY& entry = entries[i];
+		memset(&entry, 0, sizeof(entry));
+		strcpy(entry.name, source.pName);
+		entry.offset = (unsigned int)offset;
+		entry.nFrames = nFrames;
+		entry.nChannels = source.nChannels;
+		entry.sourceRate = source.sampleRate;
+		offset += samples[i].size() * sizeof(short);
+	}
+
+	FILE* fp = fopen(pFile, "wb");
+	if (fp == NULL)
+		return false;
+
+	bool bOk = fwrite(&header, sizeof(header), 1, fp) == 1 &&
+		fwrite(&entries[0], sizeof(SOUNDBANKENTRY), nSources, fp) == (size_t)nSources;
+	for (int i = 0; i < nSources && bOk; i++)
+	{
+		static const unsigned char zeros[SOUNDBANK_ALIGN] = { 0 };
+		long pad = (long)entries[i].offset - ftell(fp);
+		bOk = fwrite(zeros, 1, pad, fp) == (size_t)pad &&
+			fwrite(&samples[i][0], sizeof(short), samples[i].size(), fp) == samples[i].size();
+	}
+
+	return fclose(fp) == 0 && bOk;
+}
+
+//SoundBank_Validate() : checks the header and that every entry lies inside the file
+static bool SoundBank_Validate(const SOUNDBANK* pBank)
+{
+	if (pBank->map.nSize < sizeof(SOUNDBANKHEADER))
+		return false;
+
+	const SOUNDBANKHEADER* pHeader = pBank->pHeader;
+	if (pHeader->magic != SOUNDBANK_MAGIC || pHeader->version != SOUNDBANK_VERSION ||
+		pHeader->sampleRate != MIXER_RATE || pHeader->nSounds > SOUNDBANK_MAX_SOUNDS)
+		return false;
+
+	if (pBank->map.nSize < sizeof(SOUNDBANKHEADER) + pHeader->nSounds * sizeof(SOUNDBANKENTRY))
+		return false;
+
+	for (unsigned int i = 0; i < pHeader->nSounds; i++)
+	{
+		const SOUNDBANKENTRY& entry = pBank->pEntries[i];
+
+		if (memchr(entry.name, '\0', SOUNDBANK_NAME_LEN) == NULL || entry.offset % SOUNDBANK_ALIGN != 0 ||
+			(entry.nChannels != 1 && entry.nChannels != 2) || entry.offset > pBank->map.nSize ||
+			(size_t)entry.nFrames * entry.nChannels * sizeof(short) > pBank->map.nSize - entry.offset)
+			return false;
+	}
+
+	return true;
+}
+
+bool SoundBank_Open(const char* pFile, SOUNDBANK* pBank)
+{
+	memset(pBank, 0, sizeof(*pBank));
+
+	if (!FileMap_Open(pFile, &pBank->map))
+		return false;
+
+	pBank->pHeader = (const SOUNDBANKHEADER*)pBank->map.pBase;
+	pBank->pEntries = (const SOUNDBANKENTRY*)(pBank->map.pBase + sizeof(SOUNDBANKHEADER));
+
+	if (!SoundBank_Validate(pBank))
+	{
+		SoundBank_Close(pBank);
+		return false;
+	}
+
+	for (unsigned int i = 0; i < pBank->pHeader->nSounds; i++)
+	{
+		const SOUNDBANKENTRY& entry = pBank->pEntries[i];
+		MIXERSOUND& sound = pBank->sounds[i];
+		sound.pSamples = (const short*)(pBank->map.pBase + entry.offset);
+		sound.nFrames = entry.nFrames;
+		sound.nChannels = entry.nChannels;
+	}
+
+	return true;
+}
+
+int SoundBank_Find(const SOUNDBANK* pBank, const char* pName)
+{
+	if (pBank->map.pBase == NULL)
+		return -1;
+
+	for (unsigned int i = 0; i < pBank->pHeader->nSounds; i++)
+	{
+		if (strcmp(pBank->pEntries[i].name, pName) == 0)
+			return i;
+	}
+
+	return -1;
+}
+
+const MIXERSOUND* SoundBank_GetSound(const SOUNDBANK* pBank, int sound)
+{
+	if (pBank->map.pBase == NULL || sound < 0 || (unsigned int)sound >= pBank->pHeader->nSounds)
+		return NULL;
+
+	return &pBank->sounds[sound];
+}
+
+void SoundBank_Close(SOUNDBANK* pBank)
+{
+	FileMap_Close(&pBank->map);
+	memset(pBank, 0, sizeof(*pBank));
+}
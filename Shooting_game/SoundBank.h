@@ -0,0 +1,65 @@
+#pragma once
+#include <stddef.h>
+#include "Mixer.h"
+#include "FileMap.h"
+
+// Sound effect bank (.sbk).
+// Short effects are decoded and resampled once, when the bank is built,
+// to what the mixer plays: 16-bit PCM at MIXER_RATE. The bank is one file
+// of named entries with their samples 16-byte aligned, so SoundBank_Open()
+// maps it and hands out MIXERSOUNDs that point into the mapping; triggering
+// an effect from a bank does no decoding, copying or allocation.
+// Sources are 16-bit PCM at any rate, mono or stereo. Resampling uses a
+// windowed sinc (Lanczos, 8 lobes) that also low-passes when the rate goes
+// down.
+
+#define SOUNDBANK_MAGIC       0x4b4e4253    // 'SBNK'
+#define SOUNDBANK_VERSION     1
+#define SOUNDBANK_MAX_SOUNDS  64
+#define SOUNDBANK_NAME_LEN    48
+#define SOUNDBANK_ALIGN       16
+
+struct SOUNDBANKHEADER
+{
+	unsigned int magic;
+	unsigned int version;
+	unsigned int nSounds;
+	unsigned int sampleRate;    // MIXER_RATE
+	unsigned int reserved[4];
+};
+
+struct SOUNDBANKENTRY
+{
+	char name[SOUNDBANK_NAME_LEN];
+	unsigned int offset;        // from the start of the file
+	unsigned int nFrames;
+	unsigned int nChannels;
+	unsigned int sourceRate;    // before resampling, for reference
+};
+
+// a decoded effect to put in the bank
+struct SOUNDBANKSOURCE
+{
+	const char* pName;
+	const short* pSamples;      // interleaved when nChannels is 2
+	int nFrames;
+	int nChannels;
+	int sampleRate;
+};
+
+struct SOUNDBANK
+{
+	const SOUNDBANKHEADER* pHeader;
+	const SOUNDBANKENTRY* pEntries;
+	MIXERSOUND sounds[SOUNDBANK_MAX_SOUNDS];    // views into the mapping
+	FILEMAP map;
+};
+
+int SoundBank_Resample(const short* pIn, int nFrames, int nChannels, int inRate, short* pOut, int outRate);    // returns the frames written
+int SoundBank_ResampledFrames(int nFrames, int inRate, int outRate);
+bool SoundBank_Write(const char* pFile, const SOUNDBANKSOURCE* pSources, int nSources);
+
+bool SoundBank_Open(const char* pFile, SOUNDBANK* pBank);    // maps and validates the bank
+int SoundBank_Find(const SOUNDBANK* pBank, const char* pName);    // -1 when missing
+const MIXERSOUND* SoundBank_GetSound(const SOUNDBANK* pBank, int sound);
+void SoundBank_Close(SOUNDBANK* pBank);
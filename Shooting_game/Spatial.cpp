@@ -0,0 +1,71 @@
+#include "Spatial.h"
+#include <math.h>
+
+#if defined(_M_X64) || defined(__x86_64__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define SPATIAL_SSE2
+#include <emmintrin.h>
+#endif
+
+static SPATIALLISTENER g_SpatialListener = { 0.0f, 0.0f, 1.0f, 1.0f, 0.0f };
+
+//Spatial_SetListener() : the center of the screen is the usual listener
+void Spatial_SetListener(const SPATIALLISTENER& listener)
+{
+	g_SpatialListener = listener;
+	if (g_SpatialListener.halfWidth <= 0.0f)
+		g_SpatialListener.halfWidth = 1.0f;
+	if (g_SpatialListener.minDistance <= 0.0f)
+		g_SpatialListener.minDistance = 1.0f;
+	if (g_SpatialListener.rolloff < 0.0f)
+		g_SpatialListener.rolloff = 0.0f;
+}
+
+//Spatial_Gains() : writes the gains of nCount emitters, pVolume scales each one
+void Spatial_Gains(const float* pX, const float* pY, const float* pVolume, int nCount, float* pLeft, float* pRight)
+{
+	const SPATIALLISTENER& listener = g_SpatialListener;
+	float fInvHalf = 1.0f / listener.halfWidth;
+	int i = 0;
+
+#ifdef SPATIAL_SSE2
+	__m128 lx = _mm_set1_ps(listener.x);
+	__m128 ly = _mm_set1_ps(listener.y);
+	__m128 invHalf = _mm_set1_ps(fInvHalf);
+	__m128 minDistance = _mm_set1_ps(listener.minDistance);
+	__m128 rolloff = _mm_set1_ps(listener.rolloff);
+	__m128 zero = _mm_setzero_ps();
+	__m128 half = _mm_set1_ps(0.5f);
+	__m128 one = _mm_set1_ps(1.0f);
+
+	for (; i + 4 <= nCount; i += 4)
+	{
+		__m128 dx = _mm_sub_ps(_mm_loadu_ps(pX + i), lx);
+		__m128 dy = _mm_sub_ps(_mm_loadu_ps(pY + i), ly);
+		__m128 pan = _mm_max_ps(_mm_min_ps(_mm_mul_ps(dx, invHalf), one), _mm_sub_ps(zero, one));
+
+		__m128 distance = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)));
+		__m128 excess = _mm_max_ps(_mm_sub_ps(distance, minDistance), zero);
+		__m128 volume = _mm_div_ps(_mm_mul_ps(_mm_loadu_ps(pVolume + i), minDistance),
+			_mm_add_ps(minDistance, _mm_mul_ps(rolloff, excess)));
+
+		__m128 side = _mm_mul_ps(pan, half);
+		_mm_storeu_ps(pLeft + i, _mm_mul_ps(volume, _mm_sqrt_ps(_mm_sub_ps(half, side))));
+		_mm_storeu_ps(pRight + i, _mm_mul_ps(volume, _mm_sqrt_ps(_mm_add_ps(half, side))));
+	}
+#endif
+	for (; i < nCount; i++)
+	{
+		float dx = pX[i] - listener.x;
+		float dy = pY[i] - listener.y;
+		float pan = dx * fInvHalf;
+		pan = pan < -1.0f ? -1.0f : pan > 1.0f ? 1.0f : pan;
+
+		float excess = sqrtf(dx * dx + dy * dy) - listener.minDistance;
+		if (excess < 0.0f)
+			excess = 0.0f;
+		float volume = pVolume[i] * listener.minDistance / (listener.minDistance + listener.rolloff * excess);
+
+		pLeft[i] = volume * sqrtf(0.5f - pan * 0.5f);
+		pRight[i] = volume * sqrtf(0.5f + pan * 0.5f);
+	}
+}
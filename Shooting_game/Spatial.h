@@ -0,0 +1,26 @@
+#pragma once
+
+// Stereo placement of sound emitters.
+// Spatial_Gains() turns emitter positions into left and right gains for the
+// mixer in one pass, four emitters at a time with SSE2. The positions are
+// packed arrays (not strided like Cull_Build()) so they load straight into
+// registers; the game copies the x and y of the voices it is placing before
+// the call. Pan follows the horizontal offset from the listener across
+// halfWidth and uses the square-root law, which keeps the power of
+// Mixer_Gains() without a sine. Loudness falls off with the inverse of the
+// distance past minDistance, scaled by rolloff; 0 turns it off.
+// The gains go to the voices once a tick: to mixer voices with
+// Mixer_SetGains(), which ramps them over a block so the steps between
+// ticks are not heard, and to the game's FMOD channels as a volume and a
+// pan by CSound::Update().
+
+struct SPATIALLISTENER
+{
+	float x, y;
+	float halfWidth;      // offset that pans fully to one side
+	float minDistance;    // full volume inside it
+	float rolloff;
+};
+
+void Spatial_SetListener(const SPATIALLISTENER& listener);
+void Spatial_Gains(const float* pX, const float* pY, const float* pVolume, int nCount, float* pLeft, float* pRight);
@@ -0,0 +1,316 @@
+#include "Stream.h"
+#include "Mixer.h"
+#include "WavFile.h"
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+struct STREAMDATA
+{
+	bool bOpen;
+	bool bLoop;
+	STREAMDECODER decoder;
+	short blocks[STREAM_BLOCKS][STREAM_BLOCK_FRAMES * 2];
+	int nBlockFrames[STREAM_BLOCKS];
+	std::atomic<unsigned int> nWritten;    // blocks filled, only the decoder writes it
+	std::atomic<unsigned int> nRead;       // blocks drained, only the consumer writes it
+	int nReadFrame;                        // frames already read from the current block
+	std::atomic<bool> bEnded;              // the decoder wrote its last block
+	long long nTrackFrames;                // frames decoded since the last rewind
+	STREAMSTATS stats;
+};
+
+static STREAMDATA g_Streams[STREAM_MAX];
+static std::thread g_StreamThread;
+static std::mutex g_StreamLock;    // guards opening and closing against the decoder thread
+static std::condition_variable g_StreamWake;
+static bool g_bStreamRunning = false;
+static std::atomic<bool> g_bStreamRequest(false);
+
+// fills every free block of the stream, returns true when it did any work
+static bool Stream_Fill(STREAMDATA& stream)
+{
+	bool bWork = false;
+	bool bEnded = false;
+
+	while (bEnded == false && stream.bEnded == false && stream.nWritten - stream.nRead.load(std::memory_order_acquire) < STREAM_BLOCKS)
+	{
+		unsigned int block = stream.nWritten & (STREAM_BLOCKS - 1);
+		short* pBlock = stream.blocks[block];
+		int nFrames = 0;
+
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		while (nFrames < STREAM_BLOCK_FRAMES)
+		{
+			int n = stream.decoder.pRead(stream.decoder.pContext, pBlock + nFrames * 2, STREAM_BLOCK_FRAMES - nFrames);
+			if (n > 0)
+			{
+				nFrames += n;
+				stream.nTrackFrames += n;
+				continue;
+			}
+
+			// end of the track, the loop continues in the same block
+			if (stream.stats.nTrackBytes == 0)
+				stream.stats.nTrackBytes = (size_t)stream.nTrackFrames * 4;
+			if (stream.bLoop == false || stream.nTrackFrames == 0 || stream.decoder.pRewind(stream.decoder.pContext) == false)
+			{
+				bEnded = true;
+				break;
+			}
+			stream.nTrackFrames = 0;
+			stream.stats.nLoops++;
+		}
+		stream.stats.fDecodeTime += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		stream.stats.nDecoded += nFrames;
+
+		if (nFrames > 0)
+		{
+			stream.nBlockFrames[block] = nFrames;
+			stream.nWritten.store(stream.nWritten + 1, std::memory_order_release);
+			bWork = true;
+		}
+	}
+
+	// only after the last block is published, or the consumer could see the
+	// end with that block still uncounted and drop it
+	if (bEnded)
+		stream.bEnded.store(true, std::memory_order_release);
+
+	return bWork;
+}
+
+static void Stream_ThreadProc(void)
+{
+	std::unique_lock<std::mutex> lock(g_StreamLock);
+
+	while (g_bStreamRunning)
+	{
+		for (int i = 0; i < STREAM_MAX; i++)
+		{
+			if (g_Streams[i].bOpen)
+				Stream_Fill(g_Streams[i]);
+		}
+
+		// the consumer sets the request without the lock, so never sleep long on it
+		if (g_bStreamRequest.exchange(false) == false)
+			g_StreamWake.wait_for(lock, std::chrono::milliseconds(5));
+	}
+}
+
+bool Stream_Init(void)
+{
+	Stream_Release();
+
+	g_bStreamRunning = true;
+	g_StreamThread = std::thread(Stream_ThreadProc);
+
+	return true;
+}
+
+void Stream_Release(void)
+{
+	if (g_bStreamRunning == false)
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(g_StreamLock);
+		g_bStreamRunning = false;
+	}
+	g_StreamWake.notify_one();
+	g_StreamThread.join();
+
+	for (int i = 0; i < STREAM_MAX; i++)
+		Stream_Close(i);
+}
+
+//Stream_Open() : the first blocks are decoded in the background, see Stream_Prefill()
+int Stream_Open(const STREAMDECODER& decoder, bool bLoop)
+{
+	std::lock_guard<std::mutex> lock(g_StreamLock);
+
+	for (int i = 0; i < STREAM_MAX; i++)
+	{
+		STREAMDATA& stream = g_Streams[i];
+		if (stream.bOpen)
+			continue;
+
+		stream.bLoop = bLoop;
+		stream.decoder = decoder;
+		stream.nWritten = 0;
+		stream.nRead = 0;
+		stream.nReadFrame = 0;
+		stream.bEnded = false;
+		stream.nTrackFrames = 0;
+		memset(&stream.stats, 0, sizeof(stream.stats));
+		stream.stats.nResidentBytes = sizeof(stream.blocks);
+		stream.stats.nMinFillBlocks = STREAM_BLOCKS;
+		stream.bOpen = true;
+
+		g_StreamWake.notify_one();
+		return i;
+	}
+
+	if (decoder.pClose != NULL)
+		decoder.pClose(decoder.pContext);
+	return -1;
+}
+
+void Stream_Close(int stream)
+{
+	if (stream < 0 || stream >= STREAM_MAX)
+		return;
+
+	std::lock_guard<std::mutex> lock(g_StreamLock);
+	STREAMDATA& data = g_Streams[stream];
+	if (data.bOpen == false)
+		return;
+
+	if (data.decoder.pClose != NULL)
+		data.decoder.pClose(data.decoder.pContext);
+	data.bOpen = false;
+}
+
+//Stream_Read() : never blocks; an empty ring is an underrun and reads silence
+int Stream_Read(int stream, short* pFrames, int nFrames)
+{
+	STREAMDATA& data = g_Streams[stream];
+	int nDone = 0;
+
+	data.stats.nFillBlocks = (int)(data.nWritten.load(std::memory_order_acquire) - data.nRead.load(std::memory_order_relaxed));
+	if (data.bEnded == false && data.stats.nFillBlocks < data.stats.nMinFillBlocks)
+		data.stats.nMinFillBlocks = data.stats.nFillBlocks;
+
+	while (nDone < nFrames)
+	{
+		unsigned int nRead = data.nRead.load(std::memory_order_relaxed);
+		if (nRead == data.nWritten.load(std::memory_order_acquire))
+			break;
+
+		unsigned int block = nRead & (STREAM_BLOCKS - 1);
+		int n = data.nBlockFrames[block] - data.nReadFrame;
+		if (n > nFrames - nDone)
+			n = nFrames - nDone;
+
+		memcpy(pFrames + nDone * 2, data.blocks[block] + data.nReadFrame * 2, n * 4);
+		data.nReadFrame += n;
+		nDone += n;
+
+		if (data.nReadFrame == data.nBlockFrames[block])
+		{
+			data.nReadFrame = 0;
+			data.nRead.store(nRead + 1, std::memory_order_release);
+			g_bStreamRequest = true;
+		}
+	}
+
+	if (nDone < nFrames)
+	{
+		memset(pFrames + nDone * 2, 0, (nFrames - nDone) * 4);
+		if (data.bEnded == false)
+			data.stats.nUnderruns++;
+	}
+	data.stats.nPlayed += nDone;
+
+	return nDone;
+}
+
+bool Stream_IsFinished(int stream)
+{
+	const STREAMDATA& data = g_Streams[stream];
+
+	return data.bEnded && data.nRead == data.nWritten;
+}
+
+void Stream_Prefill(int stream)
+{
+	STREAMDATA& data = g_Streams[stream];
+
+	while (data.bEnded == false && data.nWritten - data.nRead < STREAM_BLOCKS)
+	{
+		g_StreamWake.notify_one();
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+}
+
+//Stream_GetStats() : the decoder side counters are updated while it runs, read them as a snapshot
+STREAMSTATS Stream_GetStats(int stream)
+{
+	return g_Streams[stream].stats;
+}
+
+
+struct STREAMWAVFILE
+{
+	WAVFILE wav;
+	unsigned int position;    // next frame
+};
+
+static int Stream_WavRead(void* pContext, short* pFrames, int nFrames)
+{
+	STREAMWAVFILE* pStream = (STREAMWAVFILE*)pContext;
+	const WAVFILE& wav = pStream->wav;
+
+	if ((unsigned int)nFrames > wav.nFrames - pStream->position)
+		nFrames = wav.nFrames - pStream->position;
+
+	// little endian samples straight from the mapping, mono is copied to both sides
+	const unsigned char* p = (const unsigned char*)wav.pSamples + pStream->position * wav.format.blockAlign;
+	for (int i = 0; i < nFrames; i++, p += wav.format.blockAlign)
+	{
+		short left = (short)(p[0] | (p[1] << 8));
+		short right = wav.format.channels == 2 ? (short)(p[2] | (p[3] << 8)) : left;
+		pFrames[i * 2] = left;
+		pFrames[i * 2 + 1] = right;
+	}
+	pStream->position += nFrames;
+
+	return nFrames;
+}
+
+static bool Stream_WavRewind(void* pContext)
+{
+	STREAMWAVFILE* pStream = (STREAMWAVFILE*)pContext;
+
+	pStream->position = 0;
+	return true;
+}
+
+static void Stream_WavClose(void* pContext)
+{
+	STREAMWAVFILE* pStream = (STREAMWAVFILE*)pContext;
+
+	WavFile_Close(&pStream->wav);
+	delete pStream;
+}
+
+//Stream_WavDecoder() : 16-bit mono or stereo PCM at MIXER_RATE, read from a mapping of the file
+bool Stream_WavDecoder(const char* pFile, STREAMDECODER* pDecoder)
+{
+	STREAMWAVFILE* pStream = new STREAMWAVFILE;
+	const WAVFILEFORMAT& format = pStream->wav.format;
+
+	if (WavFile_Open(pFile, &pStream->wav) == false)
+	{
+		delete pStream;
+		return false;
+	}
+
+	if (format.formatTag != WAVFILE_FORMAT_PCM || format.bitsPerSample != 16 || format.channels > 2 ||
+		format.sampleRate != MIXER_RATE)
+	{
+		Stream_WavClose(pStream);
+		return false;
+	}
+
+	pStream->position = 0;
+	pDecoder->pContext = pStream;
+	pDecoder->pRead = Stream_WavRead;
+	pDecoder->pRewind = Stream_WavRewind;
+	pDecoder->pClose = Stream_WavClose;
+
+	return true;
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <stddef.h>
+
+// Streaming music for the mixer.
+// A decoder thread keeps a small ring of PCM blocks filled per stream and
+// the mixer drains it, so a track costs STREAM_BLOCKS blocks of memory
+// however long it is. Looping streams rewind the decoder as soon as it
+// runs dry and keep filling the same ring, so the loop point is sample
+// exact. Decoders are pluggable and produce 16-bit stereo at MIXER_RATE;
+// Stream_WavDecoder() reads 16-bit PCM .wav files.
+// The ring is single-producer, single-consumer: one decoder thread writes,
+// and only the mixer (or one thread calling Stream_Read()) reads.
+
+#define STREAM_MAX           4
+#define STREAM_BLOCKS        8
+#define STREAM_BLOCK_FRAMES  4096    // 8 blocks are about 0.75 s and 128 KB
+
+struct STREAMDECODER
+{
+	void* pContext;
+	int (*pRead)(void* pContext, short* pFrames, int nFrames);    // stereo frames read, 0 at the end
+	bool (*pRewind)(void* pContext);
+	void (*pClose)(void* pContext);
+};
+
+struct STREAMSTATS
+{
+	size_t nResidentBytes;     // the ring, all the PCM that is ever in memory
+	size_t nTrackBytes;        // what a full decode would take, 0 until the end was reached once
+	long long nDecoded;        // frames
+	long long nPlayed;         // frames
+	int nLoops;
+	int nUnderruns;            // reads the ring could not fill
+	int nFillBlocks;           // decoded blocks waiting, at the last read
+	int nMinFillBlocks;        // lowest before the track ended, how close it came to an underrun
+	double fDecodeTime;        // seconds on the decoder thread
+};
+
+bool Stream_Init(void);
+void Stream_Release(void);    // closes every stream
+int Stream_Open(const STREAMDECODER& decoder, bool bLoop);    // -1 when every stream is taken; owns the decoder
+void Stream_Close(int stream);    // not while the mixer plays it
+int Stream_Read(int stream, short* pFrames, int nFrames);    // consumer side, zero fills what is missing
+bool Stream_IsFinished(int stream);    // every frame of a non-looping stream was read
+void Stream_Prefill(int stream);    // waits until the ring is full or the track ended
+STREAMSTATS Stream_GetStats(int stream);
+
+bool Stream_WavDecoder(const char* pFile, STREAMDECODER* pDecoder);
@@ -0,0 +1,287 @@
+#include "TexCook.h"
+#include "Image.h"
+#include "BlockCompress.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+
+// x * y / 255, rounded
+static inline unsigned int TexCook_Mul255(unsigned int x, unsigned int y)
+{
+	unsigned int v = x * y + 128;
+	return (v + (v >> 8)) >> 8;
+}
+
+static void TexCook_Premultiply(IMAGE* pImage)
+{
+	size_t nPixels = (size_t)pImage->width * pImage->height;
+
+	for (size_t i = 0; i < nPixels; i++)
+	{
+		unsigned int c = pImage->pixels[i];
+		unsigned int a = c >> 24;
+
+		pImage->pixels[i] = (a << 24) | (TexCook_Mul255((c >> 16) & 0xff, a) << 16) |
+			(TexCook_Mul255((c >> 8) & 0xff, a) << 8) | TexCook_Mul255(c & 0xff, a);
+	}
+}
+
+//TexCook_Downsample() : averages 2x2 blocks, odd edges repeat the last texel
+static bool TexCook_Downsample(const IMAGE* pSrc, IMAGE* pDst)
+{
+	int width = pSrc->width > 1 ? pSrc->width / 2 : 1;
+	int height = pSrc->height > 1 ? pSrc->height / 2 : 1;
+
+	if (!Image_Create(pDst, width, height))
+		return false;
+
+	for (int y = 0; y < height; y++)
+	{
+		const unsigned int* pRow0 = pSrc->pixels + (y * 2) * pSrc->width;
+		const unsigned int* pRow1 = (y * 2 + 1 < pSrc->height) ? pRow0 + pSrc->width : pRow0;
+
+		for (int x = 0; x < width; x++)
+		{
+			int x0 = x * 2;
+			int x1 = (x0 + 1 < pSrc->width) ? x0 + 1 : x0;
+			unsigned int texels[4] = { pRow0[x0], pRow0[x1], pRow1[x0], pRow1[x1] };
+			unsigned int result = 0;
+
+			for (int shift = 0; shift < 32; shift += 8)
+			{
+				unsigned int sum = 2;
+				for (int i = 0; i < 4; i++)
+					sum += (texels[i] >> shift) & 0xff;
+				result |= (sum >> 2) << shift;
+			}
+
+			pDst->pixels[y * width + x] = result;
+		}
+	}
+
+	return true;
+}
+
+static size_t TexCook_LevelSize(int blockFormat, const TEXFILELEVEL& level)
+{
+	return (size_t)level.pitch * ((blockFormat < 0) ? level.height : (level.height + 3) / 4);
+}
+
+static size_t TexCook_Align(size_t offset)
+{
+	return (offset + TEXFILE_ALIGN - 1) & ~(size_t)(TEXFILE_ALIGN - 1);
+}
+
+//TexCook_Measure() : PSNR of the decoded top level over the texels that are
+//drawn, and the encode and decode rates
+static void TexCook_Measure(int format, const IMAGE* pSource, const void* pBlocks, float fEncodeTime, TEXCOOKSTATS* pStats)
+{
+	IMAGE source, decoded;
+	if (!Image_Create(&source, pSource->width, pSource->height) || !Image_Create(&decoded, pSource->width, pSource->height))
+	{
+		if (source.pixels != NULL)
+			Image_Free(&source);
+		return;
+	}
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	BC_Decode(format, pBlocks, decoded.width, decoded.height, decoded.pixels);
+	float fDecodeTime = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+
+	// colors under transparent texels are never seen, BC1 drops them below half alpha
+	size_t nPixels = (size_t)source.width * source.height;
+	unsigned int threshold = (format == BC_FORMAT_BC1) ? 128 : 1;
+	for (size_t i = 0; i < nPixels; i++)
+	{
+		source.pixels[i] = pSource->pixels[i];
+		if ((source.pixels[i] >> 24) < threshold)
+			source.pixels[i] = decoded.pixels[i] = 0;
+	}
+
+	IMAGEDIFF diff;
+	Image_Compare(&source, &decoded, 0, &diff, NULL);
+
+	float fMegaPixels = nPixels / 1000000.0f;
+	pStats->psnr = diff.psnr;
+	pStats->fEncodeRate = fEncodeTime > 0.0f ? fMegaPixels / fEncodeTime : 0.0f;
+	pStats->fDecodeRate = fDecodeTime > 0.0f ? fMegaPixels / fDecodeTime : 0.0f;
+
+	Image_Free(&source);
+	Image_Free(&decoded);
+}
+
+//TexCook_Write() : cooks the decoded top level in levels[0] into pDst, and
+//frees every level it made
+static bool TexCook_Write(IMAGE* levels, unsigned int hash, const char* pDst, const TEXCOOKSETTINGS& settings,
+	TEXCOOKSTATS* pStats)
+{
+	if (pStats != NULL)
+	{
+		pStats->format = TEXFILE_FORMAT_A8R8G8B8;
+		pStats->psnr = 100.0;
+		pStats->fEncodeRate = 0.0f;
+		pStats->fDecodeRate = 0.0f;
+	}
+
+	if (settings.bColorKey)
+	{
+		size_t nPixels = (size_t)levels[0].width * levels[0].height;
+		for (size_t i = 0; i < nPixels; i++)
+		{
+			if (levels[0].pixels[i] == settings.colorKey)
+				levels[0].pixels[i] = 0;
+		}
+	}
+
+	// premultiplied before filtering, so transparent texels do not bleed color into the mips
+	if (settings.bPremultiply)
+		TexCook_Premultiply(&levels[0]);
+
+	int nLevels = 1;
+	while (settings.bMips && nLevels < TEXFILE_MAX_LEVELS &&
+		(levels[nLevels - 1].width > 1 || levels[nLevels - 1].height > 1))
+	{
+		if (!TexCook_Downsample(&levels[nLevels - 1], &levels[nLevels]))
+			break;
+		nLevels++;
+	}
+
+	// D3D9 needs block compressed top levels in whole blocks
+	int blockFormat = -1;
+	if (settings.format == TEXCOOK_BC1 || (settings.format == TEXCOOK_BC && !BC_HasSoftAlpha(levels[0].pixels, levels[0].width, levels[0].height)))
+		blockFormat = BC_FORMAT_BC1;
+	else if (settings.format == TEXCOOK_BC3 || settings.format == TEXCOOK_BC)
+		blockFormat = BC_FORMAT_BC3;
+
+	bool bOk = blockFormat < 0 || (levels[0].width % 4 == 0 && levels[0].height % 4 == 0);
+	void* pBlocks[TEXFILE_MAX_LEVELS];
+	memset(pBlocks, 0, sizeof(pBlocks));
+
+	for (int i = 0; bOk && blockFormat >= 0 && i < nLevels; i++)
+	{
+		pBlocks[i] = malloc(BC_GetSize(blockFormat, levels[i].width, levels[i].height));
+		if (pBlocks[i] == NULL)
+		{
+			bOk = false;
+			break;
+		}
+
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		BC_Encode(blockFormat, levels[i].pixels, levels[i].width, levels[i].height, pBlocks[i]);
+
+		if (i == 0 && pStats != NULL)
+		{
+			float fEncodeTime = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+			pStats->format = (blockFormat == BC_FORMAT_BC1) ? TEXFILE_FORMAT_DXT1 : TEXFILE_FORMAT_DXT5;
+			TexCook_Measure(blockFormat, &levels[0], pBlocks[0], fEncodeTime, pStats);
+		}
+	}
+
+	TEXFILEHEADER header;
+	TEXFILELEVEL table[TEXFILE_MAX_LEVELS];
+	memset(&header, 0, sizeof(header));
+	memset(table, 0, sizeof(table));
+
+	header.magic = TEXFILE_MAGIC;
+	header.version = TEXFILE_VERSION;
+	header.flags = (settings.bColorKey ? TEXFILE_COLORKEY : 0) | (settings.bPremultiply ? TEXFILE_PREMULTIPLIED : 0) |
+		(nLevels > 1 ? TEXFILE_MIPS : 0);
+	header.format = (blockFormat < 0) ? TEXFILE_FORMAT_A8R8G8B8 :
+		(blockFormat == BC_FORMAT_BC1) ? TEXFILE_FORMAT_DXT1 : TEXFILE_FORMAT_DXT5;
+	header.width = levels[0].width;
+	header.height = levels[0].height;
+	header.levels = nLevels;
+	header.colorKey = settings.bColorKey ? settings.colorKey : 0;
+	header.sourceHash = hash;
+
+	size_t offset = TexCook_Align(sizeof(header) + nLevels * sizeof(TEXFILELEVEL));
+	for (int i = 0; i < nLevels; i++)
+	{
+		table[i].offset = (unsigned int)offset;
+		table[i].width = levels[i].width;
+		table[i].height = levels[i].height;
+		table[i].pitch = (blockFormat < 0) ? levels[i].width * 4 : (unsigned int)BC_GetPitch(blockFormat, levels[i].width);
+		offset = TexCook_Align(offset + TexCook_LevelSize(blockFormat, table[i]));
+	}
+
+	static const unsigned char padding[TEXFILE_ALIGN] = { 0 };
+
+	FILE* fp = bOk ? fopen(pDst, "wb") : NULL;
+	bOk = fp != NULL;
+	if (bOk)
+	{
+		size_t written = fwrite(&header, sizeof(header), 1, fp) + fwrite(table, sizeof(TEXFILELEVEL), nLevels, fp);
+		size_t pos = sizeof(header) + nLevels * sizeof(TEXFILELEVEL);
+		bOk = written == (size_t)nLevels + 1;
+
+		for (int i = 0; bOk && i < nLevels; i++)
+		{
+			size_t nLevel = TexCook_LevelSize(blockFormat, table[i]);
+			const void* pLevel = (blockFormat < 0) ? (const void*)levels[i].pixels : pBlocks[i];
+
+			bOk = fwrite(padding, 1, table[i].offset - pos, fp) == table[i].offset - pos &&
+				fwrite(pLevel, 1, nLevel, fp) == nLevel;
+			pos = table[i].offset + nLevel;
+		}
+
+		if (fclose(fp) != 0)
+			bOk = false;
+		if (!bOk)
+			remove(pDst);
+	}
+
+	for (int i = 0; i < nLevels; i++)
+	{
+		Image_Free(&levels[i]);
+		free(pBlocks[i]);
+	}
+
+	return bOk;
+}
+
+//TexFile_CookMemory() : cooks a source image that is already in memory;
+//pStats may be NULL
+bool TexFile_CookMemory(const void* pData, size_t nSize, const char* pDst, const TEXCOOKSETTINGS& settings,
+	TEXCOOKSTATS* pStats)
+{
+	IMAGE levels[TEXFILE_MAX_LEVELS];
+	if (!Image_Decode(pData, nSize, &levels[0]))
+		return false;
+
+	return TexCook_Write(levels, TexFile_Hash(pData, nSize), pDst, settings, pStats);
+}
+
+//TexFile_CookImage() : cooks pixels that are already decoded, such as a
+//piece cut out of a larger source; the image is left as it is
+bool TexFile_CookImage(const IMAGE* pImage, unsigned int sourceHash, const char* pDst, const TEXCOOKSETTINGS& settings,
+	TEXCOOKSTATS* pStats)
+{
+	IMAGE levels[TEXFILE_MAX_LEVELS];
+	if (!Image_Create(&levels[0], pImage->width, pImage->height))
+		return false;
+
+	memcpy(levels[0].pixels, pImage->pixels, (size_t)pImage->width * pImage->height * 4);
+	return TexCook_Write(levels, sourceHash, pDst, settings, pStats);
+}
+
+bool TexFile_Cook(const char* pSrc, const char* pDst, const TEXCOOKSETTINGS& settings, TEXCOOKSTATS* pStats)
+{
+	FILE* fp = fopen(pSrc, "rb");
+	if (fp == NULL)
+		return false;
+
+	fseek(fp, 0, SEEK_END);
+	long nSize = ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+
+	unsigned char* pData = (nSize > 0) ? (unsigned char*)malloc(nSize) : NULL;
+	bool bOk = pData != NULL && fread(pData, 1, nSize, fp) == (size_t)nSize;
+	fclose(fp);
+
+	if (bOk)
+		bOk = TexFile_CookMemory(pData, nSize, pDst, settings, pStats);
+	free(pData);
+
+	return bOk;
+}
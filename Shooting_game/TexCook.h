@@ -0,0 +1,35 @@
+#pragma once
+#include "TexFile.h"
+#include "Image.h"
+
+// Texture cooker: turns a PNG, BMP or QOI source into a .ctex file.
+// The color key is baked the way D3DX applies it at load time (matching
+// opaque pixels become transparent black), so cooked and uncooked loads
+// produce the same texels. Textures can be block compressed; TEXCOOK_BC
+// picks BC1 when alpha is only 0 or 255 and BC3 otherwise, and the stats
+// report the PSNR of what was lost.
+
+enum { TEXCOOK_A8R8G8B8, TEXCOOK_BC1, TEXCOOK_BC3, TEXCOOK_BC };
+
+struct TEXCOOKSETTINGS
+{
+	bool bColorKey;
+	unsigned int colorKey;    // 0xAARRGGBB
+	bool bPremultiply;
+	bool bMips;               // full chain down to 1x1, 2x2 box filter
+	int format;               // TEXCOOK_, block compressed sizes must be multiples of 4
+};
+
+struct TEXCOOKSTATS
+{
+	unsigned int format;      // TEXFILE_FORMAT_ written
+	double psnr;              // dB over the drawn texels of the top level, 100 when lossless
+	float fEncodeRate;        // megapixels per second, top level
+	float fDecodeRate;
+};
+
+bool TexFile_Cook(const char* pSrc, const char* pDst, const TEXCOOKSETTINGS& settings, TEXCOOKSTATS* pStats);
+bool TexFile_CookMemory(const void* pData, size_t nSize, const char* pDst, const TEXCOOKSETTINGS& settings,
+	TEXCOOKSTATS* pStats);
+bool TexFile_CookImage(const IMAGE* pImage, unsigned int sourceHash, const char* pDst, const TEXCOOKSETTINGS& settings,
+	TEXCOOKSTATS* pStats);    // sourceHash is the source file's, for telling stale files apart
@@ -0,0 +1,163 @@
+#include "Trace.h"
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+
+enum { TRACE_SPAN, TRACE_MARK, TRACE_THREAD };
+
+struct TRACEEVENT
+{
+	char szName[TRACE_NAME_LEN];
+	int type;
+	int thread;
+	long long start;                  // microseconds
+	std::atomic<long long> duration;  // microseconds, -1 while the span is open
+	std::atomic<bool> bReady;         // set once the fields above are written
+};
+
+static TRACEEVENT g_TraceEvents[TRACE_MAX_EVENTS];
+static std::atomic<int> g_nTraceEvents(0);
+static std::atomic<int> g_nTraceThreads(0);
+static std::chrono::steady_clock::time_point g_TraceStart = std::chrono::steady_clock::now();
+static thread_local int t_nTraceThread = -1;
+
+static long long Trace_Micros(void)
+{
+	using namespace std::chrono;
+	return duration_cast<microseconds>(steady_clock::now() - g_TraceStart).count();
+}
+
+static int Trace_Thread(void)
+{
+	if (t_nTraceThread < 0)
+		t_nTraceThread = g_nTraceThreads++;
+
+	return t_nTraceThread;
+}
+
+static int Trace_Add(const char* pName, int type)
+{
+	int i = g_nTraceEvents++;
+	if (i >= TRACE_MAX_EVENTS)
+		return -1;
+
+	TRACEEVENT& event = g_TraceEvents[i];
+	snprintf(event.szName, sizeof(event.szName), "%s", pName);
+	event.type = type;
+	event.thread = Trace_Thread();
+	event.start = Trace_Micros();
+	event.duration = type == TRACE_SPAN ? -1 : 0;
+	event.bReady = true;
+
+	return i;
+}
+
+//Trace_Init() : call before any other thread records
+bool Trace_Init(void)
+{
+	for (int i = 0; i < TRACE_MAX_EVENTS; i++)
+		g_TraceEvents[i].bReady = false;
+	g_nTraceEvents = 0;
+	g_TraceStart = std::chrono::steady_clock::now();
+
+	return true;
+}
+
+int Trace_Begin(const char* pName)
+{
+	return Trace_Add(pName, TRACE_SPAN);
+}
+
+void Trace_End(int span)
+{
+	if (span < 0 || span >= TRACE_MAX_EVENTS)
+		return;
+
+	TRACEEVENT& event = g_TraceEvents[span];
+	event.duration = Trace_Micros() - event.start;
+}
+
+void Trace_Mark(const char* pName)
+{
+	Trace_Add(pName, TRACE_MARK);
+}
+
+void Trace_SetThreadName(const char* pName)
+{
+	Trace_Add(pName, TRACE_THREAD);
+}
+
+double Trace_Now(void)
+{
+	return Trace_Micros() * 1e-6;
+}
+
+double Trace_GetDuration(const char* pName)
+{
+	int nEvents = g_nTraceEvents < TRACE_MAX_EVENTS ? g_nTraceEvents.load() : TRACE_MAX_EVENTS;
+
+	for (int i = 0; i < nEvents; i++)
+	{
+		const TRACEEVENT& event = g_TraceEvents[i];
+
+		if (event.bReady && event.type == TRACE_SPAN && event.duration >= 0 && strcmp(event.szName, pName) == 0)
+			return event.duration * 1e-6;
+	}
+
+	return 0.0;
+}
+
+//Trace_Write() : spans still open are written as ending now
+bool Trace_Write(const char* pFile)
+{
+	FILE* fp = fopen(pFile, "w");
+	if (fp == NULL)
+		return false;
+
+	int nEvents = g_nTraceEvents < TRACE_MAX_EVENTS ? g_nTraceEvents.load() : TRACE_MAX_EVENTS;
+	long long now = Trace_Micros();
+	bool bFirst = true;
+
+	fprintf(fp, "{\"traceEvents\":[\n");
+	for (int i = 0; i < nEvents; i++)
+	{
+		const TRACEEVENT& event = g_TraceEvents[i];
+		if (!event.bReady)
+			continue;
+
+		// names are program text, only quotes and backslashes need escaping
+		char szName[TRACE_NAME_LEN * 2];
+		size_t n = 0;
+		for (const char* p = event.szName; *p != '\0'; p++)
+		{
+			if (*p == '"' || *p == '\\')
+				szName[n++] = '\\';
+			szName[n++] = *p;
+		}
+		szName[n] = '\0';
+
+		fprintf(fp, bFirst ? "" : ",\n");
+		bFirst = false;
+
+		if (event.type == TRACE_SPAN)
+		{
+			long long duration = event.duration;
+			fprintf(fp, "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%lld,\"dur\":%lld}",
+				szName, event.thread, event.start, duration >= 0 ? duration : now - event.start);
+		}
+		else if (event.type == TRACE_MARK)
+		{
+			fprintf(fp, "{\"name\":\"%s\",\"ph\":\"i\",\"s\":\"g\",\"pid\":1,\"tid\":%d,\"ts\":%lld}",
+				szName, event.thread, event.start);
+		}
+		else
+		{
+			fprintf(fp, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+				event.thread, szName);
+		}
+	}
+	fprintf(fp, "\n]}\n");
+
+	return fclose(fp) == 0;
+}
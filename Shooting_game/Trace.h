@@ -0,0 +1,22 @@
+#pragma once
+
+// Startup trace.
+// Named spans and instant marks are stamped with a microsecond clock that
+// starts at Trace_Init() and with the recording thread, into a fixed table
+// that any thread can append to without locking. Trace_Write() saves the
+// table in the Chrome trace format (chrome://tracing or ui.perfetto.dev),
+// where every thread is a row, so work moved off the startup path shows up
+// next to the phases it overlaps. Names are copied, events past the table
+// size are dropped.
+
+#define TRACE_MAX_EVENTS   512
+#define TRACE_NAME_LEN     48
+
+bool Trace_Init(void);                      // time zero, and clears the table
+int Trace_Begin(const char* pName);         // returns the span for Trace_End(), -1 when the table is full
+void Trace_End(int span);
+void Trace_Mark(const char* pName);
+void Trace_SetThreadName(const char* pName);    // labels the calling thread's row
+double Trace_Now(void);                     // seconds since Trace_Init()
+double Trace_GetDuration(const char* pName);    // seconds of the first finished span of that name, 0 if none
+bool Trace_Write(const char* pFile);
@@ -0,0 +1,166 @@
+#include "Voice.h"
+#include <string.h>
+
+//Voice_Init() : every sound starts at priority 0, 4 instances, no cooldown and no length
+void Voice_Init(VOICEPOOL* pPool, int nVoices)
+{
+	memset(pPool, 0, sizeof(*pPool));
+	pPool->nVoices = nVoices < VOICE_MAX_VOICES ? nVoices : VOICE_MAX_VOICES;
+
+	for (int i = 0; i < VOICE_MAX_VOICES; i++)
+		pPool->voices[i].sound = -1;
+	for (int i = 0; i < VOICE_MAX_SOUNDS; i++)
+		pPool->sounds[i].maxInstances = 4;
+}
+
+void Voice_SetSound(VOICEPOOL* pPool, int sound, int priority, int maxInstances, float fCooldown, float fLength)
+{
+	if (sound < 0 || sound >= VOICE_MAX_SOUNDS)
+		return;
+
+	VOICESOUND& settings = pPool->sounds[sound];
+	settings.priority = priority;
+	settings.maxInstances = maxInstances > 0 ? maxInstances : 1;
+	settings.cooldown = fCooldown;
+	settings.length = fLength;
+}
+
+// trigger volume, faded out linearly over the length of the sound
+static float Voice_Loudness(const VOICEPOOL* pPool, const VOICE& voice, float fNow)
+{
+	float length = pPool->sounds[voice.sound].length;
+	if (length <= 0.0f)
+		return voice.volume;
+
+	float left = 1.0f - (fNow - voice.start) / length;
+	return left > 0.0f ? voice.volume * left : 0.0f;
+}
+
+//Voice_Trigger() : the caller starts the sound on the returned voice and stores its handle there
+//a stolen voice keeps the old handle until then, so the caller can stop its playback first
+VOICETRIGGER Voice_Trigger(VOICEPOOL* pPool, int sound, float fVolume, float fNow)
+{
+	VOICETRIGGER trigger = { -1, -1, false };
+
+	if (sound < 0 || sound >= VOICE_MAX_SOUNDS)
+		return trigger;
+
+	const VOICESOUND& settings = pPool->sounds[sound];
+	int nInstances = 0;
+	int newest = -1;
+	int oldest = -1;
+	int free = -1;
+	int victim = -1;
+	float victimLoudness = 0.0f;
+	pPool->stats.nTriggered++;
+
+	for (int i = 0; i < pPool->nVoices; i++)
+	{
+		const VOICE& voice = pPool->voices[i];
+
+		if (voice.sound < 0)
+		{
+			if (free < 0)
+				free = i;
+			continue;
+		}
+
+		if (voice.sound == sound)
+		{
+			nInstances++;
+			if (newest < 0 || voice.start > pPool->voices[newest].start)
+				newest = i;
+			if (oldest < 0 || voice.start < pPool->voices[oldest].start)
+				oldest = i;
+		}
+
+		// a steal candidate is a lower priority, or an equal one that is quieter than the trigger
+		int priority = pPool->sounds[voice.sound].priority;
+		float loudness = Voice_Loudness(pPool, voice, fNow);
+		if (priority > settings.priority || (priority == settings.priority && loudness >= fVolume))
+			continue;
+
+		if (victim < 0 || priority < pPool->sounds[pPool->voices[victim].sound].priority ||
+			(priority == pPool->sounds[pPool->voices[victim].sound].priority &&
+			(loudness < victimLoudness || (loudness == victimLoudness && voice.start < pPool->voices[victim].start))))
+		{
+			victim = i;
+			victimLoudness = loudness;
+		}
+	}
+
+	// the same sound again within its cooldown, one instance is enough
+	if (newest >= 0 && fNow - pPool->voices[newest].start < settings.cooldown)
+	{
+		VOICE& voice = pPool->voices[newest];
+		if (fVolume > voice.volume)
+			voice.volume = fVolume;
+		trigger.voice = newest;
+		trigger.bCoalesced = true;
+		pPool->stats.nCoalesced++;
+		return trigger;
+	}
+
+	if (nInstances >= settings.maxInstances)
+		victim = oldest;
+	else if (free >= 0)
+		victim = -1;
+
+	if (free < 0 || victim >= 0)
+	{
+		if (victim < 0)
+		{
+			pPool->stats.nDropped++;
+			return trigger;
+		}
+		trigger.stolen = victim;
+		free = victim;
+		pPool->stats.nStolen++;
+	}
+
+	VOICE& voice = pPool->voices[free];
+	voice.sound = sound;
+	voice.volume = fVolume;
+	voice.start = fNow;
+	trigger.voice = free;
+	pPool->stats.nPlayed++;
+
+	int nCount = Voice_Count(pPool);
+	if (nCount > pPool->stats.nPeakVoices)
+		pPool->stats.nPeakVoices = nCount;
+
+	return trigger;
+}
+
+void Voice_Free(VOICEPOOL* pPool, int voice)
+{
+	if (voice >= 0 && voice < pPool->nVoices)
+		pPool->voices[voice].sound = -1;
+}
+
+void Voice_Update(VOICEPOOL* pPool, float fNow)
+{
+	for (int i = 0; i < pPool->nVoices; i++)
+	{
+		VOICE& voice = pPool->voices[i];
+		if (voice.sound < 0)
+			continue;
+
+		float length = pPool->sounds[voice.sound].length;
+		if (length > 0.0f && fNow - voice.start >= length)
+			voice.sound = -1;
+	}
+}
+
+int Voice_Count(const VOICEPOOL* pPool)
+{
+	int nCount = 0;
+
+	for (int i = 0; i < pPool->nVoices; i++)
+	{
+		if (pPool->voices[i].sound >= 0)
+			nCount++;
+	}
+
+	return nCount;
+}
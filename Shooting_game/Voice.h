@@ -0,0 +1,65 @@
+#pragma once
+
+// Sound effect voice pool.
+// Decides, on the game thread, whether a triggered effect gets a voice and
+// which playing one it replaces; the audio backend (FMOD channels or mixer
+// voices) only starts and stops what it is told, keeping its own handle in
+// the voice. Every sound has a priority, a limit on instances playing at
+// once and a cooldown. A trigger inside the cooldown of the same sound is
+// coalesced into the instance already playing. At the instance limit the
+// oldest instance of the sound is replaced. With every voice busy the
+// quietest voice of a lower priority is stolen, the oldest on a tie, and an
+// equal priority is stolen only when it is quieter; otherwise the trigger
+// is dropped. Loudness is the trigger volume faded out over the length of
+// the sound, which needs no feedback from the backend.
+
+#define VOICE_MAX_VOICES  32
+#define VOICE_MAX_SOUNDS  16
+
+struct VOICESOUND
+{
+	int priority;        // higher wins
+	int maxInstances;
+	float cooldown;      // seconds, triggers inside it are coalesced
+	float length;        // seconds, 0 plays until freed
+};
+
+struct VOICE
+{
+	int sound;           // -1 when free
+	float volume;
+	float start;         // trigger time, seconds
+	unsigned int handle; // the backend's channel or voice
+};
+
+struct VOICETRIGGER
+{
+	int voice;           // -1 when dropped
+	int stolen;          // voice whose playback must be stopped first, -1 for none
+	bool bCoalesced;     // voice is an instance already playing, volume raised to the trigger's
+};
+
+struct VOICESTATS
+{
+	int nTriggered;
+	int nPlayed;
+	int nCoalesced;
+	int nStolen;         // replaced at the instance limit or stolen from another sound
+	int nDropped;
+	int nPeakVoices;
+};
+
+struct VOICEPOOL
+{
+	int nVoices;
+	VOICE voices[VOICE_MAX_VOICES];
+	VOICESOUND sounds[VOICE_MAX_SOUNDS];
+	VOICESTATS stats;
+};
+
+void Voice_Init(VOICEPOOL* pPool, int nVoices);
+void Voice_SetSound(VOICEPOOL* pPool, int sound, int priority, int maxInstances, float fCooldown, float fLength);
+VOICETRIGGER Voice_Trigger(VOICEPOOL* pPool, int sound, float fVolume, float fNow);
+void Voice_Free(VOICEPOOL* pPool, int voice);    // the backend finished or stopped it
+void Voice_Update(VOICEPOOL* pPool, float fNow);    // frees voices past their sound's length
+int Voice_Count(const VOICEPOOL* pPool);
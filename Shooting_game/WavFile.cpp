@@ -0,0 +1,181 @@
+#include "WavFile.h"
+#include <string.h>
+
+#define WAVFILE_FORMAT_EXTENSIBLE  0xfffe
+
+static unsigned int WavFile_U16(const unsigned char* p)
+{
+	return p[0] | (p[1] << 8);
+}
+
+static unsigned int WavFile_U32(const unsigned char* p)
+{
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((unsigned int)p[3] << 24);
+}
+
+//WavFile_ParseFormat() : PCM and float only, with a block size that matches the channels
+static bool WavFile_ParseFormat(const unsigned char* p, unsigned int nSize, WAVFILEFORMAT* pFormat)
+{
+	if (nSize < 16)
+		return false;
+
+	pFormat->formatTag = WavFile_U16(p);
+	pFormat->channels = WavFile_U16(p + 2);
+	pFormat->sampleRate = WavFile_U32(p + 4);
+	pFormat->bytesPerSecond = WavFile_U32(p + 8);
+	pFormat->blockAlign = WavFile_U16(p + 12);
+	pFormat->bitsPerSample = WavFile_U16(p + 14);
+
+	// the real format is the first two bytes of the subformat GUID
+	if (pFormat->formatTag == WAVFILE_FORMAT_EXTENSIBLE)
+	{
+		if (nSize < 40 || WavFile_U16(p + 16) < 22)
+			return false;
+		pFormat->formatTag = WavFile_U16(p + 24);
+	}
+
+	if (pFormat->formatTag != WAVFILE_FORMAT_PCM && pFormat->formatTag != WAVFILE_FORMAT_FLOAT)
+		return false;
+	if (pFormat->channels == 0 || pFormat->channels > 8 || pFormat->sampleRate == 0)
+		return false;
+	if (pFormat->bitsPerSample != 8 && pFormat->bitsPerSample != 16 && pFormat->bitsPerSample != 24 &&
+		pFormat->bitsPerSample != 32)
+		return false;
+
+	return pFormat->blockAlign == pFormat->channels * pFormat->bitsPerSample / 8;
+}
+
+static bool WavFile_ParseLoops(const unsigned char* p, unsigned int nSize, WAVFILE* pWav)
+{
+	if (nSize < 36)
+		return false;
+
+	unsigned int nLoops = WavFile_U32(p + 28);
+	if (nLoops > (nSize - 36) / 24)
+		return false;
+
+	for (unsigned int i = 0; i < nLoops && pWav->nLoops < WAVFILE_MAX_LOOPS; i++)
+	{
+		const unsigned char* pLoop = p + 36 + i * 24;
+		WAVFILELOOP& loop = pWav->loops[pWav->nLoops++];
+		loop.start = WavFile_U32(pLoop + 8);
+		loop.end = WavFile_U32(pLoop + 12);
+	}
+
+	return true;
+}
+
+//WavFile_Parse() : fails on anything that would read outside the buffer
+bool WavFile_Parse(const void* pData, size_t nSize, WAVFILE* pWav)
+{
+	const unsigned char* pBase = (const unsigned char*)pData;
+	bool bFormat = false;
+	WAVFILECHUNK data = { { 0 }, NULL, 0 };
+
+	memset(pWav, 0, sizeof(*pWav));
+
+	if (nSize < 12 || memcmp(pBase, "RIFF", 4) != 0 || memcmp(pBase + 8, "WAVE", 4) != 0)
+		return false;
+
+	// some writers leave the RIFF size 0 or get it wrong, the chunks still have to fit the file
+	size_t nEnd = (size_t)WavFile_U32(pBase + 4) + 8;
+	if (nEnd < 12 || nEnd > nSize)
+		nEnd = nSize;
+
+	for (size_t offset = 12; offset + 8 <= nEnd;)
+	{
+		const unsigned char* pChunk = pBase + offset;
+		unsigned int nChunk = WavFile_U32(pChunk + 4);
+		if (nChunk > nEnd - offset - 8)
+			return false;
+
+		WAVFILECHUNK chunk;
+		memcpy(chunk.id, pChunk, 4);
+		chunk.pData = pChunk + 8;
+		chunk.nSize = nChunk;
+
+		if (pWav->nChunks < WAVFILE_MAX_CHUNKS)
+			pWav->chunks[pWav->nChunks++] = chunk;
+
+		if (memcmp(chunk.id, "fmt ", 4) == 0)
+		{
+			if (bFormat || !WavFile_ParseFormat(chunk.pData, nChunk, &pWav->format))
+				return false;
+			bFormat = true;
+		}
+		else if (memcmp(chunk.id, "data", 4) == 0)
+		{
+			if (data.pData != NULL)
+				return false;
+			data = chunk;
+		}
+		else if (memcmp(chunk.id, "smpl", 4) == 0)
+		{
+			if (!WavFile_ParseLoops(chunk.pData, nChunk, pWav))
+				return false;
+		}
+		else if (memcmp(chunk.id, "LIST", 4) == 0 && pWav->pList == NULL)
+		{
+			pWav->pList = chunk.pData;
+			pWav->nListBytes = nChunk;
+		}
+
+		// chunks are padded to an even size
+		offset += 8 + (size_t)nChunk + (nChunk & 1);
+	}
+
+	if (bFormat == false || data.pData == NULL)
+		return false;
+
+	pWav->pSamples = data.pData;
+	pWav->nFrames = data.nSize / pWav->format.blockAlign;
+	pWav->nBytes = pWav->nFrames * pWav->format.blockAlign;
+
+	for (int i = 0; i < pWav->nLoops; i++)
+	{
+		if (pWav->loops[i].start > pWav->loops[i].end || pWav->loops[i].end >= pWav->nFrames)
+			return false;
+	}
+
+	return true;
+}
+
+bool WavFile_Open(const char* pFile, WAVFILE* pWav)
+{
+	memset(pWav, 0, sizeof(*pWav));
+
+	FILEMAP map;
+	if (!FileMap_Open(pFile, &map))
+		return false;
+
+	bool bOk = WavFile_Parse(map.pBase, map.nSize, pWav);
+
+	// parsing clears the struct, the mapping is filled in after it
+	pWav->map = map;
+
+	if (bOk == false)
+	{
+		WavFile_Close(pWav);
+		return false;
+	}
+
+	return true;
+}
+
+const WAVFILECHUNK* WavFile_FindChunk(const WAVFILE* pWav, const char* pId)
+{
+	for (int i = 0; i < pWav->nChunks; i++)
+	{
+		if (memcmp(pWav->chunks[i].id, pId, 4) == 0)
+			return &pWav->chunks[i];
+	}
+
+	return NULL;
+}
+
+//WavFile_Close() : unmaps a file from WavFile_Open(), the views are gone after it
+void WavFile_Close(WAVFILE* pWav)
+{
+	FileMap_Close(&pWav->map);
+	memset(pWav, 0, sizeof(*pWav));
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <stddef.h>
+#include "FileMap.h"
+
+// RIFF/WAVE reader.
+// The file is mapped and parsed in place: WavFile_Open() walks the chunks
+// once, checks that every one of them lies inside the file, and keeps an
+// index of them, so the sample data, the LIST metadata and any other chunk
+// are views into the mapping rather than copies. The format is decoded
+// from "fmt " (WAVE_FORMAT_EXTENSIBLE included) and loop points from
+// "smpl". WavFile_Parse() does the same for a buffer already in memory.
+
+#define WAVFILE_MAX_CHUNKS  16
+#define WAVFILE_MAX_LOOPS   4
+
+#define WAVFILE_FORMAT_PCM    1
+#define WAVFILE_FORMAT_FLOAT  3
+
+struct WAVFILEFORMAT
+{
+	unsigned int formatTag;    // the subformat for WAVE_FORMAT_EXTENSIBLE
+	unsigned int channels;
+	unsigned int sampleRate;
+	unsigned int bytesPerSecond;
+	unsigned int blockAlign;
+	unsigned int bitsPerSample;
+};
+
+struct WAVFILECHUNK
+{
+	char id[4];
+	const unsigned char* pData;
+	unsigned int nSize;
+};
+
+struct WAVFILELOOP
+{
+	unsigned int start;    // first frame
+	unsigned int end;      // last frame, played too
+};
+
+struct WAVFILE
+{
+	WAVFILEFORMAT format;
+	const void* pSamples;    // the data chunk, whole frames only
+	unsigned int nBytes;
+	unsigned int nFrames;
+	const unsigned char* pList;    // the first LIST chunk, NULL when there is none
+	unsigned int nListBytes;
+	WAVFILELOOP loops[WAVFILE_MAX_LOOPS];
+	int nLoops;
+	WAVFILECHUNK chunks[WAVFILE_MAX_CHUNKS];    // in file order, chunks past the table are skipped
+	int nChunks;
+
+	FILEMAP map;
+};
+
+bool WavFile_Open(const char* pFile, WAVFILE* pWav);    // maps and validates the file
+bool WavFile_Parse(const void* pData, size_t nSize, WAVFILE* pWav);    // the buffer must outlive the views
+const WAVFILECHUNK* WavFile_FindChunk(const WAVFILE* pWav, const char* pId);
+void WavFile_Close(WAVFILE* pWav);
@@ -0,0 +1,208 @@
+#include "Flipbook.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+static UINT Flipbook_Pow2(UINT n)
+{
+	UINT p = 1;
+
+	while (p < n)
+		p <<= 1;
+
+	return p;
+}
+
+//Flipbook_CopyFrame() : copies a frame into its cell and repeats its edge
+//texels into the border around it
+static void Flipbook_CopyFrame(LPDIRECT3DTEXTURE9 pFrame, const D3DLOCKED_RECT& atlas, UINT x0, UINT y0)
+{
+	D3DSURFACE_DESC desc;
+	D3DLOCKED_RECT src;
+
+	if (FAILED(pFrame->GetLevelDesc(0, &desc)))
+		return;
+	if (desc.Format != D3DFMT_A8R8G8B8 && desc.Format != D3DFMT_X8R8G8B8)
+	{
+		OutputDebugStringA("flipbook: frames must be A8R8G8B8 or X8R8G8B8\n");
+		return;
+	}
+	if (FAILED(pFrame->LockRect(0, &src, NULL, D3DLOCK_READONLY)))
+		return;
+
+	DWORD alpha = desc.Format == D3DFMT_X8R8G8B8 ? 0xff000000 : 0;
+	UINT w = desc.Width;
+	UINT h = desc.Height;
+
+	for (int y = -1; y <= (int)h; y++)
+	{
+		int sy = y < 0 ? 0 : (y >= (int)h ? h - 1 : y);
+		const DWORD* pSrc = (const DWORD*)((const BYTE*)src.pBits + sy * src.Pitch);
+		DWORD* pDst = (DWORD*)((BYTE*)atlas.pBits + (y0 + y) * atlas.Pitch) + x0;
+
+		for (UINT x = 0; x < w; x++)
+			pDst[x] = pSrc[x] | alpha;
+		pDst[-1] = pSrc[0] | alpha;
+		pDst[w] = pSrc[w - 1] | alpha;
+	}
+
+	pFrame->UnlockRect(0);
+}
+
+//Flipbook_Create() : packs the frames, lockable 32-bit textures, into one
+//managed texture; a NULL frame leaves its cell transparent
+bool Flipbook_Create(LPDIRECT3DDEVICE9 pDevice, const LPDIRECT3DTEXTURE9* pFrames, int nFrames, FLIPBOOK* pBook)
+{
+	UINT frameWidth[FLIPBOOK_MAX_FRAMES], frameHeight[FLIPBOOK_MAX_FRAMES];
+	UINT cellWidth = 0, cellHeight = 0;
+
+	memset(pBook, 0, sizeof(FLIPBOOK));
+	if (nFrames <= 0 || nFrames > FLIPBOOK_MAX_FRAMES)
+		return false;
+
+	for (int i = 0; i < nFrames; i++)
+	{
+		D3DSURFACE_DESC desc;
+
+		frameWidth[i] = frameHeight[i] = 0;
+		if (pFrames[i] == NULL || FAILED(pFrames[i]->GetLevelDesc(0, &desc)))
+			continue;
+
+		frameWidth[i] = desc.Width;
+		frameHeight[i] = desc.Height;
+		if (desc.Width + 2 > cellWidth)
+			cellWidth = desc.Width + 2;
+		if (desc.Height + 2 > cellHeight)
+			cellHeight = desc.Height + 2;
+	}
+
+	if (cellWidth == 0)
+		return false;
+
+	// the grid whose power of two texture is smallest, the squarer one on a tie
+	int columns = 0;
+	UINT width = 0, height = 0;
+	for (int c = 1; c <= nFrames; c++)
+	{
+		int rows = (nFrames + c - 1) / c;
+		UINT w = Flipbook_Pow2(c * cellWidth);
+		UINT h = Flipbook_Pow2(rows * cellHeight);
+
+		if (w > FLIPBOOK_MAX_SIZE || h > FLIPBOOK_MAX_SIZE)
+			continue;
+		if (columns == 0 || w * h < width * height || (w * h == width * height && (w > h ? w : h) < (width > height ? width : height)))
+		{
+			columns = c;
+			width = w;
+			height = h;
+		}
+	}
+
+	if (columns == 0)
+	{
+		OutputDebugStringA("flipbook: frames do not fit in one texture\n");
+		return false;
+	}
+
+	if (FAILED(pDevice->CreateTexture(width, height, 1, 0, D3DFMT_A8R8G8B8, D3DPOOL_MANAGED, &pBook->pTexture, NULL)))
+		return false;
+
+	D3DLOCKED_RECT atlas;
+	if (FAILED(pBook->pTexture->LockRect(0, &atlas, NULL, 0)))
+	{
+		Flipbook_Release(pBook);
+		return false;
+	}
+
+	for (UINT y = 0; y < height; y++)
+		memset((BYTE*)atlas.pBits + y * atlas.Pitch, 0, width * 4);
+
+	for (int i = 0; i < nFrames; i++)
+	{
+		UINT x0 = (i % columns) * cellWidth + 1;
+		UINT y0 = (i / columns) * cellHeight + 1;
+		FLIPBOOKFRAME& frame = pBook->frames[i];
+
+		if (frameWidth[i] != 0)
+			Flipbook_CopyFrame(pFrames[i], atlas, x0, y0);
+
+		frame.u0 = (float)x0 / width;
+		frame.v0 = (float)y0 / height;
+		frame.u1 = (float)(x0 + frameWidth[i]) / width;
+		frame.v1 = (float)(y0 + frameHeight[i]) / height;
+	}
+
+	pBook->pTexture->UnlockRect(0);
+	pBook->width = width;
+	pBook->height = height;
+	pBook->nFrames = nFrames;
+
+	char szReport[96];
+	sprintf_s(szReport, sizeof(szReport), "flipbook: %d frames in %ux%u, %d columns\n", nFrames, width, height, columns);
+	OutputDebugStringA(szReport);
+
+	return true;
+}
+
+//Flipbook_GetTransform() : maps texture coordinates 0..1 onto the frame's rectangle
+void Flipbook_GetTransform(const FLIPBOOK* pBook, int frame, MAT4* pMatrix)
+{
+	Mat4_Identity(pMatrix);
+	if (frame < 0 || frame >= pBook->nFrames)
+		return;
+
+	const FLIPBOOKFRAME& rect = pBook->frames[frame];
+	pMatrix->m[0][0] = rect.u1 - rect.u0;
+	pMatrix->m[1][1] = rect.v1 - rect.v0;
+	pMatrix->m[2][0] = rect.u0;
+	pMatrix->m[2][1] = rect.v0;
+}
+
+void Flipbook_Release(FLIPBOOK* pBook)
+{
+	if (pBook->pTexture != NULL)
+		pBook->pTexture->Release();
+
+	memset(pBook, 0, sizeof(FLIPBOOK));
+}
+
+void Flipbook_Play(FLIPPLAYER* pPlayer, const FLIPCLIP* pClip)
+{
+	if (pPlayer->pClip == pClip)
+		return;
+
+	pPlayer->pClip = pClip;
+	pPlayer->time = 0.0f;
+}
+
+//Flipbook_Advance() : a looping clip keeps its time within one pass, so the
+//frame number does not lose precision over a long run
+void Flipbook_Advance(FLIPPLAYER* pPlayer, float fSeconds)
+{
+	const FLIPCLIP* pClip = pPlayer->pClip;
+
+	if (pClip == NULL)
+		return;
+
+	pPlayer->time += fSeconds;
+
+	float length = pClip->nFrames / pClip->fps;
+	if (pClip->bLoop)
+		pPlayer->time = fmodf(pPlayer->time, length);
+	else if (pPlayer->time > length)
+		pPlayer->time = length;
+}
+
+int Flipbook_GetFrame(const FLIPPLAYER* pPlayer)
+{
+	const FLIPCLIP* pClip = pPlayer->pClip;
+
+	if (pClip == NULL || pClip->nFrames == 0)
+		return 0;
+
+	int i = (int)(pPlayer->time * pClip->fps);
+	if (i >= pClip->nFrames)
+		i = pClip->bLoop ? i % pClip->nFrames : pClip->nFrames - 1;
+
+	return pClip->pFrames[i];
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <d3d9.h>
+#include <d3dx9.h>
+#include "VecMath.h"
+
+// Flipbook animation.
+// The frames of an animation are packed into one texture, a grid of cells
+// with a one texel border copied from each frame's edge so filtering never
+// picks up the neighbour. The frame table holds each frame's UV rectangle;
+// a clip is a list of frame numbers played at a fixed rate, and a player
+// turns elapsed time into the frame to draw. Switching frames only changes
+// the texture transform, the texture stays bound.
+
+#define FLIPBOOK_MAX_FRAMES  32
+#define FLIPBOOK_MAX_SIZE    2048    // largest atlas side, the minimum every D3D9 part supports
+
+struct FLIPBOOKFRAME
+{
+	float u0, v0;
+	float u1, v1;
+};
+
+struct FLIPBOOK
+{
+	LPDIRECT3DTEXTURE9 pTexture;
+	UINT width;
+	UINT height;
+	int nFrames;
+	FLIPBOOKFRAME frames[FLIPBOOK_MAX_FRAMES];
+};
+
+struct FLIPCLIP
+{
+	const unsigned char* pFrames;    // frame numbers, in play order
+	int nFrames;
+	float fps;
+	bool bLoop;    // otherwise holds the last frame
+};
+
+struct FLIPPLAYER
+{
+	const FLIPCLIP* pClip;
+	float time;
+};
+
+bool Flipbook_Create(LPDIRECT3DDEVICE9 pDevice, const LPDIRECT3DTEXTURE9* pFrames, int nFrames, FLIPBOOK* pBook);
+void Flipbook_GetTransform(const FLIPBOOK* pBook, int frame, MAT4* pMatrix);    // for D3DTS_TEXTUREn with D3DTTFF_COUNT2
+void Flipbook_Release(FLIPBOOK* pBook);
+void Flipbook_Play(FLIPPLAYER* pPlayer, const FLIPCLIP* pClip);    // restarts only when the clip changes
+void Flipbook_Advance(FLIPPLAYER* pPlayer, float fSeconds);
+int Flipbook_GetFrame(const FLIPPLAYER* pPlayer);
@@ -0,0 +1,53 @@
+#pragma once
+#include <d3d9.h>
+#include <d3dx9.h>
+
+// Reference counted texture manager on top of the loader.
+// Textures are acquired by file name and come back as handles; acquiring a
+// file that is already resident only adds a reference. Every texture is
+// charged to a category, and when the resident total is over the budget
+// Res_Update() evicts textures nobody holds, least recently used first.
+// An evicted texture keeps its slot, so acquiring it again queues a reload.
+// Handles carry a generation, so a handle kept past its release reads NULL
+// instead of another texture. Res_Shutdown() releases everything and
+// reports what was still referenced.
+// Like Loader_Poll(), all of it runs on the thread that draws with the textures.
+
+#define RES_MAX_TEXTURES    64
+#define RES_MAX_CATEGORIES  8
+
+struct TEXTUREHANDLE
+{
+	unsigned int value;    // generation << 16 | slot + 1, 0 is no texture
+};
+
+struct RESCATEGORYSTATS
+{
+	const char* pName;
+	int nResident;      // textures in memory
+	int nReferenced;    // of those, textures with at least one reference
+	size_t nBytes;
+};
+
+struct RESSTATS
+{
+	size_t nBytes;        // resident texture memory, all levels
+	size_t nBudget;       // 0 is no budget
+	size_t nPeakBytes;
+	int nEvicted;
+	int nReloaded;        // evicted textures acquired again
+};
+
+bool Res_Init(size_t nBudget);
+void Res_SetCategoryName(int category, const char* pName);
+TEXTUREHANDLE Res_AcquireTexture(LPCWSTR pFile, UINT width, UINT height, D3DFORMAT format, D3DCOLOR colorKey,
+	int category, int group);
+void Res_AddRef(TEXTUREHANDLE handle);
+void Res_Release(TEXTUREHANDLE* pHandle);    // clears the handle
+LPDIRECT3DTEXTURE9 Res_GetTexture(TEXTUREHANDLE handle);    // NULL while loading or for a stale handle
+bool Res_IsValid(TEXTUREHANDLE handle);
+void Res_Update(void);                  // call once a frame, after Loader_Poll()
+int Res_Trim(size_t nBytes);            // evicts unreferenced textures down to nBytes
+const RESSTATS& Res_GetStats(void);
+RESCATEGORYSTATS Res_GetCategoryStats(int category);
+int Res_Shutdown(void);                 // after Loader_Release(), returns the number of leaked textures
@@ -0,0 +1,60 @@
+#pragma once
+#include <stddef.h>
+#include "FileMap.h"
+
+// Cooked texture container (.ctex).
+// A cooked file holds the pixels exactly as a locked texture level expects
+// them, A8R8G8B8 or DXT1/DXT5 blocks: color key already baked into alpha,
+// optional premultiplied alpha and mip chain, every level 64-byte aligned. The loader maps the file
+// and copies each level straight into the locked texture, so loading does
+// no decoding and no intermediate allocation. Files are written by the
+// cooker (TexCook) and carry a hash of the source they were cooked from.
+
+#define TEXFILE_MAGIC       0x58455443    // 'CTEX'
+#define TEXFILE_VERSION     1
+#define TEXFILE_MAX_LEVELS  16
+#define TEXFILE_ALIGN       64
+
+#define TEXFILE_COLORKEY      0x1    // colorKey pixels were turned transparent
+#define TEXFILE_PREMULTIPLIED 0x2
+#define TEXFILE_MIPS          0x4
+
+#define TEXFILE_FORMAT_A8R8G8B8  21            // D3DFMT_A8R8G8B8
+#define TEXFILE_FORMAT_DXT1      0x31545844    // D3DFMT_DXT1, BC1
+#define TEXFILE_FORMAT_DXT5      0x35545844    // D3DFMT_DXT5, BC3
+
+struct TEXFILEHEADER
+{
+	unsigned int magic;
+	unsigned int version;
+	unsigned int flags;
+	unsigned int format;
+	unsigned int width;
+	unsigned int height;
+	unsigned int levels;
+	unsigned int colorKey;
+	unsigned int sourceHash;    // FNV-1a of the source file
+	unsigned int reserved[7];
+};
+
+struct TEXFILELEVEL
+{
+	unsigned int offset;    // from the start of the file
+	unsigned int width;
+	unsigned int height;
+	unsigned int pitch;     // bytes per row of texels, or of 4x4 blocks
+};
+
+struct TEXFILE
+{
+	const TEXFILEHEADER* pHeader;
+	const TEXFILELEVEL* pLevels;
+	FILEMAP map;
+};
+
+unsigned int TexFile_Hash(const void* pData, size_t nSize);
+
+bool TexFile_Open(const char* pFile, TEXFILE* pTex);    // maps and validates the file
+const void* TexFile_GetPixels(const TEXFILE* pTex, unsigned int level);
+unsigned int TexFile_GetRows(const TEXFILE* pTex, unsigned int level);    // rows of pitch bytes
+void TexFile_Close(TEXFILE* pTex);
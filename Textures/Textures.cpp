@@ -30,6 +30,10 @@
 #pragma warning( disable : 4996 ) // disable deprecated warning 
 #include <strsafe.h>
 #pragma warning( default : 4996 )
+#include "Loader.h"
+#include "ResManager.h"
+#include "Flipbook.h"
+#include "VecMath.h"
 
 
 
@@ -39,30 +43,47 @@
 LPDIRECT3D9             g_pD3D = NULL; // Used to create the D3DDevice
 LPDIRECT3DDEVICE9       g_pd3dDevice = NULL; // Our rendering device
 LPDIRECT3DVERTEXBUFFER9 g_pVB = NULL; // Buffer to hold vertices
-LPDIRECT3DTEXTURE9      g_pTexture00 = NULL; // Our texture
-LPDIRECT3DTEXTURE9      g_pTexture01 = NULL;
-LPDIRECT3DTEXTURE9      g_pTexture02 = NULL;
-LPDIRECT3DTEXTURE9      g_pTexture03 = NULL;
-LPDIRECT3DTEXTURE9      g_pTexture04 = NULL;
-LPDIRECT3DTEXTURE9      g_pTexture05 = NULL;
-LPDIRECT3DTEXTURE9      g_pTexture06 = NULL;
-LPDIRECT3DTEXTURE9      g_pTexture07 = NULL;
-LPDIRECT3DTEXTURE9      g_pTexture08 = NULL;
-LPDIRECT3DTEXTURE9      g_pTexture09 = NULL;
-LPDIRECT3DTEXTURE9      g_pTexture10 = NULL;
-LPDIRECT3DTEXTURE9      g_pTexture11 = NULL;
+FLIPBOOK                g_Flipbook; // All animation frames in one texture
+FLIPPLAYER              g_Player;
+
+// The frames are loaded one texture each and packed into the flipbook once
+// they are all in; the frame numbers below index this table
+LPCWSTR g_FrameFiles[] =
+{
+	L"right_walk_1.png", L"right_walk_2.png", L"right_walk_3.png",
+	L"attack_1.png", L"attack_2.png", L"attack_3.png",
+	L"skill_1.png", L"skill_2.png",
+	L"left_walk_1.png", L"left_walk_2.png", L"left_walk_3.png",
+};
+#define FRAME_NUM ((int)(sizeof(g_FrameFiles) / sizeof(g_FrameFiles[0])))
+TEXTUREHANDLE           g_hFrames[FRAME_NUM];
+bool                    g_bPacked = false;
+
+// Clips, indexed by B: go left, attack, attack2, go right, stand
+const unsigned char g_LeftFrames[] = { 8, 9, 10 };
+const unsigned char g_AttackFrames[] = { 3, 4, 5, 4, 3 };
+const unsigned char g_Attack2Frames[] = { 3, 4, 5, 6, 7, 3 };
+const unsigned char g_RightFrames[] = { 0, 1, 2 };
+const unsigned char g_StandFrames[] = { 0 };
+const FLIPCLIP g_Clips[] =
+{
+	{ g_LeftFrames, 3, 6.0f, true },
+	{ g_AttackFrames, 5, 6.0f, true },
+	{ g_Attack2Frames, 6, 6.0f, true },
+	{ g_RightFrames, 3, 6.0f, true },
+	{ g_StandFrames, 1, 6.0f, false },
+};
 
 float A = 0;
 int B = 4;
-static float counter = 0;
-static float counter2 = 0;
-static float counter3 = 0;
-static float counter4 = 0;
+bool g_bKeyHeld = false; // The clip plays while its key is down
+DWORD g_dwLastTime = 0;
+DWORD g_dwStartTime = 0; // For the time-to-first-frame report
 
 // A structure for our custom vertex type. We added texture coordinates
 struct CUSTOMVERTEX
 {
-	D3DXVECTOR3 position; // The position
+	VEC3 position;      // The position
 	D3DCOLOR color;    // The color
 	FLOAT tu, tv;   // The texture coordinates
 };
@@ -97,8 +118,10 @@ HRESULT InitD3D(HWND hWnd)
 	d3dpp.AutoDepthStencilFormat = D3DFMT_D16;
 
 	// Create the D3DDevice
+	// The device is multithreaded because the loader creates textures from
+	// its worker threads
 	if (FAILED(g_pD3D->CreateDevice(D3DADAPTER_DEFAULT, D3DDEVTYPE_HAL, hWnd,
-		D3DCREATE_SOFTWARE_VERTEXPROCESSING,
+		D3DCREATE_SOFTWARE_VERTEXPROCESSING | D3DCREATE_MULTITHREADED,
 		&d3dpp, &g_pd3dDevice)))
 	{
 		return E_FAIL;
@@ -138,18 +161,12 @@ HRESULT InitGeometry()
 	}
 	*/
 
-		D3DXCreateTextureFromFile(g_pd3dDevice, L"right_walk_1.png", &g_pTexture00);
-		D3DXCreateTextureFromFile(g_pd3dDevice, L"right_walk_2.png", &g_pTexture01);
-		D3DXCreateTextureFromFile(g_pd3dDevice, L"right_walk_3.png", &g_pTexture02);
-		D3DXCreateTextureFromFile(g_pd3dDevice, L"attack_1.png", &g_pTexture03);
-		D3DXCreateTextureFromFile(g_pd3dDevice, L"attack_2.png", &g_pTexture04);
-		D3DXCreateTextureFromFile(g_pd3dDevice, L"attack_3.png", &g_pTexture05);
-		D3DXCreateTextureFromFile(g_pd3dDevice, L"skill_1.png", &g_pTexture06);
-		D3DXCreateTextureFromFile(g_pd3dDevice, L"skill_2.png", &g_pTexture07);
-		D3DXCreateTextureFromFile(g_pd3dDevice, L"left_walk_1.png", &g_pTexture08);
-		D3DXCreateTextureFromFile(g_pd3dDevice, L"left_walk_2.png", &g_pTexture09);
-		D3DXCreateTextureFromFile(g_pd3dDevice, L"left_walk_3.png", &g_pTexture10);
-		D3DXCreateTextureFromFile(g_pd3dDevice, L"right_walk_1.png", &g_pTexture11);
+	// Decode the animation frames on the loader threads. The quad is drawn
+	// untextured until all of them are handed over and packed.
+	Loader_Init(g_pd3dDevice, 0, g_dwStartTime);
+	Res_Init(0);
+	for (int i = 0; i < FRAME_NUM; i++)
+		g_hFrames[i] = Res_AcquireTexture(g_FrameFiles[i], D3DX_DEFAULT_NONPOW2, D3DX_DEFAULT_NONPOW2, D3DFMT_A8R8G8B8, 0, 0, 0);
 
 	// Create the vertex buffer.
 	if (FAILED(g_pd3dDevice->CreateVertexBuffer(6 * sizeof(CUSTOMVERTEX),
@@ -166,32 +183,32 @@ HRESULT InitGeometry()
 		return E_FAIL;
 
 	{
-		pVertices[0].position = D3DXVECTOR3(1.0f, 1.0f, 0.0f);
+		pVertices[0].position = Vec3(1.0f, 1.0f, 0.0f);
 		pVertices[0].color = 0xffffffff;
 		pVertices[0].tu = 0.0f;
 		pVertices[0].tv = 1.0f;
 
-		pVertices[1].position = D3DXVECTOR3(-1.0f, -1.0f, 0.0f);
+		pVertices[1].position = Vec3(-1.0f, -1.0f, 0.0f);
 		pVertices[1].color = 0xffffffff;
 		pVertices[1].tu = 1.0f;
 		pVertices[1].tv = 0.0f;
 
-		pVertices[2].position = D3DXVECTOR3(1.0f, -1.0f, 0.0f);
+		pVertices[2].position = Vec3(1.0f, -1.0f, 0.0f);
 		pVertices[2].color = 0xffffffff;
 		pVertices[2].tu = 0.0f;
 		pVertices[2].tv = 0.0f;
 
-		pVertices[3].position = D3DXVECTOR3(-1.0f, -1.0f, 0.0f);
+		pVertices[3].position = Vec3(-1.0f, -1.0f, 0.0f);
 		pVertices[3].color = 0xffffffff;
 		pVertices[3].tu = 1.0f;
 		pVertices[3].tv = 0.0f;
 
-		pVertices[4].position = D3DXVECTOR3(1.0f, 1.0f, 0.0f);
+		pVertices[4].position = Vec3(1.0f, 1.0f, 0.0f);
 		pVertices[4].color = 0xffffffff;
 		pVertices[4].tu = 0.0f;
 		pVertices[4].tv = 1.0f;
 
-		pVertices[5].position = D3DXVECTOR3(-1.0f, 1.0f, 0.0f);
+		pVertices[5].position = Vec3(-1.0f, 1.0f, 0.0f);
 		pVertices[5].color = 0xffffffff;
 		pVertices[5].tu = 1.0f;
 		pVertices[5].tv = 1.0f;
@@ -205,14 +222,43 @@ HRESULT InitGeometry()
 
 
 
+//-----------------------------------------------------------------------------
+// Name: PackFrames()
+// Desc: Packs the loaded frames into the flipbook and lets the frame
+//       textures go
+//-----------------------------------------------------------------------------
+VOID PackFrames()
+{
+	LPDIRECT3DTEXTURE9 frames[FRAME_NUM];
+
+	for (int i = 0; i < FRAME_NUM; i++)
+		frames[i] = Res_GetTexture(g_hFrames[i]);
+
+	Flipbook_Create(g_pd3dDevice, frames, FRAME_NUM, &g_Flipbook);
+
+	for (int i = 0; i < FRAME_NUM; i++)
+		Res_Release(&g_hFrames[i]);
+	Res_Trim(0);
+
+	g_bPacked = true;
+}
+
+
+
+
 //-----------------------------------------------------------------------------
 // Name: Cleanup()
 // Desc: Releases all previously initialized objects
 //-----------------------------------------------------------------------------
 VOID Cleanup()
 {
-	if (g_pTexture00 != NULL)
-		g_pTexture00->Release();
+	Loader_Release();
+
+	for (int i = 0; i < FRAME_NUM; i++)
+		Res_Release(&g_hFrames[i]);
+	Res_Shutdown();
+
+	Flipbook_Release(&g_Flipbook);
 
 	if (g_pVB != NULL)
 		g_pVB->Release();
@@ -233,26 +279,26 @@ VOID Cleanup()
 VOID SetupMatrices()
 {
 	// Set up world matrix
-	D3DXMATRIXA16 matWorld;
-	D3DXMATRIXA16 matWorld01;
+	MAT4 matWorld;
+	MAT4 matWorld01;
 
 	
-	D3DXMatrixIdentity(&matWorld);
-	D3DXMatrixTranslation(&matWorld, A, 0.0f, 0.0f);
-	//D3DXMatrixRotationX(&matWorld, A);
-	g_pd3dDevice->SetTransform(D3DTS_WORLD, &matWorld);
+	Mat4_Identity(&matWorld);
+	Mat4_Translation(&matWorld, A, 0.0f, 0.0f);
+	//Mat4_RotationX(&matWorld, A);
+	g_pd3dDevice->SetTransform(D3DTS_WORLD, (D3DMATRIX*)&matWorld);
 	
 	
 	// Set up our view matrix. A view matrix can be defined given an eye point,
 	// a point to lookat, and a direction for which way is up. Here, we set the
 	// eye five units back along the z-axis and up three units, look at the
 	// origin, and define "up" to be in the y-direction.
-	D3DXVECTOR3 vEyePt(0.0f, 0.0f, -10.0f);
-	D3DXVECTOR3 vLookatPt(0.0f, 0.0f, 0.0f);
-	D3DXVECTOR3 vUpVec(0.0f, -1.0f, 0.0f);
-	D3DXMATRIXA16 matView;
-	D3DXMatrixLookAtLH(&matView, &vEyePt, &vLookatPt, &vUpVec);
-	g_pd3dDevice->SetTransform(D3DTS_VIEW, &matView);
+	VEC3 vEyePt = Vec3(0.0f, 0.0f, -10.0f);
+	VEC3 vLookatPt = Vec3(0.0f, 0.0f, 0.0f);
+	VEC3 vUpVec = Vec3(0.0f, -1.0f, 0.0f);
+	MAT4 matView;
+	Mat4_LookAtLH(&matView, vEyePt, vLookatPt, vUpVec);
+	g_pd3dDevice->SetTransform(D3DTS_VIEW, (D3DMATRIX*)&matView);
 
 	// For the projection matrix, we set up a perspective transform (which
 	// transforms geometry from 3D view space to 2D viewport space, with
@@ -260,9 +306,9 @@ VOID SetupMatrices()
 	// a perpsective transform, we need the field of view (1/4 pi is common),
 	// the aspect ratio, and the near and far clipping planes (which define at
 	// what distances geometry should be no longer be rendered).
-	D3DXMATRIXA16 matProj;
-	D3DXMatrixPerspectiveFovLH(&matProj, D3DX_PI / 7, 1.0f, 1.0f, 100.0f);
-	g_pd3dDevice->SetTransform(D3DTS_PROJECTION, &matProj);
+	MAT4 matProj;
+	Mat4_PerspectiveFovLH(&matProj, VECMATH_PI / 7, 1.0f, 1.0f, 100.0f);
+	g_pd3dDevice->SetTransform(D3DTS_PROJECTION, (D3DMATRIX*)&matProj);
 }
 
 
@@ -284,89 +330,18 @@ VOID Render()
 		// Setup the world, view, and projection matrices
 		SetupMatrices();
 
-		//go left & right
-		if (B == 0)
-		{
-			switch ((int)counter % 3)
-			{
-			case 0:
-				g_pd3dDevice->SetTexture(0, g_pTexture08);
-				break;
-			case 1:
-				g_pd3dDevice->SetTexture(0, g_pTexture09);
-				break;
-			case 2:
-				g_pd3dDevice->SetTexture(0, g_pTexture10);
-				break;
-			}
-		}
-		else if (B == 3)
-		{
-			switch ((int)counter4 % 3)
-			{
-			case 0:
-				g_pd3dDevice->SetTexture(0, g_pTexture00);
-				break;
-			case 1:
-				g_pd3dDevice->SetTexture(0, g_pTexture01);
-				break;
-			case 2:
-				g_pd3dDevice->SetTexture(0, g_pTexture01);
-				break;
-			}
-		}
-		//attack
-		else if (B == 1)
-		{
-			switch ((int)counter2 % 5)
-			{
-			case 0:
-				g_pd3dDevice->SetTexture(0, g_pTexture03);
-				break;
-			case 1:
-				g_pd3dDevice->SetTexture(0, g_pTexture04);
-				break;
-			case 2:
-				g_pd3dDevice->SetTexture(0, g_pTexture05);
-				break;
-			case 3:
-				g_pd3dDevice->SetTexture(0, g_pTexture04);
-				break;
-			case 4:
-				g_pd3dDevice->SetTexture(0, g_pTexture03);
-				break;
-			}
-		}
-
-		//attack2
-		else if (B == 2)
-		{
-			switch ((int)counter3 % 6)
-			{
-			case 0:
-				g_pd3dDevice->SetTexture(0, g_pTexture03);
-				break;
-			case 1:
-				g_pd3dDevice->SetTexture(0, g_pTexture04);
-				break;
-			case 2:
-				g_pd3dDevice->SetTexture(0, g_pTexture05);
-				break;
-			case 3:
-				g_pd3dDevice->SetTexture(0, g_pTexture06);
-				break;
-			case 4:
-				g_pd3dDevice->SetTexture(0, g_pTexture07);
-				break;
-			case 5:
-				g_pd3dDevice->SetTexture(0, g_pTexture03);
-				break;
-			}
-		}
-
+		// Pick the frame by time and point the texture coordinates at it
+		DWORD dwTime = timeGetTime();
+		Flipbook_Play(&g_Player, &g_Clips[B]);
+		if (g_bKeyHeld)
+			Flipbook_Advance(&g_Player, (dwTime - g_dwLastTime) * 0.001f);
+		g_dwLastTime = dwTime;
 
-		else
-			g_pd3dDevice->SetTexture(0, g_pTexture11);
+		MAT4 matFrame;
+		Flipbook_GetTransform(&g_Flipbook, Flipbook_GetFrame(&g_Player), &matFrame);
+		g_pd3dDevice->SetTransform(D3DTS_TEXTURE0, (D3DMATRIX*)&matFrame);
+		g_pd3dDevice->SetTextureStageState(0, D3DTSS_TEXTURETRANSFORMFLAGS, D3DTTFF_COUNT2);
+		g_pd3dDevice->SetTexture(0, g_Flipbook.pTexture);
 
 		// Setup our texture. Using Textures introduces the texture stage states,
 		// which govern how Textures get blended together (in the case of multiple
@@ -389,6 +364,8 @@ VOID Render()
 
 	// Present the backbuffer contents to the display
 	g_pd3dDevice->Present(NULL, NULL, NULL, NULL);
+
+	Loader_FirstFrame();
 }
 
 
@@ -406,19 +383,22 @@ LRESULT WINAPI MsgProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam)
 		switch (wParam)
 		{
 		case VK_LEFT:
-			B = 0, A = A + 0.01f, counter = counter + 0.2f;				
+			B = 0, A = A + 0.01f, g_bKeyHeld = true;
 			break;
 		case VK_RIGHT:
-			B = 3, A = A - 0.01f, counter4 = counter4 + 0.2f;
+			B = 3, A = A - 0.01f, g_bKeyHeld = true;
 			break;
 		case VK_SPACE:
-			B = 1, counter2 = counter2 + 0.2f;
+			B = 1, g_bKeyHeld = true;
 			break;
 		case VK_SHIFT:
-			B = 2, counter3 = counter3 + 0.2f;
+			B = 2, g_bKeyHeld = true;
 			break;
 		}
 		return 0;
+	case WM_KEYUP:
+		g_bKeyHeld = false;
+		return 0;
 	case WM_DESTROY:
 		Cleanup();
 		PostQuitMessage(0);
@@ -439,6 +419,8 @@ INT WINAPI wWinMain(HINSTANCE hInst, HINSTANCE, LPWSTR, INT)
 {
 	UNREFERENCED_PARAMETER(hInst);
 
+	g_dwStartTime = timeGetTime();
+
 	// Register the window class
 	WNDCLASSEX wc =
 	{
@@ -474,7 +456,13 @@ INT WINAPI wWinMain(HINSTANCE hInst, HINSTANCE, LPWSTR, INT)
 					DispatchMessage(&msg);
 				}
 				else
+				{
+					Loader_Poll();
+					Res_Update();
+					if (!g_bPacked && Loader_IsGroupReady(0))
+						PackFrames();
 					Render();
+				}
 			}
 		}
 	}
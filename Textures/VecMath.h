@@ -0,0 +1,427 @@
+#pragma once
+#include <math.h>
+
+// Vector and matrix math.
+// Header only and free of Windows, so the same transforms run in the demos
+// and in tools or tests on any platform. The conventions are D3DX's: left
+// handed, row vectors (v' = v * M, translation in the last row) and
+// matrices laid out like D3DMATRIX, so a MAT4 goes to SetTransform() as it
+// is and the builders return what their D3DX namesakes do.
+// Single matrices and vectors use SSE when the target has it; the batched
+// calls (Mat4_MultiplyArray(), Vec3_TransformCoordArray()) also have an
+// AVX2 kernel that does two at a time. Every path does the same multiplies
+// and adds in the same order, so SSE, AVX2 and the scalar fallback give
+// bit-identical results as long as the compiler does not fuse the scalar
+// ones into FMAs (MSVC does not; GCC needs -ffp-contract=off when FMA is
+// enabled). Define VECMATH_SCALAR to force the fallback.
+
+#if !defined(VECMATH_SCALAR) && (defined(_M_X64) || defined(__x86_64__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1) || defined(__SSE__))
+#define VECMATH_SSE
+#include <xmmintrin.h>
+#endif
+#if defined(VECMATH_SSE) && defined(__AVX2__)
+#define VECMATH_AVX2
+#include <immintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#define VECMATH_ALIGN __declspec(align(16))
+#else
+#define VECMATH_ALIGN __attribute__((aligned(16)))
+#endif
+
+#define VECMATH_PI  3.141592654f
+
+struct VEC3
+{
+	float x, y, z;
+};
+
+struct VECMATH_ALIGN VEC4
+{
+	float x, y, z, w;
+};
+
+// x, y, z is the axis scaled by the sine of half the angle, w the cosine
+struct VECMATH_ALIGN QUAT
+{
+	float x, y, z, w;
+};
+
+struct VECMATH_ALIGN MAT4
+{
+	float m[4][4];    // m[row][column], m[3] is the translation
+};
+
+
+inline VEC3 Vec3(float x, float y, float z)
+{
+	VEC3 v = { x, y, z };
+	return v;
+}
+
+inline VEC4 Vec4(float x, float y, float z, float w)
+{
+	VEC4 v = { x, y, z, w };
+	return v;
+}
+
+inline VEC3 Vec3_Add(const VEC3& a, const VEC3& b)
+{
+	return Vec3(a.x + b.x, a.y + b.y, a.z + b.z);
+}
+
+inline VEC3 Vec3_Subtract(const VEC3& a, const VEC3& b)
+{
+	return Vec3(a.x - b.x, a.y - b.y, a.z - b.z);
+}
+
+inline VEC3 Vec3_Scale(const VEC3& v, float s)
+{
+	return Vec3(v.x * s, v.y * s, v.z * s);
+}
+
+inline float Vec3_Dot(const VEC3& a, const VEC3& b)
+{
+	return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+inline VEC3 Vec3_Cross(const VEC3& a, const VEC3& b)
+{
+	return Vec3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+}
+
+inline float Vec3_Length(const VEC3& v)
+{
+	return sqrtf(Vec3_Dot(v, v));
+}
+
+//Vec3_Normalize() : a zero vector stays zero
+inline VEC3 Vec3_Normalize(const VEC3& v)
+{
+	float length = Vec3_Length(v);
+	return length > 0.0f ? Vec3_Scale(v, 1.0f / length) : v;
+}
+
+
+inline void Mat4_Identity(MAT4* pOut)
+{
+	for (int i = 0; i < 4; i++)
+		for (int j = 0; j < 4; j++)
+			pOut->m[i][j] = i == j ? 1.0f : 0.0f;
+}
+
+inline void Mat4_Translation(MAT4* pOut, float x, float y, float z)
+{
+	Mat4_Identity(pOut);
+	pOut->m[3][0] = x;
+	pOut->m[3][1] = y;
+	pOut->m[3][2] = z;
+}
+
+inline void Mat4_Scaling(MAT4* pOut, float x, float y, float z)
+{
+	Mat4_Identity(pOut);
+	pOut->m[0][0] = x;
+	pOut->m[1][1] = y;
+	pOut->m[2][2] = z;
+}
+
+// positive angles turn clockwise looking down the axis at the origin, like D3DX
+inline void Mat4_RotationX(MAT4* pOut, float angle)
+{
+	float s = sinf(angle), c = cosf(angle);
+	Mat4_Identity(pOut);
+	pOut->m[1][1] = c;
+	pOut->m[1][2] = s;
+	pOut->m[2][1] = -s;
+	pOut->m[2][2] = c;
+}
+
+inline void Mat4_RotationY(MAT4* pOut, float angle)
+{
+	float s = sinf(angle), c = cosf(angle);
+	Mat4_Identity(pOut);
+	pOut->m[0][0] = c;
+	pOut->m[0][2] = -s;
+	pOut->m[2][0] = s;
+	pOut->m[2][2] = c;
+}
+
+inline void Mat4_RotationZ(MAT4* pOut, float angle)
+{
+	float s = sinf(angle), c = cosf(angle);
+	Mat4_Identity(pOut);
+	pOut->m[0][0] = c;
+	pOut->m[0][1] = s;
+	pOut->m[1][0] = -s;
+	pOut->m[1][1] = c;
+}
+
+//Mat4_RotationQuat() : q is expected to be unit length
+inline void Mat4_RotationQuat(MAT4* pOut, const QUAT& q)
+{
+	float xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+	float xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+	float wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+
+	Mat4_Identity(pOut);
+	pOut->m[0][0] = 1.0f - 2.0f * (yy + zz);
+	pOut->m[0][1] = 2.0f * (xy + wz);
+	pOut->m[0][2] = 2.0f * (xz - wy);
+	pOut->m[1][0] = 2.0f * (xy - wz);
+	pOut->m[1][1] = 1.0f - 2.0f * (xx + zz);
+	pOut->m[1][2] = 2.0f * (yz + wx);
+	pOut->m[2][0] = 2.0f * (xz + wy);
+	pOut->m[2][1] = 2.0f * (yz - wx);
+	pOut->m[2][2] = 1.0f - 2.0f * (xx + yy);
+}
+
+inline void Mat4_LookAtLH(MAT4* pOut, const VEC3& eye, const VEC3& at, const VEC3& up)
+{
+	VEC3 zaxis = Vec3_Normalize(Vec3_Subtract(at, eye));
+	VEC3 xaxis = Vec3_Normalize(Vec3_Cross(up, zaxis));
+	VEC3 yaxis = Vec3_Cross(zaxis, xaxis);
+
+	pOut->m[0][0] = xaxis.x; pOut->m[0][1] = yaxis.x; pOut->m[0][2] = zaxis.x; pOut->m[0][3] = 0.0f;
+	pOut->m[1][0] = xaxis.y; pOut->m[1][1] = yaxis.y; pOut->m[1][2] = zaxis.y; pOut->m[1][3] = 0.0f;
+	pOut->m[2][0] = xaxis.z; pOut->m[2][1] = yaxis.z; pOut->m[2][2] = zaxis.z; pOut->m[2][3] = 0.0f;
+	pOut->m[3][0] = -Vec3_Dot(xaxis, eye);
+	pOut->m[3][1] = -Vec3_Dot(yaxis, eye);
+	pOut->m[3][2] = -Vec3_Dot(zaxis, eye);
+	pOut->m[3][3] = 1.0f;
+}
+
+// depth goes 0 at zn to 1 at zf
+inline void Mat4_PerspectiveFovLH(MAT4* pOut, float fovy, float aspect, float zn, float zf)
+{
+	float yScale = 1.0f / tanf(fovy * 0.5f);
+
+	for (int i = 0; i < 4; i++)
+		for (int j = 0; j < 4; j++)
+			pOut->m[i][j] = 0.0f;
+	pOut->m[0][0] = yScale / aspect;
+	pOut->m[1][1] = yScale;
+	pOut->m[2][2] = zf / (zf - zn);
+	pOut->m[2][3] = 1.0f;
+	pOut->m[3][2] = -zn * zf / (zf - zn);
+}
+
+
+// out row = r.x * b[0] + r.y * b[1] + r.z * b[2] + r.w * b[3], in this order on every path
+inline void VecMath_MultiplyScalar(MAT4* pOut, const MAT4& a, const MAT4& b)
+{
+	MAT4 result;
+
+	for (int i = 0; i < 4; i++)
+		for (int j = 0; j < 4; j++)
+			result.m[i][j] = a.m[i][0] * b.m[0][j] + a.m[i][1] * b.m[1][j] + a.m[i][2] * b.m[2][j] + a.m[i][3] * b.m[3][j];
+
+	*pOut = result;
+}
+
+//Mat4_Multiply() : pOut = a * b, a applies first; pOut may be a or b
+inline void Mat4_Multiply(MAT4* pOut, const MAT4& a, const MAT4& b)
+{
+#ifdef VECMATH_SSE
+	__m128 b0 = _mm_load_ps(b.m[0]);
+	__m128 b1 = _mm_load_ps(b.m[1]);
+	__m128 b2 = _mm_load_ps(b.m[2]);
+	__m128 b3 = _mm_load_ps(b.m[3]);
+	__m128 rows[4];
+
+	for (int i = 0; i < 4; i++)
+	{
+		__m128 r = _mm_load_ps(a.m[i]);
+		__m128 sum = _mm_mul_ps(_mm_shuffle_ps(r, r, 0x00), b0);
+		sum = _mm_add_ps(sum, _mm_mul_ps(_mm_shuffle_ps(r, r, 0x55), b1));
+		sum = _mm_add_ps(sum, _mm_mul_ps(_mm_shuffle_ps(r, r, 0xaa), b2));
+		rows[i] = _mm_add_ps(sum, _mm_mul_ps(_mm_shuffle_ps(r, r, 0xff), b3));
+	}
+
+	for (int i = 0; i < 4; i++)
+		_mm_store_ps(pOut->m[i], rows[i]);
+#else
+	VecMath_MultiplyScalar(pOut, a, b);
+#endif
+}
+
+inline void Mat4_Transpose(MAT4* pOut, const MAT4& m)
+{
+	MAT4 result;
+
+	for (int i = 0; i < 4; i++)
+		for (int j = 0; j < 4; j++)
+			result.m[i][j] = m.m[j][i];
+
+	*pOut = result;
+}
+
+//Mat4_MultiplyArray() : pOut[i] = pA[i] * b, e.g. every world matrix by the view-projection; pOut may be pA
+inline void Mat4_MultiplyArray(MAT4* pOut, const MAT4* pA, const MAT4& b, int nCount)
+{
+	int i = 0;
+#ifdef VECMATH_AVX2
+	// rows of two matrices side by side, b's rows repeated in both halves
+	__m256 b0 = _mm256_broadcast_ps((const __m128*)b.m[0]);
+	__m256 b1 = _mm256_broadcast_ps((const __m128*)b.m[1]);
+	__m256 b2 = _mm256_broadcast_ps((const __m128*)b.m[2]);
+	__m256 b3 = _mm256_broadcast_ps((const __m128*)b.m[3]);
+
+	for (; i + 2 <= nCount; i += 2)
+	{
+		const float* pIn = pA[i].m[0];
+		float* pDst = pOut[i].m[0];
+		__m256 rows[4];
+
+		for (int j = 0; j < 4; j++)
+		{
+			__m256 r = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_load_ps(pIn + j * 4)), _mm_load_ps(pIn + 16 + j * 4), 1);
+			__m256 sum = _mm256_mul_ps(_mm256_shuffle_ps(r, r, 0x00), b0);
+			sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_shuffle_ps(r, r, 0x55), b1));
+			sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_shuffle_ps(r, r, 0xaa), b2));
+			rows[j] = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_shuffle_ps(r, r, 0xff), b3));
+		}
+
+		for (int j = 0; j < 4; j++)
+		{
+			_mm_store_ps(pDst + j * 4, _mm256_castps256_ps128(rows[j]));
+			_mm_store_ps(pDst + 16 + j * 4, _mm256_extractf128_ps(rows[j], 1));
+		}
+	}
+#endif
+	for (; i < nCount; i++)
+		Mat4_Multiply(&pOut[i], pA[i], b);
+}
+
+#ifdef VECMATH_SSE
+inline __m128 VecMath_TransformSSE(float x, float y, float z, const MAT4& m)
+{
+	__m128 sum = _mm_mul_ps(_mm_set1_ps(x), _mm_load_ps(m.m[0]));
+	sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(y), _mm_load_ps(m.m[1])));
+	sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(z), _mm_load_ps(m.m[2])));
+	return _mm_add_ps(sum, _mm_load_ps(m.m[3]));
+}
+#endif
+
+//Vec3_Transform() : (v, 1) * m, without the divide
+inline VEC4 Vec3_Transform(const VEC3& v, const MAT4& m)
+{
+	VEC4 out;
+#ifdef VECMATH_SSE
+	_mm_store_ps(&out.x, VecMath_TransformSSE(v.x, v.y, v.z, m));
+#else
+	out.x = v.x * m.m[0][0] + v.y * m.m[1][0] + v.z * m.m[2][0] + m.m[3][0];
+	out.y = v.x * m.m[0][1] + v.y * m.m[1][1] + v.z * m.m[2][1] + m.m[3][1];
+	out.z = v.x * m.m[0][2] + v.y * m.m[1][2] + v.z * m.m[2][2] + m.m[3][2];
+	out.w = v.x * m.m[0][3] + v.y * m.m[1][3] + v.z * m.m[2][3] + m.m[3][3];
+#endif
+	return out;
+}
+
+//Vec3_TransformCoord() : (v, 1) * m divided by w, like D3DXVec3TransformCoord()
+inline VEC3 Vec3_TransformCoord(const VEC3& v, const MAT4& m)
+{
+	VEC4 h = Vec3_Transform(v, m);
+	return Vec3(h.x / h.w, h.y / h.w, h.z / h.w);
+}
+
+#ifdef VECMATH_AVX2
+// a in the low four lanes, b in the high four
+inline __m256 VecMath_Pair(float a, float b)
+{
+	return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_set1_ps(a)), _mm_set1_ps(b), 1);
+}
+#endif
+
+//Vec3_TransformCoordArray() : the strides are in bytes, so positions can be read from and written to vertices
+inline void Vec3_TransformCoordArray(VEC3* pOut, int nOutStride, const VEC3* pIn, int nInStride, const MAT4& m, int nCount)
+{
+	char* pDst = (char*)pOut;
+	const char* pSrc = (const char*)pIn;
+	int i = 0;
+#ifdef VECMATH_AVX2
+	__m256 m0 = _mm256_broadcast_ps((const __m128*)m.m[0]);
+	__m256 m1 = _mm256_broadcast_ps((const __m128*)m.m[1]);
+	__m256 m2 = _mm256_broadcast_ps((const __m128*)m.m[2]);
+	__m256 m3 = _mm256_broadcast_ps((const __m128*)m.m[3]);
+
+	for (; i + 2 <= nCount; i += 2)
+	{
+		const VEC3& a = *(const VEC3*)(pSrc + i * nInStride);
+		const VEC3& b = *(const VEC3*)(pSrc + (i + 1) * nInStride);
+
+		__m256 sum = _mm256_mul_ps(VecMath_Pair(a.x, b.x), m0);
+		sum = _mm256_add_ps(sum, _mm256_mul_ps(VecMath_Pair(a.y, b.y), m1));
+		sum = _mm256_add_ps(sum, _mm256_mul_ps(VecMath_Pair(a.z, b.z), m2));
+		sum = _mm256_add_ps(sum, m3);
+		sum = _mm256_div_ps(sum, _mm256_shuffle_ps(sum, sum, 0xff));
+
+		VECMATH_ALIGN float result[8];
+		_mm256_store_ps(result, sum);
+		*(VEC3*)(pDst + i * nOutStride) = Vec3(result[0], result[1], result[2]);
+		*(VEC3*)(pDst + (i + 1) * nOutStride) = Vec3(result[4], result[5], result[6]);
+	}
+#endif
+	for (; i < nCount; i++)
+		*(VEC3*)(pDst + i * nOutStride) = Vec3_TransformCoord(*(const VEC3*)(pSrc + i * nInStride), m);
+}
+
+
+inline QUAT Quat_Identity(void)
+{
+	QUAT q = { 0.0f, 0.0f, 0.0f, 1.0f };
+	return q;
+}
+
+//Quat_RotationAxis() : turns like Mat4_RotationX/Y/Z() about a unit axis
+inline QUAT Quat_RotationAxis(const VEC3& axis, float angle)
+{
+	float s = sinf(angle * 0.5f);
+	QUAT q = { axis.x * s, axis.y * s, axis.z * s, cosf(angle * 0.5f) };
+	return q;
+}
+
+//Quat_Multiply() : a then b, the same order as Mat4_Multiply() of their matrices (D3DXQuaternionMultiply())
+inline QUAT Quat_Multiply(const QUAT& a, const QUAT& b)
+{
+	QUAT q;
+	q.x = b.w * a.x + b.x * a.w + b.y * a.z - b.z * a.y;
+	q.y = b.w * a.y - b.x * a.z + b.y * a.w + b.z * a.x;
+	q.z = b.w * a.z + b.x * a.y - b.y * a.x + b.z * a.w;
+	q.w = b.w * a.w - b.x * a.x - b.y * a.y - b.z * a.z;
+	return q;
+}
+
+inline QUAT Quat_Normalize(const QUAT& q)
+{
+	float length = sqrtf(q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w);
+	float s = length > 0.0f ? 1.0f / length : 0.0f;
+	QUAT out = { q.x * s, q.y * s, q.z * s, q.w * s };
+	return out;
+}
+
+//Quat_Slerp() : takes the short way round, falls back to a normalized lerp when a and b are close
+inline QUAT Quat_Slerp(const QUAT& a, const QUAT& b, float t)
+{
+	float cosTheta = a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
+	float sign = 1.0f;
+	if (cosTheta < 0.0f)
+	{
+		cosTheta = -cosTheta;
+		sign = -1.0f;
+	}
+
+	float wa = 1.0f - t, wb = t;
+	if (cosTheta < 0.9995f)
+	{
+		float theta = acosf(cosTheta);
+		float invSin = 1.0f / sinf(theta);
+		wa = sinf(wa * theta) * invSin;
+		wb = sinf(wb * theta) * invSin;
+	}
+	wb *= sign;
+
+	QUAT q = { a.x * wa + b.x * wb, a.y * wa + b.y * wb, a.z * wa + b.z * wb, a.w * wa + b.w * wb };
+	return cosTheta < 0.9995f ? q : Quat_Normalize(q);
+}